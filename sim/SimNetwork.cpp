@@ -0,0 +1,347 @@
+#include "SimNetwork.h"
+#include "WiFiManager.h"
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define SIM_NTP_PACKET_SIZE 48
+#define SIM_NTP_UNIX_OFFSET 2208988800ULL
+
+/**
+ * @brief Request waiting for its simulated round trip.
+ */
+struct SimNtpRequest {
+    uint8_t packet[SIM_NTP_PACKET_SIZE];
+    sockaddr_in from;
+    uint64_t arrival;  ///< Reference time the request reached the network
+};
+
+/**
+ * @brief Loopback stand-in for one NTP server.
+ */
+struct SimNtpServer {
+    std::string name;
+    int fd;
+    uint16_t port;
+    std::vector<SimNtpRequest> queue;
+};
+
+static SimNetworkModel netModel = {1500, 600, 250, 60, 40, true};
+static bool netConnected = false;
+static std::vector<SimNtpServer> ntpServers;
+
+/**
+ * @brief Opens a non-blocking UDP socket on an ephemeral loopback port.
+ *
+ * @param port Receives the bound port.
+ * @return The socket, or -1.
+ */
+static int openLoopbackSocket(uint16_t* port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t size = sizeof(local);
+    if (bind(fd, (sockaddr*)&local, sizeof(local)) < 0 || getsockname(fd, (sockaddr*)&local, &size) < 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    *port = ntohs(local.sin_port);
+    return fd;
+}
+
+static uint32_t serverAddress(size_t index) {
+    return IPAddress(10, 0, 0, (uint8_t)(index + 1));
+}
+
+static void writeNtpTimestamp(uint8_t* bytes, uint64_t micros) {
+    uint64_t value = ((micros / 1000000ULL + SIM_NTP_UNIX_OFFSET) << 32) | (((micros % 1000000ULL) << 32) / 1000000ULL);
+    for (int i = 7; i >= 0; i--) {
+        bytes[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+void SimNetwork::configure(const SimNetworkModel& model) {
+    netModel = model;
+}
+
+const SimNetworkModel& SimNetwork::model() {
+    return netModel;
+}
+
+/**
+ * @brief Associates with the access point; the radio stays on until sleep.
+ *
+ * @param millis Time the association takes.
+ * @param timeoutMillis Time spent before giving up when the network is down.
+ * @return true if the station is connected.
+ */
+bool SimNetwork::connect(uint32_t millis, uint32_t timeoutMillis) {
+    Sim::setRadio(true);
+    if (!netConnected) {
+        Sim::advance((uint64_t)(netModel.available ? millis : timeoutMillis) * 1000ULL);
+        netConnected = netModel.available;
+    }
+    return netConnected;
+}
+
+bool SimNetwork::isConnected() {
+    return netConnected;
+}
+
+/**
+ * @brief Resolves a host name to the address of its stand-in server.
+ *
+ * @param host Host name.
+ * @param ip Receives the address.
+ * @return false if not connected or the stand-in could not be opened.
+ */
+bool SimNetwork::resolve(const char* host, uint32_t* ip) {
+    if (!netConnected) return false;
+    Sim::advance((uint64_t)netModel.dnsMillis * 1000ULL);
+    Sim::counters().dnsLookups++;
+
+    for (size_t i = 0; i < ntpServers.size(); i++) {
+        if (ntpServers[i].name == host) {
+            *ip = serverAddress(i);
+            return true;
+        }
+    }
+    SimNtpServer server;
+    server.name = host;
+    server.fd = openLoopbackSocket(&server.port);
+    if (server.fd < 0) return false;
+    ntpServers.push_back(server);
+    *ip = serverAddress(ntpServers.size() - 1);
+    return true;
+}
+
+/**
+ * @brief Maps a server address to the loopback port of its stand-in.
+ *
+ * @param ip Server address handed out by resolve().
+ * @param port Destination port (only NTP is served).
+ * @param localPort Receives the loopback port.
+ * @return false if nothing listens at that address.
+ */
+bool SimNetwork::route(uint32_t ip, uint16_t port, uint16_t* localPort) {
+    if (port != NTP_PORT) return false;
+    for (size_t i = 0; i < ntpServers.size(); i++) {
+        if (serverAddress(i) == ip) {
+            *localPort = ntpServers[i].port;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Maps a loopback port back to the server address.
+ *
+ * @param localPort Source port of a received datagram.
+ * @return The server address, or 0.
+ */
+uint32_t SimNetwork::address(uint16_t localPort) {
+    for (size_t i = 0; i < ntpServers.size(); i++) {
+        if (ntpServers[i].port == localPort) return serverAddress(i);
+    }
+    return 0;
+}
+
+/**
+ * @brief Queues incoming requests and sends the answers that are due.
+ *
+ * Server `i` answers `(i + 1) * ntpMillis` after the request, stamping its
+ * receive and transmit times in the middle of that round trip.
+ */
+void SimNetwork::serve() {
+    for (size_t i = 0; i < ntpServers.size(); i++) {
+        SimNtpServer& server = ntpServers[i];
+        SimNtpRequest request;
+        socklen_t size = sizeof(request.from);
+        while (recvfrom(server.fd, request.packet, sizeof(request.packet), 0, (sockaddr*)&request.from, &size) == SIM_NTP_PACKET_SIZE) {
+            request.arrival = Sim::trueMicros();
+            if (netConnected && netModel.available) server.queue.push_back(request);
+            size = sizeof(request.from);
+        }
+
+        uint64_t roundTrip = (uint64_t)netModel.ntpMillis * 1000ULL * (i + 1);
+        for (size_t q = 0; q < server.queue.size();) {
+            SimNtpRequest& pending = server.queue[q];
+            if (Sim::trueMicros() < pending.arrival + roundTrip) {
+                q++;
+                continue;
+            }
+            uint8_t answer[SIM_NTP_PACKET_SIZE] = {};
+            uint64_t utc = pending.arrival + roundTrip / 2 - (uint64_t)TIMEOFFSET * 1000000ULL;
+            answer[0] = (0 << 6) | (4 << 3) | 4;  // LI = 0, VN = 4, Mode = server
+            answer[1] = 2;                        // Stratum
+            answer[2] = pending.packet[2];        // Poll
+            answer[3] = (uint8_t)-20;             // Precision (~1 us)
+            memcpy(answer + 24, pending.packet + 40, 8);  // Originate = request transmit
+            writeNtpTimestamp(answer + 16, utc);  // Reference
+            writeNtpTimestamp(answer + 32, utc);  // Receive
+            writeNtpTimestamp(answer + 40, utc);  // Transmit
+            sendto(server.fd, answer, sizeof(answer), 0, (sockaddr*)&pending.from, sizeof(pending.from));
+            server.queue.erase(server.queue.begin() + q);
+        }
+    }
+}
+
+void SimNetwork::shutdown() {
+    netConnected = false;
+    Sim::setRadio(false);
+    for (size_t i = 0; i < ntpServers.size(); i++) ntpServers[i].queue.clear();  // Answers in flight are lost
+}
+
+// ==================================================
+// Driver objects on the network model
+// ==================================================
+
+WiFiClass WiFi;
+
+int WiFiClass::hostByName(const char* host, IPAddress& result) {
+    uint32_t ip;
+    if (!SimNetwork::resolve(host, &ip)) return 0;
+    result = IPAddress(ip);
+    return 1;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    (void)port;
+    stop();
+    uint16_t bound;
+    _fd = openLoopbackSocket(&bound);
+    return _fd >= 0;
+}
+
+void WiFiUDP::stop() {
+    if (_fd >= 0) close(_fd);
+    _fd = -1;
+    _tx.clear();
+    _rx.clear();
+    _rxRead = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+    _txIp = ip;
+    _txPort = port;
+    _tx.clear();
+    return _fd >= 0;
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t size) {
+    _tx.append((const char*)buffer, size);
+    return size;
+}
+
+/**
+ * @brief Sends the datagram; unknown destinations are silently dropped.
+ */
+int WiFiUDP::endPacket() {
+    uint16_t localPort;
+    if (_fd < 0) return 0;
+    if (SimNetwork::route(_txIp, _txPort, &localPort)) {
+        sockaddr_in to = {};
+        to.sin_family = AF_INET;
+        to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        to.sin_port = htons(localPort);
+        if (sendto(_fd, _tx.data(), _tx.size(), 0, (sockaddr*)&to, sizeof(to)) < 0) return 0;
+        SimNetwork::serve();  // The request reaches the server now
+    }
+    _tx.clear();
+    return 1;
+}
+
+int WiFiUDP::parsePacket() {
+    if (_fd < 0) return 0;
+    SimNetwork::serve();
+    uint8_t buffer[1500];
+    sockaddr_in from = {};
+    socklen_t size = sizeof(from);
+    ssize_t length = recvfrom(_fd, buffer, sizeof(buffer), 0, (sockaddr*)&from, &size);
+    if (length <= 0) return 0;
+    _rx.assign((const char*)buffer, (size_t)length);
+    _rxRead = 0;
+    _remoteIp = SimNetwork::address(ntohs(from.sin_port));
+    _remotePort = NTP_PORT;
+    return (int)length;
+}
+
+int WiFiUDP::read(uint8_t* buffer, size_t length) {
+    size_t available = _rx.size() - _rxRead;
+    if (length > available) length = available;
+    memcpy(buffer, _rx.data() + _rxRead, length);
+    _rxRead += length;
+    return (int)length;
+}
+
+// ==================================================
+// WiFiManager on the network model (station mode only, no web portal)
+// ==================================================
+
+WiFiManager::WiFiManager(ConfigManager* configManager, RTCManager* RTC, Device* device)
+    : configManager(configManager), RTC(RTC), device(device), server(80), isAPMode(false),
+      apSSID(DEFAULT_AP_SSID), apPassword(DEFAULT_AP_PASSWORD) {}
+
+/**
+ * @brief The access point portal is not simulated.
+ */
+void WiFiManager::begin() {
+    if (DEBUGMODE) Serial.println("WiFiManager: Portal not available in the simulator");
+}
+
+/**
+ * @brief Same connect policy as the firmware: cached AP first, then a full scan.
+ */
+void WiFiManager::connectToWiFi() {
+    EnergyScope phase(EnergyPhase::WifiConnect);
+    if (DEBUGMODE) Serial.println("WiFiManager: Connecting (simulated)");
+    String ssid = configManager->Get<ConfigField::WifiSsid>();
+    String password = configManager->Get<ConfigField::WifiPass>();
+
+    WifiConnectMode mode = WifiLease::plan(ssid.c_str(), password.c_str());
+    bool connected = connectStation(ssid, password, mode);
+    if (!connected && mode != WifiConnectMode::Scan) {
+        WifiLease::forget();
+        connected = connectStation(ssid, password, WifiConnectMode::Scan);
+    }
+    if (!connected) SimNetwork::shutdown();  // Radio off until the next attempt
+}
+
+bool WiFiManager::connectStation(const String& ssid, const String& password, WifiConnectMode mode) {
+    static const uint8_t bssid[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    const SimNetworkModel& model = SimNetwork::model();
+    uint32_t millis = model.connectMillis;
+    uint32_t timeout = WIFI_CONNECT_TIMEOUT_MS;
+    if (mode != WifiConnectMode::Scan) {
+        millis = mode == WifiConnectMode::Lease ? model.leaseMillis : model.channelMillis;
+        timeout = WIFI_FAST_TIMEOUT_MS;
+    }
+
+    uint64_t start = Sim::millis();
+    bool connected = SimNetwork::connect(millis, timeout);
+    WifiLease::recordAttempt(mode, connected, (uint32_t)(Sim::millis() - start));
+    if (connected) {
+        WifiLease::remember(ssid.c_str(), password.c_str(), bssid, 6,
+                            IPAddress(192, 168, 1, 50), IPAddress(192, 168, 1, 1), IPAddress(255, 255, 255, 0),
+                            IPAddress(192, 168, 1, 1), IPAddress(0, 0, 0, 0), mode != WifiConnectMode::Lease);
+    }
+    return connected;
+}
+
+bool WiFiManager::isStillConnected() {
+    return SimNetwork::isConnected();
+}
+
+void WiFiManager::disconnect() {
+    SimNetwork::shutdown();
+}
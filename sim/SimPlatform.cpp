@@ -0,0 +1,409 @@
+#include <stdarg.h>
+#include <algorithm>
+#include <vector>
+#include "Arduino.h"
+#include "Preferences.h"
+#include "esp_sleep.h"
+#include "SimNetwork.h"
+#include "SimUlp.h"
+#include "Config.h"
+#include "TimeAccounting.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static uint64_t simTrue = 0;         // Reference local time (us)
+static uint64_t simRtc = 0;          // Device RTC timer (us since power-on)
+static double simRtcFraction = 0;    // Sub-microsecond part of the RTC timer
+static double simDriftPpm = 0;       // RTC rate error against the reference
+static uint64_t simBootRtc = 0;      // RTC timer at the last boot
+static bool simClockSet = false;     // System clock set since power-on
+static int64_t simClockOffset = 0;   // System time = RTC timer + offset (us)
+static bool simRadio = false;
+static uint8_t simPins[SIM_GPIO_COUNT];
+static void (*simHandlers[SIM_GPIO_COUNT])();  // Interrupt handlers (nullptr = none)
+static int simHandlerModes[SIM_GPIO_COUNT];
+static uint64_t simWakeTimer = 0;
+static int simWakeCause = 0;
+static int simExt0Pin = -1;          // ext0 wake pin (-1 = disabled)
+static int simExt0Level = LOW;
+static uint64_t simExt1Mask = 0;     // ext1 wake pins (0 = disabled)
+static bool simExt1AnyHigh = false;
+static bool simVerbose = false;
+static SimCounters simCounters = {};
+
+/**
+ * @brief Input change scheduled by the scenario.
+ */
+struct SimStimulus {
+    uint64_t trueMicros;
+    int pin;
+    int level;
+};
+
+static std::vector<SimStimulus> simStimuli;  // Sorted by time
+
+/**
+ * @brief Moves the RTC timer by a reference duration, applying the drift.
+ *
+ * @param trueMicros Elapsed reference time.
+ */
+static void advanceRtc(uint64_t trueMicros) {
+    double scaled = (double)trueMicros * (1.0 + simDriftPpm / 1e6) + simRtcFraction;
+    uint64_t whole = (uint64_t)scaled;
+    simRtcFraction = scaled - (double)whole;
+    simRtc += whole;
+    TimeAccounting::setHostRtcMicros(simRtc);
+}
+
+/**
+ * @brief Resets the device as on power-on (RTC timer and RTC memory lost).
+ *
+ * RTC_DATA_ATTR variables are plain statics on the host; the simulator only
+ * powers on once, at the start of a run.
+ *
+ * @param trueMicros Reference local time at power-on.
+ * @param driftPpm RTC rate error in parts per million (positive = fast).
+ */
+void Sim::powerOn(uint64_t trueMicros, double driftPpm) {
+    simTrue = trueMicros;
+    simRtc = 0;
+    simRtcFraction = 0;
+    simDriftPpm = driftPpm;
+    simBootRtc = 0;
+    simClockSet = false;
+    simClockOffset = 0;
+    simRadio = false;
+    memset(simPins, HIGH, sizeof(simPins));  // Inputs idle high (pull-ups)
+    memset(simHandlers, 0, sizeof(simHandlers));
+    simWakeTimer = 0;
+    simWakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    simExt0Pin = -1;
+    simExt1Mask = 0;
+    simStimuli.clear();
+    SimUlp::reset();
+    TimeAccounting::setHostRtcMicros(0);
+}
+
+/**
+ * @brief Starts an application run.
+ *
+ * @param wakeCause Value returned by esp_sleep_get_wakeup_cause().
+ */
+void Sim::boot(int wakeCause) {
+    simBootRtc = simRtc;
+    simWakeCause = wakeCause;
+    memset(simHandlers, 0, sizeof(simHandlers));  // Interrupts are not configured after reset
+    simWakeTimer = 0;
+    simExt0Pin = -1;  // Wake sources are configured again before the next sleep
+    simExt1Mask = 0;
+    SimUlp::boot();
+}
+
+/**
+ * @brief Drives an input pin.
+ *
+ * @param pin GPIO number.
+ * @param level New level.
+ * @param interrupts false in deep sleep, where no handler runs.
+ * @return true if an interrupt handler ran.
+ */
+static bool drivePin(int pin, int level, bool interrupts) {
+    if (pin < 0 || pin >= SIM_GPIO_COUNT) return false;
+    int previous = simPins[pin];
+    simPins[pin] = level;
+    if (!interrupts || simHandlers[pin] == nullptr || previous == level) return false;
+    int mode = simHandlerModes[pin];
+    if (mode == CHANGE || (mode == RISING && level == HIGH) || (mode == FALLING && level == LOW)) {
+        simHandlers[pin]();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Moves the clocks while the application runs or is blocked.
+ */
+static void stepAwake(uint64_t micros, bool idle) {
+    simTrue += micros;
+    if (idle) {
+        simCounters.idleMicros += micros;
+    } else {
+        simCounters.awakeMicros += micros;
+    }
+    if (simRadio) simCounters.radioMicros += micros;
+    advanceRtc(micros);
+}
+
+/**
+ * @brief Lets awake or light-sleep time pass, applying the input changes due on the way.
+ *
+ * @param micros Reference time in microseconds.
+ * @param idle true for light sleep, which ends early when an interrupt handler runs.
+ */
+static void passTime(uint64_t micros, bool idle) {
+    uint64_t end = simTrue + micros;
+    while (!simStimuli.empty() && simStimuli.front().trueMicros <= end) {
+        SimStimulus next = simStimuli.front();
+        simStimuli.erase(simStimuli.begin());
+        if (next.trueMicros > simTrue) stepAwake(next.trueMicros - simTrue, idle);
+        if (drivePin(next.pin, next.level, true) && idle) return;  // The interrupt wakes the CPU
+    }
+    stepAwake(end - simTrue, idle);
+}
+
+/**
+ * @brief Checks the ext0/ext1 wake conditions on the current pin levels.
+ *
+ * @return The wake cause, or ESP_SLEEP_WAKEUP_UNDEFINED if no pin wakes.
+ */
+static int pinWakeCause() {
+    if (simExt0Pin >= 0 && simPins[simExt0Pin] == simExt0Level) return ESP_SLEEP_WAKEUP_EXT0;
+    if (simExt1Mask == 0) return ESP_SLEEP_WAKEUP_UNDEFINED;
+    bool anyHigh = false;
+    bool allLow = true;
+    for (int pin = 0; pin < SIM_GPIO_COUNT; pin++) {
+        if ((simExt1Mask & (1ULL << pin)) == 0) continue;
+        if (simPins[pin] == HIGH) {
+            anyHigh = true;
+            allLow = false;
+        }
+    }
+    if (simExt1AnyHigh ? anyHigh : allLow) return ESP_SLEEP_WAKEUP_EXT1;
+    return ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+/**
+ * @brief Lets time pass while the application is running.
+ *
+ * @param micros Reference time in microseconds.
+ */
+void Sim::advance(uint64_t micros) {
+    passTime(micros, false);
+}
+
+/**
+ * @brief Lets time pass while the application is blocked (automatic light sleep).
+ *
+ * Ends early if a scheduled input change runs an interrupt handler.
+ *
+ * @param micros Reference time in microseconds.
+ */
+void Sim::idle(uint64_t micros) {
+    passTime(micros, true);
+}
+
+/**
+ * @brief Lets time pass in deep sleep until the RTC timer has moved by `rtcMicros`.
+ *
+ * The sleep ends early when an input change meets an ext0/ext1 wake
+ * condition (a wake pin already at its level ends it right away) or a ULP
+ * run wakes the CPU. While the ULP timer is enabled, the program runs every
+ * wake-up period (RTC timer units), seeing the inputs as they are then.
+ *
+ * @param rtcMicros Sleep length as programmed (RTC timer units).
+ * @return ESP_SLEEP_WAKEUP_TIMER, ESP_SLEEP_WAKEUP_EXT0, ESP_SLEEP_WAKEUP_EXT1 or ESP_SLEEP_WAKEUP_ULP.
+ */
+int Sim::sleep(uint64_t rtcMicros) {
+    double rate = 1.0 + simDriftPpm / 1e6;
+    uint64_t start = simTrue;
+    uint64_t end = start + (uint64_t)((double)rtcMicros / rate);
+    uint64_t startRtc = simRtc;
+    uint64_t nextUlpRtc = startRtc + SimUlp::periodMicros();
+    int cause = pinWakeCause();
+    while (cause == ESP_SLEEP_WAKEUP_UNDEFINED) {
+        uint64_t ulpAt = SimUlp::running() ? start + (uint64_t)((double)(nextUlpRtc - startRtc) / rate) : UINT64_MAX;
+        uint64_t stimulusAt = simStimuli.empty() ? UINT64_MAX : simStimuli.front().trueMicros;
+        if (ulpAt > end && stimulusAt > end) break;
+        if (stimulusAt <= ulpAt) {
+            SimStimulus next = simStimuli.front();
+            simStimuli.erase(simStimuli.begin());
+            if (next.trueMicros > simTrue) simTrue = next.trueMicros;
+            drivePin(next.pin, next.level, false);
+            cause = pinWakeCause();
+        } else {
+            simTrue = ulpAt;
+            simRtc = nextUlpRtc;
+            TimeAccounting::setHostRtcMicros(simRtc);
+            if (SimUlp::run()) cause = ESP_SLEEP_WAKEUP_ULP;
+            nextUlpRtc += SimUlp::periodMicros();
+        }
+    }
+    if (cause == ESP_SLEEP_WAKEUP_UNDEFINED) {
+        simTrue = end;
+        simRtc = startRtc + rtcMicros;
+        cause = ESP_SLEEP_WAKEUP_TIMER;
+    } else if (cause != ESP_SLEEP_WAKEUP_ULP) {
+        simRtc = startRtc + (uint64_t)((double)(simTrue - start) * rate);
+    }
+    TimeAccounting::setHostRtcMicros(simRtc);
+    return cause;
+}
+
+uint64_t Sim::trueMicros() {
+    return simTrue;
+}
+
+uint64_t Sim::rtcMicros() {
+    return simRtc;
+}
+
+uint64_t Sim::millis() {
+    return (simRtc - simBootRtc) / 1000ULL;
+}
+
+/**
+ * @brief Reads the system clock.
+ *
+ * @param tv Receives the system time.
+ * @return false if the clock was never set since power-on.
+ */
+bool Sim::systemTime(struct timeval* tv) {
+    int64_t micros = (int64_t)simRtc + simClockOffset;
+    tv->tv_sec = micros / 1000000LL;
+    tv->tv_usec = micros % 1000000LL;
+    return simClockSet;
+}
+
+void Sim::setSystemTime(const struct timeval* tv) {
+    simClockOffset = (int64_t)tv->tv_sec * 1000000LL + tv->tv_usec - (int64_t)simRtc;
+    simClockSet = true;
+}
+
+void Sim::setRadio(bool on) {
+    simRadio = on;
+}
+
+bool Sim::radio() {
+    return simRadio;
+}
+
+/**
+ * @brief Drives an input pin; an attached interrupt handler runs on a matching edge.
+ *
+ * @param pin GPIO number.
+ * @param level New level.
+ */
+void Sim::setPin(int pin, int level) {
+    drivePin(pin, level, true);
+}
+
+/**
+ * @brief Schedules an input change at a reference time (button presses of the scenario).
+ *
+ * @param trueMicros Reference time of the change.
+ * @param pin GPIO number.
+ * @param level New level.
+ */
+void Sim::schedulePin(uint64_t trueMicros, int pin, int level) {
+    SimStimulus stimulus = {trueMicros, pin, level};
+    auto later = std::upper_bound(simStimuli.begin(), simStimuli.end(), stimulus,
+                                  [](const SimStimulus& a, const SimStimulus& b) { return a.trueMicros < b.trueMicros; });
+    simStimuli.insert(later, stimulus);
+}
+
+void Sim::attachInterrupt(int pin, void (*handler)(), int mode) {
+    if (pin < 0 || pin >= SIM_GPIO_COUNT) return;
+    simHandlers[pin] = handler;
+    simHandlerModes[pin] = mode;
+}
+
+int Sim::pin(int pin) {
+    return (pin >= 0 && pin < SIM_GPIO_COUNT) ? simPins[pin] : LOW;
+}
+
+/**
+ * @brief Records an output level; LED rising edges are counted.
+ *
+ * @param pin GPIO number.
+ * @param level New level.
+ */
+void Sim::writePin(int pin, int level) {
+    if (pin < 0 || pin >= SIM_GPIO_COUNT) return;
+    if (pin == LED_GREEN_PIN && level == HIGH && simPins[pin] != HIGH) {
+        simCounters.ledOnEvents++;
+        if (simCounters.firstLedOn == 0) simCounters.firstLedOn = simTrue;
+    }
+    simPins[pin] = level;
+}
+
+void Sim::setWakeTimer(uint64_t micros) {
+    simWakeTimer = micros;
+}
+
+uint64_t Sim::wakeTimer() {
+    return simWakeTimer;
+}
+
+void Sim::setExt0Wake(int pin, int level) {
+    simExt0Pin = (pin >= 0 && pin < SIM_GPIO_COUNT) ? pin : -1;
+    simExt0Level = level;
+}
+
+void Sim::setExt1Wake(uint64_t mask, bool anyHigh) {
+    simExt1Mask = mask;
+    simExt1AnyHigh = anyHigh;
+}
+
+int Sim::wakeCause() {
+    return simWakeCause;
+}
+
+void Sim::countNvsRead() {
+    simCounters.nvsReads++;
+}
+
+void Sim::countNvsWrite() {
+    simCounters.nvsWrites++;
+}
+
+SimCounters& Sim::counters() {
+    return simCounters;
+}
+
+void Sim::resetCounters() {
+    simCounters = SimCounters();
+}
+
+void Sim::setVerbose(bool verbose) {
+    simVerbose = verbose;
+}
+
+bool Sim::verbose() {
+    return simVerbose;
+}
+
+int simSettimeofday(const struct timeval* tv, const void* tz) {
+    (void)tz;
+    if (tv != nullptr) Sim::setSystemTime(tv);
+    return 0;
+}
+
+int simGettimeofday(struct timeval* tv, void* tz) {
+    (void)tz;
+    Sim::systemTime(tv);
+    return 0;
+}
+
+/**
+ * @brief Flash contents of the emulated NVS partitions.
+ */
+SimNvsStore& simNvsStore() {
+    static SimNvsStore store;
+    return store;
+}
+
+size_t HardwareSerial::emit(const char* text) {
+    if (simVerbose) fputs(text, stdout);
+    return strlen(text);
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    emit(buffer);
+    return length < 0 ? 0 : (size_t)length;
+}
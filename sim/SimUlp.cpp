@@ -0,0 +1,242 @@
+#include <string.h>
+#include <vector>
+#include "Arduino.h"
+#include "esp32/ulp.h"
+#include "soc/rtc.h"
+#include "soc/rtc_io_reg.h"
+#include "driver/rtc_io.h"
+
+#define SIM_ULP_MAX_STEPS 10000  // Runaway guard for one run (the real FSM would just keep going)
+
+static uint32_t ulpMemory[SIM_ULP_MEM_WORDS];
+static std::vector<ulp_insn_t> ulpProgram;  // Labels removed, branch targets resolved to indexes
+static uint32_t ulpLoadAddress = 0;
+static uint32_t ulpEntry = 0;
+static bool ulpTimer = false;                // RTC_CNTL_ULP_CP_SLP_TIMER_EN
+static bool ulpWake = false;                 // ULP wakes enabled for this sleep
+static uint64_t ulpPeriod = 0;               // Wake-up period (RTC timer microseconds)
+static uint64_t ulpLatchedTicks = 0;         // RTC timer latched by RTC_CNTL_TIME_UPDATE
+static SimUlpObserver ulpObserver = nullptr;
+
+/**
+ * @brief Clears memory, program and timer, as on power-on.
+ */
+void SimUlp::reset() {
+    memset(ulpMemory, 0, sizeof(ulpMemory));
+    ulpProgram.clear();
+    ulpTimer = false;
+    ulpWake = false;
+    ulpPeriod = 0;
+    ulpLatchedTicks = 0;
+}
+
+/**
+ * @brief Main CPU reset: wake sources are configured again before the next sleep.
+ */
+void SimUlp::boot() {
+    ulpWake = false;
+}
+
+/**
+ * @brief Loads a macro program, resolving the labels like ulp_process_macros_and_load().
+ *
+ * @param address Load address (32-bit words into RTC slow memory).
+ * @param program Instructions and macros.
+ * @param count In: number of array entries. Out: instructions loaded.
+ * @return false if a branch has no label or the program overflows the reserved memory.
+ */
+bool SimUlp::load(uint32_t address, const ulp_insn_t* program, size_t* count) {
+    std::vector<ulp_insn_t> code;
+    std::vector<std::pair<uint32_t, size_t>> labels;
+    for (size_t i = 0; i < *count; i++) {
+        if (program[i].op == SIM_ULP_LABEL) {
+            labels.push_back(std::make_pair(program[i].label, code.size()));
+        } else {
+            code.push_back(program[i]);
+        }
+    }
+    for (ulp_insn_t& insn : code) {
+        if (insn.op < SIM_ULP_BX || insn.op > SIM_ULP_BGE) continue;
+        bool found = false;
+        for (const auto& label : labels) {
+            if (label.first != insn.label) continue;
+            insn.label = (uint32_t)label.second;
+            found = true;
+            break;
+        }
+        if (!found) return false;
+    }
+    if (address + code.size() > SIM_ULP_RESERVED_WORDS) return false;
+    ulpProgram = code;
+    ulpLoadAddress = address;
+    for (size_t i = 0; i < code.size(); i++) ulpMemory[address + i] = 0xFFFFFFFFUL;  // Occupied by code
+    *count = code.size();
+    return true;
+}
+
+/**
+ * @brief Starts the ULP timer at an entry point (ulp_run()).
+ */
+bool SimUlp::start(uint32_t entry) {
+    if (ulpProgram.empty() || entry < ulpLoadAddress || entry >= ulpLoadAddress + ulpProgram.size()) return false;
+    ulpEntry = entry - ulpLoadAddress;
+    ulpTimer = true;
+    return true;
+}
+
+void SimUlp::setPeriod(uint32_t micros) {
+    ulpPeriod = micros;
+}
+
+void SimUlp::enableWake() {
+    ulpWake = true;
+}
+
+bool SimUlp::running() {
+    return ulpTimer && ulpPeriod > 0;
+}
+
+uint64_t SimUlp::periodMicros() {
+    return ulpPeriod;
+}
+
+void SimUlp::setObserver(SimUlpObserver observer) {
+    ulpObserver = observer;
+}
+
+uint32_t* SimUlp::memory() {
+    return ulpMemory;
+}
+
+/**
+ * @brief RTC timer in slow clock ticks.
+ */
+uint64_t SimUlp::ticks() {
+    return Sim::rtcMicros() * SIM_ULP_SLOW_CLK_HZ / 1000000ULL;
+}
+
+/**
+ * @brief Slow clock period as stored by the calibration (microseconds, 19 fractional bits).
+ */
+uint32_t SimUlp::calibration() {
+    return (uint32_t)((1000000ULL << RTC_CLK_CAL_FRACT) / SIM_ULP_SLOW_CLK_HZ);
+}
+
+/**
+ * @brief Reads a modelled register (0 for the others).
+ */
+uint32_t SimUlp::readRegister(uint32_t address) {
+    switch (address) {
+        case RTC_CNTL_TIME_UPDATE_REG: return RTC_CNTL_TIME_VALID;  // The latch completes at once
+        case RTC_CNTL_TIME0_REG: return (uint32_t)ulpLatchedTicks;
+        case RTC_CNTL_TIME1_REG: return (uint32_t)(ulpLatchedTicks >> 32) & 0xFFFF;
+        case RTC_CNTL_STATE0_REG: return ulpTimer ? RTC_CNTL_ULP_CP_SLP_TIMER_EN : 0;
+        case RTC_CNTL_STORE1_REG: return calibration();
+        case RTC_CNTL_LOW_POWER_ST_REG: return RTC_CNTL_RDY_FOR_WAKEUP;
+        case RTC_GPIO_IN_REG: {
+            uint32_t levels = 0;
+            for (int pin = 0; pin < SIM_GPIO_COUNT; pin++) {
+                int io = rtc_io_number_get(pin);
+                if (io >= 0 && Sim::pin(pin) == HIGH) levels |= 1UL << (RTC_GPIO_IN_NEXT_S + io);
+            }
+            return levels;
+        }
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Writes a modelled register (ignored for the others).
+ */
+void SimUlp::writeRegister(uint32_t address, uint32_t value) {
+    switch (address) {
+        case RTC_CNTL_TIME_UPDATE_REG:
+            if (value & RTC_CNTL_TIME_UPDATE) ulpLatchedTicks = ticks();
+            break;
+        case RTC_CNTL_STATE0_REG:
+            ulpTimer = (value & RTC_CNTL_ULP_CP_SLP_TIMER_EN) != 0;
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Executes the program once from its entry point, until HALT.
+ *
+ * Registers are 16 bits wide; ALU operations set the zero flag, additions
+ * and subtractions also the overflow (carry/borrow) flag. Loads and stores
+ * use the low 16 bits of a memory word.
+ *
+ * @return true if the run executed I_WAKE while ULP wakes are enabled.
+ */
+bool SimUlp::run() {
+    uint32_t before[SIM_ULP_RESERVED_WORDS];
+    memcpy(before, ulpMemory, sizeof(before));
+    uint16_t r[4] = {0, 0, 0, 0};
+    bool zero = false;
+    bool overflow = false;
+    bool woke = false;
+
+    size_t pc = ulpEntry;
+    for (uint32_t steps = 0; pc < ulpProgram.size() && steps < SIM_ULP_MAX_STEPS; steps++) {
+        const ulp_insn_t& insn = ulpProgram[pc++];
+        uint32_t result = 0;
+        bool alu = true;
+        switch (insn.op) {
+            case SIM_ULP_MOVI: result = (uint16_t)insn.imm; break;
+            case SIM_ULP_MOVR: result = r[insn.rs1]; break;
+            case SIM_ULP_ADDI: result = (uint32_t)r[insn.rs1] + (uint16_t)insn.imm; break;
+            case SIM_ULP_SUBI: result = (uint32_t)r[insn.rs1] - (uint16_t)insn.imm; break;
+            case SIM_ULP_ADDR: result = (uint32_t)r[insn.rs1] + r[insn.rs2]; break;
+            case SIM_ULP_SUBR: result = (uint32_t)r[insn.rs1] - r[insn.rs2]; break;
+            case SIM_ULP_ANDR: result = r[insn.rs1] & r[insn.rs2]; break;
+            case SIM_ULP_ORR:  result = r[insn.rs1] | r[insn.rs2]; break;
+            default: alu = false; break;
+        }
+        if (alu) {
+            r[insn.rd] = (uint16_t)result;
+            zero = (uint16_t)result == 0;
+            overflow = result > 0xFFFF;  // Carry out of an addition, borrow of a subtraction
+            continue;
+        }
+
+        uint32_t width = insn.high - insn.low + 1;
+        uint32_t mask = width >= 32 ? 0xFFFFFFFFUL : ((1UL << width) - 1);
+        switch (insn.op) {
+            case SIM_ULP_LD:
+                r[insn.rd] = ulpMemory[(r[insn.rs1] + insn.imm) % SIM_ULP_MEM_WORDS] & 0xFFFF;
+                break;
+            case SIM_ULP_ST:
+                ulpMemory[(r[insn.rs1] + insn.imm) % SIM_ULP_MEM_WORDS] = r[insn.rd];
+                break;
+            case SIM_ULP_RD_REG:
+                r[0] = (uint16_t)((readRegister(insn.reg) >> insn.low) & mask);
+                break;
+            case SIM_ULP_WR_REG: {
+                uint32_t value = readRegister(insn.reg) & ~(mask << insn.low);
+                writeRegister(insn.reg, value | (((uint32_t)insn.imm & mask) << insn.low));
+                break;
+            }
+            case SIM_ULP_BX:  pc = insn.label; break;
+            case SIM_ULP_BXZ: if (zero) pc = insn.label; break;
+            case SIM_ULP_BXF: if (overflow) pc = insn.label; break;
+            case SIM_ULP_BL:  if (r[0] < (uint16_t)insn.imm) pc = insn.label; break;
+            case SIM_ULP_BGE: if (r[0] >= (uint16_t)insn.imm) pc = insn.label; break;
+            case SIM_ULP_WAKE: woke = true; break;
+            case SIM_ULP_HALT: pc = ulpProgram.size(); break;
+            default: break;
+        }
+    }
+
+    if (ulpObserver != nullptr) {
+        SimUlpRun observed;
+        observed.ticks = (uint32_t)ticks();
+        observed.levels = (uint16_t)(readRegister(RTC_GPIO_IN_REG) >> RTC_GPIO_IN_NEXT_S);
+        observed.before = before;
+        observed.after = ulpMemory;
+        observed.woke = woke;
+        ulpObserver(observed);
+    }
+    return woke && ulpWake;
+}
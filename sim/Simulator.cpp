@@ -0,0 +1,435 @@
+/**
+ * @file Simulator.cpp
+ * @brief Deterministic virtual-time simulator of the firmware.
+ *
+ * Runs the real `setup()` through consecutive deep-sleep cycles on the
+ * virtual hardware of `SimPlatform.h`:
+ *
+ * 1. power-on: the first boot initializes the settings and restarts;
+ * 2. a daily alarm is stored, as if set from the portal;
+ * 3. every application boot is run until it enters deep sleep (or restarts),
+ *    then the programmed timer elapses on the drifting RTC. Timer wakes go
+ *    through the wake stub first, exactly like on the device. With
+ *    `--press`, the user button is pressed every day relative to the alarm
+ *    time; a press during deep sleep wakes the device through ext0, or
+ *    through the ULP during the sleeps it counts down. Every ULP run is
+ *    checked against the host model of the program (`ulpWatchStep()`).
+ *
+ * One CSV row is printed per application boot (wakes absorbed by the stub
+ * are attributed to the boot that follows them), then a summary including
+ * the `EnergyMeter` consumption figures:
+ *
+ *   boot,time,cause,stub_wakes,awake_ms,radio_ms,nvs_reads,nvs_writes,sleep_s,clock_error_ms,lateness_s
+ *
+ * Usage:
+ *   program [--days N] [--drift PPM] [--alarm HH:MM] [--boot-ms MS]
+ *           [--connect-ms MS] [--channel-ms MS] [--lease-ms MS] [--ntp-ms MS]
+ *           [--dns-ms MS] [--outage START_H:HOURS] [--press OFFSET_S[:HOLD_MS]]
+ *           [--offline] [--quiet] [--verbose]
+ *
+ * Example, energy spent while the router is down for 24 h after a power cut:
+ *   program --days 3 --outage 0:24 --quiet
+ *
+ * Example, the alarm snoozed by a short press 20 s after it starts ringing:
+ *   program --days 3 --press 20:200 --quiet
+ *
+ * `pio test -e native` links the same sources with the Unity runners of
+ * `test/`, so the simulator's main() is left out of test builds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "Arduino.h"
+#include "Preferences.h"
+#include "esp_sleep.h"
+#include "SimNetwork.h"
+#include "ConfigManager.h"
+#include "WakeStub.h"
+#include "WifiLease.h"
+#include "WakeSource.h"
+#include "UlpWatch.h"
+#include "SimUlp.h"
+
+#ifndef PIO_UNIT_TESTING
+
+void setup();
+
+#define SIM_START_TIME 1736899200ULL  ///< 2025-01-15 00:00:00 (local), reference time at power-on
+#define SIM_STUB_WAKE_MICROS 500      ///< Awake time of one wake handled by the stub
+#define SIM_RING_WINDOW 43200         ///< LED runs further than this from an alarm are not attributed to it
+#define SIM_PRESS_MILLIS 200          ///< Default length of a button press
+
+/**
+ * @brief Scenario of one simulation run.
+ */
+struct SimOptions {
+    double days = 7;          ///< Simulated time
+    double driftPpm = 40;     ///< RTC rate error (positive = fast)
+    int alarmHour = 7;        ///< Daily alarm (local time)
+    int alarmMinute = 30;
+    uint32_t bootMillis = 250;  ///< ROM, bootloader and image load before setup()
+    SimNetworkModel network = {1500, 600, 250, 60, 40, true};
+    double outageStart = 0;   ///< Router outage: hours after power-on
+    double outageHours = 0;   ///< Router outage length (0 = none)
+    bool press = false;       ///< Press the user button every day
+    double pressOffset = 0;   ///< Press time relative to the alarm (seconds, may be negative)
+    uint32_t pressMillis = SIM_PRESS_MILLIS;  ///< Press length
+    bool rows = true;         ///< Print one row per boot
+    bool verbose = false;     ///< Echo the firmware's Serial output
+};
+
+/**
+ * @brief Totals reported at the end of a run.
+ */
+struct SimSummary {
+    uint32_t boots = 0;
+    uint32_t stubWakes = 0;
+    uint64_t awakeMicros = 0;
+    uint64_t idleMicros = 0;        ///< Light sleep between events
+    uint64_t radioMicros = 0;
+    uint64_t nvsReads = 0;
+    uint64_t nvsWrites = 0;
+    uint64_t dnsLookups = 0;
+    uint32_t outageBoots = 0;       ///< Boots that started during the router outage
+    uint64_t outageRadioMicros = 0;
+    uint64_t outageChargeNc = 0;    ///< Charge of those boots and of the sleeps before them
+    uint32_t alarms = 0;        ///< Alarms due during the run
+    uint32_t rung = 0;          ///< Alarms that lit the LED
+    uint32_t ledRuns = 0;       ///< Boots that blinked the LED (a ring can span several)
+    uint64_t ledAwakeMicros = 0;    ///< Awake time of those boots
+    uint64_t ledIdleMicros = 0;     ///< Light sleep of those boots
+    int64_t maxLateness = 0;    ///< Seconds
+    int64_t sumLateness = 0;
+    int64_t maxClockError = 0;  ///< Microseconds (absolute)
+};
+
+/**
+ * @brief ULP runs checked against the model, and the wakes they caused.
+ */
+struct SimUlpCheck {
+    uint64_t runs = 0;
+    uint64_t mismatches = 0;  ///< Runs where the program and ulpWatchStep() disagree
+    uint32_t deadlineWakes = 0;
+    uint32_t buttonWakes = 0;
+};
+
+static SimUlpCheck ulpCheck;
+
+/**
+ * @brief Replays a ULP run on the model and compares the outcome.
+ */
+static void checkUlpRun(const SimUlpRun& run) {
+    UlpShared model = UlpWatch::unpack(run.before + ULP_DATA_OFFSET);
+    UlpReason reason = ulpWatchStep(model, run.ticks, run.levels);
+    UlpShared program = UlpWatch::unpack(run.after + ULP_DATA_OFFSET);
+    ulpCheck.runs++;
+    if (memcmp(&model, &program, sizeof(model)) != 0 || (reason != UlpReason::None) != run.woke) {
+        if (ulpCheck.mismatches == 0) {
+            fprintf(stderr, "ULP program and model disagree at tick %lu (model reason %u, program reason %u)\n",
+                    (unsigned long)run.ticks, (unsigned)reason, (unsigned)program.reason);
+        }
+        ulpCheck.mismatches++;
+    }
+}
+
+static bool parseOptions(int argc, char** argv, SimOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!strcmp(arg, "--quiet")) { options.rows = false; continue; }
+        if (!strcmp(arg, "--verbose")) { options.verbose = true; continue; }
+        if (!strcmp(arg, "--offline")) { options.network.available = false; continue; }
+        if (value == nullptr) return false;
+        if (!strcmp(arg, "--days")) options.days = atof(value);
+        else if (!strcmp(arg, "--drift")) options.driftPpm = atof(value);
+        else if (!strcmp(arg, "--alarm")) {
+            if (sscanf(value, "%d:%d", &options.alarmHour, &options.alarmMinute) != 2) return false;
+        }
+        else if (!strcmp(arg, "--boot-ms")) options.bootMillis = atoi(value);
+        else if (!strcmp(arg, "--connect-ms")) options.network.connectMillis = atoi(value);
+        else if (!strcmp(arg, "--channel-ms")) options.network.channelMillis = atoi(value);
+        else if (!strcmp(arg, "--lease-ms")) options.network.leaseMillis = atoi(value);
+        else if (!strcmp(arg, "--ntp-ms")) options.network.ntpMillis = atoi(value);
+        else if (!strcmp(arg, "--dns-ms")) options.network.dnsMillis = atoi(value);
+        else if (!strcmp(arg, "--outage")) {
+            if (sscanf(value, "%lf:%lf", &options.outageStart, &options.outageHours) != 2) return false;
+        }
+        else if (!strcmp(arg, "--press")) {
+            if (sscanf(value, "%lf:%u", &options.pressOffset, &options.pressMillis) < 1) return false;
+            options.press = true;
+        }
+        else return false;
+        i++;
+    }
+    return options.days > 0;
+}
+
+/**
+ * @brief First occurrence of the daily alarm of the scenario.
+ *
+ * @param options Scenario (alarm time of day).
+ * @param now Reference local time (Unix seconds).
+ * @return Local Unix time of the first alarm.
+ */
+static uint64_t firstAlarm(const SimOptions& options, uint64_t now) {
+    uint64_t alarm = now - (now % 86400ULL) + options.alarmHour * 3600ULL + options.alarmMinute * 60ULL;
+    if (alarm <= now + 3600ULL) alarm += 86400ULL;  // Leave the first day some sleep
+    return alarm;
+}
+
+/**
+ * @brief Stores a daily alarm in the settings, as the portal would.
+ *
+ * @param options Scenario (alarm time of day).
+ * @param now Reference local time (Unix seconds).
+ * @return The first occurrence of the alarm.
+ */
+static uint64_t storeDailyAlarm(const SimOptions& options, uint64_t now) {
+    uint64_t alarm = firstAlarm(options, now);
+
+    Preferences preferences;
+    preferences.begin(CONFIG_PARTITION, false);
+    ConfigManager config(&preferences);
+    AlarmEntry rule = {};
+    rule.start = alarm;
+    rule.repeat = ALARM_DAILY;
+    config.StoreAlarm(rule, false, now);
+    config.end();
+    return alarm;
+}
+
+/**
+ * @brief Charge accounted by the EnergyMeter so far, all phases.
+ */
+static uint64_t totalCharge() {
+    const EnergyLedger& ledger = EnergyMeter::ledger();
+    uint64_t charge = 0;
+    for (uint8_t i = 0; i < ENERGY_PHASE_COUNT; i++) charge += ledger.chargeNc[i];
+    return charge;
+}
+
+static const char* causeName(int cause) {
+    return WakeSource::kindName(WakeSource::resolve(cause));
+}
+
+int main(int argc, char** argv) {
+    SimOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--days N] [--drift PPM] [--alarm HH:MM] [--boot-ms MS] "
+                        "[--connect-ms MS] [--channel-ms MS] [--lease-ms MS] [--ntp-ms MS] [--dns-ms MS] "
+                        "[--outage START_H:HOURS] [--press OFFSET_S[:HOLD_MS]] [--offline] [--quiet] [--verbose]\n", argv[0]);
+        return 2;
+    }
+
+    setenv("TZ", "UTC0", 1);  // The firmware keeps local time as if it were UTC
+    tzset();
+    remove(TIME_JOURNAL_HOST_IMAGE);  // Fresh flash
+    Sim::setVerbose(options.verbose);
+    SimNetwork::configure(options.network);
+    Sim::powerOn(SIM_START_TIME * 1000000ULL, options.driftPpm);
+    SimUlp::setObserver(checkUlpRun);
+
+    const uint64_t end = (SIM_START_TIME + (uint64_t)(options.days * 86400.0)) * 1000000ULL;
+    if (options.press) {
+        // One press a day around the alarm
+        for (uint64_t alarm = firstAlarm(options, SIM_START_TIME); alarm * 1000000ULL < end; alarm += 86400ULL) {
+            int64_t at = (int64_t)alarm * 1000000LL + (int64_t)(options.pressOffset * 1e6);
+            if (at <= (int64_t)(SIM_START_TIME * 1000000ULL)) continue;
+            Sim::schedulePin(at, SWITCH_PIN, LOW);
+            Sim::schedulePin(at + options.pressMillis * 1000LL, SWITCH_PIN, HIGH);
+        }
+    }
+    SimSummary summary;
+    uint64_t nextAlarm = 0;
+    int cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    uint32_t stubWakes = 0;
+    bool ringing = false;  // Previous boot blinked the LED
+
+    if (options.rows) printf("boot,time,cause,stub_wakes,awake_ms,radio_ms,nvs_reads,nvs_writes,sleep_s,clock_error_ms,lateness_s\n");
+
+    const uint64_t outageBegin = (SIM_START_TIME + (uint64_t)(options.outageStart * 3600.0)) * 1000000ULL;
+    const uint64_t outageEnd = outageBegin + (uint64_t)(options.outageHours * 3600.0) * 1000000ULL;
+
+    while (Sim::trueMicros() < end) {
+        uint64_t bootTime = Sim::trueMicros();
+        bool outage = bootTime >= outageBegin && bootTime < outageEnd;
+        SimNetworkModel network = options.network;
+        network.available = options.network.available && !outage;
+        SimNetwork::configure(network);
+        uint64_t chargeBefore = totalCharge();
+        Sim::boot(cause);
+        Sim::advance((uint64_t)options.bootMillis * 1000ULL);
+
+        bool slept = false;
+        try {
+            setup();
+        } catch (const SimDeepSleep&) {
+            slept = true;
+        } catch (const SimRestart&) {
+            slept = false;
+        }
+        SimNetwork::shutdown();
+
+        SimCounters& counters = Sim::counters();
+        struct timeval clock;
+        bool clockSet = Sim::systemTime(&clock);
+        int64_t clockError = clockSet ? ((int64_t)clock.tv_sec * 1000000LL + clock.tv_usec) - (int64_t)Sim::trueMicros() : 0;
+        if (llabs(clockError) > summary.maxClockError) summary.maxClockError = llabs(clockError);
+
+        // A new ring starts with the first boot that blinks after a quiet one
+        while (nextAlarm != 0 && Sim::trueMicros() / 1000000ULL > nextAlarm + SIM_RING_WINDOW) {
+            summary.alarms++;  // Due and never rung
+            nextAlarm += 86400ULL;
+        }
+        bool ledRun = counters.ledOnEvents > 0;
+        char lateness[24] = "";
+        if (ledRun) {
+            summary.ledRuns++;
+            summary.ledAwakeMicros += counters.awakeMicros;
+            summary.ledIdleMicros += counters.idleMicros;
+        }
+        if (ledRun && !ringing && nextAlarm != 0) {
+            int64_t late = (int64_t)(counters.firstLedOn / 1000000ULL) - (int64_t)nextAlarm;
+            if (llabs(late) <= SIM_RING_WINDOW) {
+                summary.alarms++;
+                summary.rung++;
+                summary.sumLateness += late;
+                if (late > summary.maxLateness) summary.maxLateness = late;
+                snprintf(lateness, sizeof(lateness), "%lld", (long long)late);
+                nextAlarm += 86400ULL;
+            }
+        }
+        ringing = ledRun;
+
+        summary.boots++;
+        summary.stubWakes += stubWakes;
+        summary.awakeMicros += counters.awakeMicros;
+        summary.idleMicros += counters.idleMicros;
+        summary.radioMicros += counters.radioMicros;
+        summary.nvsReads += counters.nvsReads;
+        summary.nvsWrites += counters.nvsWrites;
+        summary.dnsLookups += counters.dnsLookups;
+        if (outage) {
+            summary.outageBoots++;
+            summary.outageRadioMicros += counters.radioMicros;
+            summary.outageChargeNc += totalCharge() - chargeBefore;
+        }
+
+        if (options.rows) {
+            time_t stamp = bootTime / 1000000ULL;
+            struct tm info;
+            gmtime_r(&stamp, &info);
+            char when[20];
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &info);
+            printf("%lu,%s,%s,%lu,%.1f,%.1f,%lu,%lu,%.0f,%.1f,%s\n",
+                   (unsigned long)summary.boots, when, causeName(cause), (unsigned long)stubWakes,
+                   counters.awakeMicros / 1000.0, counters.radioMicros / 1000.0,
+                   (unsigned long)counters.nvsReads, (unsigned long)counters.nvsWrites,
+                   slept ? Sim::wakeTimer() / 1e6 : 0.0, clockError / 1000.0, lateness);
+        }
+
+        if (!slept && cause == ESP_SLEEP_WAKEUP_UNDEFINED && nextAlarm == 0 && summary.boots == 1) {
+            nextAlarm = storeDailyAlarm(options, Sim::trueMicros() / 1000000ULL);  // First boot only set up the settings
+        }
+
+        Sim::resetCounters();
+        stubWakes = 0;
+        if (!slept) {
+            cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+            continue;
+        }
+        if (Sim::wakeTimer() == 0) {
+            fprintf(stderr, "Deep sleep without a wake source at boot %lu, stopping\n", (unsigned long)summary.boots);
+            break;
+        }
+
+        // Sleep, letting the wake stub absorb the timer wakes it can
+        cause = Sim::sleep(Sim::wakeTimer());
+        while (cause == ESP_SLEEP_WAKEUP_TIMER && Sim::trueMicros() < end &&
+               WakeStub::runOnHost(Sim::pin(SWITCH_PIN) == LOW || Sim::pin(PROG_SWITCH_PIN) == LOW)) {
+            Sim::advance(SIM_STUB_WAKE_MICROS);
+            cause = Sim::sleep(WakeStub::state().sleepTicks);
+            stubWakes++;
+        }
+        if (cause == ESP_SLEEP_WAKEUP_ULP) {
+            if (UlpWatch::reason() == UlpReason::Button) ulpCheck.buttonWakes++; else ulpCheck.deadlineWakes++;
+        }
+    }
+
+    double days = (Sim::trueMicros() - SIM_START_TIME * 1000000ULL) / 86400e6;
+    if (days <= 0) days = 1;
+    printf("\n# simulated %.2f days, drift %.1f ppm\n", days, options.driftPpm);
+    printf("# app boots %lu (%.1f/day), stub wakes %lu\n", (unsigned long)summary.boots, summary.boots / days, (unsigned long)summary.stubWakes);
+    printf("# awake %.1f s/day, light sleep %.1f s/day, radio on %.1f s/day\n", summary.awakeMicros / 1e6 / days,
+           summary.idleMicros / 1e6 / days, summary.radioMicros / 1e6 / days);
+    printf("# NVS reads %.1f/day, writes %.1f/day\n", summary.nvsReads / days, summary.nvsWrites / days);
+    printf("# DNS lookups %lu\n", (unsigned long)summary.dnsLookups);
+    const WifiAttemptLog& wifiLog = WifiLease::log();
+    for (uint8_t mode = 0; mode <= (uint8_t)WifiConnectMode::Lease; mode++) {
+        if (wifiLog.attempts[mode] == 0) continue;
+        printf("# Wi-Fi %-7s connects %lu (%lu failed), avg %.0f ms\n", WifiLease::modeName((WifiConnectMode)mode),
+               (unsigned long)wifiLog.attempts[mode], (unsigned long)wifiLog.failures[mode],
+               (double)wifiLog.millis[mode] / wifiLog.attempts[mode]);
+    }
+    printf("# alarms due %lu, rung %lu, LED runs %lu\n", (unsigned long)summary.alarms, (unsigned long)summary.rung, (unsigned long)summary.ledRuns);
+    if (summary.ledRuns > 0) {
+        uint64_t ledMicros = summary.ledAwakeMicros + summary.ledIdleMicros;
+        printf("# LED runs: CPU awake %.1f%% (%.1f s awake, %.1f s light sleep per run)\n",
+               ledMicros ? 100.0 * summary.ledAwakeMicros / ledMicros : 0.0,
+               summary.ledAwakeMicros / 1e6 / summary.ledRuns, summary.ledIdleMicros / 1e6 / summary.ledRuns);
+    }
+    if (summary.rung > 0) {
+        printf("# lateness avg %.1f s, max %lld s\n", (double)summary.sumLateness / summary.rung, (long long)summary.maxLateness);
+    }
+    printf("# max clock error %.1f ms\n", summary.maxClockError / 1000.0);
+
+    // Wake sources and button actions, as counted by the firmware
+    const WakeStats& wakes = WakeSource::stats();
+    printf("# wakes:");
+    for (uint8_t i = 0; i < WAKE_KIND_COUNT; i++) {
+        if (wakes.wakes[i] != 0) printf(" %s %lu", WakeSource::kindName((WakeKind)i), (unsigned long)wakes.wakes[i]);
+    }
+    printf("\n# actions:");
+    for (uint8_t i = 0; i < WAKE_ACTION_COUNT; i++) {
+        if (wakes.actions[i] != 0) printf(" %s %lu", WakeSource::actionName((WakeAction)i), (unsigned long)wakes.actions[i]);
+    }
+    printf("\n");
+    if (wakes.latencySamples > 0) {
+        printf("# button wake to action: avg %lu ms, max %lu ms (boot included)\n",
+               (unsigned long)(wakes.latencySumMs / wakes.latencySamples), (unsigned long)wakes.latencyMaxMs);
+    }
+    if (ulpCheck.runs > 0) {
+        printf("# ulp: %llu runs, wakes %lu deadline %lu button, model mismatches %llu\n", (unsigned long long)ulpCheck.runs,
+               (unsigned long)ulpCheck.deadlineWakes, (unsigned long)ulpCheck.buttonWakes, (unsigned long long)ulpCheck.mismatches);
+    }
+    if (options.outageHours > 0) {
+        printf("# router outage %.1f h: %lu boots, radio on %.1f s, %.3f mAh\n", options.outageHours,
+               (unsigned long)summary.outageBoots, summary.outageRadioMicros / 1e6, summary.outageChargeNc / 3.6e9);
+    }
+
+    // Same accounting as on the device, over the virtual RTC timer
+    EnergyReport energy = EnergyMeter::report();
+    const EnergyLedger& ledger = EnergyMeter::ledger();
+    printf("# energy %.3f mAh/day, battery %.0f days (%lu mAh)\n", energy.mahPerDay, energy.batteryDays,
+           (unsigned long)EnergyMeter::model().batteryMah);
+    for (uint8_t i = 0; i < ENERGY_PHASE_COUNT; i++) {
+        if (ledger.phaseMicros[i] == 0) continue;
+        printf("#   %-9s %10.1f s/day %9.4f mAh/day\n", EnergyMeter::phaseName((EnergyPhase)i),
+               ledger.phaseMicros[i] / 1e6 / days, ledger.chargeNc[i] / 3.6e9 / days);
+    }
+
+    // Phase timings of the last application boots
+    const WakeProfileRing& ring = WakeProfiler::ring();
+    printf("# profile of the last %u boots (min/avg/max ms)\n", (unsigned)ring.count);
+    for (uint8_t i = 0; i < PROFILE_POINT_COUNT; i++) {
+        ProfileStats stats = WakeProfiler::stats((ProfilePoint)i);
+        if (stats.samples == 0) continue;
+        printf("#   %-12s %3u %9.1f %9.1f %9.1f\n", WakeProfiler::pointName((ProfilePoint)i), (unsigned)stats.samples,
+               stats.minMicros / 1000.0, stats.avgMicros / 1000.0, stats.maxMicros / 1000.0);
+    }
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,191 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+/**
+ * @file Arduino.h
+ * @brief Subset of the Arduino core used by the firmware, on virtual hardware.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <functional>
+#include "SimPlatform.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+/**
+ * @brief Arduino `String` backed by std::string.
+ */
+class String {
+public:
+    String() {}
+    String(const char* text) : _text(text ? text : "") {}
+    String(const std::string& text) : _text(text) {}
+    explicit String(char c) : _text(1, c) {}
+    explicit String(int value) : _text(std::to_string(value)) {}
+    explicit String(unsigned int value) : _text(std::to_string(value)) {}
+    explicit String(long value) : _text(std::to_string(value)) {}
+    explicit String(unsigned long value) : _text(std::to_string(value)) {}
+    explicit String(long long value) : _text(std::to_string(value)) {}
+    explicit String(unsigned long long value) : _text(std::to_string(value)) {}
+    explicit String(double value, unsigned int decimals = 2) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+        _text = buffer;
+    }
+
+    const char* c_str() const { return _text.c_str(); }
+    unsigned int length() const { return (unsigned int)_text.length(); }
+    bool isEmpty() const { return _text.empty(); }
+    String substring(unsigned int from) const { return from < _text.length() ? _text.substr(from) : std::string(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) { unsigned int t = from; from = to; to = t; }
+        if (from >= _text.length()) return String();
+        return _text.substr(from, to - from);
+    }
+    long toInt() const { return strtol(_text.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(_text.c_str(), nullptr); }
+    int indexOf(char c) const { size_t at = _text.find(c); return at == std::string::npos ? -1 : (int)at; }
+    char charAt(unsigned int index) const { return index < _text.length() ? _text[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    void trim() {
+        size_t first = _text.find_first_not_of(" \t\r\n");
+        size_t last = _text.find_last_not_of(" \t\r\n");
+        _text = first == std::string::npos ? std::string() : _text.substr(first, last - first + 1);
+    }
+
+    bool concat(const String& other) { _text += other._text; return true; }
+    String& operator+=(const String& other) { _text += other._text; return *this; }
+    String& operator+=(const char* other) { _text += other; return *this; }
+    String& operator+=(char c) { _text += c; return *this; }
+
+    bool operator==(const String& other) const { return _text == other._text; }
+    bool operator==(const char* other) const { return _text == other; }
+    bool operator!=(const String& other) const { return _text != other._text; }
+    bool operator!=(const char* other) const { return _text != other; }
+
+    friend String operator+(const String& a, const String& b) { return a._text + b._text; }
+    friend String operator+(const String& a, const char* b) { return a._text + b; }
+    friend String operator+(const char* a, const String& b) { return a + b._text; }
+
+private:
+    std::string _text;
+};
+
+/**
+ * @brief IPv4 address, packed with the first octet in the low byte.
+ */
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : _address((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+    IPAddress(uint32_t address) : _address(address) {}
+
+    operator uint32_t() const { return _address; }
+    uint8_t operator[](int index) const { return (_address >> (8 * index)) & 0xFF; }
+    String toString() const {
+        char text[16];
+        snprintf(text, sizeof(text), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return String(text);
+    }
+
+private:
+    uint32_t _address = 0;
+};
+
+/**
+ * @brief Serial port; output goes to stdout when the simulator is verbose.
+ */
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+    void flush() { if (Sim::verbose()) fflush(stdout); }
+    int available() { return 0; }
+    String readStringUntil(char) { return String(); }
+    void onReceive(std::function<void(void)>, bool = false) {}  // No input on the host
+
+    size_t print(const char* text) { return emit(text); }
+    size_t print(const String& text) { return emit(text.c_str()); }
+    size_t print(char c) { char text[2] = {c, 0}; return emit(text); }
+    size_t print(int value) { return print((long long)value); }
+    size_t print(unsigned int value) { return print((unsigned long long)value); }
+    size_t print(long value) { return print((long long)value); }
+    size_t print(unsigned long value) { return print((unsigned long long)value); }
+    size_t print(long long value) { return emit(std::to_string(value).c_str()); }
+    size_t print(unsigned long long value) { return emit(std::to_string(value).c_str()); }
+    size_t print(double value) { return emit(String(value).c_str()); }
+
+    size_t println() { return emit("\n"); }
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    size_t emit(const char* text);
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * @brief `ESP` object; restart() unwinds to the simulator.
+ */
+class EspClass {
+public:
+    [[noreturn]] void restart() { throw SimRestart(); }
+};
+
+extern EspClass ESP;
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+// newlib has strlcpy(); glibc only since 2.38
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t n = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return length;
+}
+#endif
+
+inline unsigned long millis() { return (unsigned long)Sim::millis(); }
+inline unsigned long micros() { return (unsigned long)(Sim::millis() * 1000UL); }
+inline void delay(unsigned long ms) { Sim::advance((uint64_t)ms * 1000ULL); }
+inline void delayMicroseconds(unsigned int us) { Sim::advance(us); }
+inline void yield() {}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t level) { Sim::writePin(pin, level); }
+inline int digitalRead(uint8_t pin) { return Sim::pin(pin); }
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterrupt(int pin, void (*handler)(), int mode) { Sim::attachInterrupt(pin, handler, mode); }
+inline void detachInterrupt(int pin) { Sim::attachInterrupt(pin, nullptr, 0); }
+
+/**
+ * @brief Local time from the system clock (fails before the clock was set).
+ */
+inline bool getLocalTime(struct tm* info, uint32_t ms = 5000) {
+    (void)ms;
+    struct timeval tv;
+    if (!Sim::systemTime(&tv)) return false;
+    time_t now = tv.tv_sec;
+    localtime_r(&now, info);
+    return info->tm_year > (2016 - 1900);
+}
+
+#endif // SIM_ARDUINO_H
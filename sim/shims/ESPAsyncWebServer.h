@@ -0,0 +1,20 @@
+#ifndef SIM_ESP_ASYNC_WEB_SERVER_H
+#define SIM_ESP_ASYNC_WEB_SERVER_H
+/**
+ * @file ESPAsyncWebServer.h
+ * @brief Declarations needed by WiFiManager.h; the web portal is not simulated.
+ */
+
+#include <stdint.h>
+
+class AsyncWebServerRequest;
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) : _port(port) {}
+
+private:
+    uint16_t _port;
+};
+
+#endif // SIM_ESP_ASYNC_WEB_SERVER_H
@@ -0,0 +1,123 @@
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+/**
+ * @file Preferences.h
+ * @brief NVS key/value store kept in host memory.
+ *
+ * The store survives simulated deep sleep and restarts like flash does and
+ * counts every access in `Sim::counters()`. As in NVS, a read with a
+ * different type than the stored value returns the default.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+/**
+ * @brief One stored value.
+ */
+struct SimNvsValue {
+    uint8_t type;                ///< SimNvsType of the value
+    std::vector<uint8_t> data;   ///< Raw bytes
+};
+
+enum SimNvsType : uint8_t { SIM_NVS_BOOL, SIM_NVS_INT, SIM_NVS_UINT, SIM_NVS_U64, SIM_NVS_FLOAT, SIM_NVS_STRING, SIM_NVS_BLOB };
+
+typedef std::map<std::string, std::map<std::string, SimNvsValue>> SimNvsStore;
+
+SimNvsStore& simNvsStore();  // All namespaces (flash contents)
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        _space = &simNvsStore()[name];
+        _readOnly = readOnly;
+        return true;
+    }
+    void end() { _space = nullptr; }
+
+    bool clear() {
+        if (!writable()) return false;
+        Sim::countNvsWrite();
+        _space->clear();
+        return true;
+    }
+    bool remove(const char* key) {
+        if (!writable()) return false;
+        Sim::countNvsWrite();
+        return _space->erase(key) > 0;
+    }
+    bool isKey(const char* key) {
+        if (_space == nullptr) return false;
+        Sim::countNvsRead();
+        return _space->count(key) > 0;
+    }
+
+    size_t putBool(const char* key, bool value) { return put(key, SIM_NVS_BOOL, &value, sizeof(value)); }
+    size_t putInt(const char* key, int32_t value) { return put(key, SIM_NVS_INT, &value, sizeof(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return put(key, SIM_NVS_UINT, &value, sizeof(value)); }
+    size_t putULong64(const char* key, uint64_t value) { return put(key, SIM_NVS_U64, &value, sizeof(value)); }
+    size_t putFloat(const char* key, float value) { return put(key, SIM_NVS_FLOAT, &value, sizeof(value)); }
+    size_t putString(const char* key, const char* value) { return put(key, SIM_NVS_STRING, value, strlen(value)); }
+    size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+    size_t putBytes(const char* key, const void* value, size_t length) { return put(key, SIM_NVS_BLOB, value, length); }
+
+    bool getBool(const char* key, bool defaultValue = false) { return get(key, SIM_NVS_BOOL, defaultValue); }
+    int32_t getInt(const char* key, int32_t defaultValue = 0) { return get(key, SIM_NVS_INT, defaultValue); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return get(key, SIM_NVS_UINT, defaultValue); }
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0) { return get(key, SIM_NVS_U64, defaultValue); }
+    float getFloat(const char* key, float defaultValue = NAN) { return get(key, SIM_NVS_FLOAT, defaultValue); }
+    String getString(const char* key, const String defaultValue = String()) {
+        const SimNvsValue* value = find(key, SIM_NVS_STRING);
+        if (value == nullptr) return defaultValue;
+        return String(std::string(value->data.begin(), value->data.end()));
+    }
+    size_t getBytesLength(const char* key) {
+        const SimNvsValue* value = find(key, SIM_NVS_BLOB);
+        return value ? value->data.size() : 0;
+    }
+    size_t getBytes(const char* key, void* buffer, size_t maxLength) {
+        const SimNvsValue* value = find(key, SIM_NVS_BLOB);
+        if (value == nullptr || value->data.size() > maxLength) return 0;
+        memcpy(buffer, value->data.data(), value->data.size());
+        return value->data.size();
+    }
+
+private:
+    bool writable() const { return _space != nullptr && !_readOnly; }
+
+    size_t put(const char* key, uint8_t type, const void* data, size_t length) {
+        if (!writable()) return 0;
+        Sim::countNvsWrite();
+        SimNvsValue& value = (*_space)[key];
+        value.type = type;
+        value.data.assign((const uint8_t*)data, (const uint8_t*)data + length);
+        return length;
+    }
+
+    const SimNvsValue* find(const char* key, uint8_t type) {
+        if (_space == nullptr) return nullptr;
+        Sim::countNvsRead();
+        auto it = _space->find(key);
+        if (it == _space->end() || it->second.type != type) return nullptr;
+        return &it->second;
+    }
+
+    template <typename T>
+    T get(const char* key, uint8_t type, T defaultValue) {
+        const SimNvsValue* value = find(key, type);
+        if (value == nullptr || value->data.size() != sizeof(T)) return defaultValue;
+        T result;
+        memcpy(&result, value->data.data(), sizeof(T));
+        return result;
+    }
+
+    std::map<std::string, SimNvsValue>* _space = nullptr;
+    bool _readOnly = false;
+};
+
+#endif // SIM_PREFERENCES_H
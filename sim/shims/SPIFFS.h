@@ -0,0 +1,8 @@
+#ifndef SIM_SPIFFS_H
+#define SIM_SPIFFS_H
+/**
+ * @file SPIFFS.h
+ * @brief Placeholder; the web portal is not part of the native build.
+ */
+
+#endif // SIM_SPIFFS_H
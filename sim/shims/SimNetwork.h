@@ -0,0 +1,48 @@
+#ifndef SIM_NETWORK_H
+#define SIM_NETWORK_H
+/**
+ * @file SimNetwork.h
+ * @brief Timing model of the Wi-Fi station, DNS and the NTP servers.
+ *
+ * Association and DNS lookups take a fixed amount of virtual time with the
+ * radio on. Association is fastest with the cached access point and address
+ * (`leaseMillis`), slower with the cached access point and DHCP
+ * (`channelMillis`) and slowest with a full scan (`connectMillis`); an
+ * unreachable network costs the whole connect timeout. Every host name resolved gets its own NTP stand-in server: a
+ * real UDP socket on the loopback interface that answers SNTP requests
+ * from the reference clock. Server `i` (in resolution order) answers after
+ * `(i + 1) * ntpMillis` of virtual time, so the servers have distinct
+ * round-trip delays.
+ *
+ * The reference clock is kept in local time; the stand-in servers remove
+ * `TIMEOFFSET` and answer in UTC like real ones.
+ */
+
+#include <stdint.h>
+
+/**
+ * @brief Tunables of the network model.
+ */
+struct SimNetworkModel {
+    uint32_t connectMillis;  ///< Scan + association + DHCP time
+    uint32_t channelMillis;  ///< Association on a known channel + DHCP time
+    uint32_t leaseMillis;    ///< Association on a known channel with a static address
+    uint32_t ntpMillis;      ///< Round trip to the fastest NTP server
+    uint32_t dnsMillis;      ///< One DNS lookup
+    bool available;          ///< Access point and servers reachable
+};
+
+class SimNetwork {
+public:
+    static void configure(const SimNetworkModel& model);
+    static const SimNetworkModel& model();
+    static bool connect(uint32_t millis, uint32_t timeoutMillis);  // Associate (radio on)
+    static bool isConnected();
+    static bool resolve(const char* host, uint32_t* ip);  // DNS lookup of a stand-in server
+    static bool route(uint32_t ip, uint16_t port, uint16_t* localPort);  // Loopback port of a server address
+    static uint32_t address(uint16_t localPort);  // Server address of a loopback port (0 if none)
+    static void serve();  // Let the stand-in servers answer what is due
+    static void shutdown();  // Radio off (deep sleep, restart)
+};
+
+#endif // SIM_NETWORK_H
@@ -0,0 +1,100 @@
+#ifndef SIM_PLATFORM_H
+#define SIM_PLATFORM_H
+/**
+ * @file SimPlatform.h
+ * @brief Virtual hardware behind the native (host) build.
+ *
+ * This header is force-included into every translation unit of
+ * `env:native` (`-include SimPlatform.h`). It owns the virtual time base
+ * and the counters the simulator reports:
+ *
+ * - a reference ("true") clock, in local Unix microseconds;
+ * - the device RTC timer, which runs `driftPpm` fast or slow against the
+ *   reference and keeps counting through deep sleep;
+ * - the system clock (`settimeofday()`/`getLocalTime()`), an offset on the
+ *   RTC timer like in ESP-IDF;
+ * - GPIO levels and interrupts, input changes scheduled by the scenario
+ *   (button presses), the deep-sleep timer, the ext0/ext1 wake pins and
+ *   the wake cause;
+ * - the ULP coprocessor (`SimUlp`), which runs its program during deep sleep;
+ * - awake time, light-sleep time, radio-on time and NVS operation counters.
+ *
+ * Time only moves when the firmware waits (`delay()`, Wi-Fi/NTP models),
+ * blocks on an event group (light sleep) or sleeps, so every run is
+ * deterministic. A scheduled input change that runs an interrupt handler
+ * ends a light sleep; one that reaches a wake pin's level ends a deep sleep. `esp_deep_sleep_start()` and
+ * `ESP.restart()` throw `SimDeepSleep`/`SimRestart` to unwind back into the
+ * simulator loop, which then boots the firmware again.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <sys/time.h>
+
+#define RTC_DATA_ATTR   // Plain static storage: survives simulated deep sleep
+#define RTC_IRAM_ATTR
+#define IRAM_ATTR
+
+#define SIM_GPIO_COUNT 40
+
+struct SimDeepSleep {};  ///< Thrown by esp_deep_sleep_start()
+struct SimRestart {};    ///< Thrown by ESP.restart()
+
+/**
+ * @brief Counters accumulated by the virtual hardware.
+ */
+struct SimCounters {
+    uint64_t awakeMicros;   ///< Time spent running the application
+    uint64_t idleMicros;    ///< Time the application was blocked (light sleep)
+    uint64_t radioMicros;   ///< Time the radio was on
+    uint32_t nvsReads;      ///< Preferences reads (including isKey)
+    uint32_t nvsWrites;     ///< Preferences writes, removes and clears
+    uint32_t dnsLookups;    ///< Host names resolved over the network
+    uint32_t ledOnEvents;   ///< Rising edges on LED_GREEN_PIN
+    uint64_t firstLedOn;    ///< Reference time of the first LED rising edge (0 = none)
+};
+
+class Sim {
+public:
+    static void powerOn(uint64_t trueMicros, double driftPpm);  // Reset every block, RTC timer at 0
+    static void boot(int wakeCause);  // Start an application run (millis() restarts at 0)
+    static void advance(uint64_t micros);  // Let time pass while awake
+    static void idle(uint64_t micros);  // Let time pass in light sleep (blocked on an event group)
+    static int sleep(uint64_t rtcMicros);  // Deep sleep (RTC timer units) until the timer, a wake pin or the ULP, returns the wake cause
+
+    static uint64_t trueMicros();  // Reference local time
+    static uint64_t rtcMicros();  // Device RTC timer
+    static uint64_t millis();  // Milliseconds since boot (device clock)
+    static bool systemTime(struct timeval* tv);  // System clock; false until set
+    static void setSystemTime(const struct timeval* tv);
+
+    static void setRadio(bool on);
+    static bool radio();
+    static void setPin(int pin, int level);  // Drive an input pin (runs its interrupt handler on a matching edge)
+    static int pin(int pin);
+    static void writePin(int pin, int level);  // Output written by the firmware
+    static void attachInterrupt(int pin, void (*handler)(), int mode);  // attachInterrupt()
+    static void schedulePin(uint64_t trueMicros, int pin, int level);  // Drive an input pin at a reference time
+
+    static void setWakeTimer(uint64_t micros);  // esp_sleep_enable_timer_wakeup()
+    static uint64_t wakeTimer();
+    static void setExt0Wake(int pin, int level);  // esp_sleep_enable_ext0_wakeup()
+    static void setExt1Wake(uint64_t mask, bool anyHigh);  // esp_sleep_enable_ext1_wakeup()
+    static int wakeCause();
+
+    static void countNvsRead();
+    static void countNvsWrite();
+    static SimCounters& counters();
+    static void resetCounters();
+
+    static void setVerbose(bool verbose);  // Echo Serial output to stdout
+    static bool verbose();
+};
+
+int simSettimeofday(const struct timeval* tv, const void* tz);
+int simGettimeofday(struct timeval* tv, void* tz);
+#define settimeofday simSettimeofday
+#define gettimeofday simGettimeofday
+
+#endif // SIM_PLATFORM_H
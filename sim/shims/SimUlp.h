@@ -0,0 +1,65 @@
+#ifndef SIM_ULP_H
+#define SIM_ULP_H
+/**
+ * @file SimUlp.h
+ * @brief ULP FSM coprocessor and the RTC registers it reads, on virtual hardware.
+ *
+ * Programs built with the `esp32/ulp.h` macros are loaded label-resolved
+ * and interpreted instruction by instruction with 16-bit registers and the
+ * zero/overflow ALU flags of the real FSM. While the ULP timer runs, the
+ * simulator executes the program every wake-up period of deep sleep (in RTC
+ * timer units); `I_WAKE` ends the sleep with ESP_SLEEP_WAKEUP_ULP when ULP
+ * wakes are enabled, `I_END` stops the timer.
+ *
+ * The register file covers what the firmware uses: the RTC timer (latched
+ * by `RTC_CNTL_TIME_UPDATE`, counting a 150 kHz slow clock), its
+ * calibration, the RTC IO inputs (from the GPIO levels), the ULP timer
+ * enable and the ready-for-wakeup flag (always set during deep sleep).
+ *
+ * An observer sees every run with the shared memory before and after it,
+ * so the simulator can check the program against its host model.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIM_ULP_SLOW_CLK_HZ 150000  ///< RTC slow clock (RC oscillator)
+#define SIM_ULP_MEM_WORDS 2048      ///< RTC slow memory (8 KB)
+#define SIM_ULP_RESERVED_WORDS 128  ///< Reserved for the ULP (CONFIG_ULP_COPROC_RESERVE_MEM = 512)
+
+/**
+ * @brief One ULP run, as seen by the observer.
+ */
+struct SimUlpRun {
+    uint32_t ticks;         ///< Low 32 bits of the RTC timer during the run
+    uint16_t levels;        ///< RTC IO inputs 0 to 15
+    const uint32_t* before; ///< Reserved RTC slow memory before the run
+    const uint32_t* after;  ///< Reserved RTC slow memory after the run
+    bool woke;              ///< The run executed I_WAKE
+};
+
+typedef void (*SimUlpObserver)(const SimUlpRun& run);
+
+struct ulp_insn_t;
+
+class SimUlp {
+public:
+    static void reset();  // Power-on: memory, program and timer cleared
+    static void boot();  // Main CPU reset: ULP wake disabled (the ULP itself keeps running)
+    static bool load(uint32_t address, const ulp_insn_t* program, size_t* count);  // ulp_process_macros_and_load()
+    static bool start(uint32_t entry);  // ulp_run()
+    static void setPeriod(uint32_t micros);  // ulp_set_wakeup_period()
+    static void enableWake();  // esp_sleep_enable_ulp_wakeup()
+    static bool running();  // ULP timer enabled
+    static uint64_t periodMicros();
+    static bool run();  // Execute the program once; true if it woke the main CPU
+    static void setObserver(SimUlpObserver observer);
+
+    static uint32_t* memory();  // RTC_SLOW_MEM
+    static uint32_t readRegister(uint32_t address);
+    static void writeRegister(uint32_t address, uint32_t value);
+    static uint64_t ticks();  // RTC timer in slow clock ticks
+    static uint32_t calibration();  // Slow clock period (microseconds, Q13.19)
+};
+
+#endif // SIM_ULP_H
@@ -0,0 +1,20 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+/**
+ * @file WiFi.h
+ * @brief Wi-Fi driver subset; the station and DNS are modelled by SimNetwork.
+ */
+
+#include "Arduino.h"
+
+typedef enum { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+
+class WiFiClass {
+public:
+    int hostByName(const char* host, IPAddress& result);  // Resolve through the network model
+    wifi_mode_t getMode() { return Sim::radio() ? WIFI_STA : WIFI_OFF; }
+};
+
+extern WiFiClass WiFi;
+
+#endif // SIM_WIFI_H
@@ -0,0 +1,44 @@
+#ifndef SIM_WIFIUDP_H
+#define SIM_WIFIUDP_H
+/**
+ * @file WiFiUdp.h
+ * @brief UDP socket on a real loopback socket.
+ *
+ * Datagrams to the addresses handed out by `WiFi.hostByName()` are routed
+ * to the local stand-in servers of `SimNetwork`, so the firmware exchanges
+ * real packets with them.
+ */
+
+#include "Arduino.h"
+
+class WiFiUDP {
+public:
+    WiFiUDP() {}
+    ~WiFiUDP() { stop(); }
+    WiFiUDP(const WiFiUDP&) = delete;
+    WiFiUDP& operator=(const WiFiUDP&) = delete;
+
+    uint8_t begin(uint16_t port);  // The local port is chosen by the host
+    void stop();
+
+    int beginPacket(IPAddress ip, uint16_t port);
+    size_t write(const uint8_t* buffer, size_t size);
+    int endPacket();
+
+    int parsePacket();  // Non-blocking; size of the next datagram or 0
+    int read(uint8_t* buffer, size_t length);
+    IPAddress remoteIP() const { return _remoteIp; }
+    uint16_t remotePort() const { return _remotePort; }
+
+private:
+    int _fd = -1;
+    IPAddress _txIp;
+    uint16_t _txPort = 0;
+    std::string _tx;
+    std::string _rx;
+    size_t _rxRead = 0;
+    IPAddress _remoteIp;
+    uint16_t _remotePort = 0;
+};
+
+#endif // SIM_WIFIUDP_H
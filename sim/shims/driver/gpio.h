@@ -0,0 +1,22 @@
+#ifndef SIM_DRIVER_GPIO_H
+#define SIM_DRIVER_GPIO_H
+/**
+ * @file gpio.h
+ * @brief GPIO driver subset (light-sleep wake configuration, no-op on the host).
+ */
+
+typedef int gpio_num_t;
+
+typedef enum {
+    GPIO_INTR_DISABLE,
+    GPIO_INTR_POSEDGE,
+    GPIO_INTR_NEGEDGE,
+    GPIO_INTR_ANYEDGE,
+    GPIO_INTR_LOW_LEVEL,
+    GPIO_INTR_HIGH_LEVEL,
+} gpio_int_type_t;
+
+inline int gpio_wakeup_enable(gpio_num_t, gpio_int_type_t) { return 0; }
+inline int gpio_wakeup_disable(gpio_num_t) { return 0; }
+
+#endif // SIM_DRIVER_GPIO_H
@@ -0,0 +1,28 @@
+#ifndef SIM_DRIVER_RTC_IO_H
+#define SIM_DRIVER_RTC_IO_H
+/**
+ * @file rtc_io.h
+ * @brief RTC IO driver (pin configuration is a no-op on the host).
+ */
+
+#include <stdint.h>
+#include "gpio.h"
+
+typedef enum { RTC_GPIO_MODE_INPUT_ONLY, RTC_GPIO_MODE_OUTPUT_ONLY, RTC_GPIO_MODE_INPUT_OUTPUT } rtc_gpio_mode_t;
+
+/**
+ * @brief RTC IO number of a GPIO (ESP32 mapping), -1 if the pin is not an RTC IO.
+ */
+inline int rtc_io_number_get(gpio_num_t pin) {
+    static const int8_t map[40] = {11, -1, 12, -1, 10, -1, -1, -1, -1, -1, -1, -1, 15, 14, 16, 13, -1, -1, -1, -1,
+                                   -1, -1, -1, -1, -1, 6, 7, 17, -1, -1, -1, -1, 9, 8, 4, 5, 0, 1, 2, 3};
+    return (pin >= 0 && pin < 40) ? map[pin] : -1;
+}
+inline bool rtc_gpio_is_valid_gpio(gpio_num_t pin) { return rtc_io_number_get(pin) >= 0; }
+inline int rtc_gpio_init(gpio_num_t) { return 0; }
+inline int rtc_gpio_deinit(gpio_num_t) { return 0; }
+inline int rtc_gpio_set_direction(gpio_num_t, rtc_gpio_mode_t) { return 0; }
+inline int rtc_gpio_pullup_en(gpio_num_t) { return 0; }
+inline int rtc_gpio_pulldown_dis(gpio_num_t) { return 0; }
+
+#endif // SIM_DRIVER_RTC_IO_H
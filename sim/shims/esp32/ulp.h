@@ -0,0 +1,86 @@
+#ifndef SIM_ESP32_ULP_H
+#define SIM_ESP32_ULP_H
+/**
+ * @file ulp.h
+ * @brief ULP FSM instruction macros and loader, interpreted by SimUlp.
+ *
+ * Same macro names and arguments as ESP-IDF; the instructions are decoded
+ * fields instead of the packed 32-bit words, which only SimUlp reads.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SimUlp.h"
+#include "soc/soc.h"
+
+#define R0 0
+#define R1 1
+#define R2 2
+#define R3 3
+
+#define RTC_SLOW_MEM (SimUlp::memory())
+
+/**
+ * @brief Operations of the interpreted instruction set.
+ */
+enum SimUlpOp : uint8_t {
+    SIM_ULP_MOVI, SIM_ULP_MOVR, SIM_ULP_ADDI, SIM_ULP_SUBI, SIM_ULP_ADDR, SIM_ULP_SUBR, SIM_ULP_ANDR, SIM_ULP_ORR,
+    SIM_ULP_LD, SIM_ULP_ST, SIM_ULP_RD_REG, SIM_ULP_WR_REG,
+    SIM_ULP_LABEL, SIM_ULP_BX, SIM_ULP_BXZ, SIM_ULP_BXF, SIM_ULP_BL, SIM_ULP_BGE,
+    SIM_ULP_WAKE, SIM_ULP_HALT
+};
+
+/**
+ * @brief One instruction or macro (label, branch to label).
+ */
+struct ulp_insn_t {
+    uint8_t op;      ///< SimUlpOp
+    uint8_t rd;      ///< Destination (or value) register
+    uint8_t rs1;     ///< First source (or address) register
+    uint8_t rs2;     ///< Second source register
+    int32_t imm;     ///< Immediate, memory offset, branch threshold or register value
+    uint32_t label;  ///< Label number (labels and branches)
+    uint32_t reg;    ///< Peripheral register address (RD_REG/WR_REG)
+    uint8_t low;     ///< First bit of the register field
+    uint8_t high;    ///< Last bit of the register field
+};
+
+#define SIM_ULP_INSN(op, rd, rs1, rs2, imm, label, reg, low, high) \
+    { (uint8_t)(op), (uint8_t)(rd), (uint8_t)(rs1), (uint8_t)(rs2), (int32_t)(imm), (uint32_t)(label), (uint32_t)(reg), (uint8_t)(low), (uint8_t)(high) }
+
+#define I_MOVI(reg_dest, imm_) SIM_ULP_INSN(SIM_ULP_MOVI, reg_dest, 0, 0, imm_, 0, 0, 0, 0)
+#define I_MOVR(reg_dest, reg_src) SIM_ULP_INSN(SIM_ULP_MOVR, reg_dest, reg_src, 0, 0, 0, 0, 0, 0)
+#define I_ADDI(reg_dest, reg_src, imm_) SIM_ULP_INSN(SIM_ULP_ADDI, reg_dest, reg_src, 0, imm_, 0, 0, 0, 0)
+#define I_SUBI(reg_dest, reg_src, imm_) SIM_ULP_INSN(SIM_ULP_SUBI, reg_dest, reg_src, 0, imm_, 0, 0, 0, 0)
+#define I_ADDR(reg_dest, reg_src1, reg_src2) SIM_ULP_INSN(SIM_ULP_ADDR, reg_dest, reg_src1, reg_src2, 0, 0, 0, 0, 0)
+#define I_SUBR(reg_dest, reg_src1, reg_src2) SIM_ULP_INSN(SIM_ULP_SUBR, reg_dest, reg_src1, reg_src2, 0, 0, 0, 0, 0)
+#define I_ANDR(reg_dest, reg_src1, reg_src2) SIM_ULP_INSN(SIM_ULP_ANDR, reg_dest, reg_src1, reg_src2, 0, 0, 0, 0, 0)
+#define I_ORR(reg_dest, reg_src1, reg_src2) SIM_ULP_INSN(SIM_ULP_ORR, reg_dest, reg_src1, reg_src2, 0, 0, 0, 0, 0)
+#define I_LD(reg_dest, reg_addr, offset_) SIM_ULP_INSN(SIM_ULP_LD, reg_dest, reg_addr, 0, offset_, 0, 0, 0, 0)
+#define I_ST(reg_val, reg_addr, offset_) SIM_ULP_INSN(SIM_ULP_ST, reg_val, reg_addr, 0, offset_, 0, 0, 0, 0)
+#define I_RD_REG(reg, low_bit, high_bit) SIM_ULP_INSN(SIM_ULP_RD_REG, 0, 0, 0, 0, 0, reg, low_bit, high_bit)
+#define I_WR_REG(reg, low_bit, high_bit, val) SIM_ULP_INSN(SIM_ULP_WR_REG, 0, 0, 0, val, 0, reg, low_bit, high_bit)
+#define READ_RTC_REG(rtc_reg, low_bit, bit_width) I_RD_REG(rtc_reg, low_bit, (low_bit) + (bit_width) - 1)
+#define WRITE_RTC_REG(rtc_reg, low_bit, bit_width, value) I_WR_REG(rtc_reg, low_bit, (low_bit) + (bit_width) - 1, value)
+#define I_WAKE() SIM_ULP_INSN(SIM_ULP_WAKE, 0, 0, 0, 0, 0, 0, 0, 0)
+#define I_HALT() SIM_ULP_INSN(SIM_ULP_HALT, 0, 0, 0, 0, 0, 0, 0, 0)
+#define I_END() WRITE_RTC_REG(RTC_CNTL_STATE0_REG, RTC_CNTL_ULP_CP_SLP_TIMER_EN_S, 1, 0)
+
+#define M_LABEL(label_num) SIM_ULP_INSN(SIM_ULP_LABEL, 0, 0, 0, 0, label_num, 0, 0, 0)
+#define M_BX(label_num) SIM_ULP_INSN(SIM_ULP_BX, 0, 0, 0, 0, label_num, 0, 0, 0)
+#define M_BXZ(label_num) SIM_ULP_INSN(SIM_ULP_BXZ, 0, 0, 0, 0, label_num, 0, 0, 0)
+#define M_BXF(label_num) SIM_ULP_INSN(SIM_ULP_BXF, 0, 0, 0, 0, label_num, 0, 0, 0)
+#define M_BL(label_num, imm_value) SIM_ULP_INSN(SIM_ULP_BL, 0, 0, 0, imm_value, label_num, 0, 0, 0)
+#define M_BGE(label_num, imm_value) SIM_ULP_INSN(SIM_ULP_BGE, 0, 0, 0, imm_value, label_num, 0, 0, 0)
+
+inline esp_err_t ulp_process_macros_and_load(uint32_t load_addr, const ulp_insn_t* program, size_t* psize) {
+    return SimUlp::load(load_addr, program, psize) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+inline esp_err_t ulp_run(uint32_t entry_point) { return SimUlp::start(entry_point) ? ESP_OK : ESP_ERR_INVALID_ARG; }
+inline esp_err_t ulp_set_wakeup_period(size_t period_index, uint32_t period_us) {
+    if (period_index != 0) return ESP_ERR_INVALID_ARG;
+    SimUlp::setPeriod(period_us);
+    return ESP_OK;
+}
+
+#endif // SIM_ESP32_ULP_H
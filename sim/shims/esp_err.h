@@ -0,0 +1,15 @@
+#ifndef SIM_ESP_ERR_H
+#define SIM_ESP_ERR_H
+/**
+ * @file esp_err.h
+ * @brief ESP-IDF error codes used by the shims.
+ */
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+
+#endif // SIM_ESP_ERR_H
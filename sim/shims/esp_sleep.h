@@ -0,0 +1,49 @@
+#ifndef SIM_ESP_SLEEP_H
+#define SIM_ESP_SLEEP_H
+/**
+ * @file esp_sleep.h
+ * @brief Deep sleep on virtual hardware.
+ *
+ * `esp_deep_sleep_start()` throws `SimDeepSleep`; the simulator then lets
+ * the programmed timer elapse, or less if a wake pin reaches its level or
+ * the ULP wakes the CPU first, and boots the firmware again.
+ */
+
+#include <stdint.h>
+#include "SimPlatform.h"
+#include "driver/gpio.h"
+#include "SimUlp.h"
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+    ESP_SLEEP_WAKEUP_GPIO,
+    ESP_SLEEP_WAKEUP_UART,
+    ESP_SLEEP_WAKEUP_WIFI,
+    ESP_SLEEP_WAKEUP_COCPU,
+    ESP_SLEEP_WAKEUP_COCPU_TRAP_TRIG,
+    ESP_SLEEP_WAKEUP_BT,
+} esp_sleep_wakeup_cause_t;
+
+typedef enum { ESP_EXT1_WAKEUP_ALL_LOW = 0, ESP_EXT1_WAKEUP_ANY_HIGH = 1 } esp_sleep_ext1_wakeup_mode_t;
+typedef enum { ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_DOMAIN_RTC_SLOW_MEM, ESP_PD_DOMAIN_RTC_FAST_MEM, ESP_PD_DOMAIN_XTAL, ESP_PD_DOMAIN_RTC8M } esp_sleep_pd_domain_t;
+typedef enum { ESP_PD_OPTION_OFF, ESP_PD_OPTION_ON, ESP_PD_OPTION_AUTO } esp_sleep_pd_option_t;
+
+inline int esp_sleep_enable_timer_wakeup(uint64_t micros) { Sim::setWakeTimer(micros); return 0; }
+inline int esp_sleep_enable_ext0_wakeup(gpio_num_t pin, int level) { Sim::setExt0Wake(pin, level); return 0; }
+inline int esp_sleep_enable_ext1_wakeup(uint64_t mask, esp_sleep_ext1_wakeup_mode_t mode) {
+    Sim::setExt1Wake(mask, mode == ESP_EXT1_WAKEUP_ANY_HIGH);
+    return 0;
+}
+inline int esp_sleep_enable_ulp_wakeup() { SimUlp::enableWake(); return 0; }
+inline int esp_sleep_pd_config(esp_sleep_pd_domain_t, esp_sleep_pd_option_t) { return 0; }
+inline int esp_sleep_enable_gpio_wakeup() { return 0; }  // Light sleep only
+[[noreturn]] inline void esp_deep_sleep_start() { throw SimDeepSleep(); }
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return (esp_sleep_wakeup_cause_t)Sim::wakeCause(); }
+
+#endif // SIM_ESP_SLEEP_H
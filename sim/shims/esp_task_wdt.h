@@ -0,0 +1,10 @@
+#ifndef SIM_ESP_TASK_WDT_H
+#define SIM_ESP_TASK_WDT_H
+/**
+ * @file esp_task_wdt.h
+ * @brief Task watchdog (no-op on the host).
+ */
+
+inline int esp_task_wdt_reset() { return 0; }
+
+#endif // SIM_ESP_TASK_WDT_H
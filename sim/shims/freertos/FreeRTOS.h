@@ -0,0 +1,20 @@
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+/**
+ * @file FreeRTOS.h
+ * @brief FreeRTOS types used by the firmware; the host runs a single task.
+ */
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(...) do {} while (0)
+
+#endif // SIM_FREERTOS_H
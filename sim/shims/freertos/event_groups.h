@@ -0,0 +1,54 @@
+#ifndef SIM_FREERTOS_EVENT_GROUPS_H
+#define SIM_FREERTOS_EVENT_GROUPS_H
+/**
+ * @file event_groups.h
+ * @brief Event groups on virtual hardware.
+ *
+ * Only interrupt handlers run concurrently with the firmware on the host,
+ * and they only fire when the simulator drives a pin. A wait that is not
+ * satisfied right away therefore lasts its whole timeout, which passes as
+ * light sleep (`Sim::idle()`). An endless wait passes one second at a time.
+ */
+
+#include "FreeRTOS.h"
+#include "SimPlatform.h"
+
+typedef uint32_t EventBits_t;
+
+struct SimEventGroup {
+    EventBits_t bits;
+};
+
+typedef SimEventGroup* EventGroupHandle_t;
+
+inline EventGroupHandle_t xEventGroupCreate() { return new SimEventGroup(); }
+inline EventBits_t xEventGroupGetBits(EventGroupHandle_t group) { return group->bits; }
+
+inline EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    group->bits |= bits;
+    return group->bits;
+}
+
+inline BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t group, EventBits_t bits, BaseType_t* woken) {
+    xEventGroupSetBits(group, bits);
+    if (woken != nullptr) *woken = pdFALSE;
+    return pdTRUE;
+}
+
+inline EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    EventBits_t previous = group->bits;
+    group->bits &= ~bits;
+    return previous;
+}
+
+inline EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                       BaseType_t waitForAll, TickType_t ticks) {
+    bool satisfied = waitForAll ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    if (!satisfied) Sim::idle((uint64_t)(ticks == portMAX_DELAY ? 1000 : ticks) * 1000ULL);
+    EventBits_t result = group->bits;
+    satisfied = waitForAll ? (result & bits) == bits : (result & bits) != 0;
+    if (satisfied && clearOnExit) group->bits &= ~bits;
+    return result;
+}
+
+#endif // SIM_FREERTOS_EVENT_GROUPS_H
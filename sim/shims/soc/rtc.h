@@ -0,0 +1,19 @@
+#ifndef SIM_SOC_RTC_H
+#define SIM_SOC_RTC_H
+/**
+ * @file rtc.h
+ * @brief RTC timer and slow clock calibration, on the SimUlp 150 kHz slow clock.
+ */
+
+#include <stdint.h>
+#include "rtc_cntl_reg.h"
+
+#define RTC_CLK_CAL_FRACT 19
+#define RTC_SLOW_CLK_CAL_REG RTC_CNTL_STORE1_REG
+
+inline uint64_t rtc_time_get() { return SimUlp::ticks(); }
+inline uint64_t rtc_time_us_to_slowclk(uint64_t time_in_us, uint32_t period) {
+    return (time_in_us << RTC_CLK_CAL_FRACT) / period;
+}
+
+#endif // SIM_SOC_RTC_H
@@ -0,0 +1,25 @@
+#ifndef SIM_SOC_RTC_CNTL_REG_H
+#define SIM_SOC_RTC_CNTL_REG_H
+/**
+ * @file rtc_cntl_reg.h
+ * @brief RTC control registers modelled by SimUlp (ESP32 addresses).
+ */
+
+#include "soc.h"
+
+#define RTC_CNTL_TIME_UPDATE_REG (DR_REG_RTCCNTL_BASE + 0xc)
+#define RTC_CNTL_TIME_UPDATE_S 31
+#define RTC_CNTL_TIME_UPDATE (1UL << RTC_CNTL_TIME_UPDATE_S)
+#define RTC_CNTL_TIME_VALID_S 30
+#define RTC_CNTL_TIME_VALID (1UL << RTC_CNTL_TIME_VALID_S)
+#define RTC_CNTL_TIME0_REG (DR_REG_RTCCNTL_BASE + 0x10)
+#define RTC_CNTL_TIME1_REG (DR_REG_RTCCNTL_BASE + 0x14)
+#define RTC_CNTL_STATE0_REG (DR_REG_RTCCNTL_BASE + 0x18)
+#define RTC_CNTL_ULP_CP_SLP_TIMER_EN_S 24
+#define RTC_CNTL_ULP_CP_SLP_TIMER_EN (1UL << RTC_CNTL_ULP_CP_SLP_TIMER_EN_S)
+#define RTC_CNTL_STORE1_REG (DR_REG_RTCCNTL_BASE + 0xb0)
+#define RTC_CNTL_LOW_POWER_ST_REG (DR_REG_RTCCNTL_BASE + 0xc0)
+#define RTC_CNTL_RDY_FOR_WAKEUP_S 19
+#define RTC_CNTL_RDY_FOR_WAKEUP (1UL << RTC_CNTL_RDY_FOR_WAKEUP_S)
+
+#endif // SIM_SOC_RTC_CNTL_REG_H
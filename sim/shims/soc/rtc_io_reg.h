@@ -0,0 +1,13 @@
+#ifndef SIM_SOC_RTC_IO_REG_H
+#define SIM_SOC_RTC_IO_REG_H
+/**
+ * @file rtc_io_reg.h
+ * @brief RTC IO input register modelled by SimUlp (ESP32 address).
+ */
+
+#include "soc.h"
+
+#define RTC_GPIO_IN_REG (DR_REG_RTCIO_BASE + 0x24)
+#define RTC_GPIO_IN_NEXT_S 14
+
+#endif // SIM_SOC_RTC_IO_REG_H
@@ -0,0 +1,22 @@
+#ifndef SIM_SOC_SOC_H
+#define SIM_SOC_SOC_H
+/**
+ * @file soc.h
+ * @brief Register access macros, backed by the SimUlp register file.
+ */
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "SimUlp.h"
+
+#define DR_REG_RTCCNTL_BASE 0x3ff48000
+#define DR_REG_RTCIO_BASE 0x3ff48400
+
+#define REG_READ(reg) SimUlp::readRegister(reg)
+#define REG_WRITE(reg, val) SimUlp::writeRegister(reg, val)
+#define READ_PERI_REG(reg) REG_READ(reg)
+#define WRITE_PERI_REG(reg, val) REG_WRITE(reg, val)
+#define SET_PERI_REG_MASK(reg, mask) REG_WRITE(reg, REG_READ(reg) | (mask))
+#define CLEAR_PERI_REG_MASK(reg, mask) REG_WRITE(reg, REG_READ(reg) & ~(uint32_t)(mask))
+
+#endif // SIM_SOC_SOC_H
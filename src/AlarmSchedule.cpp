@@ -0,0 +1,425 @@
+#include "AlarmSchedule.h"
+#include "Crc32.h"
+#include <string.h>
+
+#define SECONDS_PER_DAY 86400UL
+
+/**
+ * @brief Header of the serialized table, followed by the entries (heap
+ *        order) and the exception keys.
+ */
+struct AlarmTableHeader {
+    uint32_t magic;            ///< ALARM_TABLE_MAGIC
+    uint16_t version;          ///< ALARM_TABLE_VERSION
+    uint16_t count;            ///< Number of entries
+    uint16_t exceptionCount;   ///< Number of exception keys
+    uint16_t nextId;           ///< Next id to hand out
+    uint32_t crc;              ///< CRC-32 of the header fields above and the payload
+};
+
+/**
+ * @brief Builds the sorted key of an exception.
+ */
+static inline uint32_t exceptionKey(uint16_t id, uint16_t day) {
+    return ((uint32_t)id << 16) | day;
+}
+
+/**
+ * @brief Binary search for an exception key.
+ */
+static bool hasException(const uint32_t* exceptions, uint16_t count, uint32_t key) {
+    uint16_t low = 0;
+    uint16_t high = count;
+    while (low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if (exceptions[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low < count && exceptions[low] == key;
+}
+
+/**
+ * @brief First occurrence of a rule at or after a time, ignoring exceptions and end time.
+ */
+static uint32_t baseOccurrence(const AlarmEntry& rule, uint32_t from) {
+    uint64_t result = ALARM_NEVER;
+    switch (rule.repeat) {
+        case ALARM_ONCE:
+            result = rule.start >= from ? rule.start : ALARM_NEVER;
+            break;
+        case ALARM_DAILY:
+        case ALARM_INTERVAL: {
+            uint32_t period = rule.repeat == ALARM_DAILY ? SECONDS_PER_DAY : rule.interval;
+            if (from <= rule.start) {
+                result = rule.start;
+            } else if (period == 0) {
+                result = ALARM_NEVER;
+            } else {
+                uint64_t steps = ((uint64_t)from - rule.start + period - 1) / period;
+                result = rule.start + steps * period;
+            }
+            break;
+        }
+        case ALARM_WEEKLY: {
+            if ((rule.weekdays & 0x7F) == 0) break;
+            uint32_t base = from > rule.start ? from : rule.start;
+            uint32_t timeOfDay = rule.start % SECONDS_PER_DAY;
+            uint32_t day = base / SECONDS_PER_DAY;
+            for (uint8_t i = 0; i < 8; i++) {
+                uint64_t candidate = (uint64_t)(day + i) * SECONDS_PER_DAY + timeOfDay;
+                if (candidate >= base && (rule.weekdays & (1 << AlarmSchedule::weekday(day + i)))) {
+                    result = candidate;
+                    break;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return result >= ALARM_NEVER ? ALARM_NEVER : (uint32_t)result;
+}
+
+/**
+ * @brief Constructs an empty schedule.
+ *
+ * @param capacity Maximum number of alarms.
+ * @param exceptionCapacity Maximum number of skipped days across all alarms.
+ */
+AlarmSchedule::AlarmSchedule(uint16_t capacity, uint16_t exceptionCapacity)
+    : _entries(new AlarmEntry[capacity]), _exceptions(new uint32_t[exceptionCapacity]),
+      _capacity(capacity), _exceptionCapacity(exceptionCapacity),
+      _count(0), _exceptionCount(0), _nextId(1) {}
+
+/**
+ * @brief Releases the table storage.
+ */
+AlarmSchedule::~AlarmSchedule() {
+    delete[] _entries;
+    delete[] _exceptions;
+}
+
+/**
+ * @brief Adds a rule to the schedule.
+ *
+ * One-shot alarms keep their start time even if it already passed (they
+ * fire on the next check, as a single alarm always did). Recurring rules
+ * start at their first occurrence at or after now.
+ *
+ * @param rule The rule to add (id and nextFire are assigned here).
+ * @param now Current local Unix time.
+ * @return The id of the new alarm, or -1 if the table is full or the rule never fires.
+ */
+int AlarmSchedule::add(const AlarmEntry& rule, uint32_t now) {
+    if (_count >= _capacity) return -1;
+
+    AlarmEntry entry = rule;
+    entry.id = _nextId;
+    entry.nextFire = evaluate(entry, entry.repeat == ALARM_ONCE ? entry.start : now);
+    if (entry.nextFire == ALARM_NEVER) return -1;
+
+    _nextId = (_nextId == 0xFFFF) ? 1 : _nextId + 1;
+    _entries[_count] = entry;
+    siftUp(_count++);
+    return entry.id;
+}
+
+/**
+ * @brief Removes a rule and its exceptions.
+ *
+ * @param id Identifier of the alarm.
+ * @return true if the alarm existed.
+ */
+bool AlarmSchedule::remove(uint16_t id) {
+    uint16_t index = 0;
+    while (index < _count && _entries[index].id != id) index++;
+    if (index == _count) return false;
+
+    _entries[index] = _entries[--_count];
+    if (index < _count) {
+        siftUp(index);
+        siftDown(index);
+    }
+
+    // Drop the exceptions of this alarm (they are contiguous in key order)
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < _exceptionCount; i++) {
+        if ((_exceptions[i] >> 16) != id) _exceptions[kept++] = _exceptions[i];
+    }
+    _exceptionCount = kept;
+    return true;
+}
+
+/**
+ * @brief Skips one day of an alarm.
+ *
+ * @param id Identifier of the alarm.
+ * @param day Day to skip (days since 1970-01-01, local).
+ * @param now Current local Unix time, used to refresh the alarm's next occurrence.
+ * @return true if the exception was stored.
+ */
+bool AlarmSchedule::addException(uint16_t id, uint16_t day, uint32_t now) {
+    uint16_t index = 0;
+    while (index < _count && _entries[index].id != id) index++;
+    if (index == _count) return false;
+
+    uint32_t key = exceptionKey(id, day);
+    if (!hasException(_exceptions, _exceptionCount, key)) {
+        if (_exceptionCount >= _exceptionCapacity) return false;
+        uint16_t position = _exceptionCount;
+        while (position > 0 && _exceptions[position - 1] > key) {
+            _exceptions[position] = _exceptions[position - 1];
+            position--;
+        }
+        _exceptions[position] = key;
+        _exceptionCount++;
+    }
+
+    uint32_t from = _entries[index].nextFire < now ? _entries[index].nextFire : now;
+    _entries[index].nextFire = evaluate(_entries[index], from);
+    if (_entries[index].nextFire == ALARM_NEVER) {
+        remove(id);
+    } else {
+        siftUp(index);
+        siftDown(index);
+    }
+    return true;
+}
+
+/**
+ * @brief Removes all alarms and exceptions.
+ */
+void AlarmSchedule::clear() {
+    _count = 0;
+    _exceptionCount = 0;
+}
+
+/**
+ * @brief Earliest next occurrence over all alarms.
+ *
+ * @return Local Unix time, or ALARM_NEVER if the schedule is empty.
+ */
+uint32_t AlarmSchedule::nextFire() const {
+    return _count ? _entries[0].nextFire : ALARM_NEVER;
+}
+
+/**
+ * @brief Rule that fires next.
+ *
+ * @return Pointer to the heap root, or nullptr if the schedule is empty.
+ */
+const AlarmEntry* AlarmSchedule::next() const {
+    return _count ? &_entries[0] : nullptr;
+}
+
+/**
+ * @brief Consumes every occurrence due at the given time.
+ *
+ * Each fired rule jumps directly to its first occurrence after now (missed
+ * occurrences while asleep are not replayed); exhausted rules are removed.
+ *
+ * @param now Current local Unix time.
+ * @return The new earliest next occurrence.
+ */
+uint32_t AlarmSchedule::advance(uint32_t now) {
+    while (_count && _entries[0].nextFire <= now) {
+        _entries[0].nextFire = (now == ALARM_NEVER) ? ALARM_NEVER : evaluate(_entries[0], now + 1);
+        if (_entries[0].nextFire == ALARM_NEVER) {
+            remove(_entries[0].id);
+        } else {
+            siftDown(0);
+        }
+    }
+    return nextFire();
+}
+
+/**
+ * @brief Number of alarms in the table.
+ */
+uint16_t AlarmSchedule::count() const {
+    return _count;
+}
+
+/**
+ * @brief Number of stored exceptions.
+ */
+uint16_t AlarmSchedule::exceptionCount() const {
+    return _exceptionCount;
+}
+
+/**
+ * @brief Raw access to the entries (heap order).
+ */
+const AlarmEntry* AlarmSchedule::entries() const {
+    return _entries;
+}
+
+/**
+ * @brief Size of the serialized table.
+ *
+ * @return Number of bytes serialize() writes.
+ */
+size_t AlarmSchedule::serializedSize() const {
+    return sizeof(AlarmTableHeader) + _count * sizeof(AlarmEntry) + _exceptionCount * sizeof(uint32_t);
+}
+
+/**
+ * @brief Writes the table as a compact CRC-checked blob.
+ *
+ * @param buffer Destination buffer.
+ * @param maxLength Size of the destination buffer.
+ * @return Number of bytes written, or 0 if the buffer is too small.
+ */
+size_t AlarmSchedule::serialize(uint8_t* buffer, size_t maxLength) const {
+    size_t length = serializedSize();
+    if (length > maxLength) return 0;
+
+    AlarmTableHeader header = {};
+    header.magic = ALARM_TABLE_MAGIC;
+    header.version = ALARM_TABLE_VERSION;
+    header.count = _count;
+    header.exceptionCount = _exceptionCount;
+    header.nextId = _nextId;
+
+    uint8_t* payload = buffer + sizeof(header);
+    memcpy(payload, _entries, _count * sizeof(AlarmEntry));
+    memcpy(payload + _count * sizeof(AlarmEntry), _exceptions, _exceptionCount * sizeof(uint32_t));
+
+    header.crc = crc32Update(&header, offsetof(AlarmTableHeader, crc));
+    header.crc = crc32Update(payload, length - sizeof(header), header.crc);
+    memcpy(buffer, &header, sizeof(header));
+    return length;
+}
+
+/**
+ * @brief Loads a table written by serialize().
+ *
+ * The entries are stored in heap order, so no rebuild is needed. Version 1
+ * tables (without the pattern) load with the default pattern.
+ *
+ * @param buffer Serialized table.
+ * @param length Size of the serialized table.
+ * @return true if the blob was valid and fits the capacity.
+ */
+bool AlarmSchedule::deserialize(const uint8_t* buffer, size_t length) {
+    if (length < sizeof(AlarmTableHeader)) return false;
+
+    AlarmTableHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    if (header.magic != ALARM_TABLE_MAGIC || header.version == 0 || header.version > ALARM_TABLE_VERSION) return false;
+    if (header.count > _capacity || header.exceptionCount > _exceptionCapacity) return false;
+
+    size_t entrySize = header.version == 1 ? ALARM_ENTRY_V1_SIZE : sizeof(AlarmEntry);
+    size_t expected = sizeof(header) + header.count * entrySize + header.exceptionCount * sizeof(uint32_t);
+    if (length != expected) return false;
+
+    const uint8_t* payload = buffer + sizeof(header);
+    uint32_t crc = crc32Update(&header, offsetof(AlarmTableHeader, crc));
+    if (crc32Update(payload, length - sizeof(header), crc) != header.crc) return false;
+
+    for (uint16_t i = 0; i < header.count; i++) {
+        memset(&_entries[i], 0, sizeof(AlarmEntry));  // Version 1 entries end before the pattern
+        memcpy(&_entries[i], payload + i * entrySize, entrySize);
+    }
+    memcpy(_exceptions, payload + header.count * entrySize, header.exceptionCount * sizeof(uint32_t));
+    _count = header.count;
+    _exceptionCount = header.exceptionCount;
+    _nextId = header.nextId;
+    return true;
+}
+
+/**
+ * @brief Next occurrence of a rule at or after a time.
+ *
+ * Constant time per rule; each skipped day costs one extra step and one
+ * binary search in the exception list.
+ *
+ * @param rule The rule to evaluate.
+ * @param from Earliest acceptable time (local Unix time).
+ * @param exceptions Sorted exception keys.
+ * @param exceptionCount Number of exception keys.
+ * @return Local Unix time of the occurrence, or ALARM_NEVER.
+ */
+uint32_t AlarmSchedule::nextOccurrence(const AlarmEntry& rule, uint32_t from,
+                                       const uint32_t* exceptions, uint16_t exceptionCount) {
+    uint32_t candidate = baseOccurrence(rule, from);
+    for (uint32_t skipped = 0; candidate != ALARM_NEVER && skipped <= exceptionCount; skipped++) {
+        if (rule.until != 0 && candidate > rule.until) return ALARM_NEVER;
+        uint32_t day = candidate / SECONDS_PER_DAY;
+        if (!hasException(exceptions, exceptionCount, exceptionKey(rule.id, day))) return candidate;
+        if ((uint64_t)(day + 1) * SECONDS_PER_DAY >= ALARM_NEVER) return ALARM_NEVER;
+        candidate = baseOccurrence(rule, (day + 1) * SECONDS_PER_DAY);  // Skip the whole day
+    }
+    return ALARM_NEVER;
+}
+
+/**
+ * @brief Day of the week of a day number.
+ *
+ * @param day Days since 1970-01-01 (a Thursday).
+ * @return 0 = Sunday ... 6 = Saturday.
+ */
+uint8_t AlarmSchedule::weekday(uint32_t day) {
+    return (day + 4) % 7;
+}
+
+/**
+ * @brief Parses the name of a recurrence rule.
+ *
+ * @param name "once", "daily", "weekly" or "interval" (nullptr or empty = once).
+ * @return The AlarmRepeat value, or -1 for an unknown name.
+ */
+int AlarmSchedule::parseRepeat(const char* name) {
+    if (name == nullptr || name[0] == '\0' || strcmp(name, "once") == 0) return ALARM_ONCE;
+    if (strcmp(name, "daily") == 0) return ALARM_DAILY;
+    if (strcmp(name, "weekly") == 0) return ALARM_WEEKLY;
+    if (strcmp(name, "interval") == 0) return ALARM_INTERVAL;
+    return -1;
+}
+
+/**
+ * @brief Next occurrence of a rule using this table's exceptions.
+ */
+uint32_t AlarmSchedule::evaluate(const AlarmEntry& rule, uint32_t from) const {
+    return nextOccurrence(rule, from, _exceptions, _exceptionCount);
+}
+
+/**
+ * @brief Moves an entry up until the heap property holds.
+ */
+void AlarmSchedule::siftUp(uint16_t index) {
+    while (index > 0) {
+        uint16_t parent = (index - 1) / 2;
+        if (_entries[parent].nextFire <= _entries[index].nextFire) break;
+        swap(parent, index);
+        index = parent;
+    }
+}
+
+/**
+ * @brief Moves an entry down until the heap property holds.
+ */
+void AlarmSchedule::siftDown(uint16_t index) {
+    while (true) {
+        uint32_t left = 2UL * index + 1;
+        uint32_t right = left + 1;
+        uint16_t smallest = index;
+        if (left < _count && _entries[left].nextFire < _entries[smallest].nextFire) smallest = left;
+        if (right < _count && _entries[right].nextFire < _entries[smallest].nextFire) smallest = right;
+        if (smallest == index) break;
+        swap(index, smallest);
+        index = smallest;
+    }
+}
+
+/**
+ * @brief Swaps two heap entries.
+ */
+void AlarmSchedule::swap(uint16_t a, uint16_t b) {
+    AlarmEntry tmp = _entries[a];
+    _entries[a] = _entries[b];
+    _entries[b] = tmp;
+}
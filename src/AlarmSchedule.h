@@ -0,0 +1,100 @@
+#ifndef ALARM_SCHEDULE_H
+#define ALARM_SCHEDULE_H
+/**
+ * @file AlarmSchedule.h
+ * @brief Multi-alarm recurring schedule with O(log n) next-fire lookup.
+ *
+ * Alarms are one-shot, daily, weekly (weekday mask) or fixed-interval rules,
+ * optionally bounded by an end time, plus a sorted list of skipped days
+ * (exceptions). Each entry caches its next occurrence and the entry array is
+ * kept as a binary min-heap on that value, so:
+ * - the next fire time is the heap root (O(1));
+ * - consuming a fired alarm recomputes only that rule's next occurrence in
+ *   constant time and sifts it down (O(log n));
+ * - exceptions are found by binary search.
+ *
+ * The table serializes to a compact CRC-checked blob in heap order, so a
+ * reload does not need to rebuild anything. The engine is pure C++ and
+ * compiles unchanged in host builds. Times are local Unix seconds, the same
+ * convention as the rest of the firmware.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Config.h"
+
+#define ALARM_NEVER 0xFFFFFFFFUL        ///< nextFire of an exhausted alarm
+#define ALARM_TABLE_MAGIC 0x414C524DUL  ///< "ALRM"
+#define ALARM_TABLE_VERSION 2
+#define ALARM_ENTRY_V1_SIZE 20         ///< Entry size of version 1 tables (no pattern)
+
+/**
+ * @brief Recurrence rule of an alarm.
+ */
+enum AlarmRepeat : uint8_t {
+    ALARM_ONCE = 0,      ///< Fires once at start
+    ALARM_DAILY = 1,     ///< Every day at the time of day of start
+    ALARM_WEEKLY = 2,    ///< On the weekdays of the mask, at the time of day of start
+    ALARM_INTERVAL = 3   ///< Every interval seconds from start
+};
+
+/**
+ * @brief One alarm of the table (24 bytes, stored as-is in NVS).
+ */
+struct AlarmEntry {
+    uint32_t nextFire;  ///< Cached next occurrence (heap key), ALARM_NEVER when exhausted
+    uint32_t start;     ///< First occurrence (local Unix time)
+    uint32_t interval;  ///< Period of ALARM_INTERVAL rules (seconds)
+    uint32_t until;     ///< No occurrence after this time (0 = no end)
+    uint16_t id;        ///< Stable identifier, referenced by exceptions
+    uint8_t repeat;     ///< AlarmRepeat
+    uint8_t weekdays;   ///< ALARM_WEEKLY mask, bit 0 = Sunday ... bit 6 = Saturday
+    uint8_t pattern;    ///< LED/buzzer pattern played when it fires (PatternIndex)
+    uint8_t reserved[3];
+};
+
+class AlarmSchedule {
+public:
+    AlarmSchedule(uint16_t capacity = ALARM_MAX_COUNT, uint16_t exceptionCapacity = ALARM_MAX_EXCEPTIONS);
+    ~AlarmSchedule();
+    AlarmSchedule(const AlarmSchedule&) = delete;
+    AlarmSchedule& operator=(const AlarmSchedule&) = delete;
+
+    int add(const AlarmEntry& rule, uint32_t now);  // Add a rule, returns its id or -1
+    bool remove(uint16_t id);  // Remove a rule and its exceptions
+    bool addException(uint16_t id, uint16_t day, uint32_t now);  // Skip a day for a rule
+    void clear();
+
+    uint32_t nextFire() const;  // Earliest next occurrence (ALARM_NEVER if none)
+    const AlarmEntry* next() const;  // Rule firing next (nullptr if none)
+    uint32_t advance(uint32_t now);  // Consume occurrences due at now, returns next fire
+    uint16_t count() const;
+    uint16_t exceptionCount() const;
+    const AlarmEntry* entries() const;
+
+    size_t serializedSize() const;
+    size_t serialize(uint8_t* buffer, size_t maxLength) const;
+    bool deserialize(const uint8_t* buffer, size_t length);
+
+    // Pure helpers (host testable)
+    static uint32_t nextOccurrence(const AlarmEntry& rule, uint32_t from,
+                                   const uint32_t* exceptions, uint16_t exceptionCount);
+    static uint8_t weekday(uint32_t day);  // 0 = Sunday
+    static int parseRepeat(const char* name);  // "once", "daily", "weekly", "interval" or -1
+
+private:
+    uint32_t evaluate(const AlarmEntry& rule, uint32_t from) const;
+    void siftUp(uint16_t index);
+    void siftDown(uint16_t index);
+    void swap(uint16_t a, uint16_t b);
+
+    AlarmEntry* _entries;   // Min-heap on nextFire
+    uint32_t* _exceptions;  // Sorted (id << 16 | day) keys
+    uint16_t _capacity;
+    uint16_t _exceptionCapacity;
+    uint16_t _count;
+    uint16_t _exceptionCount;
+    uint16_t _nextId;
+};
+
+#endif // ALARM_SCHEDULE_H
@@ -0,0 +1,171 @@
+#include "CivilTime.h"
+#include <string.h>
+
+#define CIVIL_MAX_DAYS 49710       ///< 2106-02-07, last day of 32-bit Unix time
+#define CIVIL_MAX_SECOND 23295UL   ///< 06:28:15 on that day
+
+/**
+ * @brief Reads `count` decimal digits.
+ *
+ * @return The value, or -1 if one of the characters is not a digit.
+ */
+static int32_t civilDigits(const char* text, uint8_t count) {
+    int32_t value = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (text[i] < '0' || text[i] > '9') return -1;
+        value = value * 10 + (text[i] - '0');
+    }
+    return value;
+}
+
+/**
+ * @brief Writes a value as `count` decimal digits (zero padded).
+ */
+static void civilPut(char* out, uint32_t value, uint8_t count) {
+    while (count > 0) {
+        out[--count] = '0' + (char)(value % 10);
+        value /= 10;
+    }
+}
+
+/**
+ * @brief Number of days of a month.
+ */
+uint8_t CivilTime::daysInMonth(uint16_t year, uint8_t month) {
+    static const uint8_t kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month < 1 || month > 12) return 0;
+    if (month == 2 && (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))) return 29;
+    return kDays[month - 1];
+}
+
+/**
+ * @brief Parses a `YYYY-MM-DD` date into the date part of `out`.
+ *
+ * @param text Date text (needs no NUL terminator).
+ * @param length Length of the text (exactly 10).
+ * @param out Receives year, month and day; untouched on failure.
+ * @return false if the text is malformed, the year is outside 1970 to
+ *         2106 or the day does not exist.
+ */
+bool CivilTime::parseDate(const char* text, size_t length, CivilDateTime& out) {
+    if (text == nullptr || length != 10 || text[4] != '-' || text[7] != '-') return false;
+    int32_t year = civilDigits(text, 4);
+    int32_t month = civilDigits(text + 5, 2);
+    int32_t day = civilDigits(text + 8, 2);
+    if (year < 1970 || year > 2106 || month < 1 || month > 12) return false;
+    if (day < 1 || day > daysInMonth(year, month)) return false;
+    out.year = year;
+    out.month = month;
+    out.day = day;
+    return true;
+}
+
+/**
+ * @brief Parses an `HH:MM` or `HH:MM:SS` time into the time part of `out`.
+ *
+ * @param text Time text (needs no NUL terminator).
+ * @param length Length of the text (5 or 8).
+ * @param out Receives hour, minute and second; untouched on failure.
+ * @return false if the text is malformed or a field is out of range.
+ */
+bool CivilTime::parseTime(const char* text, size_t length, CivilDateTime& out) {
+    if (text == nullptr || (length != 5 && length != 8) || text[2] != ':') return false;
+    int32_t hour = civilDigits(text, 2);
+    int32_t minute = civilDigits(text + 3, 2);
+    int32_t second = 0;
+    if (length == 8) {
+        if (text[5] != ':') return false;
+        second = civilDigits(text + 6, 2);
+    }
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) return false;
+    out.hour = hour;
+    out.minute = minute;
+    out.second = second;
+    return true;
+}
+
+/**
+ * @brief Parses a date and a time to Unix seconds.
+ *
+ * @param date `YYYY-MM-DD` (NUL terminated).
+ * @param time `HH:MM` or `HH:MM:SS` (NUL terminated).
+ * @param timestamp Receives the Unix time.
+ * @return false if either text is invalid or the moment is outside the
+ *         32-bit range.
+ */
+bool CivilTime::parse(const char* date, const char* time, uint32_t& timestamp) {
+    CivilDateTime civil = {};
+    if (date == nullptr || time == nullptr) return false;
+    if (!parseDate(date, strlen(date), civil) || !parseTime(time, strlen(time), civil)) return false;
+    return toUnix(civil, timestamp);
+}
+
+/**
+ * @brief Converts a validated date and time to Unix seconds.
+ *
+ * @return false before 1970 or after 2106-02-07 06:28:15.
+ */
+bool CivilTime::toUnix(const CivilDateTime& civil, uint32_t& timestamp) {
+    int32_t days = daysFromCivil(civil.year, civil.month, civil.day);
+    uint32_t second = civil.hour * 3600UL + civil.minute * 60UL + civil.second;
+    if (days < 0 || days > CIVIL_MAX_DAYS || (days == CIVIL_MAX_DAYS && second > CIVIL_MAX_SECOND)) return false;
+    timestamp = (uint32_t)days * 86400UL + second;
+    return true;
+}
+
+/**
+ * @brief Splits Unix seconds into date and time (civil-from-days).
+ */
+CivilDateTime CivilTime::fromUnix(uint32_t timestamp) {
+    CivilDateTime civil;
+    uint32_t second = timestamp % 86400UL;
+    civil.hour = second / 3600;
+    civil.minute = second / 60 % 60;
+    civil.second = second % 60;
+
+    // Days since 0000-03-01; all values are non-negative from 1970 on
+    uint32_t z = timestamp / 86400UL + 719468;
+    uint32_t era = z / 146097;
+    uint32_t dayOfEra = z - era * 146097;
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t shiftedMonth = (5 * dayOfYear + 2) / 153;  // 0 = March
+    civil.day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    civil.month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    civil.year = yearOfEra + era * 400 + (civil.month <= 2 ? 1 : 0);
+    return civil;
+}
+
+/**
+ * @brief Writes the date of a Unix time as `YYYY-MM-DD`.
+ *
+ * @param out At least 11 bytes.
+ */
+void CivilTime::formatDate(uint32_t timestamp, char* out) {
+    CivilDateTime civil = fromUnix(timestamp);
+    civilPut(out, civil.year, 4);
+    out[4] = '-';
+    civilPut(out + 5, civil.month, 2);
+    out[7] = '-';
+    civilPut(out + 8, civil.day, 2);
+    out[10] = '\0';
+}
+
+/**
+ * @brief Writes the time of a Unix time as `HH:MM` or `HH:MM:SS`.
+ *
+ * @param out At least 6 bytes (9 with seconds).
+ */
+void CivilTime::formatTime(uint32_t timestamp, char* out, bool seconds) {
+    uint32_t second = timestamp % 86400UL;
+    civilPut(out, second / 3600, 2);
+    out[2] = ':';
+    civilPut(out + 3, second / 60 % 60, 2);
+    if (seconds) {
+        out[5] = ':';
+        civilPut(out + 6, second % 60, 2);
+        out[8] = '\0';
+    } else {
+        out[5] = '\0';
+    }
+}
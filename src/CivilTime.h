@@ -0,0 +1,65 @@
+#ifndef CIVIL_TIME_H
+#define CIVIL_TIME_H
+/**
+ * @file CivilTime.h
+ * @brief Date and time text to Unix seconds and back, without mktime().
+ *
+ * The portal and the serial command send dates as `YYYY-MM-DD` and times
+ * as `HH:MM` or `HH:MM:SS`. They are parsed from `const char*` spans,
+ * every field is range checked (including the length of the month), and
+ * converted with the days-from-civil algorithm (proleptic Gregorian
+ * calendar), which is constexpr so constant dates cost nothing at run
+ * time. The firmware keeps local time as if it were UTC, so no time zone
+ * or locale state is involved.
+ *
+ * Unix times are 32-bit unsigned: 1970-01-01 00:00:00 to
+ * 2106-02-07 06:28:15.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Broken-down date and time.
+ */
+struct CivilDateTime {
+    uint16_t year;   ///< 1970 to 2106
+    uint8_t month;   ///< 1 to 12
+    uint8_t day;     ///< 1 to 31
+    uint8_t hour;    ///< 0 to 23
+    uint8_t minute;  ///< 0 to 59
+    uint8_t second;  ///< 0 to 59
+};
+
+// Days-from-civil (H. Hinnant), split into single-expression constexpr steps
+constexpr int32_t civilEra(int32_t year) { return (year >= 0 ? year : year - 399) / 400; }
+constexpr uint32_t civilYearOfEra(int32_t year) { return (uint32_t)(year - civilEra(year) * 400); }
+constexpr uint32_t civilDayOfYear(uint32_t month, uint32_t day) { return (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; }  // From March 1st
+constexpr uint32_t civilDayOfEra(uint32_t yearOfEra, uint32_t dayOfYear) { return yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear; }
+
+/**
+ * @brief Days since 1970-01-01 of a proleptic Gregorian date.
+ */
+constexpr int32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day) {
+    return civilEra(month <= 2 ? year - 1 : year) * 146097 +
+           (int32_t)civilDayOfEra(civilYearOfEra(month <= 2 ? year - 1 : year), civilDayOfYear(month, day)) - 719468;
+}
+
+static_assert(daysFromCivil(1970, 1, 1) == 0, "Unix epoch");
+static_assert(daysFromCivil(2000, 3, 1) == 11017, "Leap century");
+static_assert(daysFromCivil(2106, 2, 7) == 49710, "Last day of 32-bit Unix time");
+
+class CivilTime {
+public:
+    // Pure helpers (host testable)
+    static bool parseDate(const char* text, size_t length, CivilDateTime& out);  // YYYY-MM-DD (sets the date part)
+    static bool parseTime(const char* text, size_t length, CivilDateTime& out);  // HH:MM[:SS] (sets the time part)
+    static bool parse(const char* date, const char* time, uint32_t& timestamp);  // NUL-terminated date and time to Unix time
+    static bool toUnix(const CivilDateTime& civil, uint32_t& timestamp);  // false outside the 32-bit range
+    static CivilDateTime fromUnix(uint32_t timestamp);
+    static void formatDate(uint32_t timestamp, char* out);  // YYYY-MM-DD, 11 bytes with the NUL
+    static void formatTime(uint32_t timestamp, char* out, bool seconds = false);  // HH:MM (6 bytes) or HH:MM:SS (9 bytes)
+    static uint8_t daysInMonth(uint16_t year, uint8_t month);
+};
+
+#endif // CIVIL_TIME_H
@@ -4,6 +4,10 @@
 // ==================================================
 // Device Identification Keys
 // ==================================================
+#define CONFIG_DATA_SAVED "CFGDAT"                    ///< Key for saving all settings (ConfigSchema blob)
+#define CONFIG_SCHEMA_VERSION 2                       ///< Layout version of the settings blob
+
+// Keys of the per-setting layout of earlier firmware (migrated into CONFIG_DATA_SAVED)
 #define DEVICE_NAME "DEVNAM"                           ///< Device name
 #define DEVICE_ID "DEVID"                              ///< Unique device identifier
 
@@ -18,10 +22,100 @@
 #define ALERT_DATE_ "DATE"                             ///< Key for saving the alert date
 #define ALERT_TIME_ "TIME"                             ///< Key for saving the alert time
 #define LED_STATE "LEDSTA"                            ///< Key for saving the LED state
+#define DRIFT_HISTORY_SAVED "DRFHIS"                  ///< Key for saving the RTC drift history (blob)
+#define ALARM_TABLE_SAVED "ALMTBL"                    ///< Key for saving the alarm schedule table (blob)
+#define ALARM_PATTERN_SAVED "ALMPAT"                  ///< Key for saving the pattern of the alarm that fired
 
 #define WIFI_TIMEOUT 120000                           ///< Wi-Fi connection timeout (2 minutes in milliseconds)
-#define TIME_ERROR_THRESHOLD 5400                     ///< Time error threshold (in seconds)
-#define DEEPSLEEP_TIME 60000                          ///< Deep sleep timeout (in milliseconds)
+#define DEEPSLEEP_TIME 60000                          ///< Default deep sleep timeout (in milliseconds)
+#define RTC_VALID_AFTER 1483228800UL                  ///< Earliest Unix time taken as a set clock (2017-01-01, as getLocalTime())
+
+// Fast-wake state cache (RTC slow memory)
+#define WAKESTATE_VERSION 1                           ///< Layout version of the RTC state block
+#define WAKESTATE_CHECKPOINT_WAKES 60                 ///< Fast wakes between NVS time checkpoints (0 = never)
+#define WAKESTUB_MAX_SKIPPED_WAKES 60                 ///< Wakes the deep-sleep stub absorbs before booting the app
+
+// Sleep scheduler (sleep until the alarm instead of fixed DEEPSLEEP_TIME wakes)
+#define SLEEP_GUARD_BAND 120                          ///< Seconds kept before the alarm for the final approach
+#define SLEEP_DRIFT_PPM 5000                          ///< Assumed worst-case RTC drift (parts per million)
+#define SLEEP_MIN_INTERVAL 5                          ///< Shortest intermediate sleep (in seconds)
+#define SLEEP_MAX_INTERVAL 86400                      ///< Longest sleep between checkpoints (in seconds, 0 = unlimited)
+#define SLEEP_QUIET_START_HOUR 0                      ///< Quiet hours start (local hour, equal to end = disabled)
+#define SLEEP_QUIET_END_HOUR 0                        ///< Quiet hours end (local hour)
+
+// RTC drift estimation
+#define DRIFT_HISTORY_SIZE 8                          ///< NTP sync samples kept for the drift fit
+#define DRIFT_MIN_SAMPLE_INTERVAL 3600                ///< Shortest sync interval worth a sample (in seconds)
+#define DRIFT_SYNC_RESOLUTION_MS 1000                 ///< Resolution of the reference time (in milliseconds)
+#define DRIFT_DEFAULT_UNCERTAINTY_PPM SLEEP_DRIFT_PPM ///< Drift uncertainty before two samples exist (ppm)
+#define DRIFT_MIN_UNCERTAINTY_PPM 5                   ///< Floor of the drift uncertainty (ppm)
+#define DRIFT_MAX_ERROR_MS 5000                       ///< Predicted clock error that triggers an NTP resync (in milliseconds)
+#define DRIFT_MAX_RESYNC_INTERVAL 604800              ///< Longest time between NTP resyncs, whatever the fit (in seconds)
+
+// Alarm schedule
+#define ALARM_MAX_COUNT 64                            ///< Alarms kept in the schedule table
+#define ALARM_MAX_EXCEPTIONS 64                       ///< Skipped days kept across all alarms
+
+// Energy accounting (average current per wake phase, in microamps)
+#define ENERGY_CURRENT_BOOT_UA 45000                  ///< ROM, bootloader and early init
+#define ENERGY_CURRENT_ACTIVE_UA 40000                ///< CPU running, radio off
+#define ENERGY_CURRENT_COUNTDOWN_UA 40000             ///< User action countdown (CPU waiting)
+#define ENERGY_CURRENT_NVS_UA 45000                   ///< Flash reads and writes
+#define ENERGY_CURRENT_WIFI_UA 130000                 ///< Wi-Fi association (radio on)
+#define ENERGY_CURRENT_NTP_UA 110000                  ///< NTP exchange (radio on)
+#define ENERGY_CURRENT_LED_UA 45000                   ///< Alarm LED blinking
+#define ENERGY_CURRENT_IDLE_UA 1500                   ///< Automatic light sleep between events (radio off)
+#define ENERGY_CURRENT_SLEEP_UA 10                    ///< Deep sleep (RTC timer and RTC memory)
+#define ENERGY_CURRENT_ULP_SLEEP_UA 25                ///< Deep sleep with the ULP running every ULP_PERIOD_MS
+#define ENERGY_BATTERY_MAH 2000                       ///< Usable battery capacity (in mAh)
+
+// Wake profiler
+#define PROFILER_HISTORY_SIZE 16                      ///< Wakes kept in the RTC-memory profile ring
+
+// Wi-Fi fast reconnect (cached AP, channel and address in RTC slow memory)
+#define WIFI_CONNECT_TIMEOUT_MS 10000                 ///< Connect timeout with a full scan (in milliseconds)
+#define WIFI_FAST_TIMEOUT_MS 1500                     ///< Connect timeout on the cached AP and channel (in milliseconds)
+#define WIFI_LEASE_TTL 43200                          ///< Reuse of a DHCP address without renewing it (in seconds)
+#define WIFI_ATTEMPT_HISTORY 8                        ///< Connect attempts kept in RTC memory
+
+// Time sync retry policy (jittered exponential backoff, the waits are deep sleeps)
+#define RETRY_BASE_SECONDS 60                         ///< Wait after the first failed sync (in seconds)
+#define RETRY_MAX_SECONDS 21600                       ///< Longest wait between attempts (in seconds)
+#define RETRY_JITTER_PERCENT 25                       ///< Random spread of each wait (+/- percent)
+
+// Event loop (FreeRTOS event group and timer wheel, light sleep between events)
+#define EVENTLOOP_TICK_MS 10                          ///< Resolution of the timer wheel (in milliseconds)
+#define EVENTLOOP_WHEEL_SLOTS 64                      ///< Slots of the timer wheel
+#define EVENTLOOP_MAX_TIMERS 16                       ///< Timers armed at the same time
+#define EVENTLOOP_WDT_FEED_MS 1000                    ///< Longest wait of idle loops between watchdog feeds (in milliseconds)
+#define EVENTLOOP_MAX_FREQ_MHZ 240                    ///< CPU clock while busy (power management)
+#define EVENTLOOP_MIN_FREQ_MHZ 40                     ///< CPU clock while idle, before light sleep (power management)
+#define ALARM_BLINK_DURATION_MS 120000                ///< Length of the alarm indication (in milliseconds)
+#define ALARM_REST_SLEEP_MS 300000                    ///< Deep sleep after an unanswered alarm (in milliseconds)
+#define ALARM_MAX_UNANSWERED 3                        ///< Unanswered indications before an alarm stops ringing
+#define ALARM_SNOOZE_SECONDS 540                      ///< Snooze length (short press on a ringing alarm, in seconds)
+
+// Button wakes (ext0 on SWITCH_PIN, ext1 on PROG_SWITCH_PIN, no countdown)
+#define BUTTON_LONG_PRESS_MS 1500                     ///< Hold that dismisses a ringing alarm or opens the admin mode
+#define BUTTON_POLL_MS 20                             ///< Release polling while a press is timed (in milliseconds)
+#define BUTTON_RELEASE_WAIT_MS 5000                   ///< Wait for a held button to be released before deep sleep (in milliseconds)
+
+// ULP coprocessor (counts down short sleeps and watches the buttons while the main cores sleep)
+#define ULP_COUNTDOWN_MAX_S 600                       ///< Sleeps up to this long run on the ULP countdown (in seconds, 0 = never)
+#define ULP_PERIOD_MS 20                              ///< ULP run period (in milliseconds)
+#define ULP_DEBOUNCE_SAMPLES 3                        ///< Consecutive low samples that make a press
+#define ULP_BACKSTOP_MS 2000                          ///< Timer wake kept behind the ULP deadline (in milliseconds)
+#define ULP_DATA_OFFSET 0                             ///< Shared variables in RTC slow memory (in 32-bit words)
+#define ULP_PROG_OFFSET 16                            ///< ULP program in RTC slow memory (in 32-bit words)
+
+// LED and buzzer patterns (LEDC, clocked from the RC oscillator so they play in light sleep)
+#define PATTERN_LEDC_CLOCK_HZ 8000000                 ///< LEDC slow clock (RC fast oscillator, +/- 5%)
+#define PATTERN_PWM_HZ 5000                           ///< PWM frequency of steady levels and fades
+#define PATTERN_LEDC_CHANNEL 0                        ///< LEDC channel and timer of the LED (the buzzer uses the next one)
+
+// Web portal JSON (request bodies get one buffer per request, sized from Content-Length)
+#define WEB_BODY_MAX_BYTES 1024                       ///< Largest accepted JSON body (in bytes, larger ones get 413)
+#define WEB_JSON_MAX_BYTES 2048                       ///< Reply buffer of the JSON report endpoints (in bytes)
 
 // ==================================================
 // Default Values
@@ -44,6 +138,9 @@
 #define DEFAULT_LAST_TIME_SAVED 1736121600           ///< Default last time saved (Unix timestamp example)
 #define DEFAULT_LED_STATE false                      ///< Default LED state (false for OFF, true for ON)
 #define DEFAULT_ALERT_TIME_SAVED 0                  ///< Default alert time (Unix epoch timestamp)
+#define DEFAULT_ALARM_PATTERN 0                      ///< Pattern of alarms set without one (PATTERN_CLASSIC)
+#define DEFAULT_ALERT_DATE "2025-01-01"              ///< Default alert date shown in the portal
+#define DEFAULT_ALERT_TIME "11:18"                   ///< Default alert time shown in the portal
 
 // ==================================================
 // General Configuration
@@ -52,6 +149,10 @@
 #define DEBUGMODE 1                                   ///< Debug mode flag (1 = enabled, 0 = disabled)
 #define SERIAL_BAUD_RATE 115200                       ///< Baud rate for serial communication
 #define CONFIG_PARTITION "config"                     ///< Configuration storage partition name
+#define CONFIG_CACHE_SIZE 16                          ///< Preferences kept in the RAM write-back cache
+#define TIME_JOURNAL_PARTITION "journal"              ///< Raw partition holding the time checkpoint journal
+#define TIME_JOURNAL_HOST_IMAGE "journal.img"         ///< File emulating the journal partition in host builds
+#define TIME_JOURNAL_HOST_SIZE 0xCB000                ///< Size of the emulated journal partition (as in partitions.csv)
 
 // ==================================================
 // Pin Configuration
@@ -67,7 +168,15 @@
 // Time Offset (in seconds)
 #define TIMEOFFSET 3600                               ///< Time offset for UTC+1 (3600 seconds)
 #define NTP_SERVER "pool.ntp.org"                     ///< NTP server for time synchronization
+#define NTP_SERVER_2 "time.google.com"                ///< Second server queried in parallel
+#define NTP_SERVER_3 "time.cloudflare.com"            ///< Third server queried in parallel
+#define NTP_MAX_SERVERS 3                             ///< Servers queried in parallel (DNS cache slots)
 #define NTP_UPDATE_INTERVAL 60000                     ///< NTP update interval in milliseconds (default 1 minute)
+#define NTP_PORT 123                                  ///< NTP server port
+#define NTP_LOCAL_PORT 4123                           ///< Local UDP port of the SNTP client
+#define NTP_TIMEOUT_MS 2000                           ///< Time given to the servers to answer (in milliseconds)
+#define NTP_SETTLE_MS 20                              ///< Wait for a lower-delay answer after the first one (in milliseconds)
+#define NTP_DNS_TTL 86400                             ///< Lifetime of cached server addresses (in seconds)
 
 // ==================================================
 // End of Configuration
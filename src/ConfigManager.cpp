@@ -13,7 +13,7 @@
  * 
  * @param prefs Reference to the Preferences object.
  */
-ConfigManager::ConfigManager(Preferences* preferences) : preferences(preferences),namespaceName(CONFIG_PARTITION) {}
+ConfigManager::ConfigManager(Preferences* preferences) : preferences(preferences),namespaceName(CONFIG_PARTITION),config(ConfigSchema::defaults()),configLoaded(false),configDirty(false),configRevision(0),stats() {}
 
 /**
  * @brief Destructor for the ConfigManager class.
@@ -23,6 +23,7 @@ ConfigManager::ConfigManager(Preferences* preferences) : preferences(preferences
  */
 ConfigManager::~ConfigManager() {
     end();  // Ensure preferences are closed properly
+    for (uint8_t i = 0; i < CONFIG_CACHE_SIZE; i++) free(cache[i].blob);
 }
 
 /**
@@ -99,6 +100,7 @@ void ConfigManager::RestartSysDelay(unsigned long delayTime) {
         Serial.println("Restarting now...");
     }
     //simulatePowerDown();  // Simulate power down before restart
+    commit();  // Flush cached settings before restarting
      ESP.restart();
 }
 
@@ -113,6 +115,7 @@ void ConfigManager::RestartSysDelay(unsigned long delayTime) {
  * @param delayTime Time in milliseconds to wait before restarting the device.
  */
 void ConfigManager::CountdownDelay(unsigned long delayTime) {
+    EnergyScope phase(EnergyPhase::Countdown);
     unsigned long startTime = millis();  // Record the start time
 
     if (DEBUGMODE) {
@@ -142,6 +145,7 @@ void ConfigManager::CountdownDelay(unsigned long delayTime) {
  * It is used to simulate the power-down state of the device.
  */
 void ConfigManager::simulatePowerDown() {
+    commit();  // Flush cached settings before sleeping
     // Put the ESP32 into deep sleep for 1 second (simulate power-down)
     esp_sleep_enable_timer_wakeup(1000000); // 1 second (in microseconds)
     esp_deep_sleep_start();  // Enter deep sleep
@@ -187,15 +191,20 @@ void ConfigManager::begin() {
         Serial.println("###########################################################");
     }
     
-    bool resetFlag = GetBool(RESET_FLAG, true);  // Default to true if not set
+    ConfigLoad loaded = loadConfig();  // One blob read (or a one-time migration)
 
-    if (resetFlag) {
+    if (loaded == ConfigLoad::Empty || config.resetFlag) {
         // Only print once, if necessary, then reset device
         if (DEBUGMODE) {
             Serial.println("ConfigManager: Initializing the device...");
         };
         initializeDefaults();  // Reset preferences if the flag is set
         RestartSysDelay(7000);  // Use a delay for restart after reset
+    } else if (loaded == ConfigLoad::Damaged) {
+        // Keep running on defaults; the alarm table and other keys stay as they are
+        if (DEBUGMODE) {
+            Serial.println("ConfigManager: Settings unreadable, using defaults...");
+        }
     } else {
         // Use existing configuration, no need for unnecessary delay
         if (DEBUGMODE) {
@@ -207,19 +216,12 @@ void ConfigManager::begin() {
 
 
 /**
- * @brief Retrieves the reset flag from preferences.
- * 
- * This function checks and returns the value of the "Reset" flag from 
- * the preferences. If the flag is not set, it defaults to true. The 
- * function also resets the watchdog timer to prevent the system from 
- * resetting unexpectedly.
+ * @brief Retrieves the reset flag from the settings.
  * 
  * @return bool The value of the reset flag.
  */
 bool ConfigManager::getResetFlag() {
-    esp_task_wdt_reset();
-    bool value = preferences->getBool(RESET_FLAG, true); // Default to true if not set
-    return value;
+    return Get<ConfigField::ResetFlag>();
 }
 
 /**
@@ -230,56 +232,314 @@ bool ConfigManager::getResetFlag() {
  * It should be called when no further preference operations are needed.
  */
 void ConfigManager::end() {
+    commit();  // Flush cached settings first
     preferences->end();  // Close preferences
 }
 
 
 /**
- * @brief Initializes all needed default variables.
+ * @brief Restores the factory settings.
  * 
- * This function is called to initialize all necessary default variables 
- * for the ConfigManager, ensuring that all values are set to a known 
- * state before use.
+ * All settings come from the schema defaults and are written as one blob 
+ * on the next commit(). The alarm table is removed with them.
  */
 void ConfigManager::initializeDefaults() {
-    initializeVariables();  // Initialize all default variables
+    config = ConfigSchema::defaults();
+    configLoaded = true;
+    configDirty = true;
+    configRevision++;
+    RemoveKey(ALARM_TABLE_SAVED);
 }
 
 /**
- * @brief Initializes all default variables.
+ * @brief Loads the settings blob.
+ * 
+ * A blob written by a newer firmware (after a rollback) is read whole and 
+ * its known prefix is used; it is rewritten in this layout only when a 
+ * setting changes. An unreadable blob falls back to migrating the 
+ * per-setting keys of earlier firmware, then to the schema defaults in 
+ * RAM: nothing is erased, so a bad blob costs the settings, not the alarm 
+ * table.
  * 
- * This function sets the initial values for various boolean and string 
- * variables used by the ConfigManager. It includes settings for GPIO, 
- * Wi-Fi SSID, and password. Debug messages are printed if DEBUGMODE is enabled.
+ * @return Whether settings were found, absent or unreadable.
  */
-void ConfigManager::initializeVariables() {
-    // Assign default values to configuration variables
-    PutString(WIFISSID, DEFAULT_WIFI_SSID);  // Default Wi-Fi SSID
-    PutString(WIFIPASS, DEFAULT_WIFI_PASSWORD);  // Default Wi-Fi password
-    PutBool(RESET_FLAG, false);  // Reset flag is set to false after initialization
+ConfigLoad ConfigManager::loadConfig() {
+    esp_task_wdt_reset();
+    EnergyScope phase(EnergyPhase::Nvs);
+    configLoaded = true;
+    configDirty = false;
+    configRevision++;
 
-    // Device information defaults
-    //PutString(DEVICE_NAME, DEFAULT_DEVICE_NAME);  // Default device name
-    //PutString(DEVICE_ID, DEFAULT_DEVICE_ID);  // Default device ID
+    size_t length = GetBytesLength(CONFIG_DATA_SAVED);
+    if (length > 0) {
+        ConfigBlob blob;
+        uint8_t* buffer = length <= sizeof(blob) ? (uint8_t*)&blob : (uint8_t*)malloc(length);
+        bool read = buffer != nullptr && GetBytes(CONFIG_DATA_SAVED, buffer, length) == length;
+        ConfigBlobHeader header = {};
+        if (read && length >= sizeof(header)) memcpy(&header, buffer, sizeof(header));
+        bool current = read && ConfigSchema::decode(buffer, length, config);
+        bool newer = read && !current && ConfigSchema::decodeNewer(buffer, length, config);
+        if (buffer != (uint8_t*)&blob) free(buffer);
 
-    // RTC time and date default values
-    PutULong64(CURRENT_TIME_SAVED, DEFAULT_CURRENT_TIME_SAVED);  // Default current time
-    PutULong64(LAST_TIME_SAVED, DEFAULT_LAST_TIME_SAVED);  // Default last saved time
-    PutULong64(ALERT_TIMESTAMP_SAVED, DEFAULT_ALERT_TIME_SAVED);  // Default alert time
-    PutString(ALERT_DATE_, "2025-01-01");  // Default date saved
-    PutString(ALERT_TIME_, "11:18");  // Default time saved
+        if (current) {
+            configDirty = header.version != CONFIG_SCHEMA_VERSION;  // Rewrite older layouts
+            return ConfigLoad::Loaded;
+        }
+        if (newer) {
+            if (DEBUGMODE) Serial.printf("ConfigManager: Settings from schema %u, keeping the known fields\n", (unsigned)header.version);
+            return ConfigLoad::Loaded;
+        }
+        if (DEBUGMODE) Serial.println("ConfigManager: Settings blob corrupted");
+    }
 
-    PutBool(LED_STATE, DEFAULT_LED_STATE);  // Default LED state
-    // Add any additional configurations here if needed
+    config = ConfigSchema::defaults();
+    if (migrateLegacy()) return ConfigLoad::Loaded;
+    return length > 0 ? ConfigLoad::Damaged : ConfigLoad::Empty;
+}
+
+/**
+ * @brief Migrates the per-setting keys of earlier firmware into the blob.
+ * 
+ * Each key of the old layout is read with its type, copied into the 
+ * settings and removed. The blob is written right away so the migration 
+ * runs only once.
+ * 
+ * @return true if an old layout was found.
+ */
+bool ConfigManager::migrateLegacy() {
+    if (!preferences->isKey(RESET_FLAG)) return false;  // Every old layout wrote the reset flag
+    if (DEBUGMODE) Serial.println("ConfigManager: Migrating per-key settings");
+
+    size_t count;
+    const ConfigLegacyField* fields = ConfigSchema::legacyFields(count);
+    for (size_t i = 0; i < count; i++) {
+        uint8_t* field = (uint8_t*)&config + fields[i].offset;
+        if (preferences->isKey(fields[i].key)) {
+            switch (fields[i].type) {
+                case CFG_BOOL: {
+                    bool value = GetBool(fields[i].key, false);
+                    memcpy(field, &value, sizeof(value));
+                    break;
+                }
+                case CFG_U64: {
+                    uint64_t value = GetULong64(fields[i].key, 0);
+                    memcpy(field, &value, sizeof(value));
+                    break;
+                }
+                case CFG_STRING: {
+                    String value = GetString(fields[i].key, "");
+                    memset(field, 0, fields[i].size);
+                    strncpy((char*)field, value.c_str(), fields[i].size - 1);
+                    break;
+                }
+            }
+        }
+        RemoveKey(fields[i].key);
+    }
+    configDirty = true;
+    commit();
+    return true;
 }
 
 
+/**
+ * @brief Finds the cache entry of a key.
+ * 
+ * @param key The key to look up.
+ * @return The entry, or nullptr if the key is not cached.
+ */
+ConfigCacheEntry* ConfigManager::cacheFind(const char* key) {
+    for (uint8_t i = 0; i < CONFIG_CACHE_SIZE; i++) {
+        if (cache[i].type != CFG_NONE && strncmp(cache[i].key, key, sizeof(cache[i].key)) == 0) return &cache[i];
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Returns the cache entry of a key, loading it from NVS on first use.
+ * 
+ * The value is read from NVS only once; later reads and the comparison done 
+ * by the Put* methods are served from RAM. An entry cached with another type 
+ * is reloaded unless it holds an unflushed value.
+ * 
+ * @param key The key to load.
+ * @param type The type the caller expects.
+ * @return The entry, or nullptr if the cache is full (callers then go to NVS directly).
+ */
+ConfigCacheEntry* ConfigManager::cacheLoad(const char* key, uint8_t type) {
+    ConfigCacheEntry* entry = cacheFind(key);
+    if (entry != nullptr && (entry->type == type || entry->dirty)) return entry;
+
+    if (entry == nullptr) {
+        if (strlen(key) >= sizeof(entry->key)) return nullptr;  // Not a valid NVS key
+        for (uint8_t i = 0; i < CONFIG_CACHE_SIZE && entry == nullptr; i++) {
+            if (cache[i].type == CFG_NONE) entry = &cache[i];
+        }
+        if (entry == nullptr) return nullptr;
+        strncpy(entry->key, key, sizeof(entry->key));
+    }
+
+    entry->type = type;
+    entry->dirty = false;
+    entry->present = preferences->isKey(key);
+    entry->stored = entry->present ? type : (uint8_t)CFG_NONE;
+    entry->scalar = 0;
+    entry->text = "";
+    free(entry->blob);
+    entry->blob = nullptr;
+    entry->blobLength = 0;
+    if (!entry->present) return entry;
+
+    stats.nvsReads++;
+    switch (type) {
+        case CFG_BOOL:   entry->scalar = preferences->getBool(key, false); break;
+        case CFG_INT:    entry->scalar = (uint32_t)preferences->getInt(key, 0); break;
+        case CFG_UINT:   entry->scalar = preferences->getUInt(key, 0); break;
+        case CFG_U64:    entry->scalar = preferences->getULong64(key, 0); break;
+        case CFG_FLOAT: {
+            float value = preferences->getFloat(key, 0.0f);
+            memcpy(&entry->scalar, &value, sizeof(value));
+            break;
+        }
+        case CFG_STRING: entry->text = preferences->getString(key, ""); break;
+        case CFG_BYTES: {
+            size_t length = preferences->getBytesLength(key);
+            entry->blob = (uint8_t*)malloc(length ? length : 1);
+            if (entry->blob == nullptr) {
+                entry->type = CFG_NONE;  // Out of memory: drop the entry
+                return nullptr;
+            }
+            entry->blobLength = preferences->getBytes(key, entry->blob, length);
+            break;
+        }
+    }
+    return entry;
+}
+
+/**
+ * @brief Stores a scalar value in the cache.
+ * 
+ * A value equal to the cached one is not written again; a changed value is 
+ * marked dirty and written by commit().
+ * 
+ * @param key The key to store.
+ * @param type The value type.
+ * @param scalar The value bits.
+ * @return false if the cache is full and the caller must write through.
+ */
+bool ConfigManager::cacheStore(const char* key, uint8_t type, uint64_t scalar) {
+    ConfigCacheEntry* entry = cacheLoad(key, type);
+    if (entry == nullptr) return false;
+    if (entry->present && entry->type == type && entry->scalar == scalar) {
+        stats.skippedWrites++;
+        return true;
+    }
+    entry->type = type;
+    entry->scalar = scalar;
+    entry->present = true;
+    entry->dirty = true;
+    return true;
+}
+
+/**
+ * @brief Writes one dirty entry to NVS.
+ * 
+ * The key is removed first only if NVS may hold it with another type.
+ * 
+ * @param entry The entry to write.
+ */
+void ConfigManager::flushEntry(ConfigCacheEntry& entry) {
+    esp_task_wdt_reset();
+    if (entry.stored != entry.type) RemoveNvsKey(entry.key);
+
+    switch (entry.type) {
+        case CFG_BOOL:   preferences->putBool(entry.key, entry.scalar != 0); break;
+        case CFG_INT:    preferences->putInt(entry.key, (int32_t)entry.scalar); break;
+        case CFG_UINT:   preferences->putUInt(entry.key, (uint32_t)entry.scalar); break;
+        case CFG_U64:    preferences->putULong64(entry.key, entry.scalar); break;
+        case CFG_FLOAT: {
+            float value;
+            memcpy(&value, &entry.scalar, sizeof(value));
+            preferences->putFloat(entry.key, value);
+            break;
+        }
+        case CFG_STRING: preferences->putString(entry.key, entry.text); break;
+        case CFG_BYTES:  preferences->putBytes(entry.key, entry.blob, entry.blobLength); break;
+    }
+    entry.stored = entry.type;
+    entry.dirty = false;
+    stats.nvsWrites++;
+}
+
+/**
+ * @brief Writes all changed values to NVS.
+ * 
+ * Must be called before deep sleep or restart; Put* only updates the RAM 
+ * cache. Unchanged values were already skipped by Put*, so only the keys 
+ * that really changed since the last commit reach the flash. Changed 
+ * schema settings are written as one blob. The keys are written one after 
+ * the other, not as a transaction (see ConfigManager.h).
+ * 
+ * @return Number of values written.
+ */
+uint8_t ConfigManager::commit() {
+    EnergyScope phase(EnergyPhase::Nvs);
+    if (configDirty) {
+        ConfigBlob blob;
+        ConfigSchema::seal(blob, config);
+        PutBytes(CONFIG_DATA_SAVED, &blob, sizeof(blob));
+        configDirty = false;
+    }
+
+    uint8_t written = 0;
+    for (uint8_t i = 0; i < CONFIG_CACHE_SIZE; i++) {
+        if (cache[i].type == CFG_NONE || !cache[i].dirty) continue;
+        flushEntry(cache[i]);
+        written++;
+    }
+    if (DEBUGMODE && written) {
+        Serial.print("ConfigManager: Committed ");
+        Serial.print(written);
+        Serial.print(" keys (NVS reads ");
+        Serial.print(stats.nvsReads);
+        Serial.print(", writes ");
+        Serial.print(stats.nvsWrites);
+        Serial.print(", skipped ");
+        Serial.print(stats.skippedWrites);
+        Serial.println(")");
+    }
+    return written;
+}
+
+/**
+ * @brief Gives read access to the NVS access counters.
+ * 
+ * @return The counters since boot.
+ */
+const ConfigStats& ConfigManager::getStats() const {
+    return stats;
+}
+
+/**
+ * @brief Gives the revision of the typed settings.
+ * 
+ * The value changes whenever a setting is loaded, reset or changed by a 
+ * Put, so a cache built from settings is current as long as the revision 
+ * it was built at still matches.
+ * 
+ * @return The settings revision.
+ */
+uint32_t ConfigManager::revision() const {
+    return configRevision;
+}
+
 /**
  * @brief Gets a boolean value from preferences.
  * 
  * This function retrieves a boolean value associated with the given key 
  * from the preferences. If the key does not exist, it returns the specified 
- * default value. The function also resets the watchdog timer to prevent 
+ * default value. The value is read from NVS once and then served from the 
+ * RAM cache. The function also resets the watchdog timer to prevent 
  * unexpected resets.
  * 
  * @param key The key associated with the boolean value.
@@ -288,8 +548,12 @@ void ConfigManager::initializeVariables() {
  */
 bool ConfigManager::GetBool(const char* key, bool defaultValue) {
     esp_task_wdt_reset();
-    bool value = preferences->getBool(key, defaultValue);
-    return value;
+    ConfigCacheEntry* entry = cacheLoad(key, CFG_BOOL);
+    if (entry == nullptr) {
+        stats.nvsReads++;
+        return preferences->getBool(key, defaultValue);
+    }
+    return entry->present ? entry->scalar != 0 : defaultValue;
 }
 
 /**
@@ -297,7 +561,8 @@ bool ConfigManager::GetBool(const char* key, bool defaultValue) {
  * 
  * This function retrieves an integer value associated with the given key 
  * from the preferences. If the key does not exist, it returns the specified 
- * default value. The function also resets the watchdog timer to prevent 
+ * default value. The value is read from NVS once and then served from the 
+ * RAM cache. The function also resets the watchdog timer to prevent 
  * unexpected resets.
  * 
  * @param key The key associated with the integer value.
@@ -306,25 +571,34 @@ bool ConfigManager::GetBool(const char* key, bool defaultValue) {
  */
 int ConfigManager::GetInt(const char* key, int defaultValue) {
     esp_task_wdt_reset();
-    int value = preferences->getInt(key, defaultValue);
-    return value;
+    ConfigCacheEntry* entry = cacheLoad(key, CFG_INT);
+    if (entry == nullptr) {
+        stats.nvsReads++;
+        return preferences->getInt(key, defaultValue);
+    }
+    return entry->present ? (int32_t)entry->scalar : defaultValue;
 }
 /**
- * @brief Gets an integer value from preferences.
+ * @brief Gets an unsigned 64-bit integer value from preferences.
  * 
- * This function retrieves an integer value associated with the given key 
- * from the preferences. If the key does not exist, it returns the specified 
- * default value. The function also resets the watchdog timer to prevent 
+ * This function retrieves an unsigned 64-bit value associated with the given 
+ * key from the preferences. If the key does not exist, it returns the 
+ * specified default value. The value is read from NVS once and then served 
+ * from the RAM cache. The function also resets the watchdog timer to prevent 
  * unexpected resets.
  * 
  * @param key The key associated with the integer value.
  * @param defaultValue The default value to return if the key does not exist.
- * @return int The retrieved integer value or the default value.
+ * @return uint64_t The retrieved integer value or the default value.
  */
-uint64_t ConfigManager::GetULong64(const char* key, int defaultValue) {
+uint64_t ConfigManager::GetULong64(const char* key, uint64_t defaultValue) {
     esp_task_wdt_reset();
-    uint64_t value = preferences->getULong64(key, defaultValue);
-    return value;
+    ConfigCacheEntry* entry = cacheLoad(key, CFG_U64);
+    if (entry == nullptr) {
+        stats.nvsReads++;
+        return preferences->getULong64(key, defaultValue);
+    }
+    return entry->present ? entry->scalar : defaultValue;
 }
 
 /**
@@ -332,7 +606,8 @@ uint64_t ConfigManager::GetULong64(const char* key, int defaultValue) {
  * 
  * This function retrieves a float value associated with the given key 
  * from the preferences. If the key does not exist, it returns the specified 
- * default value. The function also resets the watchdog timer to prevent 
+ * default value. The value is read from NVS once and then served from the 
+ * RAM cache. The function also resets the watchdog timer to prevent 
  * unexpected resets.
  * 
  * @param key The key associated with the float value.
@@ -341,7 +616,14 @@ uint64_t ConfigManager::GetULong64(const char* key, int defaultValue) {
  */
 float ConfigManager::GetFloat(const char* key, float defaultValue) {
     esp_task_wdt_reset();
-    float value = preferences->getFloat(key, defaultValue);
+    ConfigCacheEntry* entry = cacheLoad(key, CFG_FLOAT);
+    if (entry == nullptr) {
+        stats.nvsReads++;
+        return preferences->getFloat(key, defaultValue);
+    }
+    if (!entry->present) return defaultValue;
+    float value;
+    memcpy(&value, &entry->scalar, sizeof(value));
     return value;
 }
 
@@ -350,7 +632,8 @@ float ConfigManager::GetFloat(const char* key, float defaultValue) {
  * 
  * This function retrieves a string value associated with the given key 
  * from the preferences. If the key does not exist, it returns the specified 
- * default value. The function also resets the watchdog timer to prevent 
+ * default value. The value is read from NVS once and then served from the 
+ * RAM cache. The function also resets the watchdog timer to prevent 
  * unexpected resets.
  * 
  * @param key The key associated with the string value.
@@ -359,131 +642,378 @@ float ConfigManager::GetFloat(const char* key, float defaultValue) {
  */
 String ConfigManager::GetString(const char* key, const String& defaultValue) {
     esp_task_wdt_reset();
-    String value = preferences->getString(key, defaultValue);
-    return value;
+    ConfigCacheEntry* entry = cacheLoad(key, CFG_STRING);
+    if (entry == nullptr) {
+        stats.nvsReads++;
+        return preferences->getString(key, defaultValue);
+    }
+    return entry->present ? entry->text : defaultValue;
+}
+
+/**
+ * @brief Gets a binary blob from preferences.
+ * 
+ * This function copies the blob associated with the given key into the 
+ * caller's buffer. The blob is read from NVS once and then served from the 
+ * RAM cache. The function also resets the watchdog timer to prevent 
+ * unexpected resets.
+ * 
+ * @param key The key associated with the blob.
+ * @param buffer Destination buffer.
+ * @param maxLength Size of the destination buffer.
+ * @return size_t Number of bytes read (0 if the key does not exist or does not fit).
+ */
+size_t ConfigManager::GetBytes(const char* key, void* buffer, size_t maxLength) {
+    esp_task_wdt_reset();
+    ConfigCacheEntry* entry = cacheLoad(key, CFG_BYTES);
+    if (entry == nullptr) {
+        if (!preferences->isKey(key)) return 0;
+        stats.nvsReads++;
+        return preferences->getBytes(key, buffer, maxLength);
+    }
+    if (!entry->present || entry->blobLength > maxLength) return 0;
+    memcpy(buffer, entry->blob, entry->blobLength);
+    return entry->blobLength;
+}
+
+/**
+ * @brief Gets the length of a binary blob.
+ * 
+ * @param key The key associated with the blob.
+ * @return size_t Length of the blob in bytes (0 if the key does not exist).
+ */
+size_t ConfigManager::GetBytesLength(const char* key) {
+    esp_task_wdt_reset();
+    ConfigCacheEntry* entry = cacheLoad(key, CFG_BYTES);
+    if (entry == nullptr) {
+        if (!preferences->isKey(key)) return 0;
+        stats.nvsReads++;
+        return preferences->getBytesLength(key);
+    }
+    return entry->present ? entry->blobLength : 0;
 }
 
 /**
  * @brief Puts a boolean value into preferences.
  * 
  * This function stores a boolean value associated with the given key 
- * in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
+ * in the RAM cache; it reaches NVS on the next commit() if it changed. 
+ * It also resets the watchdog timer to prevent unexpected resets.
  * 
  * @param key The key to associate with the boolean value.
  * @param value The boolean value to store.
  */
 void ConfigManager::PutBool(const char* key, bool value) {
     esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putBool(key, value);  // Store the new value
+    if (cacheStore(key, CFG_BOOL, value ? 1 : 0)) return;
+    RemoveNvsKey(key);
+    preferences->putBool(key, value);  // Cache full: write through
+    stats.nvsWrites++;
 }
 
 /**
  * @brief Puts an unsigned integer value into preferences.
  * 
  * This function stores an unsigned integer value associated with the given 
- * key in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
+ * key in the RAM cache; it reaches NVS on the next commit() if it changed. 
+ * It also resets the watchdog timer to prevent unexpected resets.
  * 
  * @param key The key to associate with the unsigned integer value.
  * @param value The unsigned integer value to store.
  */
 void ConfigManager::PutUInt(const char* key, int value) {
     esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putUInt(key, value);  // Store the new value
+    if (cacheStore(key, CFG_UINT, (uint32_t)value)) return;
+    RemoveNvsKey(key);
+    preferences->putUInt(key, value);  // Cache full: write through
+    stats.nvsWrites++;
 }
 
 /**
- * @brief Puts an unsigned integer value into preferences.
+ * @brief Puts an unsigned 64-bit integer value into preferences.
  * 
- * This function stores an unsigned integer value associated with the given 
- * key in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
+ * This function stores an unsigned 64-bit value associated with the given 
+ * key in the RAM cache; it reaches NVS on the next commit() if it changed. 
+ * It also resets the watchdog timer to prevent unexpected resets.
  * 
  * @param key The key to associate with the unsigned integer value.
  * @param value The unsigned integer value to store.
  */
-void ConfigManager::PutULong64(const char* key, int value) {
+void ConfigManager::PutULong64(const char* key, uint64_t value) {
     esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putULong64(key, value);  // Store the new value
+    if (cacheStore(key, CFG_U64, value)) return;
+    RemoveNvsKey(key);
+    preferences->putULong64(key, value);  // Cache full: write through
+    stats.nvsWrites++;
 }
 
 /**
  * @brief Puts an integer value into preferences.
  * 
  * This function stores an integer value associated with the given key 
- * in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
+ * in the RAM cache; it reaches NVS on the next commit() if it changed. 
+ * It also resets the watchdog timer to prevent unexpected resets.
  * 
  * @param key The key to associate with the integer value.
  * @param value The integer value to store.
  */
 void ConfigManager::PutInt(const char* key, int value) {
     esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putInt(key, value);  // Store the new value
+    if (cacheStore(key, CFG_INT, (uint32_t)value)) return;
+    RemoveNvsKey(key);
+    preferences->putInt(key, value);  // Cache full: write through
+    stats.nvsWrites++;
 }
 
 /**
  * @brief Puts a float value into preferences.
  * 
  * This function stores a float value associated with the given key 
- * in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
+ * in the RAM cache; it reaches NVS on the next commit() if it changed. 
+ * It also resets the watchdog timer to prevent unexpected resets.
  * 
  * @param key The key to associate with the float value.
  * @param value The float value to store.
  */
 void ConfigManager::PutFloat(const char* key, float value) {
     esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putFloat(key, value);  // Store the new value
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(value));
+    if (cacheStore(key, CFG_FLOAT, bits)) return;
+    RemoveNvsKey(key);
+    preferences->putFloat(key, value);  // Cache full: write through
+    stats.nvsWrites++;
 }
 
 /**
  * @brief Puts a string value into preferences.
  * 
  * This function stores a string value associated with the given key 
- * in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
+ * in the RAM cache; it reaches NVS on the next commit() if it changed. 
+ * It also resets the watchdog timer to prevent unexpected resets.
  * 
  * @param key The key to associate with the string value.
  * @param value The string value to store.
  */
 void ConfigManager::PutString(const char* key, const String& value) {
     esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putString(key, value);  // Store the new value
+    ConfigCacheEntry* entry = cacheLoad(key, CFG_STRING);
+    if (entry == nullptr) {
+        RemoveNvsKey(key);
+        preferences->putString(key, value);  // Cache full: write through
+        stats.nvsWrites++;
+        return;
+    }
+    if (entry->present && entry->type == CFG_STRING && entry->text == value) {
+        stats.skippedWrites++;
+        return;
+    }
+    entry->type = CFG_STRING;
+    entry->text = value;
+    entry->present = true;
+    entry->dirty = true;
+}
+
+/**
+ * @brief Puts a binary blob into preferences.
+ * 
+ * This function stores a blob associated with the given key in the RAM 
+ * cache; it reaches NVS on the next commit() if it changed. It also resets 
+ * the watchdog timer to prevent unexpected resets.
+ * 
+ * @param key The key to associate with the blob.
+ * @param value Pointer to the data to store.
+ * @param length Number of bytes to store.
+ */
+void ConfigManager::PutBytes(const char* key, const void* value, size_t length) {
+    esp_task_wdt_reset();
+    ConfigCacheEntry* entry = cacheLoad(key, CFG_BYTES);
+    if (entry != nullptr && entry->present && entry->type == CFG_BYTES &&
+        entry->blobLength == length && memcmp(entry->blob, value, length) == 0) {
+        stats.skippedWrites++;
+        return;
+    }
+
+    uint8_t* copy = entry != nullptr ? (uint8_t*)malloc(length ? length : 1) : nullptr;
+    if (copy == nullptr) {
+        if (entry != nullptr) entry->type = CFG_NONE;  // Out of memory: drop the stale entry
+        RemoveNvsKey(key);
+        preferences->putBytes(key, value, length);  // Write through
+        stats.nvsWrites++;
+        return;
+    }
+    memcpy(copy, value, length);
+    free(entry->blob);
+    entry->type = CFG_BYTES;
+    entry->blob = copy;
+    entry->blobLength = length;
+    entry->present = true;
+    entry->dirty = true;
+}
+
+/**
+ * @brief Opens the time checkpoint journal on first use.
+ * 
+ * @return true if the journal is ready.
+ */
+bool ConfigManager::openJournal() {
+    if (TimeJournal::isReady()) return true;
+#ifdef ARDUINO
+    if (!journalFlash.begin(TIME_JOURNAL_PARTITION)) {
+        if (DEBUGMODE) Serial.println("ConfigManager: No journal partition, checkpoints go to NVS");
+        return false;
+    }
+#else
+    if (!journalFlash.begin(TIME_JOURNAL_HOST_IMAGE, TIME_JOURNAL_HOST_SIZE)) return false;
+#endif
+    return TimeJournal::begin(journalFlash);
+}
+
+/**
+ * @brief Checkpoints the time so it survives a power loss.
+ * 
+ * The checkpoint is appended to the journal (one flash write, no NVS page 
+ * churn). Without a journal partition it falls back to the settings blob.
+ * 
+ * @param currentTime Current time (Unix seconds).
+ * @param lastTimeSaved Last checked time (Unix seconds).
+ */
+void ConfigManager::SaveTime(uint64_t currentTime, uint64_t lastTimeSaved) {
+    esp_task_wdt_reset();
+    EnergyScope phase(EnergyPhase::Nvs);
+    if (openJournal() && TimeJournal::append(currentTime, lastTimeSaved)) return;
+    Put<ConfigField::CurrentTime>(currentTime);
+    Put<ConfigField::LastTimeSaved>(lastTimeSaved);
+}
+
+/**
+ * @brief Returns the newest checkpointed time.
+ * 
+ * @return The journal's newest time, or the settings blob's if the journal is empty.
+ */
+uint64_t ConfigManager::LoadTime() {
+    JournalRecord record;
+    if (openJournal() && TimeJournal::latest(record)) return record.currentTime;
+    return Get<ConfigField::CurrentTime>();
+}
+
+/**
+ * @brief Loads the alarm schedule table.
+ * 
+ * If no table has been stored yet, the single alarm of earlier firmware 
+ * (`ALERT_TIMESTAMP_SAVED`) is migrated into a one-shot entry.
+ * 
+ * @param schedule The schedule to fill.
+ * @return true if a stored table (or a migrated alarm) was loaded.
+ */
+bool ConfigManager::LoadAlarms(AlarmSchedule& schedule) {
+    esp_task_wdt_reset();
+    schedule.clear();
+
+    size_t length = GetBytesLength(ALARM_TABLE_SAVED);
+    if (length > 0) {
+        uint8_t* buffer = (uint8_t*)malloc(length);
+        bool loaded = buffer != nullptr &&
+                      GetBytes(ALARM_TABLE_SAVED, buffer, length) == length &&
+                      schedule.deserialize(buffer, length);
+        free(buffer);
+        if (loaded) return true;
+        if (DEBUGMODE) Serial.println("ConfigManager: Alarm table corrupted, starting empty");
+        return false;
+    }
+
+    // Migrate the single alarm of earlier firmware
+    uint64_t legacy = Get<ConfigField::AlertTimestamp>();
+    if (legacy == 0 || legacy >= ALARM_NEVER) return false;
+    AlarmEntry rule = {};
+    rule.start = (uint32_t)legacy;
+    rule.repeat = ALARM_ONCE;
+    return schedule.add(rule, rule.start) >= 0;
+}
+
+/**
+ * @brief Saves the alarm schedule table.
+ * 
+ * The table is written as one blob and its next fire time is published in 
+ * `ALERT_TIMESTAMP_SAVED`, which is all the wake path needs to read.
+ * 
+ * @param schedule The schedule to store.
+ */
+void ConfigManager::SaveAlarms(const AlarmSchedule& schedule) {
+    esp_task_wdt_reset();
+    size_t length = schedule.serializedSize();
+    uint8_t* buffer = (uint8_t*)malloc(length);
+    if (buffer == nullptr) return;
+    schedule.serialize(buffer, length);
+    PutBytes(ALARM_TABLE_SAVED, buffer, length);
+    free(buffer);
+    Put<ConfigField::AlertTimestamp>(schedule.nextFire());
+}
+
+/**
+ * @brief Stores an alarm rule set by the user.
+ * 
+ * @param rule The rule to store.
+ * @param append true to add it to the existing table, false to replace the table.
+ * @param now Current local Unix time.
+ * @return The id of the new alarm, or -1 if it was rejected (table full or never fires).
+ */
+int ConfigManager::StoreAlarm(const AlarmEntry& rule, bool append, uint32_t now) {
+    AlarmSchedule schedule;
+    if (append) LoadAlarms(schedule);
+    int id = schedule.add(rule, now);
+    if (id < 0) return -1;
+    SaveAlarms(schedule);
+    return id;
 }
 
 /**
  * @brief Clears all stored preferences.
  * 
  * This function removes all key-value pairs from the preferences 
- * storage.
+ * storage and drops the RAM cache, including unflushed values.
  */
 void ConfigManager::ClearKey() {
+    for (uint8_t i = 0; i < CONFIG_CACHE_SIZE; i++) {
+        free(cache[i].blob);
+        cache[i] = ConfigCacheEntry();
+    }
     preferences->clear();
 }
 
 /**
  * @brief Removes a specific key from the preferences.
  * 
+ * The key is removed from NVS right away and its cached value (including 
+ * an unflushed one) is dropped.
+ * 
+ * @param key The key to remove from the preferences.
+ */
+void ConfigManager::RemoveKey(const char * key) {
+    ConfigCacheEntry* entry = cacheFind(key);
+    if (entry != nullptr) {
+        free(entry->blob);
+        *entry = ConfigCacheEntry();
+    }
+    RemoveNvsKey(key);
+}
+
+/**
+ * @brief Removes a specific key from NVS, bypassing the cache.
+ * 
  * This function checks if the specified key exists in the 
  * preferences and removes it if it does. If the key is not found, 
  * it logs a message if debugging is enabled.
  * 
  * @param key The key to remove from the preferences.
  */
-void ConfigManager::RemoveKey(const char * key) {
+void ConfigManager::RemoveNvsKey(const char * key) {
     esp_task_wdt_reset();  // Reset the watchdog timer
 
     // Check if the key exists before removing it
     if (preferences->isKey(key)) {
         preferences->remove(key);  // Remove the key if it exists
+        stats.nvsWrites++;
         if (DEBUGMODE) {
             Serial.print("Removed key: ");
             Serial.println(key);
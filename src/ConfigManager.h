@@ -16,6 +16,17 @@
  * - Methods for storing and retrieving configuration values.
  * - System control methods to restart the system or simulate power down for testing.
  * - Utility functions to manage application flags and reset conditions.
+ * - Typed settings declared once in `ConfigSchema.h` and stored as a single 
+ *   blob: `Get<ConfigField::LedState>()`, `Put<ConfigField::LedState>(true)`.
+ * - Time checkpoints appended to a raw-partition journal (`TimeJournal`) 
+ *   instead of rewriting NVS keys.
+ * - A write-back RAM cache: values are read from NVS once, Put* calls that 
+ *   do not change a value are skipped, and changed values are written by 
+ *   `commit()` (called before deep sleep and restart). `commit()` is not a 
+ *   transaction: NVS writes each key on its own (a batched `nvs_commit()` 
+ *   would not change that), so a reset in the middle can leave some keys 
+ *   written and others not. Each key is still all-or-nothing, which is why 
+ *   the schema settings travel as one CRC-checked blob.
  * 
  * This class is especially useful in applications where persistent configuration 
  * data is necessary, such as in IoT devices that require configuration 
@@ -27,21 +38,57 @@
 #include <time.h>
 #include <esp_task_wdt.h>
 #include <driver/rtc_io.h>
+#include <driver/gpio.h>
 #include <esp_sleep.h>
 #include <WiFi.h>
 #include <WiFiUdp.h>
-#include <ArduinoJson.h>
 
 
 // External libraries
-#include <NTPClient.h>
 #include <SPIFFS.h>
 #include <ESPAsyncWebServer.h>
 
 // Custom includes
 #include "Config.h"  // Include Config.h for default values
+#include "ConfigSchema.h"  // Include ConfigSchema for the typed settings
+#include "AlarmSchedule.h"  // Include AlarmSchedule for the alarm table
+#include "TimeJournal.h"  // Include TimeJournal for the time checkpoints
+#include "EnergyMeter.h"  // Include EnergyMeter for the per-phase charge accounting
+#include "WakeProfiler.h"  // Include WakeProfiler for the per-phase wake timing
 #include <Preferences.h>
 
+/**
+ * @brief NVS access counters of the configuration cache.
+ */
+struct ConfigStats {
+    uint32_t nvsReads;       ///< Values read from NVS
+    uint32_t nvsWrites;      ///< Values written to (or removed from) NVS
+    uint32_t skippedWrites;  ///< Put* calls that matched the cached value
+};
+
+/**
+ * @brief Outcome of loading the settings blob.
+ */
+enum class ConfigLoad : uint8_t {
+    Loaded,   ///< Settings read from the blob or migrated from the old keys
+    Empty,    ///< Nothing stored yet (first boot)
+    Damaged   ///< Blob unreadable: defaults kept in RAM, nothing erased
+};
+
+/**
+ * @brief One cached preference.
+ */
+struct ConfigCacheEntry {
+    char key[16] = {};             ///< NVS key (15 characters max)
+    uint8_t type = CFG_NONE;       ///< ConfigValueType of the cached value (CFG_NONE = free slot)
+    uint8_t stored = CFG_NONE;     ///< Type known to be in NVS (CFG_NONE = unknown or absent)
+    bool present = false;          ///< Key has a value
+    bool dirty = false;            ///< Value not yet written to NVS
+    uint64_t scalar = 0;           ///< Bool, integer and float values
+    String text;                   ///< String value
+    uint8_t* blob = nullptr;       ///< Blob value (heap)
+    size_t blobLength = 0;         ///< Blob length
+};
 
 class ConfigManager {
 public:
@@ -51,20 +98,55 @@ public:
     void begin();  // Initialize the configuration
     void end();    // End access to preferences
 
+    // Typed settings (ConfigSchema.h): a wrong or narrowing type fails to compile
+    template <typename Field>
+    typename ConfigAccess<typename Field::type>::result Get() {
+        if (!configLoaded) loadConfig();
+        return ConfigAccess<typename Field::type>::read(Field::ref(config));
+    }
+    template <typename Field, typename Value>
+    void Put(const Value& value) {
+        if (!configLoaded) loadConfig();
+        if (ConfigAccess<typename Field::type>::write(Field::ref(config), value)) {
+            configDirty = true;
+            configRevision++;
+        } else {
+            stats.skippedWrites++;
+        }
+    }
+    template <typename Field>
+    void Put(const String& value) {
+        Put<Field>(value.c_str());
+    }
+
    
     void PutBool(const char* key, bool value);      // Save a boolean value
     void PutInt(const char* key, int value);        // Save an integer value
     void PutFloat(const char* key, float value);    // Save a float value
     void PutString(const char* key, const String& value);  // Save a string value
     void PutUInt(const char* key, int value);       // Save an unsigned integer value
-    void PutULong64(const char* key, int value);       // Save an unsigned integer value
+    void PutULong64(const char* key, uint64_t value);  // Save an unsigned 64-bit integer value
+    void PutBytes(const char* key, const void* value, size_t length);  // Save a binary blob
 
 
     bool GetBool(const char* key, bool defaultValue);    // Retrieve a boolean value
     int GetInt(const char* key, int defaultValue);       // Retrieve an integer value
-    uint64_t GetULong64(const char* key, int defaultValue);       // Retrieve an UIntinteger value
+    uint64_t GetULong64(const char* key, uint64_t defaultValue);  // Retrieve an unsigned 64-bit integer value
     float GetFloat(const char* key, float defaultValue); // Retrieve a float value
     String GetString(const char* key, const String& defaultValue);  // Retrieve a string value
+    size_t GetBytes(const char* key, void* buffer, size_t maxLength);  // Retrieve a binary blob
+    size_t GetBytesLength(const char* key);  // Length of a binary blob
+
+    uint8_t commit();  // Write changed values to NVS, returns the number of keys written
+    const ConfigStats& getStats() const;  // NVS access counters
+    uint32_t revision() const;  // Changes whenever a typed setting changes (for caches built from them)
+
+    void SaveTime(uint64_t currentTime, uint64_t lastTimeSaved);  // Checkpoint the time (journal, NVS fallback)
+    uint64_t LoadTime();  // Newest checkpointed time
+
+    bool LoadAlarms(AlarmSchedule& schedule);  // Load the alarm table (migrates the single alarm)
+    void SaveAlarms(const AlarmSchedule& schedule);  // Save the alarm table and its next fire time
+    int StoreAlarm(const AlarmEntry& rule, bool append, uint32_t now);  // Add (or replace with) one alarm
 
     void RemoveKey(const char* key);  // Remove a specific key
     void ClearKey(); 
@@ -83,11 +165,27 @@ public:
 private:
     // Private utility methods for internal use only
     void initializeDefaults();   // Initialize default values
-    void initializeVariables();  // Initialize internal variables
     bool getResetFlag();         // Get system reset flag
+    ConfigLoad loadConfig();     // Load the settings blob
+    bool migrateLegacy();        // Migrate the per-setting keys of earlier firmware
+    bool openJournal();          // Open the time checkpoint journal
+    void RemoveNvsKey(const char* key);  // Remove a key from NVS, bypassing the cache
+
+    // RAM cache
+    ConfigCacheEntry* cacheFind(const char* key);
+    ConfigCacheEntry* cacheLoad(const char* key, uint8_t type);
+    bool cacheStore(const char* key, uint8_t type, uint64_t scalar);
+    void flushEntry(ConfigCacheEntry& entry);
 
     Preferences* preferences;     // Preferences object to store configuration
     const char* namespaceName;   // Namespace for the preferences storage
+    ConfigData config;           // Typed settings (RAM copy of the blob)
+    bool configLoaded;           // Settings blob loaded
+    bool configDirty;            // Settings changed since the last commit
+    uint32_t configRevision;     // Incremented on every change of the typed settings
+    ConfigCacheEntry cache[CONFIG_CACHE_SIZE];  // Write-back cache of the preferences
+    PartitionFlash journalFlash; // Partition of the time checkpoint journal
+    ConfigStats stats;           // NVS access counters
 };
 
 #endif // CONFIG_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "ConfigSchema.h"
+#include "Crc32.h"
+
+// Factory defaults, generated from the schema
+static const ConfigData kConfigDefaults = {
+#define CONFIG_DEFAULT(tag, member, type, key, def) {def},
+    CONFIG_FIELDS(CONFIG_DEFAULT)
+#undef CONFIG_DEFAULT
+};
+
+// Old per-key layout, generated from the schema
+static const ConfigLegacyField kLegacyFields[] = {
+#define CONFIG_LEGACY(tag, member, type, key, def) \
+    {key, ConfigKind<type>::value, (uint16_t)offsetof(ConfigData, member), (uint16_t)sizeof(type)},
+    CONFIG_FIELDS(CONFIG_LEGACY)
+#undef CONFIG_LEGACY
+};
+
+static_assert(sizeof(ConfigData) <= 0xFFFF, "ConfigData too large for the blob header");
+
+/**
+ * @brief Gives access to the factory defaults.
+ *
+ * @return The default settings.
+ */
+const ConfigData& ConfigSchema::defaults() {
+    return kConfigDefaults;
+}
+
+/**
+ * @brief Gives access to the table of the old one-key-per-setting layout.
+ *
+ * @param count Receives the number of entries.
+ * @return The table.
+ */
+const ConfigLegacyField* ConfigSchema::legacyFields(size_t& count) {
+    count = sizeof(kLegacyFields) / sizeof(kLegacyFields[0]);
+    return kLegacyFields;
+}
+
+/**
+ * @brief Builds a blob from the settings.
+ *
+ * @param blob The blob to fill.
+ * @param data The settings to store.
+ */
+void ConfigSchema::seal(ConfigBlob& blob, const ConfigData& data) {
+    blob.header.magic = CONFIG_BLOB_MAGIC;
+    blob.header.version = CONFIG_SCHEMA_VERSION;
+    blob.header.size = sizeof(ConfigData);
+    blob.header.reserved = 0;
+    blob.data = data;
+    blob.header.crc = crc32Update(&blob.data, sizeof(ConfigData));
+}
+
+/**
+ * @brief Checks magic, length and CRC of a stored blob.
+ *
+ * @param buffer The stored blob.
+ * @param length Length of the stored blob.
+ * @param header Receives the header.
+ * @return The data bytes, or nullptr if the blob is damaged.
+ */
+const uint8_t* ConfigSchema::payload(const void* buffer, size_t length, ConfigBlobHeader& header) {
+    if (length < sizeof(ConfigBlobHeader)) return nullptr;
+    memcpy(&header, buffer, sizeof(header));
+    if (header.magic != CONFIG_BLOB_MAGIC || length != sizeof(header) + header.size) return nullptr;
+
+    const uint8_t* data = (const uint8_t*)buffer + sizeof(header);
+    if (crc32Update(data, header.size) != header.crc) return nullptr;
+    return data;
+}
+
+/**
+ * @brief Validates a stored blob and loads its settings.
+ *
+ * A blob from an older schema version is shorter: its bytes are copied over
+ * the defaults, so fields appended since then keep their default value.
+ *
+ * @param buffer The stored blob.
+ * @param length Length of the stored blob.
+ * @param data Receives the settings (untouched if the blob is invalid).
+ * @return true if the blob was valid and not newer than this schema.
+ */
+bool ConfigSchema::decode(const void* buffer, size_t length, ConfigData& data) {
+    ConfigBlobHeader header;
+    const uint8_t* bytes = payload(buffer, length, header);
+    if (bytes == nullptr || header.version > CONFIG_SCHEMA_VERSION || header.size > sizeof(ConfigData)) return false;
+
+    data = kConfigDefaults;
+    memcpy(&data, bytes, header.size);
+    return true;
+}
+
+/**
+ * @brief Loads the settings this schema knows from a newer blob.
+ *
+ * Fields are only appended, so the first `sizeof(ConfigData)` bytes of a
+ * blob written by a later version hold this version's settings.
+ *
+ * @param buffer The stored blob.
+ * @param length Length of the stored blob.
+ * @param data Receives the settings (untouched if the blob is not a valid newer one).
+ * @return true if the blob was valid and written by a newer schema.
+ */
+bool ConfigSchema::decodeNewer(const void* buffer, size_t length, ConfigData& data) {
+    ConfigBlobHeader header;
+    const uint8_t* bytes = payload(buffer, length, header);
+    if (bytes == nullptr || header.version <= CONFIG_SCHEMA_VERSION || header.size < sizeof(ConfigData)) return false;
+
+    memcpy(&data, bytes, sizeof(ConfigData));
+    return true;
+}
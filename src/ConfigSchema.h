@@ -0,0 +1,167 @@
+#ifndef CONFIG_SCHEMA_H
+#define CONFIG_SCHEMA_H
+/**
+ * @file ConfigSchema.h
+ * @brief Typed configuration schema stored as a single NVS blob.
+ *
+ * Every setting is declared once in `CONFIG_FIELDS` with its tag, member,
+ * type, legacy NVS key and default. From that list the header generates:
+ * - `ConfigData`, the struct stored as one versioned, CRC-checked blob;
+ * - the factory defaults (`ConfigSchema::defaults()`);
+ * - a tag per field in `ConfigField`, used by `ConfigManager::Get<>()` and
+ *   `ConfigManager::Put<>()` so a wrong or narrowing type fails to compile;
+ * - the table used to migrate the old one-key-per-setting layout.
+ *
+ * Layout rule: fields are only ever appended. A blob written by an older
+ * schema version is shorter; its bytes are copied over the defaults, so the
+ * new fields start at their default value. A blob written by a newer
+ * version (firmware rolled back) is longer; `decodeNewer()` loads the
+ * prefix this version knows.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+#include "Config.h"
+
+// Value types of stored settings
+enum ConfigValueType : uint8_t { CFG_NONE, CFG_BOOL, CFG_INT, CFG_UINT, CFG_U64, CFG_FLOAT, CFG_STRING, CFG_BYTES };
+
+/**
+ * @brief Fixed-capacity text field (capacity includes the terminator).
+ */
+template <size_t N>
+struct ConfigText {
+    char value[N];
+};
+
+// Schema: tag, member, type, legacy key, default (append only)
+// AlertDate/AlertTime are the portal's display copy (HH:MM); alarms keep their seconds in the alarm table
+#define CONFIG_FIELDS(X) \
+    X(ResetFlag,      resetFlag,      bool,           RESET_FLAG,            false)                      \
+    X(LedState,       ledState,       bool,           LED_STATE,             DEFAULT_LED_STATE)          \
+    X(CurrentTime,    currentTime,    uint64_t,       CURRENT_TIME_SAVED,    DEFAULT_CURRENT_TIME_SAVED) \
+    X(LastTimeSaved,  lastTimeSaved,  uint64_t,       LAST_TIME_SAVED,       DEFAULT_LAST_TIME_SAVED)    \
+    X(AlertTimestamp, alertTimestamp, uint64_t,       ALERT_TIMESTAMP_SAVED, DEFAULT_ALERT_TIME_SAVED)   \
+    X(WifiSsid,       wifiSsid,       ConfigText<33>, WIFISSID,              DEFAULT_WIFI_SSID)          \
+    X(WifiPass,       wifiPass,       ConfigText<65>, WIFIPASS,              DEFAULT_WIFI_PASSWORD)      \
+    X(AlertDate,      alertDate,      ConfigText<11>, ALERT_DATE_,           DEFAULT_ALERT_DATE)         \
+    X(AlertTime,      alertTime,      ConfigText<6>,  ALERT_TIME_,           DEFAULT_ALERT_TIME)         \
+    X(AlarmPattern,   alarmPattern,   uint8_t,        ALARM_PATTERN_SAVED,   DEFAULT_ALARM_PATTERN)
+
+/**
+ * @brief All settings, stored as one blob.
+ */
+struct ConfigData {
+#define CONFIG_MEMBER(tag, member, type, key, def) type member;
+    CONFIG_FIELDS(CONFIG_MEMBER)
+#undef CONFIG_MEMBER
+};
+
+/**
+ * @brief Header of the stored blob.
+ */
+struct ConfigBlobHeader {
+    uint32_t magic;    ///< CONFIG_BLOB_MAGIC
+    uint16_t version;  ///< Schema version that wrote the blob
+    uint16_t size;     ///< sizeof(ConfigData) of that version
+    uint32_t crc;      ///< CRC-32 of the data bytes
+    uint32_t reserved; ///< Keeps the data 8-byte aligned
+};
+
+/**
+ * @brief Stored blob: header followed by the settings.
+ */
+struct ConfigBlob {
+    ConfigBlobHeader header;
+    ConfigData data;
+};
+
+#define CONFIG_BLOB_MAGIC 0x43464744UL  ///< "CFGD"
+
+static_assert(offsetof(ConfigBlob, data) == sizeof(ConfigBlobHeader), "ConfigBlob must not be padded");
+
+// Storage type of a field type (undefined for unsupported types)
+template <typename T> struct ConfigKind;
+template <> struct ConfigKind<bool> { static const uint8_t value = CFG_BOOL; };
+template <> struct ConfigKind<uint8_t> { static const uint8_t value = CFG_UINT; };
+template <> struct ConfigKind<uint64_t> { static const uint8_t value = CFG_U64; };
+template <size_t N> struct ConfigKind<ConfigText<N> > { static const uint8_t value = CFG_STRING; };
+
+// True if V converts to T without narrowing
+template <typename T, typename V, typename = void>
+struct ConfigLossless : std::false_type {};
+template <typename T, typename V>
+struct ConfigLossless<T, V, decltype(void(T{std::declval<V>()}))> : std::true_type {};
+
+/**
+ * @brief Typed read/write of a scalar field.
+ */
+template <typename T>
+struct ConfigAccess {
+    typedef T result;
+    static T read(const T& field) { return field; }
+    template <typename V>
+    static bool write(T& field, const V& value) {
+        static_assert(ConfigLossless<T, V>::value, "Value does not fit the config field type");
+        T converted = T{value};
+        if (field == converted) return false;
+        field = converted;
+        return true;
+    }
+};
+
+/**
+ * @brief Typed read/write of a text field (truncated to its capacity).
+ */
+template <size_t N>
+struct ConfigAccess<ConfigText<N> > {
+    typedef const char* result;
+    static const char* read(const ConfigText<N>& field) { return field.value; }
+    static bool write(ConfigText<N>& field, const char* value) {
+        ConfigText<N> next = {};
+        strncpy(next.value, value, N - 1);
+        if (memcmp(next.value, field.value, N) == 0) return false;
+        field = next;
+        return true;
+    }
+};
+
+// One tag per field: ConfigField::LedState, ConfigField::CurrentTime, ...
+namespace ConfigField {
+#define CONFIG_TAG(tag, member, fieldType, key, def)                             \
+    struct tag {                                                                \
+        typedef fieldType type;                                                 \
+        static type& ref(ConfigData& data) { return data.member; }              \
+        static const type& ref(const ConfigData& data) { return data.member; }  \
+    };
+    CONFIG_FIELDS(CONFIG_TAG)
+#undef CONFIG_TAG
+}
+
+/**
+ * @brief Location of a field in the old one-key-per-setting layout.
+ */
+struct ConfigLegacyField {
+    const char* key;   ///< NVS key used by earlier firmware
+    uint8_t type;      ///< ConfigValueType
+    uint16_t offset;   ///< Offset in ConfigData
+    uint16_t size;     ///< Size in ConfigData
+};
+
+class ConfigSchema {
+public:
+    static const ConfigData& defaults();  // Factory defaults
+    static const ConfigLegacyField* legacyFields(size_t& count);  // Migration table
+
+    static void seal(ConfigBlob& blob, const ConfigData& data);  // Fill header and CRC
+    static bool decode(const void* buffer, size_t length, ConfigData& data);  // Validate and load a blob
+    static bool decodeNewer(const void* buffer, size_t length, ConfigData& data);  // Known prefix of a newer blob
+
+private:
+    static const uint8_t* payload(const void* buffer, size_t length, ConfigBlobHeader& header);  // Checked data bytes
+};
+
+#endif // CONFIG_SCHEMA_H
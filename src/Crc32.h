@@ -0,0 +1,35 @@
+#ifndef CRC32_H
+#define CRC32_H
+/**
+ * @file Crc32.h
+ * @brief Small table-less CRC-32 (IEEE 802.3, reflected) used to validate
+ *        state blocks kept in RTC memory and flash.
+ *
+ * The implementation is deliberately platform independent so the same code
+ * runs on the ESP32 and in host builds.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Computes the CRC-32 of a buffer.
+ *
+ * @param data Pointer to the data to checksum.
+ * @param length Number of bytes to process.
+ * @param crc Running CRC from a previous call (0 to start a new checksum).
+ * @return The updated CRC-32 value.
+ */
+inline uint32_t crc32Update(const void* data, size_t length, uint32_t crc = 0) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    while (length--) {
+        crc ^= *bytes++;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1UL)));
+        }
+    }
+    return ~crc;
+}
+
+#endif // CRC32_H
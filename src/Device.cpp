@@ -1,4 +1,9 @@
 #include "Device.h"
+#include "EventLoop.h"
+#include "UlpWatch.h"
+
+// Duration of the last requested deep sleep, preserved across the sleep itself
+RTC_DATA_ATTR static unsigned long rtcLastSleepDuration = DEEPSLEEP_TIME;
 
 Device::Device() {
     _lastBlinkTime = 0;
@@ -13,6 +18,10 @@ void Device::begin() {
     
     pinMode(LED_GREEN_PIN, OUTPUT);// Initialize the LED pin as output
     digitalWrite(LED_GREEN_PIN,LOW);
+    // Release the buttons from the RTC domain (the wake stub and the ULP watch them during sleep)
+    UlpWatch::stop();
+    rtc_gpio_deinit((gpio_num_t)SWITCH_PIN);
+    rtc_gpio_deinit((gpio_num_t)PROG_SWITCH_PIN);
     pinMode(SWITCH_PIN, INPUT_PULLUP);  // Assuming the switch is connected to ground
 
     pinMode(PROG_SWITCH_PIN, INPUT_PULLUP);  // Assuming the switch is connected to ground
@@ -22,18 +31,57 @@ void Device::begin() {
 
 /**
  * @brief Blinks the LED at the specified interval.
- * Toggles the LED state every time the specified interval has passed.
- * This version uses delay() and blocks execution during the LED blink.
+ * Toggles the LED state, then waits for the interval in the event loop, so
+ * timers keep running and the CPU sleeps until the next toggle.
  *
  * @param interval The time interval (in milliseconds) for the LED blink.
  */
 void Device::blinkLED(unsigned long interval) {
-    // Toggle LED state
-    _ledState = !_ledState;
+    toggleLED();
+    EventLoop::waitFor(0, interval);
+}
+
+/**
+ * @brief Turns the LED on or off.
+ *
+ * @param on true to light the LED.
+ */
+void Device::setLED(bool on) {
+    _ledState = on;
     digitalWrite(LED_GREEN_PIN, _ledState ? HIGH : LOW);
-    
-    // Delay for the specified interval before toggling again
-    delay(interval);
+}
+
+/**
+ * @brief Inverts the LED state.
+ */
+void Device::toggleLED() {
+    setLED(!_ledState);
+}
+
+/**
+ * @brief Interrupt handler of the user button.
+ */
+static void IRAM_ATTR onButtonEdge() {
+    EventLoop::postFromISR(EVENT_BUTTON);
+}
+
+/**
+ * @brief Starts or stops posting EVENT_BUTTON when the user button is pressed.
+ *
+ * The pin also becomes a light-sleep wake source, so a press is seen right
+ * away rather than at the next timer.
+ *
+ * @param enable true to watch the button, false to release it.
+ */
+void Device::watchButton(bool enable) {
+    if (enable) {
+        attachInterrupt(digitalPinToInterrupt(SWITCH_PIN), onButtonEdge, FALLING);
+        gpio_wakeup_enable((gpio_num_t)SWITCH_PIN, GPIO_INTR_LOW_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+    } else {
+        detachInterrupt(digitalPinToInterrupt(SWITCH_PIN));
+        gpio_wakeup_disable((gpio_num_t)SWITCH_PIN);
+    }
 }
 
 
@@ -69,9 +117,27 @@ void Device::controlBuzzer(bool state) {
 }
 
 
+/**
+ * @brief Keeps an (active-low) button pulled up during deep sleep.
+ *
+ * @param pin GPIO number of the button (an RTC IO).
+ */
+static void holdButtonPullup(gpio_num_t pin) {
+    rtc_gpio_init(pin);
+    rtc_gpio_set_direction(pin, RTC_GPIO_MODE_INPUT_ONLY);
+    rtc_gpio_pulldown_dis(pin);
+    rtc_gpio_pullup_en(pin);
+}
+
 /**
  * @brief Puts the device into deep sleep mode for a given amount of time.
  *
+ * A press of either button ends the sleep early (see WakeSource). A button
+ * still held is waited for, up to `BUTTON_RELEASE_WAIT_MS`, then left out
+ * of the wake sources for this sleep. Sleeps of up to `ULP_COUNTDOWN_MAX_S`
+ * are counted down by the ULP, which also debounces the buttons (see
+ * UlpWatch); longer ones use the timer and the ext0/ext1 wakes.
+ *
  * @param sleepDuration The duration (in milliseconds) for the device to remain in deep sleep.
  */
 void Device::deepSleep(unsigned long sleepDuration) {
@@ -81,25 +147,62 @@ void Device::deepSleep(unsigned long sleepDuration) {
     if (DEBUGMODE)Serial.print(sleepDuration / 1000); // Convert milliseconds to seconds
     if (DEBUGMODE)Serial.println(" seconds.");
 
-    // Convert the sleep duration from milliseconds to microseconds
-    unsigned long sleepTimeInMicroseconds = sleepDuration * 1000;
+    // Remember the duration so the next boot can account for it
+    rtcLastSleepDuration = sleepDuration;
 
-    // Set the deep sleep duration
-    esp_sleep_enable_timer_wakeup(sleepTimeInMicroseconds);
+    // Convert the sleep duration from milliseconds to microseconds (64-bit, long sleeps overflow 32 bits)
+    uint64_t sleepTimeInMicroseconds = (uint64_t)sleepDuration * 1000ULL;
 
-    // Optional: Configure additional wakeup sources
-    // esp_sleep_enable_ext0_wakeup(GPIO_NUM_XX, HIGH); // Example GPIO wakeup
+    // A held button would end the sleep right away: give it time to be released
+    unsigned long heldSince = millis();
+    while (isButtonPressed() && millis() - heldSince < BUTTON_RELEASE_WAIT_MS) {
+        EventLoop::waitFor(0, BUTTON_POLL_MS);
+    }
+    bool buttonFree = !isButtonPressed();
+    bool switchFree = isProgButtonPressed();  // High = not in programming position
+
+    holdButtonPullup((gpio_num_t)SWITCH_PIN);
+    holdButtonPullup((gpio_num_t)PROG_SWITCH_PIN);
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);  // Keep the pull-ups powered
+    bool ulp = UlpWatch::start(sleepTimeInMicroseconds, buttonFree, switchFree);
+    if (ulp) {
+        // The ULP counts down and watches the buttons; the timer only backs it up
+        esp_sleep_enable_ulp_wakeup();
+        esp_sleep_enable_timer_wakeup(sleepTimeInMicroseconds + ULP_BACKSTOP_MS * 1000ULL);
+    } else {
+        // Timer, plus ext0 on the user button and ext1 on the programming switch (both active low)
+        UlpWatch::stop();
+        esp_sleep_enable_timer_wakeup(sleepTimeInMicroseconds);
+        if (buttonFree) esp_sleep_enable_ext0_wakeup((gpio_num_t)SWITCH_PIN, LOW);
+        if (switchFree) esp_sleep_enable_ext1_wakeup(1ULL << PROG_SWITCH_PIN, ESP_EXT1_WAKEUP_ALL_LOW);
+    }
 
     // Flush Serial buffer and notify before entering sleep
     if (DEBUGMODE)Serial.println("Entering deep sleep now...");
     if (DEBUGMODE)Serial.flush();
     delay(100); // Give time for Serial output to complete
 
+    // Charge the time from here to the wake to the sleep phase
+    EnergyMeter::sleep(sleepTimeInMicroseconds, ulp);
+    WakeProfiler::finish();  // Close the timing of this run
+
     // Enter deep sleep
     esp_deep_sleep_start();
 }
 
 
+/**
+ * @brief Returns the duration of the last deep sleep requested through deepSleep().
+ *
+ * The value lives in RTC memory, so after a timer wake it tells how long the
+ * device has been asleep. It defaults to `DEEPSLEEP_TIME` after a cold boot.
+ *
+ * @return Sleep duration in milliseconds.
+ */
+unsigned long Device::lastSleepDuration() {
+    return rtcLastSleepDuration;
+}
+
 /**
  * @brief Determines the cause of the wake-up and returns an integer based on the source.
  * This function handles all possible wake-up causes from deep sleep.
@@ -108,7 +211,6 @@ void Device::deepSleep(unsigned long sleepDuration) {
  *         - 0: Timer wakeup
  *         - 1: GPIO wakeup (external signal)
  *         - 2: Touchpad wakeup
- *         - 3: ULP program wakeup
  *         - 4: GPIO (light sleep only)
  *         - 5: UART wakeup (light sleep only)
  *         - 6: WiFi wakeup (light sleep only)
@@ -116,6 +218,7 @@ void Device::deepSleep(unsigned long sleepDuration) {
  *         - 8: COCPU trap trigger wakeup
  *         - 9: BT wakeup (light sleep only)
  *         - -1: Undefined or unknown wake-up cause
+ *         A ULP wake reports 0 for its countdown and 1 for a button.
  */
 int Device::getWakeUpCause() {
     // Get the wake-up reason from ESP32
@@ -135,7 +238,7 @@ int Device::getWakeUpCause() {
         case ESP_SLEEP_WAKEUP_TOUCHPAD:
             return 2;  // Touchpad wakeup
         case ESP_SLEEP_WAKEUP_ULP:
-            return 3;  // ULP program wakeup
+            return UlpWatch::reason() == UlpReason::Button ? 1 : 0;  // The ULP wakes on behalf of a button or the timer
         case ESP_SLEEP_WAKEUP_GPIO:
             return 4;  // GPIO wakeup (light sleep only)
         case ESP_SLEEP_WAKEUP_UART:
@@ -12,12 +12,18 @@ public:
     void begin();
     // Blink the LED with a given interval (in milliseconds)
     void blinkLED(unsigned long interval);
+    // Drive the LED without waiting
+    void setLED(bool on);
+    void toggleLED();
+    // Post EVENT_BUTTON on presses (interrupt, also wakes the CPU from light sleep)
+    void watchButton(bool enable);
     // Check if the button is pressed
     bool isButtonPressed();
     // Turn the buzzer on or off
     bool isProgButtonPressed();
     void controlBuzzer(bool state);
     void deepSleep(unsigned long sleepDuration);
+    unsigned long lastSleepDuration();  // Duration of the last deep sleep (ms)
     int getWakeUpCause();
 
 private:
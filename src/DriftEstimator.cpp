@@ -0,0 +1,283 @@
+#include "DriftEstimator.h"
+#include "TimeAccounting.h"
+#include "Crc32.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR  // Host builds: plain static storage
+#endif
+
+// Drift history preserved across deep sleep (restored from NVS after power loss)
+RTC_DATA_ATTR static DriftHistory rtcDriftHistory;
+
+/**
+ * @brief Gives access to the RTC-resident drift history.
+ *
+ * @return Reference to the history, e.g. to mirror it to NVS.
+ */
+DriftHistory& DriftEstimator::history() {
+    return rtcDriftHistory;
+}
+
+/**
+ * @brief Checks whether the RTC-resident history is intact.
+ *
+ * @return true if the history can be used.
+ */
+bool DriftEstimator::isValid() {
+    return validate(rtcDriftHistory);
+}
+
+/**
+ * @brief Starts an empty history with no usable sync.
+ */
+void DriftEstimator::reset() {
+    memset(&rtcDriftHistory, 0, sizeof(rtcDriftHistory));
+    rtcDriftHistory.magic = DRIFT_MAGIC;
+    rtcDriftHistory.syncRtcMicros = DRIFT_NO_SYNC;
+    seal(rtcDriftHistory);
+}
+
+/**
+ * @brief Adopts a history loaded from NVS after a power loss.
+ *
+ * The samples are kept, but the last sync is dropped since the RTC timer it
+ * refers to restarted with the power cycle.
+ *
+ * @param saved History read back from NVS.
+ */
+void DriftEstimator::restore(const DriftHistory& saved) {
+    if (!validate(saved)) {
+        reset();
+        return;
+    }
+    rtcDriftHistory = saved;
+    rtcDriftHistory.syncRtcMicros = DRIFT_NO_SYNC;
+    seal(rtcDriftHistory);
+}
+
+/**
+ * @brief Records a drift sample from an NTP sync.
+ *
+ * Must be called before the clock is set to the reference time. A sample is
+ * only taken if the current time anchor is the one set by the previous NTP
+ * sync (no manual time change in between) and enough time has elapsed for
+ * the offset to be meaningful.
+ *
+ * @param referenceMicros Reference (NTP) Unix time in microseconds.
+ * @return true if a sample was added to the history.
+ */
+bool DriftEstimator::recordSync(uint64_t referenceMicros) {
+    if (!isValid()) reset();
+
+    const TimeAnchor& anchor = TimeAccounting::anchor();
+    if (!TimeAccounting::isAnchored() || rtcDriftHistory.syncRtcMicros == DRIFT_NO_SYNC ||
+        anchor.rtcMicros != rtcDriftHistory.syncRtcMicros) {
+        return false;
+    }
+
+    uint64_t rtcNow = TimeAccounting::rtcMicros();
+    if (rtcNow <= anchor.rtcMicros) return false;
+    uint64_t elapsed = rtcNow - anchor.rtcMicros;
+    if (elapsed < (uint64_t)DRIFT_MIN_SAMPLE_INTERVAL * 1000000ULL) return false;
+
+    // Offset against the uncorrected clock, so samples do not depend on the previous fit
+    int64_t offset = (int64_t)(referenceMicros - (anchor.unixMicros + elapsed));
+    addSample(rtcDriftHistory, offset, elapsed);
+    return true;
+}
+
+/**
+ * @brief Remembers the anchor taken by an NTP sync and applies the new fit.
+ *
+ * Must be called right after the clock was set to the reference time.
+ */
+void DriftEstimator::markSynced() {
+    if (!isValid()) reset();
+    const TimeAnchor& anchor = TimeAccounting::anchor();
+    rtcDriftHistory.syncRtcMicros = anchor.rtcMicros;
+    rtcDriftHistory.syncUnix = anchor.unixMicros / 1000000ULL;
+    seal(rtcDriftHistory);
+    TimeAccounting::setDriftPpb(fitPpb(rtcDriftHistory));
+}
+
+/**
+ * @brief Fitted drift of the RTC-resident history.
+ *
+ * @return Drift in parts per billion.
+ */
+int32_t DriftEstimator::driftPpb() {
+    return isValid() ? fitPpb(rtcDriftHistory) : 0;
+}
+
+/**
+ * @brief Residual uncertainty of the RTC-resident history.
+ *
+ * @return Uncertainty in parts per billion.
+ */
+uint32_t DriftEstimator::uncertaintyPpb() {
+    if (!isValid()) return DRIFT_DEFAULT_UNCERTAINTY_PPM * 1000UL;
+    return uncertaintyPpb(rtcDriftHistory);
+}
+
+/**
+ * @brief Checks whether the predicted clock error calls for an NTP resync.
+ *
+ * @return true if the error predicted since the last sync exceeds DRIFT_MAX_ERROR_MS.
+ */
+bool DriftEstimator::needsResync() {
+    return secondsUntilResync() == 0;
+}
+
+/**
+ * @brief Time left until the next resync (see resyncIntervalMicros()).
+ *
+ * Without a usable NTP sync there is nothing to predict from and no resync
+ * is scheduled (UINT64_MAX is returned).
+ *
+ * @return Seconds until a resync is due (0 if already due).
+ */
+uint64_t DriftEstimator::secondsUntilResync() {
+    if (!isValid() || rtcDriftHistory.syncRtcMicros == DRIFT_NO_SYNC) return UINT64_MAX;
+    uint64_t rtcNow = TimeAccounting::rtcMicros();
+    uint64_t since = rtcNow > rtcDriftHistory.syncRtcMicros ? rtcNow - rtcDriftHistory.syncRtcMicros : 0;
+    uint64_t budget = resyncIntervalMicros(rtcDriftHistory);
+    return budget > since ? (budget - since) / 1000000ULL : 0;
+}
+
+/**
+ * @brief Recomputes and stores the CRC of a history.
+ *
+ * @param history The history to seal.
+ */
+void DriftEstimator::seal(DriftHistory& history) {
+    history.crc = crc32Update(&history, offsetof(DriftHistory, crc));
+}
+
+/**
+ * @brief Validates magic, bounds and CRC of a history.
+ *
+ * @param history The history to validate.
+ * @return true if the history is intact.
+ */
+bool DriftEstimator::validate(const DriftHistory& history) {
+    return history.magic == DRIFT_MAGIC &&
+           history.count <= DRIFT_HISTORY_SIZE &&
+           history.head < DRIFT_HISTORY_SIZE &&
+           history.crc == crc32Update(&history, offsetof(DriftHistory, crc));
+}
+
+/**
+ * @brief Appends a sample to the ring, evicting the oldest when full.
+ *
+ * @param history The history to update.
+ * @param offsetMicros Reference minus uncorrected local time.
+ * @param elapsedMicros RTC time elapsed since the previous sync.
+ */
+void DriftEstimator::addSample(DriftHistory& history, int64_t offsetMicros, uint64_t elapsedMicros) {
+    history.samples[history.head].offsetMicros = offsetMicros;
+    history.samples[history.head].elapsedMicros = elapsedMicros;
+    history.head = (history.head + 1) % DRIFT_HISTORY_SIZE;
+    if (history.count < DRIFT_HISTORY_SIZE) history.count++;
+    seal(history);
+}
+
+/**
+ * @brief Fits the drift of a history.
+ *
+ * Least squares through the origin with a variance proportional to the
+ * elapsed time, i.e. the total offset over the total elapsed time.
+ *
+ * @param history The history to fit.
+ * @return Drift in parts per billion (0 without samples).
+ */
+int32_t DriftEstimator::fitPpb(const DriftHistory& history) {
+    double offsets = 0;
+    double elapsed = 0;
+    for (uint8_t i = 0; i < history.count; i++) {
+        offsets += (double)history.samples[i].offsetMicros;
+        elapsed += (double)history.samples[i].elapsedMicros;
+    }
+    if (elapsed <= 0) return 0;
+    return (int32_t)lround(offsets * 1e9 / elapsed);
+}
+
+/**
+ * @brief Residual uncertainty of the drift fit.
+ *
+ * Elapsed-weighted spread of the per-sample drift around the fit, plus the
+ * quantization of the reference time over the average interval. Fewer than
+ * two samples fall back to DRIFT_DEFAULT_UNCERTAINTY_PPM.
+ *
+ * @param history The history to evaluate.
+ * @return Uncertainty in parts per billion.
+ */
+uint32_t DriftEstimator::uncertaintyPpb(const DriftHistory& history) {
+    if (history.count < 2) return DRIFT_DEFAULT_UNCERTAINTY_PPM * 1000UL;
+
+    double fit = fitPpb(history);
+    double weighted = 0;
+    double elapsed = 0;
+    for (uint8_t i = 0; i < history.count; i++) {
+        double e = (double)history.samples[i].elapsedMicros;
+        double ppb = (double)history.samples[i].offsetMicros * 1e9 / e;
+        weighted += e * (ppb - fit) * (ppb - fit);
+        elapsed += e;
+    }
+    double spread = sqrt(weighted / elapsed);
+    double quantization = (DRIFT_SYNC_RESOLUTION_MS * 1000.0) * 1e9 / (elapsed / history.count);
+    double sigma = spread + quantization;
+    if (sigma < DRIFT_MIN_UNCERTAINTY_PPM * 1000.0) sigma = DRIFT_MIN_UNCERTAINTY_PPM * 1000.0;
+    return (uint32_t)sigma;
+}
+
+/**
+ * @brief Predicted clock error some time after a sync.
+ *
+ * @param history The history to evaluate.
+ * @param sinceSyncMicros RTC time elapsed since the sync.
+ * @return Predicted error in microseconds.
+ */
+uint64_t DriftEstimator::predictedErrorMicros(const DriftHistory& history, uint64_t sinceSyncMicros) {
+    return (uint64_t)DRIFT_SYNC_RESOLUTION_MS * 1000ULL +
+           (uint64_t)((double)sinceSyncMicros * uncertaintyPpb(history) / 1e9);
+}
+
+/**
+ * @brief Time after a sync at which the predicted error reaches a bound.
+ *
+ * @param history The history to evaluate.
+ * @param errorMicros Error bound in microseconds.
+ * @return RTC time in microseconds after the sync (0 if the bound is already reached).
+ */
+uint64_t DriftEstimator::microsUntilError(const DriftHistory& history, uint64_t errorMicros) {
+    uint64_t base = (uint64_t)DRIFT_SYNC_RESOLUTION_MS * 1000ULL;
+    if (errorMicros <= base) return 0;
+    return (uint64_t)((double)(errorMicros - base) * 1e9 / uncertaintyPpb(history));
+}
+
+/**
+ * @brief Interval from a sync to the next resync.
+ *
+ * The time at which the predicted error reaches DRIFT_MAX_ERROR_MS, kept
+ * between DRIFT_MIN_SAMPLE_INTERVAL (a sooner sync would not add a sample,
+ * so the fit could never improve) and DRIFT_MAX_RESYNC_INTERVAL (so a fit
+ * that looks better than the clock really is still gets checked).
+ *
+ * @param history The history to evaluate.
+ * @return Interval in microseconds of RTC time.
+ */
+uint64_t DriftEstimator::resyncIntervalMicros(const DriftHistory& history) {
+    uint64_t interval = microsUntilError(history, (uint64_t)DRIFT_MAX_ERROR_MS * 1000ULL);
+    uint64_t shortest = (uint64_t)DRIFT_MIN_SAMPLE_INTERVAL * 1000000ULL;
+    uint64_t longest = (uint64_t)DRIFT_MAX_RESYNC_INTERVAL * 1000000ULL;
+    if (interval < shortest) return shortest;
+    if (interval > longest) return longest;
+    return interval;
+}
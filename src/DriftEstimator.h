@@ -0,0 +1,75 @@
+#ifndef DRIFT_ESTIMATOR_H
+#define DRIFT_ESTIMATOR_H
+/**
+ * @file DriftEstimator.h
+ * @brief RTC slow-clock drift estimation and adaptive NTP resync scheduling.
+ *
+ * Each NTP sync compares the reference time with the uncorrected clock
+ * rebuilt from the previous sync anchor and stores the (offset, elapsed)
+ * pair in a small ring. A weighted fit over the ring gives the drift of the
+ * RC slow clock in parts per billion; `TimeAccounting` applies it on every
+ * wake. The spread of the samples gives the residual uncertainty, from which
+ * the next resync is scheduled: when the predicted error reaches
+ * `DRIFT_MAX_ERROR_MS`, but not sooner than `DRIFT_MIN_SAMPLE_INTERVAL` (an
+ * earlier sync gives no sample) and not later than
+ * `DRIFT_MAX_RESYNC_INTERVAL` (a wrong fit cannot stop the resyncs).
+ *
+ * The history lives in RTC slow memory and is mirrored to NVS at each sync
+ * so the oscillator characteristic survives power loss. The module only
+ * depends on the C library and runs unchanged in host builds.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+#define DRIFT_MAGIC 0x44524654UL  ///< "DRFT"
+#define DRIFT_NO_SYNC UINT64_MAX  ///< syncRtcMicros value when no usable sync exists
+
+/**
+ * @brief One drift observation.
+ */
+struct DriftSample {
+    int64_t offsetMicros;    ///< Reference minus uncorrected local time at the sync
+    uint64_t elapsedMicros;  ///< RTC time elapsed since the previous sync
+};
+
+/**
+ * @brief Persistent drift history (RTC slow memory, mirrored to NVS).
+ */
+struct DriftHistory {
+    uint32_t magic;                            ///< DRIFT_MAGIC when valid
+    uint8_t count;                             ///< Valid samples in the ring
+    uint8_t head;                              ///< Next slot to write
+    uint16_t reserved;                         ///< Padding, always 0
+    uint64_t syncRtcMicros;                    ///< RTC timer at the last NTP sync
+    uint64_t syncUnix;                         ///< Unix time of the last NTP sync
+    DriftSample samples[DRIFT_HISTORY_SIZE];   ///< Sample ring
+    uint32_t crc;                              ///< CRC-32 of the preceding fields
+};
+
+class DriftEstimator {
+public:
+    static DriftHistory& history();  // RTC-resident history
+    static bool isValid();
+    static void reset();  // Start an empty history
+    static void restore(const DriftHistory& saved);  // Adopt a history loaded from NVS
+
+    static bool recordSync(uint64_t referenceMicros);  // Feed an NTP sync (before setting the clock)
+    static void markSynced();  // Remember the new anchor (after setting the clock)
+    static int32_t driftPpb();  // Fitted drift
+    static uint32_t uncertaintyPpb();  // Residual uncertainty of the fit
+    static bool needsResync();  // Predicted error above DRIFT_MAX_ERROR_MS
+    static uint64_t secondsUntilResync();  // Time left before a resync is due
+
+    // Pure helpers (host testable)
+    static void seal(DriftHistory& history);
+    static bool validate(const DriftHistory& history);
+    static void addSample(DriftHistory& history, int64_t offsetMicros, uint64_t elapsedMicros);
+    static int32_t fitPpb(const DriftHistory& history);
+    static uint32_t uncertaintyPpb(const DriftHistory& history);
+    static uint64_t predictedErrorMicros(const DriftHistory& history, uint64_t sinceSyncMicros);
+    static uint64_t microsUntilError(const DriftHistory& history, uint64_t errorMicros);
+    static uint64_t resyncIntervalMicros(const DriftHistory& history);  // Sync to resync, clamped
+};
+
+#endif // DRIFT_ESTIMATOR_H
@@ -0,0 +1,278 @@
+#include "EnergyMeter.h"
+#include "TimeAccounting.h"
+#include "Crc32.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR  // Host builds: plain static storage
+#endif
+
+// Ledger preserved across deep sleep (zeroed on power-on)
+RTC_DATA_ATTR static EnergyLedger rtcEnergyLedger;
+
+static EnergyModel energyModel = EnergyMeter::defaultModel();
+
+/**
+ * @brief Starts the accounting of an application boot.
+ *
+ * Called once, early in setup(). A valid ledger left in the sleep phase is
+ * closed at the programmed wake time; the time since then is boot. Any other
+ * valid ledger (software restart) charges the gap to the phase that was
+ * open. Without a valid ledger everything since power-on counts as boot.
+ *
+ * @param timerWakes Timer wakes since the application last ran (including those absorbed by the wake stub).
+ */
+void EnergyMeter::begin(uint32_t timerWakes) {
+    uint64_t now = TimeAccounting::rtcMicros();
+    if (!validate(rtcEnergyLedger) || now < rtcEnergyLedger.markRtcMicros) {
+        reset(rtcEnergyLedger, 0);  // RTC timer restarted at power-on
+    }
+    wake(rtcEnergyLedger, energyModel, now, timerWakes);
+}
+
+/**
+ * @brief Closes the open phase and opens another one.
+ *
+ * @param phase The phase the firmware enters now.
+ */
+void EnergyMeter::enter(EnergyPhase phase) {
+    if (!validate(rtcEnergyLedger)) return;
+    transition(rtcEnergyLedger, energyModel, phase, TimeAccounting::rtcMicros());
+}
+
+/**
+ * @brief Opens the sleep phase right before entering deep sleep.
+ *
+ * @param sleepMicros Programmed length of one sleep (the wake stub repeats it).
+ * @param ulp true if the ULP counts the sleep down.
+ */
+void EnergyMeter::sleep(uint64_t sleepMicros, bool ulp) {
+    if (!validate(rtcEnergyLedger)) return;
+    transition(rtcEnergyLedger, energyModel, ulp ? EnergyPhase::UlpSleep : EnergyPhase::Sleep, TimeAccounting::rtcMicros());
+    rtcEnergyLedger.plannedSleepMicros = sleepMicros;
+    seal(rtcEnergyLedger);
+}
+
+/**
+ * @brief Returns the phase currently open.
+ *
+ * @return The open phase (Active if the ledger is not valid).
+ */
+EnergyPhase EnergyMeter::phase() {
+    if (!validate(rtcEnergyLedger)) return EnergyPhase::Active;
+    return (EnergyPhase)rtcEnergyLedger.phase;
+}
+
+/**
+ * @brief Gives read access to the ledger.
+ *
+ * @return Reference to the ledger stored in RTC slow memory.
+ */
+const EnergyLedger& EnergyMeter::ledger() {
+    return rtcEnergyLedger;
+}
+
+/**
+ * @brief Derives consumption figures from the ledger.
+ *
+ * The open phase is included up to now.
+ *
+ * @return Consumption and battery life projection.
+ */
+EnergyReport EnergyMeter::report() {
+    if (!validate(rtcEnergyLedger)) return summarize(EnergyLedger(), energyModel);
+    EnergyLedger snapshot = rtcEnergyLedger;
+    transition(snapshot, energyModel, (EnergyPhase)snapshot.phase, TimeAccounting::rtcMicros());
+    return summarize(snapshot, energyModel);
+}
+
+/**
+ * @brief Replaces the current model (applies to time accounted from now on).
+ *
+ * @param model The new model.
+ */
+void EnergyMeter::setModel(const EnergyModel& model) {
+    energyModel = model;
+}
+
+const EnergyModel& EnergyMeter::model() {
+    return energyModel;
+}
+
+/**
+ * @brief Builds the model from the values in Config.h.
+ *
+ * @return The default energy model.
+ */
+EnergyModel EnergyMeter::defaultModel() {
+    EnergyModel model = {};
+    model.currentUa[(uint8_t)EnergyPhase::Boot] = ENERGY_CURRENT_BOOT_UA;
+    model.currentUa[(uint8_t)EnergyPhase::Active] = ENERGY_CURRENT_ACTIVE_UA;
+    model.currentUa[(uint8_t)EnergyPhase::Countdown] = ENERGY_CURRENT_COUNTDOWN_UA;
+    model.currentUa[(uint8_t)EnergyPhase::Nvs] = ENERGY_CURRENT_NVS_UA;
+    model.currentUa[(uint8_t)EnergyPhase::WifiConnect] = ENERGY_CURRENT_WIFI_UA;
+    model.currentUa[(uint8_t)EnergyPhase::Ntp] = ENERGY_CURRENT_NTP_UA;
+    model.currentUa[(uint8_t)EnergyPhase::LedBlink] = ENERGY_CURRENT_LED_UA;
+    model.currentUa[(uint8_t)EnergyPhase::Idle] = ENERGY_CURRENT_IDLE_UA;
+    model.currentUa[(uint8_t)EnergyPhase::Sleep] = ENERGY_CURRENT_SLEEP_UA;
+    model.currentUa[(uint8_t)EnergyPhase::UlpSleep] = ENERGY_CURRENT_ULP_SLEEP_UA;
+    model.batteryMah = ENERGY_BATTERY_MAH;
+    return model;
+}
+
+/**
+ * @brief Short name of a phase, for reports.
+ *
+ * @param phase The phase.
+ * @return A static string.
+ */
+const char* EnergyMeter::phaseName(EnergyPhase phase) {
+    switch (phase) {
+        case EnergyPhase::Boot:        return "boot";
+        case EnergyPhase::Active:      return "active";
+        case EnergyPhase::Countdown:   return "countdown";
+        case EnergyPhase::Nvs:         return "nvs";
+        case EnergyPhase::WifiConnect: return "wifi";
+        case EnergyPhase::Ntp:         return "ntp";
+        case EnergyPhase::LedBlink:    return "led";
+        case EnergyPhase::Idle:        return "idle";
+        case EnergyPhase::Sleep:       return "sleep";
+        case EnergyPhase::UlpSleep:    return "ulp";
+        default:                       return "?";
+    }
+}
+
+/**
+ * @brief Starts an empty ledger with the boot phase open.
+ *
+ * @param ledger The ledger to reset.
+ * @param rtcMicros RTC timer at which the boot phase starts.
+ */
+void EnergyMeter::reset(EnergyLedger& ledger, uint64_t rtcMicros) {
+    memset(&ledger, 0, sizeof(ledger));
+    ledger.magic = ENERGY_MAGIC;
+    ledger.version = ENERGY_VERSION;
+    ledger.phase = (uint8_t)EnergyPhase::Boot;
+    ledger.markRtcMicros = rtcMicros;
+    seal(ledger);
+}
+
+/**
+ * @brief Accounts an application boot and opens the active phase.
+ *
+ * @param ledger A valid ledger.
+ * @param model Current model.
+ * @param rtcMicros RTC timer now (start of setup()).
+ * @param timerWakes Timer wakes covered by the sleep.
+ */
+void EnergyMeter::wake(EnergyLedger& ledger, const EnergyModel& model, uint64_t rtcMicros, uint32_t timerWakes) {
+    if (ledger.phase == (uint8_t)EnergyPhase::Sleep || ledger.phase == (uint8_t)EnergyPhase::UlpSleep) {
+        uint64_t wakeAt = ledger.markRtcMicros + ledger.plannedSleepMicros * (timerWakes ? timerWakes : 1);
+        if (wakeAt > rtcMicros) wakeAt = rtcMicros;  // Woken early (button, reset)
+        transition(ledger, model, EnergyPhase::Boot, wakeAt);
+    } else if (ledger.phase != (uint8_t)EnergyPhase::Boot) {
+        transition(ledger, model, EnergyPhase::Boot, rtcMicros);  // Software restart
+    }
+    transition(ledger, model, EnergyPhase::Active, rtcMicros);
+    ledger.boots++;
+    ledger.plannedSleepMicros = 0;
+    seal(ledger);
+}
+
+/**
+ * @brief Closes the open phase at `rtcMicros` and opens `next`.
+ *
+ * @param ledger A valid ledger.
+ * @param model Current model.
+ * @param next Phase to open.
+ * @param rtcMicros RTC timer at the transition.
+ */
+void EnergyMeter::transition(EnergyLedger& ledger, const EnergyModel& model, EnergyPhase next, uint64_t rtcMicros) {
+    if (rtcMicros > ledger.markRtcMicros) {
+        account(ledger, model, (EnergyPhase)ledger.phase, rtcMicros - ledger.markRtcMicros);
+        ledger.markRtcMicros = rtcMicros;
+    }
+    ledger.phase = (uint8_t)next;
+    seal(ledger);
+}
+
+/**
+ * @brief Adds time spent in a phase and the matching charge.
+ *
+ * @param ledger The ledger to update (not resealed).
+ * @param model Current model.
+ * @param phase The phase.
+ * @param micros Time spent in it.
+ */
+void EnergyMeter::account(EnergyLedger& ledger, const EnergyModel& model, EnergyPhase phase, uint64_t micros) {
+    uint8_t index = (uint8_t)phase;
+    if (index >= ENERGY_PHASE_COUNT) return;
+    ledger.phaseMicros[index] += micros;
+    ledger.chargeNc[index] += (micros * model.currentUa[index]) / 1000ULL;  // uA x us = pC
+}
+
+/**
+ * @brief Derives consumption figures from a ledger.
+ *
+ * @param ledger The ledger.
+ * @param model Model providing the battery capacity.
+ * @return The report (zeros when nothing was accounted).
+ */
+EnergyReport EnergyMeter::summarize(const EnergyLedger& ledger, const EnergyModel& model) {
+    EnergyReport report = {};
+    for (uint8_t i = 0; i < ENERGY_PHASE_COUNT; i++) {
+        report.elapsedMicros += ledger.phaseMicros[i];
+        report.chargeNc += ledger.chargeNc[i];
+    }
+    report.boots = ledger.boots;
+    if (report.elapsedMicros == 0) return report;
+
+    // 1 mAh = 3.6 C = 3.6e9 nC
+    double mah = report.chargeNc / 3.6e9;
+    report.mahPerDay = (float)(mah * 86400e6 / report.elapsedMicros);
+    if (report.mahPerDay > 0) report.batteryDays = model.batteryMah / report.mahPerDay;
+    return report;
+}
+
+/**
+ * @brief Validates magic, version and CRC of a ledger.
+ *
+ * @param ledger The ledger to validate.
+ * @return true if the ledger is intact.
+ */
+bool EnergyMeter::validate(const EnergyLedger& ledger) {
+    return ledger.magic == ENERGY_MAGIC &&
+           ledger.version == ENERGY_VERSION &&
+           ledger.phase < ENERGY_PHASE_COUNT &&
+           ledger.crc == crc32Update(&ledger, offsetof(EnergyLedger, crc));
+}
+
+/**
+ * @brief Recomputes and stores the CRC of a ledger.
+ *
+ * @param ledger The ledger to seal.
+ */
+void EnergyMeter::seal(EnergyLedger& ledger) {
+    ledger.crc = crc32Update(&ledger, offsetof(EnergyLedger, crc));
+}
+
+/**
+ * @brief Opens a phase and remembers the one to return to.
+ *
+ * @param phase The phase to open.
+ */
+EnergyScope::EnergyScope(EnergyPhase phase) : _phase(phase), _previous(EnergyMeter::phase()) {
+    EnergyMeter::enter(phase);
+}
+
+/**
+ * @brief Returns to the previous phase unless another transition happened.
+ */
+EnergyScope::~EnergyScope() {
+    if (EnergyMeter::phase() == _phase) EnergyMeter::enter(_previous);
+}
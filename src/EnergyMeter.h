@@ -0,0 +1,126 @@
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+/**
+ * @file EnergyMeter.h
+ * @brief Per-phase charge accounting across deep sleep.
+ *
+ * The firmware marks the phase it is in (boot, countdown, NVS, Wi-Fi
+ * association, NTP, LED blink, light sleep between events, sleep with or
+ * without the ULP, everything else is "active"). On each transition the time spent in the closing phase,
+ * taken from the RTC timer, is multiplied by the current of that phase in
+ * the `EnergyModel` and added to a ledger kept in RTC slow memory. Deep
+ * sleep is a phase like the others: the next boot closes it at the
+ * programmed wake time and counts the remainder (ROM, bootloader, wake
+ * stub) as boot.
+ *
+ * From the ledger the meter derives the average charge per day and the
+ * projected battery life. The ledger is CRC protected and restarts from
+ * zero after a power-on reset.
+ *
+ * The module only depends on the C library and `TimeAccounting`, so the
+ * same accounting runs in host builds on the virtual RTC timer.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+#define ENERGY_MAGIC 0x454E5247UL  ///< "ENRG"
+#define ENERGY_VERSION 3           ///< Layout version of the ledger
+
+/**
+ * @brief Phases of a wake, each with its own current.
+ */
+enum class EnergyPhase : uint8_t {
+    Boot,         ///< ROM, bootloader, wake stub and early init
+    Active,       ///< Any other awake time
+    Countdown,    ///< User action window before the mode selection
+    Nvs,          ///< Preferences open, load and commit
+    WifiConnect,  ///< Station association
+    Ntp,          ///< NTP exchange
+    LedBlink,     ///< Alarm indication
+    Idle,         ///< Light sleep between events (event loop waits)
+    Sleep,        ///< Deep sleep
+    UlpSleep,     ///< Deep sleep counted down by the ULP
+    Count
+};
+
+#define ENERGY_PHASE_COUNT ((uint8_t)EnergyPhase::Count)
+
+/**
+ * @brief Current drawn in each phase and the battery it runs from.
+ */
+struct EnergyModel {
+    uint32_t currentUa[ENERGY_PHASE_COUNT];  ///< Average current per phase (microamps)
+    uint32_t batteryMah;                     ///< Usable battery capacity
+};
+
+/**
+ * @brief Ledger kept in RTC slow memory.
+ */
+struct EnergyLedger {
+    uint32_t magic;                              ///< ENERGY_MAGIC when valid
+    uint16_t version;                            ///< ENERGY_VERSION
+    uint8_t phase;                               ///< Phase currently open
+    uint8_t reserved;                            ///< Padding, always 0
+    uint64_t markRtcMicros;                      ///< RTC timer when the open phase started
+    uint64_t plannedSleepMicros;                 ///< Programmed length of one sleep (Sleep phase only)
+    uint64_t phaseMicros[ENERGY_PHASE_COUNT];    ///< Time spent per phase
+    uint64_t chargeNc[ENERGY_PHASE_COUNT];       ///< Charge per phase (nanocoulombs)
+    uint32_t boots;                              ///< Application boots accounted
+    uint32_t crc;                                ///< CRC-32 of the preceding fields
+};
+
+/**
+ * @brief Figures derived from the ledger.
+ */
+struct EnergyReport {
+    uint64_t elapsedMicros;  ///< Time covered by the ledger
+    uint64_t chargeNc;       ///< Total charge
+    float mahPerDay;         ///< Average consumption
+    float batteryDays;       ///< Projected battery life (0 = unknown)
+    uint32_t boots;          ///< Application boots accounted
+};
+
+class EnergyMeter {
+public:
+    static void begin(uint32_t timerWakes);  // Close the sleep at wake and open the boot phase
+    static void enter(EnergyPhase phase);  // Close the open phase, open another one
+    static void sleep(uint64_t sleepMicros, bool ulp);  // Open the sleep phase right before deep sleep
+    static EnergyPhase phase();
+
+    static const EnergyLedger& ledger();
+    static EnergyReport report();
+    static void setModel(const EnergyModel& model);
+    static const EnergyModel& model();
+    static EnergyModel defaultModel();  // Model built from Config.h
+    static const char* phaseName(EnergyPhase phase);
+
+    // Pure helpers operating on an arbitrary ledger (host testable)
+    static void reset(EnergyLedger& ledger, uint64_t rtcMicros);
+    static void wake(EnergyLedger& ledger, const EnergyModel& model, uint64_t rtcMicros, uint32_t timerWakes);
+    static void transition(EnergyLedger& ledger, const EnergyModel& model, EnergyPhase next, uint64_t rtcMicros);
+    static void account(EnergyLedger& ledger, const EnergyModel& model, EnergyPhase phase, uint64_t micros);
+    static EnergyReport summarize(const EnergyLedger& ledger, const EnergyModel& model);
+    static bool validate(const EnergyLedger& ledger);
+    static void seal(EnergyLedger& ledger);
+};
+
+/**
+ * @brief Marks a phase for the lifetime of the object, then returns to the previous one.
+ *
+ * The previous phase is only restored if no other transition happened
+ * meanwhile (in particular deep sleep).
+ */
+class EnergyScope {
+public:
+    explicit EnergyScope(EnergyPhase phase);
+    ~EnergyScope();
+    EnergyScope(const EnergyScope&) = delete;
+    EnergyScope& operator=(const EnergyScope&) = delete;
+
+private:
+    EnergyPhase _phase;
+    EnergyPhase _previous;
+};
+
+#endif // ENERGY_METER_H
@@ -0,0 +1,35 @@
+#include "EntityTag.h"
+#include <string.h>
+
+/**
+ * @brief Checks an `If-None-Match` header against the ETag of a page.
+ *
+ * @param ifNoneMatch Value of the header (nullptr = no header).
+ * @param etag Strong ETag of the page, with its quotes.
+ * @return true if the client already has this version of the page.
+ */
+bool EntityTag::matches(const char* ifNoneMatch, const char* etag) {
+    if (ifNoneMatch == nullptr || etag == nullptr) return false;
+    size_t etagLength = strlen(etag);
+    const char* p = ifNoneMatch;
+    while (true) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;  // Optional whitespace, empty list elements
+        if (*p == '\0') return false;
+        if (*p == '*') return true;
+
+        bool weak = false;
+        if (p[0] == 'W' && p[1] == '/') {
+            weak = true;
+            p += 2;
+        }
+        if (*p != '"') return false;  // Malformed
+        const char* close = strchr(p + 1, '"');
+        if (close == nullptr) return false;
+        size_t length = close - p + 1;
+        bool equal = !weak && length == etagLength && memcmp(p, etag, length) == 0;
+        p = close + 1;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p != ',' && *p != '\0') return false;  // Tags must be separated by commas
+        if (equal) return true;
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef ENTITY_TAG_H
+#define ENTITY_TAG_H
+/**
+ * @file EntityTag.h
+ * @brief `If-None-Match` matching for the embedded portal pages.
+ *
+ * The header holds `*` or a comma-separated list of entity tags, each a
+ * quoted string, optionally prefixed with `W/` for a weak tag. The pages
+ * carry strong ETags (a hash of the gzipped body), so a listed tag matches
+ * only when it is strong and equal byte for byte, quotes included; a weak
+ * tag naming the same value does not. `*` matches any page. A malformed
+ * list matches nothing, so the page is simply sent again.
+ */
+
+class EntityTag {
+public:
+    // Pure helper (host testable)
+    static bool matches(const char* ifNoneMatch, const char* etag);  // etag is quoted
+};
+
+#endif // ENTITY_TAG_H
@@ -0,0 +1,201 @@
+#include "EventLoop.h"
+#include "EnergyMeter.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+#ifdef ARDUINO
+#include <esp_pm.h>
+#endif
+
+#define EVENT_WAKE (1UL << 23)  // Never posted: lets a wait with no event bits block on timers only
+
+static EventGroupHandle_t eventGroup = nullptr;
+static TimerWheel timerWheel;
+static unsigned long wheelMillis = 0;  // millis() matching the current wheel tick
+static EventLoopStats loopStats = {};
+static bool lightSleep = false;
+
+/**
+ * @brief Moves the timer wheel to the current time, running the expired timers.
+ */
+static void runTimers() {
+    uint32_t ticks = (millis() - wheelMillis) / EVENTLOOP_TICK_MS;
+    wheelMillis += ticks * EVENTLOOP_TICK_MS;
+    loopStats.timersRun += timerWheel.advance(ticks);
+}
+
+/**
+ * @brief Creates the event group and enables automatic light sleep.
+ *
+ * Light sleep needs power management and tickless idle in the SDK
+ * configuration, which the stock Arduino core lacks; without them the idle
+ * task only halts the CPU until the next interrupt (see EventLoop.h). Any
+ * timer or event left from an earlier run is dropped.
+ */
+void EventLoop::begin() {
+    if (eventGroup == nullptr) eventGroup = xEventGroupCreate();
+    xEventGroupClearBits(eventGroup, EVENT_ALL);
+    timerWheel.clear();
+    wheelMillis = millis();
+    resetStats();
+
+#if defined(ARDUINO) && CONFIG_PM_ENABLE
+    esp_pm_config_esp32_t pm = {};
+    pm.max_freq_mhz = EVENTLOOP_MAX_FREQ_MHZ;
+    pm.min_freq_mhz = EVENTLOOP_MIN_FREQ_MHZ;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    pm.light_sleep_enable = true;
+#endif
+    lightSleep = esp_pm_configure(&pm) == ESP_OK && pm.light_sleep_enable;
+#elif !defined(ARDUINO)
+    lightSleep = true;  // The simulator models a blocked wait as light sleep
+#endif
+    if (DEBUGMODE)Serial.println(lightSleep ? "EventLoop: automatic light sleep enabled" : "EventLoop: light sleep not available");
+}
+
+/**
+ * @brief Sets event bits from a task (driver callbacks included).
+ *
+ * @param bits EventBit values.
+ */
+void EventLoop::post(uint32_t bits) {
+    if (eventGroup != nullptr) xEventGroupSetBits(eventGroup, bits);
+}
+
+/**
+ * @brief Sets event bits from an interrupt handler.
+ *
+ * @param bits EventBit values.
+ */
+void EventLoop::postFromISR(uint32_t bits) {
+    if (eventGroup == nullptr) return;
+    BaseType_t woken = pdFALSE;
+    xEventGroupSetBitsFromISR(eventGroup, bits, &woken);
+    if (woken == pdTRUE) portYIELD_FROM_ISR();
+}
+
+/**
+ * @brief Drops event bits, e.g. before starting the action that posts them.
+ *
+ * @param bits EventBit values.
+ */
+void EventLoop::clear(uint32_t bits) {
+    if (eventGroup != nullptr) xEventGroupClearBits(eventGroup, bits);
+}
+
+/**
+ * @brief Arms a one-shot timer.
+ *
+ * @param ms Delay in milliseconds (rounded up to the wheel tick).
+ * @param callback Function run from waitFor() on expiry.
+ * @param context Passed to the callback.
+ * @return The timer id, or -1 if no timer is free.
+ */
+int EventLoop::after(uint32_t ms, TimerCallback callback, void* context) {
+    runTimers();  // Count the delay from now, not from the last wheel tick
+    return timerWheel.schedule((ms + EVENTLOOP_TICK_MS - 1) / EVENTLOOP_TICK_MS, callback, context);
+}
+
+/**
+ * @brief Arms a periodic timer.
+ *
+ * @param ms Period in milliseconds (rounded up to the wheel tick).
+ * @param callback Function run from waitFor() on every expiry.
+ * @param context Passed to the callback.
+ * @return The timer id, or -1 if no timer is free.
+ */
+int EventLoop::every(uint32_t ms, TimerCallback callback, void* context) {
+    runTimers();
+    uint32_t ticks = (ms + EVENTLOOP_TICK_MS - 1) / EVENTLOOP_TICK_MS;
+    return timerWheel.schedule(ticks, callback, context, ticks ? ticks : 1);
+}
+
+/**
+ * @brief Disarms a timer.
+ *
+ * @param id Timer id; set to -1 so a second cancel is harmless.
+ */
+void EventLoop::cancel(int& id) {
+    timerWheel.cancel(id);
+    id = -1;
+}
+
+/**
+ * @brief Blocks until one of `bits` is set or the timeout expires, running timers meanwhile.
+ *
+ * The task blocks on the event group until the earlier of the next timer
+ * and the timeout, so the CPU is only woken for real work. With light sleep
+ * available and the radio off, the blocked time is charged to the idle
+ * energy phase.
+ *
+ * @param bits EventBit values to wait for (0 = only run timers).
+ * @param timeoutMs Longest wait in milliseconds, or EVENTLOOP_FOREVER.
+ * @return The bits that ended the wait (cleared), or 0 on timeout.
+ */
+uint32_t EventLoop::waitFor(uint32_t bits, uint32_t timeoutMs) {
+    if (eventGroup == nullptr) begin();
+    unsigned long start = millis();
+    unsigned long busyMark = micros();
+
+    while (true) {
+        runTimers();
+        uint32_t ready = xEventGroupGetBits(eventGroup) & bits;
+        unsigned long elapsed = millis() - start;
+        if (ready != 0 || (timeoutMs != EVENTLOOP_FOREVER && elapsed >= timeoutMs)) {
+            if (ready != 0) xEventGroupClearBits(eventGroup, ready);
+            loopStats.busyMicros += micros() - busyMark;
+            return ready;
+        }
+
+        // Block until the next timer, the timeout or an event, whichever comes first
+        uint32_t waitMs = timeoutMs == EVENTLOOP_FOREVER ? EVENTLOOP_FOREVER : timeoutMs - elapsed;
+        uint32_t nextTicks = timerWheel.ticksUntilNext();
+        if (nextTicks != TIMER_WHEEL_NONE) {
+            uint32_t sinceTick = millis() - wheelMillis;
+            uint32_t nextMs = nextTicks * EVENTLOOP_TICK_MS;
+            nextMs = nextMs > sinceTick ? nextMs - sinceTick : 0;
+            if (nextMs < waitMs) waitMs = nextMs;
+        }
+        if (waitMs == 0) continue;
+
+        EnergyPhase previous = EnergyMeter::phase();
+        bool idle = lightSleep && WiFi.getMode() == WIFI_OFF;
+        if (idle) EnergyMeter::enter(EnergyPhase::Idle);
+        loopStats.busyMicros += micros() - busyMark;
+        unsigned long blockedMark = micros();
+        xEventGroupWaitBits(eventGroup, bits | EVENT_WAKE, pdFALSE, pdFALSE,
+                            waitMs == EVENTLOOP_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(waitMs));
+        busyMark = micros();
+        loopStats.blockedMicros += busyMark - blockedMark;
+        loopStats.wakeups++;
+        if (idle) EnergyMeter::enter(previous);
+    }
+}
+
+/**
+ * @brief Tells whether blocked waits put the CPU in light sleep.
+ */
+bool EventLoop::lightSleepEnabled() {
+    return lightSleep;
+}
+
+const EventLoopStats& EventLoop::stats() {
+    return loopStats;
+}
+
+void EventLoop::resetStats() {
+    loopStats = EventLoopStats();
+}
+
+/**
+ * @brief CPU-awake share of the waits since the last reset.
+ *
+ * @return Busy time in percent of the time spent in waitFor().
+ */
+uint8_t EventLoop::busyPercent() {
+    uint64_t total = loopStats.blockedMicros + loopStats.busyMicros;
+    if (total == 0) return 0;
+    return (uint8_t)((loopStats.busyMicros * 100ULL + total / 2) / total);
+}
@@ -0,0 +1,79 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+/**
+ * @file EventLoop.h
+ * @brief Event-driven core: a FreeRTOS event group plus a timer wheel.
+ *
+ * Interrupts and driver callbacks (buttons, serial input, Wi-Fi) post bits
+ * to an event group; periodic and one-shot actions (LED blinking, timeouts)
+ * are timers of a `TimerWheel`. A task that has to wait calls `waitFor()`,
+ * which blocks on the event group until one of the requested bits is set or
+ * the next timer expires, runs the expired timers and blocks again. Between
+ * events no task is ready, so the idle task lets the CPU enter automatic
+ * light sleep when power management allows it (`CONFIG_PM_ENABLE` and
+ * `CONFIG_FREERTOS_USE_TICKLESS_IDLE`).
+ *
+ * The prebuilt SDK of the stock Arduino core enables neither, and the
+ * `arduino` framework of platformio.ini cannot change them, so on the
+ * device the loop falls back to plain blocked waits: the idle task only
+ * halts the CPU until the next interrupt, the 1 ms tick included.
+ * `lightSleepEnabled()` then returns false, blocked waits are charged to
+ * the energy meter as active time and `/getEnergy` reports
+ * `"lightSleep": false`. Light sleep needs a core built with both options.
+ *
+ * Timers and their callbacks belong to the task calling `waitFor()` (the
+ * Arduino loop task); `post()` and `postFromISR()` are safe from anywhere.
+ * The time spent blocked and busy is counted so the CPU-awake share of a
+ * wait can be reported.
+ *
+ * Host builds use the FreeRTOS shim of the simulator, where a blocked wait
+ * is simulated light sleep.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+#include "TimerWheel.h"
+
+#define EVENTLOOP_FOREVER 0xFFFFFFFFUL  ///< waitFor() timeout: no timeout
+
+/**
+ * @brief Bits of the event group.
+ */
+enum EventBit : uint32_t {
+    EVENT_BUTTON  = 1UL << 0,  ///< User button pressed (GPIO interrupt)
+    EVENT_SERIAL  = 1UL << 1,  ///< Serial data received
+    EVENT_WIFI_UP = 1UL << 2,  ///< Station got an address
+    EVENT_PATTERN_DONE = 1UL << 3,  ///< A finite LED/buzzer pattern ended
+    EVENT_ALL     = EVENT_BUTTON | EVENT_SERIAL | EVENT_WIFI_UP | EVENT_PATTERN_DONE
+};
+
+/**
+ * @brief Time split of the waits since the last reset.
+ */
+struct EventLoopStats {
+    uint64_t blockedMicros;  ///< Blocked on the event group (CPU free to sleep)
+    uint64_t busyMicros;     ///< Running timer callbacks and the loop itself
+    uint32_t wakeups;        ///< Returns from the event group wait
+    uint32_t timersRun;      ///< Timer callbacks run
+};
+
+class EventLoop {
+public:
+    static void begin();  // Create the event group, enable automatic light sleep
+    static void post(uint32_t bits);  // Set event bits (task context)
+    static void postFromISR(uint32_t bits);  // Set event bits (interrupt context)
+    static void clear(uint32_t bits);  // Drop stale event bits before waiting for them
+
+    static int after(uint32_t ms, TimerCallback callback, void* context = nullptr);  // One-shot timer
+    static int every(uint32_t ms, TimerCallback callback, void* context = nullptr);  // Periodic timer
+    static void cancel(int& id);  // Disarm a timer and set its id to -1
+
+    static uint32_t waitFor(uint32_t bits, uint32_t timeoutMs);  // Run timers until a bit is set or timeout
+
+    static bool lightSleepEnabled();
+    static const EventLoopStats& stats();
+    static void resetStats();
+    static uint8_t busyPercent();  // CPU-awake share of the waits since the last reset
+};
+
+#endif // EVENT_LOOP_H
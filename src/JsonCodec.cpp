@@ -0,0 +1,477 @@
+#include "JsonCodec.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define JSON_KEY_MAX 32  ///< Longest key looked up (longer ones are unknown anyway)
+
+/**
+ * @brief Read position in the text being parsed.
+ */
+struct JsonCursor {
+    const char* p;
+    const char* end;
+
+    bool atEnd() const { return p >= end; }
+    char peek() const { return p < end ? *p : '\0'; }
+    void skipSpace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    }
+    bool take(char c) {
+        if (peek() != c) return false;
+        p++;
+        return true;
+    }
+};
+
+static JsonError parseObject(JsonCursor& in, uint8_t* out, const JsonField* fields, uint8_t count);
+
+/**
+ * @brief Value of one hex digit, or -1.
+ */
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief Parses a quoted string into `out` (at most size - 1 characters).
+ *
+ * Escapes are decoded; `\u` escapes are limited to ASCII, which covers
+ * every value the messages carry.
+ */
+static JsonError parseString(JsonCursor& in, char* out, size_t size) {
+    if (!in.take('"')) return JsonError::Type;
+    size_t length = 0;
+    while (true) {
+        if (in.atEnd()) return JsonError::Syntax;
+        char c = *in.p++;
+        if (c == '"') break;
+        if ((uint8_t)c < 0x20) return JsonError::Syntax;  // Raw control character
+        if (c == '\\') {
+            if (in.atEnd()) return JsonError::Syntax;
+            char e = *in.p++;
+            switch (e) {
+                case '"': case '\\': case '/': c = e; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u': {
+                    if (in.end - in.p < 4) return JsonError::Syntax;
+                    int code = 0;
+                    for (int i = 0; i < 4; i++) {
+                        int digit = hexDigit(*in.p++);
+                        if (digit < 0) return JsonError::Syntax;
+                        code = (code << 4) | digit;
+                    }
+                    if (code == 0 || code >= 0x80) return JsonError::Format;
+                    c = (char)code;
+                    break;
+                }
+                default: return JsonError::Syntax;
+            }
+        }
+        if (length + 1 >= size) return JsonError::TooLong;
+        out[length++] = c;
+    }
+    out[length] = '\0';
+    return JsonError::Ok;
+}
+
+/**
+ * @brief Parses a whole number (no fraction or exponent) within [min, max].
+ */
+static JsonError parseInt(JsonCursor& in, int32_t min, int32_t max, int32_t& value) {
+    bool negative = in.take('-');
+    char c = in.peek();
+    if (c < '0' || c > '9') return negative ? JsonError::Syntax : JsonError::Type;
+    if (c == '0' && in.p + 1 < in.end && in.p[1] >= '0' && in.p[1] <= '9') return JsonError::Syntax;  // Leading zero
+    int64_t magnitude = 0;
+    bool overflow = false;
+    while (!in.atEnd() && *in.p >= '0' && *in.p <= '9') {
+        magnitude = magnitude * 10 + (*in.p++ - '0');
+        if (magnitude > 0x80000000LL) {
+            overflow = true;
+            magnitude = 0x80000000LL;
+        }
+    }
+    c = in.peek();
+    if (c == '.' || c == 'e' || c == 'E') return JsonError::Type;
+    int64_t signedValue = negative ? -magnitude : magnitude;
+    if (overflow || signedValue < min || signedValue > max) return JsonError::Range;
+    value = (int32_t)signedValue;
+    return JsonError::Ok;
+}
+
+/**
+ * @brief Parses `true` or `false`.
+ */
+static JsonError parseBool(JsonCursor& in, bool& value) {
+    if (in.end - in.p >= 4 && memcmp(in.p, "true", 4) == 0) {
+        in.p += 4;
+        value = true;
+        return JsonError::Ok;
+    }
+    if (in.end - in.p >= 5 && memcmp(in.p, "false", 5) == 0) {
+        in.p += 5;
+        value = false;
+        return JsonError::Ok;
+    }
+    return JsonError::Type;
+}
+
+/**
+ * @brief Parses the value of one member into its place in the struct.
+ */
+static JsonError parseValue(JsonCursor& in, uint8_t* out, const JsonField& field) {
+    uint8_t* member = out + field.offset;
+    switch (field.type) {
+        case JsonType::String: {
+            JsonError error = parseString(in, (char*)member, field.size);
+            if (error != JsonError::Ok) return error;
+            if (field.format != nullptr && !JsonCodec::matchesFormat((const char*)member, field.format)) return JsonError::Format;
+            return JsonError::Ok;
+        }
+        case JsonType::Int: {
+            int32_t value = 0;
+            JsonError error = parseInt(in, field.min, field.max, value);
+            if (error != JsonError::Ok) return error;
+            if (field.size == 1) {
+                int8_t narrow = (int8_t)value;
+                memcpy(member, &narrow, 1);
+            } else if (field.size == 2) {
+                int16_t narrow = (int16_t)value;
+                memcpy(member, &narrow, 2);
+            } else {
+                memcpy(member, &value, 4);
+            }
+            return JsonError::Ok;
+        }
+        case JsonType::Bool: {
+            bool value = false;
+            JsonError error = parseBool(in, value);
+            if (error == JsonError::Ok) memcpy(member, &value, sizeof(value));
+            return error;
+        }
+        case JsonType::Object:
+            if (in.peek() != '{') return JsonError::Type;
+            return parseObject(in, member, field.fields, field.count);
+    }
+    return JsonError::Type;
+}
+
+/**
+ * @brief Parses one object into a struct described by `fields`.
+ */
+static JsonError parseObject(JsonCursor& in, uint8_t* out, const JsonField* fields, uint8_t count) {
+    uint32_t seen = 0;
+    in.skipSpace();
+    if (!in.take('{')) return JsonError::Syntax;
+    in.skipSpace();
+    if (!in.take('}')) {
+        while (true) {
+            char key[JSON_KEY_MAX];
+            in.skipSpace();
+            JsonError error = parseString(in, key, sizeof(key));
+            if (error == JsonError::Type) return JsonError::Syntax;  // Key is not a string
+            if (error == JsonError::TooLong) return JsonError::UnknownField;
+            if (error != JsonError::Ok) return error;
+            in.skipSpace();
+            if (!in.take(':')) return JsonError::Syntax;
+            in.skipSpace();
+
+            uint8_t index = 0;
+            while (index < count && strcmp(fields[index].name, key) != 0) index++;
+            if (index == count) return JsonError::UnknownField;
+            if (seen & (1UL << index)) return JsonError::Duplicate;
+            seen |= 1UL << index;
+
+            error = parseValue(in, out, fields[index]);
+            if (error != JsonError::Ok) return error;
+            in.skipSpace();
+            if (in.take(',')) continue;
+            if (in.take('}')) break;
+            return JsonError::Syntax;
+        }
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (fields[i].required && !(seen & (1UL << i))) return JsonError::Missing;
+    }
+    return JsonError::Ok;
+}
+
+/**
+ * @brief Parses a JSON object into a message struct.
+ *
+ * Nothing but whitespace may follow the object. On error the struct may be
+ * partly filled.
+ *
+ * @param text JSON text (needs no NUL terminator).
+ * @param length Length of the text.
+ * @param message The struct to fill.
+ * @param fields Its field table.
+ * @param count Number of fields.
+ * @return JsonError::Ok, or the first problem found.
+ */
+JsonError JsonCodec::parseFields(const char* text, size_t length, void* message, const JsonField* fields, uint8_t count) {
+    if (text == nullptr) return JsonError::Syntax;
+    JsonCursor in = {text, text + length};
+    JsonError error = parseObject(in, (uint8_t*)message, fields, count);
+    if (error != JsonError::Ok) return error;
+    in.skipSpace();
+    return in.atEnd() ? JsonError::Ok : JsonError::Syntax;
+}
+
+/**
+ * @brief Writes a message struct as an object (a member when `key` is set).
+ */
+void JsonCodec::writeFields(JsonWriter& writer, const char* key, const void* message, const JsonField* fields, uint8_t count) {
+    const uint8_t* in = (const uint8_t*)message;
+    writer.beginObject(key);
+    for (uint8_t i = 0; i < count; i++) {
+        const JsonField& field = fields[i];
+        const uint8_t* member = in + field.offset;
+        switch (field.type) {
+            case JsonType::String:
+                writer.add(field.name, (const char*)member, field.size - 1);
+                break;
+            case JsonType::Int: {
+                int32_t value;
+                if (field.size == 1) {
+                    int8_t narrow;
+                    memcpy(&narrow, member, 1);
+                    value = narrow;
+                } else if (field.size == 2) {
+                    int16_t narrow;
+                    memcpy(&narrow, member, 2);
+                    value = narrow;
+                } else {
+                    memcpy(&value, member, 4);
+                }
+                writer.addInt(field.name, value);
+                break;
+            }
+            case JsonType::Bool: {
+                bool value;
+                memcpy(&value, member, sizeof(value));
+                writer.addBool(field.name, value);
+                break;
+            }
+            case JsonType::Object:
+                writeFields(writer, field.name, member, field.fields, field.count);
+                break;
+        }
+    }
+    writer.endObject();
+}
+
+/**
+ * @brief Checks a string against a format template.
+ *
+ * @param text The string.
+ * @param format Template: `#` matches a digit, any other character itself.
+ * @return true if the string has the template's length and shape.
+ */
+bool JsonCodec::matchesFormat(const char* text, const char* format) {
+    for (; *format != '\0'; text++, format++) {
+        if (*text == '\0') return false;
+        if (*format == '#' ? (*text < '0' || *text > '9') : *text != *format) return false;
+    }
+    return *text == '\0';
+}
+
+/**
+ * @brief Short name of a parse error, for error replies.
+ */
+const char* JsonCodec::errorName(JsonError error) {
+    switch (error) {
+        case JsonError::Ok: return "ok";
+        case JsonError::Syntax: return "syntax";
+        case JsonError::UnknownField: return "unknown field";
+        case JsonError::Duplicate: return "duplicate field";
+        case JsonError::Type: return "wrong type";
+        case JsonError::TooLong: return "too long";
+        case JsonError::Format: return "bad format";
+        case JsonError::Range: return "out of range";
+        case JsonError::Missing: return "missing field";
+    }
+    return "?";
+}
+
+/**
+ * @brief Starts writing into `buffer` (`size` bytes, including the NUL).
+ */
+JsonWriter::JsonWriter(char* buffer, size_t size)
+    : _buffer(buffer), _size(size), _length(0), _empty(0), _depth(0), _overflow(size == 0) {
+    if (size > 0) buffer[0] = '\0';
+}
+
+JsonWriter& JsonWriter::beginObject(const char* key) {
+    member(key);
+    put('{');
+    if (++_depth >= 32) _overflow = true;  // Deeper than the empty mask
+    _empty |= 1UL << (_depth & 31);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    put('}');
+    if (_depth > 0) _depth--;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray(const char* key) {
+    member(key);
+    put('[');
+    if (++_depth >= 32) _overflow = true;
+    _empty |= 1UL << (_depth & 31);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    put(']');
+    if (_depth > 0) _depth--;
+    return *this;
+}
+
+/**
+ * @brief Adds a string (at most `maxLength` characters of it).
+ */
+JsonWriter& JsonWriter::add(const char* key, const char* value, size_t maxLength) {
+    member(key);
+    if (value == nullptr) {
+        putText("null");
+    } else {
+        putQuoted(value, maxLength);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::addInt(const char* key, int64_t value) {
+    member(key);
+    if (value < 0) put('-');
+    putUnsigned(value < 0 ? (uint64_t)(-(value + 1)) + 1 : (uint64_t)value);
+    return *this;
+}
+
+/**
+ * @brief Adds a number with a fixed number of decimals (rounded).
+ *
+ * Formatted by hand so no printf float support is needed; values that do
+ * not fit 64 bits once scaled are written as null, like NaN and infinity.
+ */
+JsonWriter& JsonWriter::addFloat(const char* key, double value, uint8_t decimals) {
+    member(key);
+    if (decimals > 9) decimals = 9;
+    uint64_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+    double scaled = fabs(value) * (double)scale + 0.5;
+    if (!isfinite(value) || scaled >= 9.2e18) {
+        putText("null");
+        return *this;
+    }
+    uint64_t fixed = (uint64_t)scaled;
+    if (value < 0 && fixed != 0) put('-');
+    putUnsigned(fixed / scale);
+    if (decimals > 0) {
+        put('.');
+        uint64_t fraction = fixed % scale;
+        for (uint64_t digit = scale / 10; digit > 0; digit /= 10) {
+            put('0' + (char)((fraction / digit) % 10));
+        }
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::addBool(const char* key, bool value) {
+    member(key);
+    putText(value ? "true" : "false");
+    return *this;
+}
+
+/**
+ * @brief Checks that everything fit and every container was closed.
+ */
+bool JsonWriter::ok() const {
+    return !_overflow && _depth == 0;
+}
+
+const char* JsonWriter::c_str() const {
+    return _buffer;
+}
+
+size_t JsonWriter::length() const {
+    return _length;
+}
+
+/**
+ * @brief Writes the comma before an element and the key of a member.
+ */
+void JsonWriter::member(const char* key) {
+    uint32_t bit = 1UL << (_depth & 31);
+    if (_depth > 0) {
+        if (_empty & bit) {
+            _empty &= ~bit;
+        } else {
+            put(',');
+        }
+    }
+    if (key != nullptr) {
+        putQuoted(key, SIZE_MAX);
+        put(':');
+    }
+}
+
+void JsonWriter::put(char c) {
+    if (_length + 1 >= _size) {
+        _overflow = true;
+        return;
+    }
+    _buffer[_length++] = c;
+    _buffer[_length] = '\0';
+}
+
+void JsonWriter::putText(const char* text) {
+    while (*text != '\0') put(*text++);
+}
+
+void JsonWriter::putUnsigned(uint64_t value) {
+    char digits[20];
+    uint8_t n = 0;
+    do {
+        digits[n++] = '0' + (char)(value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (n > 0) put(digits[--n]);
+}
+
+/**
+ * @brief Writes a string in quotes, escaped.
+ */
+void JsonWriter::putQuoted(const char* text, size_t maxLength) {
+    static const char hex[] = "0123456789abcdef";
+    put('"');
+    for (size_t i = 0; i < maxLength && text[i] != '\0'; i++) {
+        char c = text[i];
+        switch (c) {
+            case '"': putText("\\\""); break;
+            case '\\': putText("\\\\"); break;
+            case '\n': putText("\\n"); break;
+            case '\r': putText("\\r"); break;
+            case '\t': putText("\\t"); break;
+            default:
+                if ((uint8_t)c < 0x20) {
+                    putText("\\u00");
+                    put(hex[(uint8_t)c >> 4]);
+                    put(hex[c & 0x0F]);
+                } else {
+                    put(c);
+                }
+        }
+    }
+    put('"');
+}
@@ -0,0 +1,154 @@
+#ifndef JSON_CODEC_H
+#define JSON_CODEC_H
+/**
+ * @file JsonCodec.h
+ * @brief Fixed-schema JSON parser and writer for the portal and serial messages.
+ *
+ * Every message is a plain struct (fixed char arrays, integers, booleans and
+ * nested message structs) described by a constant field table built with
+ * the `JSON_*` macros; `JSON_SCHEMA()` binds the table to the struct. The
+ * parser reads the text in one pass straight into the struct, without any
+ * allocation, and checks it strictly:
+ * - only the declared members, each at most once, all required ones present;
+ * - strings fit their array and match the format template, if any
+ *   (`#` stands for a digit, every other character for itself);
+ * - integers are whole numbers within the declared range.
+ * Members missing from the text keep the value the caller put in the struct,
+ * which is how optional fields get their defaults.
+ *
+ * `JsonWriter` emits JSON into a caller-supplied buffer, either from a
+ * message struct (`JsonCodec::write()`) or member by member for documents
+ * with run-time keys.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Kind of a message member.
+ */
+enum class JsonType : uint8_t {
+    String,  ///< char array
+    Int,     ///< Signed integer of 1, 2 or 4 bytes
+    Bool,    ///< bool
+    Object   ///< Nested message struct
+};
+
+/**
+ * @brief Why a text was rejected.
+ */
+enum class JsonError : uint8_t {
+    Ok,
+    Syntax,        ///< Not a JSON object of scalar members
+    UnknownField,  ///< Member not in the schema
+    Duplicate,     ///< Member given twice
+    Type,          ///< Value of the wrong type
+    TooLong,       ///< String longer than its array
+    Format,        ///< String does not match its template
+    Range,         ///< Integer out of range
+    Missing        ///< Required member absent
+};
+
+/**
+ * @brief One member of a message struct.
+ */
+struct JsonField {
+    const char* name;          ///< JSON key (the struct member name)
+    JsonType type;
+    bool required;
+    uint16_t offset;           ///< Offset of the member in the struct
+    uint16_t size;             ///< Size of the member (strings: including the NUL)
+    const char* format;        ///< String template, nullptr for any text
+    int32_t min;               ///< Integer range
+    int32_t max;
+    const JsonField* fields;   ///< Nested message members (Object)
+    uint8_t count;
+};
+
+#define JSON_MEMBER_SIZE(Message, member) ((uint16_t)sizeof(((Message*)0)->member))
+
+#define JSON_STRING(Message, member, format, required) \
+    { #member, JsonType::String, required, (uint16_t)offsetof(Message, member), JSON_MEMBER_SIZE(Message, member), format, 0, 0, nullptr, 0 }
+#define JSON_INT(Message, member, min, max, required) \
+    { #member, JsonType::Int, required, (uint16_t)offsetof(Message, member), JSON_MEMBER_SIZE(Message, member), nullptr, min, max, nullptr, 0 }
+#define JSON_BOOL(Message, member, required) \
+    { #member, JsonType::Bool, required, (uint16_t)offsetof(Message, member), JSON_MEMBER_SIZE(Message, member), nullptr, 0, 0, nullptr, 0 }
+#define JSON_OBJECT(Message, member, table) \
+    { #member, JsonType::Object, true, (uint16_t)offsetof(Message, member), JSON_MEMBER_SIZE(Message, member), nullptr, 0, 0, table, (uint8_t)(sizeof(table) / sizeof(table[0])) }
+
+template <typename Message>
+struct JsonSchema;  // Specialized by JSON_SCHEMA()
+
+/**
+ * @brief Binds a field table to its message struct.
+ */
+#define JSON_SCHEMA(Message, table)                                                    \
+    static_assert(sizeof(table) / sizeof(table[0]) <= 32, "At most 32 members");      \
+    template <>                                                                        \
+    struct JsonSchema<Message> {                                                       \
+        static const JsonField* fields() { return table; }                             \
+        static uint8_t count() { return (uint8_t)(sizeof(table) / sizeof(table[0])); } \
+    }
+
+/**
+ * @brief Writes JSON into a fixed buffer; commas are inserted automatically.
+ *
+ * Members take a key, array elements pass nullptr. Output that does not fit
+ * is cut off and reported by ok(); the text is always NUL terminated.
+ */
+class JsonWriter {
+public:
+    JsonWriter(char* buffer, size_t size);
+
+    JsonWriter& beginObject(const char* key = nullptr);
+    JsonWriter& endObject();
+    JsonWriter& beginArray(const char* key = nullptr);
+    JsonWriter& endArray();
+    JsonWriter& add(const char* key, const char* value, size_t maxLength = SIZE_MAX);
+    JsonWriter& addInt(const char* key, int64_t value);
+    JsonWriter& addFloat(const char* key, double value, uint8_t decimals = 3);  // Non-finite values are null
+    JsonWriter& addBool(const char* key, bool value);
+
+    bool ok() const;  // Everything fit and every object/array was closed
+    const char* c_str() const;
+    size_t length() const;
+
+private:
+    void member(const char* key);  // Separator and key
+    void put(char c);
+    void putText(const char* text);
+    void putUnsigned(uint64_t value);
+    void putQuoted(const char* text, size_t maxLength);
+
+    char* _buffer;
+    size_t _size;
+    size_t _length;
+    uint32_t _empty;  // Bit n: the container at depth n has no element yet
+    uint8_t _depth;
+    bool _overflow;
+};
+
+class JsonCodec {
+public:
+    // Parses `text` into `message` (schema from JSON_SCHEMA)
+    template <typename Message>
+    static JsonError parse(const char* text, size_t length, Message& message) {
+        return parseFields(text, length, &message, JsonSchema<Message>::fields(), JsonSchema<Message>::count());
+    }
+
+    // Writes `message` as one JSON object
+    template <typename Message>
+    static bool write(JsonWriter& writer, const Message& message) {
+        writeFields(writer, nullptr, &message, JsonSchema<Message>::fields(), JsonSchema<Message>::count());
+        return writer.ok();
+    }
+
+    static const char* errorName(JsonError error);
+
+    // Pure helpers (host testable)
+    static JsonError parseFields(const char* text, size_t length, void* message, const JsonField* fields, uint8_t count);
+    static void writeFields(JsonWriter& writer, const char* key, const void* message, const JsonField* fields, uint8_t count);
+    static bool matchesFormat(const char* text, const char* format);
+};
+
+#endif // JSON_CODEC_H
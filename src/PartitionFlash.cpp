@@ -0,0 +1,191 @@
+#include "PartitionFlash.h"
+#include <string.h>
+
+/**
+ * @brief Constructs a closed partition handle.
+ */
+PartitionFlash::PartitionFlash() : _size(0),
+#ifdef ARDUINO
+    _partition(nullptr) {}
+#else
+    _file(nullptr) {}
+#endif
+
+/**
+ * @brief Closes the partition.
+ */
+PartitionFlash::~PartitionFlash() {
+    end();
+}
+
+#ifdef ARDUINO
+/**
+ * @brief Opens a raw data partition.
+ *
+ * @param label Partition label from partitions.csv.
+ * @return true if the partition exists and is sector aligned.
+ */
+bool PartitionFlash::begin(const char* label) {
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (_partition == nullptr || _partition->size % PARTITION_FLASH_SECTOR != 0) {
+        _partition = nullptr;
+        return false;
+    }
+    _size = _partition->size;
+    return true;
+}
+
+/**
+ * @brief Releases the partition.
+ */
+void PartitionFlash::end() {
+    _partition = nullptr;
+    _size = 0;
+}
+
+/**
+ * @brief Checks whether the partition is open.
+ */
+bool PartitionFlash::isOpen() const {
+    return _partition != nullptr;
+}
+
+/**
+ * @brief Reads from the partition.
+ *
+ * @param offset Offset in the partition.
+ * @param buffer Destination buffer.
+ * @param length Number of bytes.
+ * @return true on success.
+ */
+bool PartitionFlash::read(size_t offset, void* buffer, size_t length) {
+    if (!isOpen() || offset + length > _size) return false;
+    return esp_partition_read(_partition, offset, buffer, length) == ESP_OK;
+}
+
+/**
+ * @brief Writes to the partition (the target must be erased).
+ *
+ * @param offset Offset in the partition.
+ * @param data Data to write.
+ * @param length Number of bytes.
+ * @return true on success.
+ */
+bool PartitionFlash::write(size_t offset, const void* data, size_t length) {
+    if (!isOpen() || offset + length > _size) return false;
+    return esp_partition_write(_partition, offset, data, length) == ESP_OK;
+}
+
+/**
+ * @brief Erases one sector.
+ *
+ * @param sector Sector index in the partition.
+ * @return true on success.
+ */
+bool PartitionFlash::eraseSector(size_t sector) {
+    if (!isOpen() || sector >= sectorCount()) return false;
+    return esp_partition_erase_range(_partition, sector * PARTITION_FLASH_SECTOR, PARTITION_FLASH_SECTOR) == ESP_OK;
+}
+#else
+/**
+ * @brief Opens an emulated partition backed by a file.
+ *
+ * A missing or short file is extended with erased (0xFF) sectors.
+ *
+ * @param path Image file.
+ * @param size Partition size (multiple of the sector size).
+ * @return true if the image could be opened.
+ */
+bool PartitionFlash::begin(const char* path, size_t size) {
+    end();
+    if (size == 0 || size % PARTITION_FLASH_SECTOR != 0) return false;
+    _file = fopen(path, "r+b");
+    if (_file == nullptr) _file = fopen(path, "w+b");
+    if (_file == nullptr) return false;
+
+    fseek(_file, 0, SEEK_END);
+    long existing = ftell(_file);
+    uint8_t erased[PARTITION_FLASH_SECTOR];
+    memset(erased, 0xFF, sizeof(erased));
+    while (existing < (long)size) {
+        size_t chunk = size - existing < sizeof(erased) ? size - existing : sizeof(erased);
+        fwrite(erased, 1, chunk, _file);
+        existing += chunk;
+    }
+    fflush(_file);
+    _size = size;
+    return true;
+}
+
+/**
+ * @brief Closes the image file.
+ */
+void PartitionFlash::end() {
+    if (_file != nullptr) fclose(_file);
+    _file = nullptr;
+    _size = 0;
+}
+
+/**
+ * @brief Checks whether the image is open.
+ */
+bool PartitionFlash::isOpen() const {
+    return _file != nullptr;
+}
+
+/**
+ * @brief Reads from the image.
+ */
+bool PartitionFlash::read(size_t offset, void* buffer, size_t length) {
+    if (!isOpen() || offset + length > _size) return false;
+    if (fseek(_file, offset, SEEK_SET) != 0) return false;
+    return fread(buffer, 1, length, _file) == length;
+}
+
+/**
+ * @brief Writes to the image with NOR semantics (bits can only be cleared).
+ */
+bool PartitionFlash::write(size_t offset, const void* data, size_t length) {
+    if (!isOpen() || offset + length > _size) return false;
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint8_t chunk[64];
+    while (length > 0) {
+        size_t n = length < sizeof(chunk) ? length : sizeof(chunk);
+        if (!read(offset, chunk, n)) return false;
+        for (size_t i = 0; i < n; i++) chunk[i] &= bytes[i];
+        if (fseek(_file, offset, SEEK_SET) != 0 || fwrite(chunk, 1, n, _file) != n) return false;
+        offset += n;
+        bytes += n;
+        length -= n;
+    }
+    fflush(_file);
+    return true;
+}
+
+/**
+ * @brief Erases one sector of the image.
+ */
+bool PartitionFlash::eraseSector(size_t sector) {
+    if (!isOpen() || sector >= sectorCount()) return false;
+    uint8_t erased[PARTITION_FLASH_SECTOR];
+    memset(erased, 0xFF, sizeof(erased));
+    if (fseek(_file, sector * PARTITION_FLASH_SECTOR, SEEK_SET) != 0) return false;
+    bool ok = fwrite(erased, 1, sizeof(erased), _file) == sizeof(erased);
+    fflush(_file);
+    return ok;
+}
+#endif
+
+/**
+ * @brief Size of the partition in bytes.
+ */
+size_t PartitionFlash::size() const {
+    return _size;
+}
+
+/**
+ * @brief Number of erase sectors in the partition.
+ */
+size_t PartitionFlash::sectorCount() const {
+    return _size / PARTITION_FLASH_SECTOR;
+}
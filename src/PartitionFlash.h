@@ -0,0 +1,57 @@
+#ifndef PARTITION_FLASH_H
+#define PARTITION_FLASH_H
+/**
+ * @file PartitionFlash.h
+ * @brief Raw access to a data partition, with a file-backed emulator.
+ *
+ * On the device the region is an `esp_partition` found by label. Host
+ * builds map it onto a file and emulate NOR flash semantics: erase sets a
+ * whole sector to 0xFF and a write can only clear bits (the stored byte
+ * becomes old & new), so code that forgets an erase misbehaves the same way
+ * it would on the chip.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Config.h"
+
+#ifdef ARDUINO
+#include <esp_partition.h>
+#else
+#include <stdio.h>
+#endif
+
+#define PARTITION_FLASH_SECTOR 4096  ///< Erase unit of the SPI flash
+
+class PartitionFlash {
+public:
+    PartitionFlash();
+    ~PartitionFlash();
+    PartitionFlash(const PartitionFlash&) = delete;
+    PartitionFlash& operator=(const PartitionFlash&) = delete;
+
+#ifdef ARDUINO
+    bool begin(const char* label);  // Open the data partition with this label
+#else
+    bool begin(const char* path, size_t size);  // Open (or create) an emulated partition image
+#endif
+    void end();
+
+    bool isOpen() const;
+    size_t size() const;
+    size_t sectorCount() const;
+
+    bool read(size_t offset, void* buffer, size_t length);
+    bool write(size_t offset, const void* data, size_t length);  // Bits can only be cleared
+    bool eraseSector(size_t sector);  // Set a whole sector to 0xFF
+
+private:
+    size_t _size;
+#ifdef ARDUINO
+    const esp_partition_t* _partition;
+#else
+    FILE* _file;
+#endif
+};
+
+#endif // PARTITION_FLASH_H
@@ -0,0 +1,481 @@
+#include "PatternEngine.h"
+#include "EventLoop.h"
+#include <Arduino.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <driver/ledc.h>
+#include <esp_sleep.h>
+#endif
+
+#define PATTERN_MAX_RESOLUTION 20  // Widest duty resolution of the LEDC timers
+#define PATTERN_MAX_DIVIDER 0x3FFFF  // 10.8 fixed-point divider field
+
+// Step tables of the built-in patterns
+static constexpr PatternStep kClassicLed[] = {patternBlink(300, 300, 200)};
+static constexpr PatternStep kGentleLed[] = {patternFade(255, 1500), patternFade(0, 1500)};
+static constexpr PatternStep kBeepLed[] = {patternBlink(500, 500, 120)};
+static constexpr PatternStep kBeepBuzzer[] = {patternBlink(100, 900, 120)};
+static constexpr PatternStep kUrgentLed[] = {patternBlink(100, 100, 600)};
+static constexpr PatternStep kUrgentBuzzer[] = {patternBlink(200, 200, 300)};
+static constexpr PatternStep kSerialModeLed[] = {patternBlink(100, 100, 3), patternLevel(255, 0)};
+static constexpr PatternStep kAdminModeLed[] = {patternBlink(100, 100, 2)};
+
+#define PATTERN_STEPS(table) table, (uint8_t)(sizeof(table) / sizeof(table[0]))
+
+// Pattern table, in PatternIndex order
+static constexpr Pattern kPatterns[PATTERN_COUNT] = {
+    {"classic", PATTERN_STEPS(kClassicLed), nullptr, 0, 0},
+    {"gentle", PATTERN_STEPS(kGentleLed), nullptr, 0, 0},
+    {"beep", PATTERN_STEPS(kBeepLed), PATTERN_STEPS(kBeepBuzzer), 0},
+    {"urgent", PATTERN_STEPS(kUrgentLed), PATTERN_STEPS(kUrgentBuzzer), 0},
+    {"serial", PATTERN_STEPS(kSerialModeLed), nullptr, 0, 1},
+    {"admin", PATTERN_STEPS(kAdminModeLed), nullptr, 0, 1},
+};
+
+static const uint8_t kPatternPins[PATTERN_OUTPUT_COUNT] = {LED_GREEN_PIN, BUZZ_PIN};
+
+static PatternTrack patternTracks[PATTERN_OUTPUT_COUNT];
+static uint8_t playingPattern = PATTERN_NONE;
+static int stepTimer = -1;
+static bool outputsAttached = false;
+
+/**
+ * @brief Routes both pins to LEDC channels clocked from the RC oscillator.
+ */
+static void attachOutputs() {
+    if (outputsAttached) return;
+#ifdef ARDUINO
+    for (uint8_t output = 0; output < PATTERN_OUTPUT_COUNT; output++) {
+        ledc_timer_config_t timer = {};
+        timer.speed_mode = LEDC_LOW_SPEED_MODE;
+        timer.duty_resolution = LEDC_TIMER_10_BIT;
+        timer.timer_num = (ledc_timer_t)(PATTERN_LEDC_CHANNEL + output);
+        timer.freq_hz = PATTERN_PWM_HZ;
+        timer.clk_cfg = LEDC_USE_RTC8M_CLK;  // The only LEDC clock running in light sleep
+        ledc_timer_config(&timer);
+
+        ledc_channel_config_t channel = {};
+        channel.gpio_num = kPatternPins[output];
+        channel.speed_mode = LEDC_LOW_SPEED_MODE;
+        channel.channel = (ledc_channel_t)(PATTERN_LEDC_CHANNEL + output);
+        channel.timer_sel = timer.timer_num;
+        channel.duty = 0;
+        ledc_channel_config(&channel);
+    }
+    ledc_fade_func_install(0);
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC8M, ESP_PD_OPTION_ON);  // Keep the LEDC clock in light sleep
+#endif
+    outputsAttached = true;
+}
+
+/**
+ * @brief Stops the LEDC channels and gives the pins back to GPIO, driven low.
+ */
+static void detachOutputs() {
+    if (!outputsAttached) return;
+#ifdef ARDUINO
+    for (uint8_t output = 0; output < PATTERN_OUTPUT_COUNT; output++) {
+        ledc_stop(LEDC_LOW_SPEED_MODE, (ledc_channel_t)(PATTERN_LEDC_CHANNEL + output), 0);
+    }
+    ledc_fade_func_uninstall();
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC8M, ESP_PD_OPTION_AUTO);
+#endif
+    for (uint8_t output = 0; output < PATTERN_OUTPUT_COUNT; output++) {
+        pinMode(kPatternPins[output], OUTPUT);
+        digitalWrite(kPatternPins[output], LOW);
+    }
+    outputsAttached = false;
+}
+
+/**
+ * @brief Programs the current step of an output.
+ *
+ * @param output Output index.
+ */
+static void applyStep(uint8_t output) {
+    const PatternTrack& track = patternTracks[output];
+    const PatternStep& step = track.steps[track.index];
+#ifdef ARDUINO
+    LedcSetting setting;
+    if (!PatternEngine::compile(step, track.fromLevel, PATTERN_LEDC_CLOCK_HZ, setting)) return;
+    ledc_mode_t mode = LEDC_LOW_SPEED_MODE;
+    ledc_timer_t timer = (ledc_timer_t)(PATTERN_LEDC_CHANNEL + output);
+    ledc_channel_t channel = (ledc_channel_t)(PATTERN_LEDC_CHANNEL + output);
+    // LEDC_APB_CLK selects the slow clock of a low-speed timer, switched to the RC oscillator in attachOutputs()
+    ledc_timer_set(mode, timer, setting.divider, setting.resolution, LEDC_APB_CLK);
+    ledc_timer_rst(mode, timer);  // Start the step with its on phase
+    if (setting.fade) {
+        ledc_set_duty(mode, channel, setting.startDuty);
+        ledc_update_duty(mode, channel);
+        ledc_set_fade_with_time(mode, channel, setting.duty, setting.fadeMs);
+        ledc_fade_start(mode, channel, LEDC_FADE_NO_WAIT);
+    } else {
+        ledc_set_duty(mode, channel, setting.duty);
+        ledc_update_duty(mode, channel);
+    }
+#else
+    digitalWrite(kPatternPins[output], PatternEngine::levelAt(step, track.fromLevel, 0) > 0 ? HIGH : LOW);
+#endif
+}
+
+/**
+ * @brief Turns an output off once its track has finished.
+ *
+ * @param output Output index.
+ */
+static void silenceOutput(uint8_t output) {
+#ifdef ARDUINO
+    ledc_channel_t channel = (ledc_channel_t)(PATTERN_LEDC_CHANNEL + output);
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, channel, 0);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, channel);
+#else
+    digitalWrite(kPatternPins[output], LOW);
+#endif
+}
+
+static void onStepEnd(void* context);
+
+/**
+ * @brief Arms the event loop timer for the next step boundary of any output.
+ */
+static void scheduleStepEnd() {
+    uint32_t earliest = PATTERN_FOREVER;
+    for (uint8_t output = 0; output < PATTERN_OUTPUT_COUNT; output++) {
+        if (patternTracks[output].done) continue;
+        uint32_t end = PatternEngine::stepEnd(patternTracks[output]);
+        if (end < earliest) earliest = end;
+    }
+    if (earliest == PATTERN_FOREVER) return;  // Held until stopped
+    uint32_t now = millis();
+    stepTimer = EventLoop::after(earliest > now ? earliest - now : 0, onStepEnd);
+}
+
+/**
+ * @brief Event loop timer: moves the outputs whose step ended to their next step.
+ *
+ * @param context Unused.
+ */
+static void onStepEnd(void* context) {
+    (void)context;
+    stepTimer = -1;
+    uint32_t now = millis();
+    bool finished = true;
+    for (uint8_t output = 0; output < PATTERN_OUTPUT_COUNT; output++) {
+        PatternTrack& track = patternTracks[output];
+        bool moved = false;
+        while (!track.done && PatternEngine::stepEnd(track) <= now) {
+            if (PatternEngine::next(track)) {
+                moved = true;
+            } else {
+                silenceOutput(output);
+            }
+        }
+        if (moved && !track.done) applyStep(output);
+        if (!track.done) finished = false;
+    }
+
+    if (finished) {
+        detachOutputs();
+        playingPattern = PATTERN_NONE;
+        EventLoop::post(EVENT_PATTERN_DONE);
+        return;
+    }
+    scheduleStepEnd();
+}
+
+/**
+ * @brief Starts playing a pattern on the LED and the buzzer.
+ *
+ * The current pattern, if any, is stopped first. The steps then play in
+ * hardware; the event loop only runs at step boundaries, from waitFor().
+ *
+ * @param pattern Index in the pattern table.
+ * @return false if the index is unknown.
+ */
+bool PatternEngine::start(uint8_t pattern) {
+    if (pattern >= PATTERN_COUNT) return false;
+    stop();
+    const Pattern& entry = kPatterns[pattern];
+    uint32_t now = millis();
+    rewind(patternTracks[(uint8_t)PatternOutput::Led], entry.led, entry.ledSteps, entry.repeat, now);
+    rewind(patternTracks[(uint8_t)PatternOutput::Buzzer], entry.buzzer, entry.buzzerSteps, entry.repeat, now);
+
+    attachOutputs();
+    for (uint8_t output = 0; output < PATTERN_OUTPUT_COUNT; output++) {
+        if (!patternTracks[output].done) applyStep(output);
+    }
+    playingPattern = pattern;
+    if (DEBUGMODE)Serial.printf("PatternEngine: playing %s\n", entry.name);
+    scheduleStepEnd();
+    return true;
+}
+
+/**
+ * @brief Stops the current pattern, turns both outputs off and releases the pins.
+ */
+void PatternEngine::stop() {
+    EventLoop::cancel(stepTimer);
+    detachOutputs();
+    for (uint8_t output = 0; output < PATTERN_OUTPUT_COUNT; output++) patternTracks[output].done = 1;
+    playingPattern = PATTERN_NONE;
+}
+
+bool PatternEngine::isPlaying() {
+    return playingPattern != PATTERN_NONE;
+}
+
+/**
+ * @brief Index of the pattern playing.
+ *
+ * @return The pattern index, or PATTERN_NONE.
+ */
+uint8_t PatternEngine::current() {
+    return playingPattern;
+}
+
+/**
+ * @brief Level an output shows now, from the step model.
+ *
+ * @param output The output.
+ * @return Level 0-255 (0 when idle).
+ */
+uint8_t PatternEngine::level(PatternOutput output) {
+    const PatternTrack& track = patternTracks[(uint8_t)output];
+    if (!isPlaying() || track.done) return 0;
+    return levelAt(track.steps[track.index], track.fromLevel, millis() - track.stepStartMs);
+}
+
+/**
+ * @brief Gives access to an entry of the pattern table.
+ *
+ * @param index Pattern index (out of range falls back to PATTERN_CLASSIC).
+ * @return The pattern.
+ */
+const Pattern& PatternEngine::pattern(uint8_t index) {
+    return kPatterns[index < PATTERN_COUNT ? index : (uint8_t)PATTERN_CLASSIC];
+}
+
+/**
+ * @brief Looks a pattern up by name.
+ *
+ * @param name Pattern name ("classic", "gentle", ...).
+ * @return The pattern index, or -1 if unknown.
+ */
+int PatternEngine::find(const char* name) {
+    if (name == nullptr) return -1;
+    for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+        if (strcmp(kPatterns[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Places a track on the first step of a table.
+ *
+ * @param track The track.
+ * @param steps Step table (nullptr or empty = nothing to play).
+ * @param count Steps in the table.
+ * @param repeat Plays of the table (0 = until stopped).
+ * @param nowMs Start time.
+ */
+void PatternEngine::rewind(PatternTrack& track, const PatternStep* steps, uint8_t count, uint8_t repeat, uint32_t nowMs) {
+    track.steps = steps;
+    track.count = steps != nullptr ? count : 0;
+    track.index = 0;
+    track.playsLeft = repeat;
+    track.done = track.count == 0;
+    track.fromLevel = 0;
+    track.stepStartMs = nowMs;
+}
+
+/**
+ * @brief Moves a track past its current step.
+ *
+ * The next step starts when the current one ends, not when this is
+ * called, so late wakes do not stretch the pattern.
+ *
+ * @param track The track.
+ * @return true if a step follows, false once the last play ended.
+ */
+bool PatternEngine::next(PatternTrack& track) {
+    if (track.done) return false;
+    const PatternStep& step = track.steps[track.index];
+    uint32_t end = stepEnd(track);
+    if (end == PATTERN_FOREVER) return true;  // Held until stopped
+    track.fromLevel = endLevel(step, track.fromLevel);
+    track.stepStartMs = end;
+    if (++track.index < track.count) return true;
+
+    if (track.playsLeft == 1) {
+        track.done = 1;
+        return false;
+    }
+    if (track.playsLeft > 1) track.playsLeft--;
+    track.index = 0;
+    return true;
+}
+
+/**
+ * @brief End of the current step of a track.
+ *
+ * @param track The track.
+ * @return End time in milliseconds, or PATTERN_FOREVER for a held step.
+ */
+uint32_t PatternEngine::stepEnd(const PatternTrack& track) {
+    if (track.done) return PATTERN_FOREVER;
+    uint32_t length = stepDuration(track.steps[track.index]);
+    return length == 0 ? PATTERN_FOREVER : track.stepStartMs + length;
+}
+
+/**
+ * @brief Length of a step.
+ *
+ * @param step The step.
+ * @return Milliseconds (blink: cycles times period), 0 = until stopped.
+ */
+uint32_t PatternEngine::stepDuration(const PatternStep& step) {
+    if (step.op == PatternOp::Blink) return (uint32_t)step.count * (step.onMs + step.offMs);
+    return step.durationMs;
+}
+
+/**
+ * @brief Length of a pattern (the longer of its two tables, times the plays).
+ *
+ * @param pattern The pattern.
+ * @return Milliseconds, or PATTERN_FOREVER if it plays until stopped.
+ */
+uint32_t PatternEngine::duration(const Pattern& pattern) {
+    if (pattern.repeat == 0) return PATTERN_FOREVER;
+    uint32_t longest = 0;
+    const PatternStep* tables[PATTERN_OUTPUT_COUNT] = {pattern.led, pattern.buzzer};
+    uint8_t counts[PATTERN_OUTPUT_COUNT] = {pattern.ledSteps, pattern.buzzerSteps};
+    for (uint8_t output = 0; output < PATTERN_OUTPUT_COUNT; output++) {
+        if (tables[output] == nullptr) continue;
+        uint32_t length = 0;
+        for (uint8_t i = 0; i < counts[output]; i++) {
+            uint32_t step = stepDuration(tables[output][i]);
+            if (step == 0) return PATTERN_FOREVER;
+            length += step;
+        }
+        if (length > longest) longest = length;
+    }
+    return longest * pattern.repeat;
+}
+
+/**
+ * @brief Level of an output during a step.
+ *
+ * @param step The step.
+ * @param fromLevel Level when the step started (start of a fade).
+ * @param elapsedMs Time since the step started.
+ * @return Level 0-255.
+ */
+uint8_t PatternEngine::levelAt(const PatternStep& step, uint8_t fromLevel, uint32_t elapsedMs) {
+    uint32_t length = stepDuration(step);
+    switch (step.op) {
+        case PatternOp::Level:
+            return step.level;
+        case PatternOp::Blink: {
+            uint32_t period = step.onMs + step.offMs;
+            if (period == 0 || elapsedMs >= length) return endLevel(step, fromLevel);
+            return (elapsedMs % period) < step.onMs ? step.level : 0;
+        }
+        case PatternOp::Fade:
+            if (length == 0 || elapsedMs >= length) return step.level;
+            return (uint8_t)(fromLevel + ((int32_t)step.level - fromLevel) * (int32_t)elapsedMs / (int32_t)length);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Level an output is left at when a step ends.
+ *
+ * @param step The step.
+ * @param fromLevel Level when the step started.
+ * @return Level 0-255 (a blink ends with its off time).
+ */
+uint8_t PatternEngine::endLevel(const PatternStep& step, uint8_t fromLevel) {
+    (void)fromLevel;
+    switch (step.op) {
+        case PatternOp::Level:
+        case PatternOp::Fade:
+            return step.level;
+        case PatternOp::Blink:
+            return step.offMs == 0 ? step.level : 0;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Solves the LEDC timer for a PWM period.
+ *
+ * The period is clock / divider / 2^resolution. The widest resolution
+ * whose divider fits the 10.8 fixed-point field is chosen, which gives the
+ * finest duty steps.
+ *
+ * @param periodMicros PWM period in microseconds.
+ * @param clockHz Timer clock.
+ * @param setting Receives divider and resolution.
+ * @return false if the period cannot be reached with this clock.
+ */
+bool PatternEngine::solveTimer(uint64_t periodMicros, uint32_t clockHz, LedcSetting& setting) {
+    for (uint8_t resolution = PATTERN_MAX_RESOLUTION; resolution > 0; resolution--) {
+        uint64_t divider = ((uint64_t)clockHz * periodMicros * 256ULL) / (1000000ULL << resolution);
+        if (divider < 256) continue;  // Below 1.0: needs a narrower resolution
+        if (divider > PATTERN_MAX_DIVIDER) return false;  // Narrower resolutions only need more
+        setting.divider = (uint32_t)divider;
+        setting.resolution = resolution;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Compiles a step into its LEDC setting.
+ *
+ * @param step The step.
+ * @param fromLevel Level when the step starts (start of a fade).
+ * @param clockHz Timer clock.
+ * @param setting Receives the timer and channel setting.
+ * @return false if the step's period is out of reach.
+ */
+bool PatternEngine::compile(const PatternStep& step, uint8_t fromLevel, uint32_t clockHz, LedcSetting& setting) {
+    setting = LedcSetting();
+    if (step.op == PatternOp::Blink) {
+        uint32_t period = step.onMs + step.offMs;
+        if (period == 0 || !solveTimer((uint64_t)period * 1000ULL, clockHz, setting)) return false;
+        setting.duty = (uint32_t)(((uint64_t)step.onMs << setting.resolution) / period);  // Square wave: on time / period
+        return true;
+    }
+
+    if (!solveTimer(1000000ULL / PATTERN_PWM_HZ, clockHz, setting)) return false;
+    switch (step.op) {
+        case PatternOp::Level:
+            setting.duty = levelToDuty(step.level, setting.resolution);
+            break;
+        case PatternOp::Fade:
+            setting.fade = 1;
+            setting.startDuty = levelToDuty(fromLevel, setting.resolution);
+            setting.duty = levelToDuty(step.level, setting.resolution);
+            setting.fadeMs = step.durationMs;
+            break;
+        default:
+            setting.duty = 0;
+            break;
+    }
+    return true;
+}
+
+/**
+ * @brief Converts a perceived level into a PWM duty (gamma 2).
+ *
+ * @param level Level 0-255.
+ * @param resolution Duty resolution in bits.
+ * @return Duty, 2^resolution for full on.
+ */
+uint32_t PatternEngine::levelToDuty(uint8_t level, uint8_t resolution) {
+    return (uint32_t)(((uint64_t)level * level << resolution) / (255U * 255U));
+}
@@ -0,0 +1,141 @@
+#ifndef PATTERN_ENGINE_H
+#define PATTERN_ENGINE_H
+/**
+ * @file PatternEngine.h
+ * @brief LED and buzzer patterns played by the LEDC peripheral.
+ *
+ * A pattern is a constexpr table of steps per output (LED, buzzer): off,
+ * steady level, blink (on/off times and a cycle count) or fade (target
+ * level and duration), played a number of times or until stopped. Each
+ * step is compiled into one LEDC timer and channel setting:
+ * - a blink becomes a square wave whose period and duty are the on/off
+ *   times: the timer runs from the slow RC oscillator with a divider and
+ *   duty resolution solved for periods of up to about two minutes;
+ * - levels and fades are PWM at `PATTERN_PWM_HZ`, fades use the hardware
+ *   fade unit;
+ * - the buzzer is an active one, so a beep is the same square wave.
+ *
+ * The LEDC low-speed timers keep running in light sleep when clocked from
+ * the RC oscillator, so a step plays without the CPU. The engine only
+ * wakes at step boundaries, through one `EventLoop` timer, and posts
+ * `EVENT_PATTERN_DONE` when a finite pattern ends.
+ *
+ * The sequencing (step order, repeats, durations, output level at a given
+ * time) and the timer solver are pure helpers. Host builds drive the pins
+ * with the level at the start of each step.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+#define PATTERN_FOREVER 0xFFFFFFFFUL  ///< Step end of a step held until stopped
+#define PATTERN_NONE 0xFF             ///< current() while nothing plays
+
+/**
+ * @brief What an output does during a step.
+ */
+enum class PatternOp : uint8_t {
+    Off,    ///< Output off for durationMs
+    Level,  ///< Steady level for durationMs (0 = until stopped)
+    Blink,  ///< count cycles of onMs on (full level) and offMs off
+    Fade    ///< Ramp from the previous level to level over durationMs
+};
+
+/**
+ * @brief One step of an output.
+ */
+struct PatternStep {
+    PatternOp op;
+    uint8_t level;        ///< Level or fade target (0-255)
+    uint16_t count;       ///< Blink cycles
+    uint16_t onMs;        ///< Blink on time
+    uint16_t offMs;       ///< Blink off time
+    uint32_t durationMs;  ///< Off, Level and Fade length
+};
+
+constexpr PatternStep patternOff(uint32_t ms) { return {PatternOp::Off, 0, 0, 0, 0, ms}; }
+constexpr PatternStep patternLevel(uint8_t level, uint32_t ms) { return {PatternOp::Level, level, 0, 0, 0, ms}; }
+constexpr PatternStep patternBlink(uint16_t onMs, uint16_t offMs, uint16_t count) { return {PatternOp::Blink, 255, count, onMs, offMs, 0}; }
+constexpr PatternStep patternFade(uint8_t level, uint32_t ms) { return {PatternOp::Fade, level, 0, 0, 0, ms}; }
+
+/**
+ * @brief A named pattern: one step table per output.
+ */
+struct Pattern {
+    const char* name;
+    const PatternStep* led;
+    uint8_t ledSteps;
+    const PatternStep* buzzer;  ///< nullptr = silent
+    uint8_t buzzerSteps;
+    uint8_t repeat;             ///< Plays of each table (0 = until stopped)
+};
+
+/**
+ * @brief Built-in patterns (index into the pattern table).
+ */
+enum PatternIndex : uint8_t {
+    PATTERN_CLASSIC,      ///< LED blink 300/300 ms (the original alarm indication)
+    PATTERN_GENTLE,       ///< LED breathing, silent
+    PATTERN_BEEP,         ///< LED blink and a short beep every second
+    PATTERN_URGENT,       ///< Fast LED blink and beeps
+    PATTERN_SERIAL_MODE,  ///< Acknowledge of the serial programming mode, LED left on
+    PATTERN_ADMIN_MODE,   ///< Acknowledge of the admin mode
+    PATTERN_COUNT
+};
+
+/**
+ * @brief Outputs driven by the engine.
+ */
+enum class PatternOutput : uint8_t { Led, Buzzer, Count };
+
+#define PATTERN_OUTPUT_COUNT ((uint8_t)PatternOutput::Count)
+
+/**
+ * @brief Play position on one output.
+ */
+struct PatternTrack {
+    const PatternStep* steps;
+    uint8_t count;        ///< Steps in the table
+    uint8_t index;        ///< Current step
+    uint8_t playsLeft;    ///< Plays left including the current one (0 = until stopped)
+    uint8_t done;         ///< 1 once the last play ended
+    uint8_t fromLevel;    ///< Level when the current step started
+    uint32_t stepStartMs; ///< Start of the current step
+};
+
+/**
+ * @brief One LEDC timer and channel setting.
+ */
+struct LedcSetting {
+    uint32_t divider;     ///< Timer clock divider, fixed point with 8 fractional bits
+    uint8_t resolution;   ///< Duty resolution in bits
+    uint8_t fade;         ///< 1 = hardware fade from startDuty to duty over fadeMs
+    uint32_t startDuty;   ///< Duty at the start of a fade
+    uint32_t duty;        ///< Duty (fade target)
+    uint32_t fadeMs;
+};
+
+class PatternEngine {
+public:
+    static bool start(uint8_t pattern);  // Play a pattern (stops the current one)
+    static void stop();  // Outputs off, pins back to GPIO
+    static bool isPlaying();
+    static uint8_t current();  // Index of the playing pattern (PATTERN_NONE if none)
+    static uint8_t level(PatternOutput output);  // Output level now (0-255)
+    static const Pattern& pattern(uint8_t index);
+    static int find(const char* name);  // Index of a pattern by name, or -1
+
+    // Pure helpers (host testable)
+    static void rewind(PatternTrack& track, const PatternStep* steps, uint8_t count, uint8_t repeat, uint32_t nowMs);
+    static bool next(PatternTrack& track);  // Move past the current step, false once finished
+    static uint32_t stepEnd(const PatternTrack& track);  // End of the current step (PATTERN_FOREVER if held)
+    static uint32_t stepDuration(const PatternStep& step);  // 0 = until stopped
+    static uint32_t duration(const Pattern& pattern);  // Length of a pattern (PATTERN_FOREVER if endless)
+    static uint8_t levelAt(const PatternStep& step, uint8_t fromLevel, uint32_t elapsedMs);
+    static uint8_t endLevel(const PatternStep& step, uint8_t fromLevel);
+    static bool solveTimer(uint64_t periodMicros, uint32_t clockHz, LedcSetting& setting);
+    static bool compile(const PatternStep& step, uint8_t fromLevel, uint32_t clockHz, LedcSetting& setting);
+    static uint32_t levelToDuty(uint8_t level, uint8_t resolution);
+};
+
+#endif // PATTERN_ENGINE_H
@@ -0,0 +1,85 @@
+#ifndef PORTAL_MESSAGES_H
+#define PORTAL_MESSAGES_H
+/**
+ * @file PortalMessages.h
+ * @brief JSON messages of the web portal and the serial alarm command.
+ *
+ * Each struct is one fixed-schema message; its field table gives the JSON
+ * key (the member name), the checks and whether it is required (see
+ * JsonCodec.h).
+ */
+
+#include "JsonCodec.h"
+
+#define JSON_DATE_FORMAT "####-##-##"  ///< YYYY-MM-DD
+#define JSON_TIME_FORMAT "##:##"       ///< HH:MM
+
+// Request dates and times are range checked by CivilTime, which also
+// accepts HH:MM:SS, so request times carry no template.
+
+/**
+ * @brief Alarm set by /setAlarm or the serial command.
+ */
+struct AlarmRequest {
+    char alarmDate[11];  ///< YYYY-MM-DD
+    char alarmTime[9];   ///< HH:MM[:SS]
+    char repeat[9];      ///< "once", "daily", "weekly" or "interval" (empty = once)
+    int32_t weekdays;    ///< Weekly mask, bit 0 = Sunday
+    int32_t interval;    ///< Period of interval rules (minutes)
+    char pattern[12];    ///< LED/buzzer pattern name
+    bool add;            ///< Add to the alarm table instead of replacing it
+};
+
+static constexpr JsonField kAlarmRequestFields[] = {
+    JSON_STRING(AlarmRequest, alarmDate, JSON_DATE_FORMAT, true),
+    JSON_STRING(AlarmRequest, alarmTime, nullptr, true),
+    JSON_STRING(AlarmRequest, repeat, nullptr, false),
+    JSON_INT(AlarmRequest, weekdays, 0, 0x7F, false),
+    JSON_INT(AlarmRequest, interval, 0, 525600, false),  // Up to a year
+    JSON_STRING(AlarmRequest, pattern, nullptr, false),
+    JSON_BOOL(AlarmRequest, add, false),
+};
+JSON_SCHEMA(AlarmRequest, kAlarmRequestFields);
+
+/**
+ * @brief Clock set by /setRTC.
+ */
+struct RtcRequest {
+    char rtcDate[11];  ///< YYYY-MM-DD
+    char rtcTime[9];   ///< HH:MM[:SS]
+};
+
+static constexpr JsonField kRtcRequestFields[] = {
+    JSON_STRING(RtcRequest, rtcDate, JSON_DATE_FORMAT, true),
+    JSON_STRING(RtcRequest, rtcTime, nullptr, true),
+};
+JSON_SCHEMA(RtcRequest, kRtcRequestFields);
+
+/**
+ * @brief A date and a time, as shown by the settings page.
+ */
+struct DateTimeReply {
+    char date[11];  ///< YYYY-MM-DD
+    char time[6];   ///< HH:MM
+};
+
+static constexpr JsonField kDateTimeReplyFields[] = {
+    JSON_STRING(DateTimeReply, date, JSON_DATE_FORMAT, true),
+    JSON_STRING(DateTimeReply, time, JSON_TIME_FORMAT, true),
+};
+
+/**
+ * @brief Reply of /getSettings: the saved alarm and the current clock.
+ */
+struct SettingsReply {
+    DateTimeReply alarm;
+    DateTimeReply rtc;
+};
+
+static constexpr JsonField kSettingsReplyFields[] = {
+    JSON_OBJECT(SettingsReply, alarm, kDateTimeReplyFields),
+    JSON_OBJECT(SettingsReply, rtc, kDateTimeReplyFields),
+};
+JSON_SCHEMA(SettingsReply, kSettingsReplyFields);
+
+#endif // PORTAL_MESSAGES_H
@@ -1,10 +1,16 @@
 #include "RTCManager.h"
+#include "TimeAccounting.h"
+#include "CivilTime.h"
 #include <time.h>
 #include <sys/time.h>
 
 // Constructor implementation
 RTCManager::RTCManager(struct tm* timeinfo) {
     this->timeinfo = timeinfo;  // Store the pointer to the timeinfo struct
+    formattedTime[0] = '\0';
+    formattedDate[0] = '\0';
+    formattedMinute = -1;
+    formattedDay = -1;
     update();  // Initialize time and date values
     if (DEBUGMODE)Serial.print("Last ON Time");
     if (DEBUGMODE)Serial.print("Time: ");
@@ -13,72 +19,107 @@ RTCManager::RTCManager(struct tm* timeinfo) {
     if (DEBUGMODE)Serial.println(formattedDate);  // Print formatted date (YYYY-MM-DD)
 }
 
-// Set the system time from a Unix timestamp (seconds since Jan 1, 1970)
+// Set the system time from a Unix timestamp (seconds since Jan 1, 1970) and re-anchor the RTC time accounting
 void RTCManager::setUnixTime(unsigned long timestamp) {
-    struct timeval tv;
-    tv.tv_sec = timestamp;  // Set seconds since the Unix epoch
-    tv.tv_usec = 0;  // No microseconds
-    esp_task_wdt_reset(); // Reset the watchdog timer to prevent a system reset
-    settimeofday(&tv, nullptr); // Set system time
+    TimeAccounting::setUnixTime(timestamp);
 }
 
-// Get the current Unix timestamp (seconds since Jan 1, 1970)
+/**
+ * @brief Current Unix timestamp (seconds since Jan 1, 1970), read straight
+ *        from the system clock.
+ *
+ * Unlike getLocalTime(), which polls for up to 5 s while the year looks
+ * unset, this never waits: an unset clock is reported at once. The firmware
+ * keeps local time as UTC, so no mktime() round trip is needed.
+ *
+ * @return The timestamp, or 0 while the clock is unset.
+ */
 unsigned long RTCManager::getUnixTime() {
-    time_t now;
-    esp_task_wdt_reset(); // Reset the watchdog timer to prevent a system reset
-    if (getLocalTime(timeinfo)) {
-        // Convert time struct to Unix timestamp
-        now = mktime(timeinfo);
-        return now;
-    }
-    return 0;  // Return 0 if time can't be fetched
+    struct timeval now;
+    if (gettimeofday(&now, nullptr) != 0 || !isValidTime(now.tv_sec)) return 0;
+    return now.tv_sec;
+}
+
+// Check whether the clock has been set (NTP, portal, serial or saved time)
+bool RTCManager::isClockSet() {
+    return getUnixTime() != 0;
+}
+
+/**
+ * @brief Whether a timestamp is a plausible wall-clock time.
+ *
+ * Earlier values mean the clock was never set (it counts from 0 after a cold
+ * boot); later ones do not fit the 32-bit timestamps of the alarm table.
+ */
+bool RTCManager::isValidTime(uint64_t timestamp) {
+    return timestamp >= RTC_VALID_AFTER && timestamp <= UINT32_MAX;
 }
 
 // Get the current time as a formatted string (HH:MM)
-String RTCManager::getTime() {
+const char* RTCManager::getTime() {
+    update();
     return formattedTime;
 }
 
 // Get the current date as a formatted string (YYYY-MM-DD)
-String RTCManager::getDate() {
+const char* RTCManager::getDate() {
+    update();
     return formattedDate;
 }
 
-// Update the formatted time and date values
-void RTCManager::update() {
-    if (getLocalTime(timeinfo)) {
-        // Format time (HH:MM)
-        char timeString[6];
-        sprintf(timeString, "%02d:%02d", timeinfo->tm_hour, timeinfo->tm_min);
-        formattedTime = String(timeString);
-
-        // Format date (YYYY-MM-DD)
-        char dateString[11];
-        sprintf(dateString, "%04d-%02d-%02d", timeinfo->tm_year + 1900, timeinfo->tm_mon + 1, timeinfo->tm_mday);
-        formattedDate = String(dateString);
-    } else {
+/**
+ * @brief Refreshes the cached time and date strings.
+ *
+ * The strings live in fixed buffers; the time is formatted again only when
+ * the minute changed and the date only when the day changed, so repeated
+ * calls cost one clock read.
+ *
+ * @return false while the clock is unset (the strings are then empty).
+ */
+bool RTCManager::update() {
+    uint32_t now = getUnixTime();
+    if (now == 0) {
         if (DEBUGMODE)Serial.println("Failed to get local time.");
+        formattedTime[0] = '\0';
+        formattedDate[0] = '\0';
+        formattedMinute = -1;
+        formattedDay = -1;
+        return false;
+    }
+
+    if (now / 60 != formattedMinute) {
+        CivilTime::formatTime(now, formattedTime);  // HH:MM
+        formattedMinute = now / 60;
+        if (timeinfo != nullptr) {
+            time_t current = now;
+            localtime_r(&current, timeinfo);  // Keep the broken-down time in step
+        }
+    }
+    if (now / 86400 != formattedDay) {
+        CivilTime::formatDate(now, formattedDate);  // YYYY-MM-DD
+        formattedDay = now / 86400;
     }
+    return true;
 }
 
 // Function to set the time of the RTC directly
-void RTCManager::setRTCTime(int year, int month, int day, int hour, int minute, int second) {
-    // Set the time values directly in the timeinfo struct
-    timeinfo->tm_year = year - 1900;  // Year since 1900 (e.g., 2025 -> 2025 - 1900)
-    timeinfo->tm_mon = month - 1;     // Month (0-based, e.g., January is 0)
-    timeinfo->tm_mday = day;          // Day of the month
-    timeinfo->tm_hour = hour;         // Hour (24-hour format)
-    timeinfo->tm_min = minute;        // Minute
-    timeinfo->tm_sec = second;        // Second
+bool RTCManager::setRTCTime(int year, int month, int day, int hour, int minute, int second) {
+    CivilDateTime civil;
+    civil.year = year;
+    civil.month = month;
+    civil.day = day;
+    civil.hour = hour;
+    civil.minute = minute;
+    civil.second = second;
 
-    // Use settimeofday to update the system time
-    struct timeval tv;
-    tv.tv_sec = mktime(timeinfo);  // Convert tm structure to Unix timestamp
-    tv.tv_usec = 0;  // No microseconds
+    // Convert without mktime() (local time is kept as UTC); the fields are validated by the caller
+    uint32_t timestamp = 0;
+    if (year < 1970 || year > 2106 || !CivilTime::toUnix(civil, timestamp)) return false;
 
-    // Set the system time
-    settimeofday(&tv, nullptr);
+    // Set the system time and re-anchor the RTC time accounting
+    setUnixTime(timestamp);
 
     // Update the formatted time and date in the class
     update();
+    return true;
 }
@@ -8,16 +8,22 @@ public:
     RTCManager(struct tm* timeinfo);  // Constructor
 
     void setUnixTime(unsigned long timestamp);  // Set RTC time using Unix timestamp
-    unsigned long getUnixTime();  // Get current Unix timestamp
-    String getTime();  // Get current time as a formatted string (HH:MM)
-    String getDate();  // Get current date as a formatted string (YYYY-MM-DD)
-    void update();  // Update time and date values
-    void setRTCTime(int year, int month, int day, int hour, int minute, int second);
+    unsigned long getUnixTime();  // Get current Unix timestamp, 0 while the clock is unset (never waits)
+    bool isClockSet();  // true once the clock holds a plausible time (RTC_VALID_AFTER)
+    const char* getTime();  // Get current time as a formatted string (HH:MM), empty while the clock is unset
+    const char* getDate();  // Get current date as a formatted string (YYYY-MM-DD), empty while the clock is unset
+    bool update();  // Update time and date values (only the parts whose minute/day changed)
+    bool setRTCTime(int year, int month, int day, int hour, int minute, int second);  // false outside 1970 to 2106
+
+    // Pure helpers (host testable)
+    static bool isValidTime(uint64_t timestamp);
 
 private:
     struct tm* timeinfo;  // Struct to hold time information
-    String formattedTime;  // Stores the formatted time (HH:MM)
-    String formattedDate;  // Stores the formatted date (YYYY-MM-DD)
+    char formattedTime[6];  // Stores the formatted time (HH:MM)
+    char formattedDate[11];  // Stores the formatted date (YYYY-MM-DD)
+    int64_t formattedMinute;  // Unix minute of formattedTime, -1 = not formatted
+    int64_t formattedDay;  // Unix day of formattedDate, -1 = not formatted
 };
 
 #endif  // RTCMANAGER_H
@@ -0,0 +1,85 @@
+#include "RequestBody.h"
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+/**
+ * @brief Adds one chunk of a request body to the buffer held in `slot`.
+ *
+ * The first chunk (index 0) allocates the buffer for the whole body; when
+ * the body is too large or memory is short, `slot` stays empty and the
+ * remaining chunks are dropped.
+ *
+ * @param slot The request's `_tempObject`.
+ * @param data Chunk data.
+ * @param len Chunk length.
+ * @param index Offset of the chunk in the body.
+ * @param total Length of the whole body.
+ * @return The body once its last byte has arrived, nullptr before that or
+ *         if it has no buffer.
+ */
+RequestBody* RequestBody::collect(void*& slot, const uint8_t* data, size_t len, size_t index, size_t total) {
+    if (slot == nullptr) {
+        if (index != 0) return nullptr;
+        slot = create(total);
+        if (slot == nullptr) return nullptr;
+    }
+    RequestBody* body = static_cast<RequestBody*>(slot);
+    if (!body->append(data, len, index)) return nullptr;
+    return body->complete() ? body : nullptr;
+}
+
+/**
+ * @brief Allocates a body buffer of `total` bytes in a single block.
+ *
+ * The header and the text share one malloc() so the owner can release
+ * both with a single free() (what AsyncWebServerRequest does with its
+ * `_tempObject`).
+ *
+ * @param total Length of the body.
+ * @return The empty body, or nullptr if it exceeds WEB_BODY_MAX_BYTES or
+ *         memory is short.
+ */
+RequestBody* RequestBody::create(size_t total) {
+    if (total == 0 || total > WEB_BODY_MAX_BYTES) return nullptr;
+    void* block = malloc(sizeof(RequestBody) + total + 1);
+    if (block == nullptr) return nullptr;
+    RequestBody* body = new (block) RequestBody();  // Trivially destructible: free() is enough
+    body->_total = total;
+    body->_received = 0;
+    body->text()[total] = '\0';
+    return body;
+}
+
+/**
+ * @brief Copies a chunk at its offset.
+ *
+ * @return false if the chunk does not fit in the body.
+ */
+bool RequestBody::append(const uint8_t* data, size_t len, size_t index) {
+    if (index > _total || len > _total - index) return false;
+    memcpy(text() + index, data, len);
+    _received += len;
+    return true;
+}
+
+/**
+ * @brief Checks whether every byte of the body has arrived.
+ */
+bool RequestBody::complete() const {
+    return _received >= _total;
+}
+
+/**
+ * @brief Gives the body text, stored right after the header.
+ */
+char* RequestBody::text() {
+    return reinterpret_cast<char*>(this + 1);
+}
+
+/**
+ * @brief Gives the length of the body.
+ */
+size_t RequestBody::length() const {
+    return _total;
+}
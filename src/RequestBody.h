@@ -0,0 +1,43 @@
+#ifndef REQUEST_BODY_H
+#define REQUEST_BODY_H
+/**
+ * @file RequestBody.h
+ * @brief Per-request buffer for the chunked JSON bodies of the web portal.
+ *
+ * ESPAsyncWebServer delivers a POST body in chunks (`index`, `len`,
+ * `total`). The first chunk allocates one buffer sized from `total` (the
+ * Content-Length) and stores it in the request's `_tempObject`; later
+ * chunks are copied in place at their index. The request frees
+ * `_tempObject` with free() when it is destroyed (also on a dropped
+ * connection), so the buffer lives exactly as long as its request and
+ * concurrent uploads never share state. The complete body is NUL
+ * terminated and handed to the parser as is.
+ *
+ * Bodies larger than `WEB_BODY_MAX_BYTES` get no buffer; the handler
+ * answers 413 once the last chunk arrives.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Config.h"
+
+class RequestBody {
+public:
+    // Adds a chunk to the body in `slot`; returns the body once complete
+    static RequestBody* collect(void*& slot, const uint8_t* data, size_t len, size_t index, size_t total);
+
+    // Pure helpers (host testable)
+    static RequestBody* create(size_t total);  // malloc'd, released with free()
+    bool append(const uint8_t* data, size_t len, size_t index);
+    bool complete() const;
+    char* text();  // NUL-terminated body
+    size_t length() const;
+
+private:
+    RequestBody() {}
+
+    size_t _total;     // Content-Length
+    size_t _received;  // Bytes copied so far
+};
+
+#endif // REQUEST_BODY_H
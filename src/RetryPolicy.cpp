@@ -0,0 +1,136 @@
+#include <Arduino.h>
+#include "RetryPolicy.h"
+#include "TimeAccounting.h"
+#include "Crc32.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR  // Host builds: plain static storage
+#endif
+
+// Backoff preserved across deep sleep (zeroed on power-on)
+RTC_DATA_ATTR static RetryState rtcRetryState;
+
+/**
+ * @brief Random value for the jitter (deterministic on the host).
+ */
+static uint32_t retryRandom() {
+#ifdef ARDUINO
+    return esp_random();
+#else
+    return (uint32_t)rand();
+#endif
+}
+
+/**
+ * @brief Checks whether a failed sync is waiting for its retry.
+ */
+bool RetryPolicy::pending() {
+    return validate(rtcRetryState) && rtcRetryState.failures > 0;
+}
+
+/**
+ * @brief Checks whether a sync may be attempted now.
+ *
+ * @return true if no retry is pending or its time has come.
+ */
+bool RetryPolicy::due() {
+    return secondsUntilRetry() == 0;
+}
+
+/**
+ * @brief Time left until the next attempt.
+ *
+ * @return Seconds (0 if due or nothing pending).
+ */
+uint32_t RetryPolicy::secondsUntilRetry() {
+    if (!pending()) return 0;
+    uint64_t now = TimeAccounting::rtcMicros();
+    if (now >= rtcRetryState.nextMicros) return 0;
+    return (uint32_t)((rtcRetryState.nextMicros - now + 999999ULL) / 1000000ULL);
+}
+
+/**
+ * @brief Records a failed sync and schedules the next attempt.
+ *
+ * @return Wait before the next attempt in seconds.
+ */
+uint32_t RetryPolicy::failed() {
+    if (!validate(rtcRetryState)) {
+        memset(&rtcRetryState, 0, sizeof(rtcRetryState));
+        rtcRetryState.magic = RETRY_MAGIC;
+    }
+    if (rtcRetryState.failures < UINT16_MAX) rtcRetryState.failures++;
+    rtcRetryState.totalFailures++;
+    rtcRetryState.waitSeconds = backoffSeconds(rtcRetryState.failures, RETRY_BASE_SECONDS, RETRY_MAX_SECONDS,
+                                               RETRY_JITTER_PERCENT, retryRandom());
+    rtcRetryState.nextMicros = TimeAccounting::rtcMicros() + rtcRetryState.waitSeconds * 1000000ULL;
+    seal(rtcRetryState);
+
+    if (DEBUGMODE)Serial.printf("Time sync failed (%u in a row), next attempt in %lu s\n",
+                                (unsigned)rtcRetryState.failures, (unsigned long)rtcRetryState.waitSeconds);
+    return rtcRetryState.waitSeconds;
+}
+
+/**
+ * @brief Clears the backoff after a successful sync.
+ */
+void RetryPolicy::succeeded() {
+    if (!validate(rtcRetryState)) {
+        memset(&rtcRetryState, 0, sizeof(rtcRetryState));
+        rtcRetryState.magic = RETRY_MAGIC;
+    }
+    rtcRetryState.failures = 0;
+    rtcRetryState.waitSeconds = 0;
+    rtcRetryState.nextMicros = 0;
+    seal(rtcRetryState);
+}
+
+/**
+ * @brief Gives read access to the backoff state.
+ */
+const RetryState& RetryPolicy::state() {
+    return rtcRetryState;
+}
+
+/**
+ * @brief Computes the jittered wait after a number of consecutive failures.
+ *
+ * @param failures Consecutive failures (1 for the first).
+ * @param baseSeconds Wait after the first failure.
+ * @param maxSeconds Cap of the un-jittered wait.
+ * @param jitterPercent Spread of the wait (+/- percent).
+ * @param random Uniform random value.
+ * @return Wait in seconds (at least 1).
+ */
+uint32_t RetryPolicy::backoffSeconds(uint16_t failures, uint32_t baseSeconds, uint32_t maxSeconds,
+                                     uint8_t jitterPercent, uint32_t random) {
+    uint64_t wait = baseSeconds;
+    for (uint16_t i = 1; i < failures && wait < maxSeconds; i++) wait *= 2;
+    if (wait > maxSeconds) wait = maxSeconds;
+
+    uint64_t spread = wait * (jitterPercent > 100 ? 100 : jitterPercent) / 100;
+    wait = wait - spread + random % (2 * spread + 1);
+    return wait > 0 ? (uint32_t)wait : 1;
+}
+
+/**
+ * @brief Validates magic and CRC of a backoff state.
+ */
+bool RetryPolicy::validate(const RetryState& state) {
+    return state.magic == RETRY_MAGIC &&
+           state.crc == crc32Update(&state, offsetof(RetryState, crc));
+}
+
+/**
+ * @brief Recomputes the CRC of a backoff state.
+ */
+void RetryPolicy::seal(RetryState& state) {
+    state.crc = crc32Update(&state, offsetof(RetryState, crc));
+}
@@ -0,0 +1,53 @@
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+/**
+ * @file RetryPolicy.h
+ * @brief Exponential backoff of failed time syncs, waited out in deep sleep.
+ *
+ * A failed sync (no Wi-Fi or no NTP answer) is not retried in a busy loop:
+ * the failure is recorded in RTC slow memory and the next attempt is
+ * scheduled `RETRY_BASE_SECONDS * 2^(n-1)` later (capped at
+ * `RETRY_MAX_SECONDS`), spread by +/- `RETRY_JITTER_PERCENT` so devices
+ * behind the same router do not retry in lockstep. Meanwhile the device
+ * keeps running on its drift-compensated local clock and sleeps until the
+ * earlier of the alarm and the next attempt.
+ *
+ * Deadlines are RTC timer values; a power-on clears the state together with
+ * the timer.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+#define RETRY_MAGIC 0x52545259UL  ///< "RTRY"
+
+/**
+ * @brief Backoff state (RTC slow memory).
+ */
+struct RetryState {
+    uint32_t magic;          ///< RETRY_MAGIC when valid
+    uint16_t failures;       ///< Consecutive failed syncs
+    uint16_t reserved;
+    uint32_t totalFailures;  ///< Failed syncs since power-on
+    uint32_t waitSeconds;    ///< Current wait
+    uint64_t nextMicros;     ///< RTC timer value of the next attempt
+    uint32_t crc;            ///< CRC-32 of the preceding fields
+};
+
+class RetryPolicy {
+public:
+    static bool pending();  // A failed sync is waiting for its retry
+    static bool due();  // True if a sync may be attempted now
+    static uint32_t secondsUntilRetry();  // 0 when due
+    static uint32_t failed();  // Record a failure, return the wait in seconds
+    static void succeeded();  // Clear the backoff
+    static const RetryState& state();
+
+    // Pure helpers (host testable)
+    static uint32_t backoffSeconds(uint16_t failures, uint32_t baseSeconds, uint32_t maxSeconds,
+                                   uint8_t jitterPercent, uint32_t random);
+    static bool validate(const RetryState& state);
+    static void seal(RetryState& state);
+};
+
+#endif // RETRY_POLICY_H
@@ -0,0 +1,117 @@
+#include "SleepScheduler.h"
+
+// Longest sleep Device::deepSleep() can express (milliseconds in 32 bits)
+static const uint64_t kMaxDeviceSleepSeconds = 4294967UL;
+
+/**
+ * @brief Constructs a scheduler using the policy defined in Config.h.
+ */
+SleepScheduler::SleepScheduler() : _policy(defaultPolicy()) {}
+
+/**
+ * @brief Constructs a scheduler with an explicit policy.
+ *
+ * @param policy The scheduling policy.
+ */
+SleepScheduler::SleepScheduler(const SleepPolicy& policy) : _policy(policy) {}
+
+/**
+ * @brief Builds the default policy from the values in Config.h.
+ *
+ * @return The default scheduling policy.
+ */
+SleepPolicy SleepScheduler::defaultPolicy() {
+    SleepPolicy policy;
+    policy.guardSeconds = SLEEP_GUARD_BAND;
+    policy.driftPpm = SLEEP_DRIFT_PPM;
+    policy.minSleepSeconds = SLEEP_MIN_INTERVAL;
+    policy.maxSleepSeconds = SLEEP_MAX_INTERVAL;
+    policy.quietStartHour = SLEEP_QUIET_START_HOUR;
+    policy.quietEndHour = SLEEP_QUIET_END_HOUR;
+    policy.directSeconds = ULP_COUNTDOWN_MAX_S;
+    return policy;
+}
+
+/**
+ * @brief Computes how long to sleep before the next wake.
+ *
+ * The interval keeps a margin of `guardSeconds` plus the drift the clock
+ * may accumulate over the remaining time. Once the remaining time is within
+ * that margin (plus the minimum sleep), or within `directSeconds`, the
+ * scheduler sleeps exactly until the alarm.
+ *
+ * @param now Current Unix time.
+ * @param alarm Alarm Unix time.
+ * @return Sleep duration in seconds (at least 1).
+ */
+uint32_t SleepScheduler::nextSleepSeconds(uint64_t now, uint64_t alarm) const {
+    uint64_t minSleep = _policy.minSleepSeconds ? _policy.minSleepSeconds : 1;
+    if (alarm <= now) return (uint32_t)minSleep;
+
+    uint64_t remaining = alarm - now;
+    uint64_t margin = _policy.guardSeconds + (remaining * _policy.driftPpm) / 1000000ULL;
+
+    uint64_t sleep;
+    if (remaining <= margin + minSleep || remaining <= _policy.directSeconds) {
+        sleep = remaining;  // Final approach: land on the alarm
+    } else {
+        uint64_t approach = remaining - margin;  // Latest safe intermediate wake
+        sleep = approach;
+        if (_policy.maxSleepSeconds != 0 && sleep > _policy.maxSleepSeconds) {
+            sleep = _policy.maxSleepSeconds;
+            // Do not schedule intermediate wakes inside the quiet window
+            if (isQuiet(now + sleep)) {
+                uint64_t deferred = quietEnd(now + sleep) - now;
+                sleep = deferred < approach ? deferred : approach;
+            }
+        }
+    }
+
+    if (sleep > kMaxDeviceSleepSeconds) sleep = kMaxDeviceSleepSeconds;
+    return (uint32_t)sleep;
+}
+
+/**
+ * @brief Updates the drift estimate used to size the safety margin.
+ *
+ * @param driftPpm Estimated worst-case drift in parts per million.
+ */
+void SleepScheduler::setDriftPpm(uint32_t driftPpm) {
+    _policy.driftPpm = driftPpm;
+}
+
+/**
+ * @brief Gives read access to the active policy.
+ *
+ * @return The scheduling policy.
+ */
+const SleepPolicy& SleepScheduler::policy() const {
+    return _policy;
+}
+
+/**
+ * @brief Checks whether a timestamp falls inside the quiet window.
+ *
+ * @param timestamp Local Unix time.
+ * @return true if quiet hours are enabled and the timestamp is within them.
+ */
+bool SleepScheduler::isQuiet(uint64_t timestamp) const {
+    if (_policy.quietStartHour == _policy.quietEndHour) return false;
+    uint8_t hour = (timestamp % 86400ULL) / 3600ULL;
+    if (_policy.quietStartHour < _policy.quietEndHour) {
+        return hour >= _policy.quietStartHour && hour < _policy.quietEndHour;
+    }
+    return hour >= _policy.quietStartHour || hour < _policy.quietEndHour;  // Wraps midnight
+}
+
+/**
+ * @brief Returns the end of the quiet window following a timestamp.
+ *
+ * @param timestamp Local Unix time inside the quiet window.
+ * @return Unix time at which the quiet window ends.
+ */
+uint64_t SleepScheduler::quietEnd(uint64_t timestamp) const {
+    uint64_t end = timestamp - (timestamp % 86400ULL) + _policy.quietEndHour * 3600ULL;
+    if (end <= timestamp) end += 86400ULL;
+    return end;
+}
@@ -0,0 +1,58 @@
+#ifndef SLEEP_SCHEDULER_H
+#define SLEEP_SCHEDULER_H
+/**
+ * @file SleepScheduler.h
+ * @brief Computes the next deep-sleep interval from the alarm deadline.
+ *
+ * Instead of waking every `DEEPSLEEP_TIME`, the device sleeps as long as it
+ * safely can: the interval is the remaining time to the alarm minus a guard
+ * band and the worst-case clock drift accumulated over that interval. This
+ * naturally yields one long sleep followed by progressively shorter ones as
+ * the alarm approaches, and a final sleep that ends exactly on the alarm.
+ *
+ * Optional policies:
+ * - a maximum interval (periodic checkpoint wakes);
+ * - quiet hours, during which intermediate (non-alarm) wakes are deferred
+ *   to the end of the quiet window.
+ * - a direct approach: once the alarm is this close, one sleep lands on it
+ *   (the ULP counts it down, see UlpWatch) instead of further approach wakes.
+ *
+ * The scheduler is pure arithmetic on Unix seconds so it can be driven with
+ * virtual time in host builds.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+/**
+ * @brief Tunables of the sleep scheduler.
+ */
+struct SleepPolicy {
+    uint32_t guardSeconds;     ///< Safety margin kept before the alarm
+    uint32_t driftPpm;         ///< Estimated worst-case clock drift (parts per million)
+    uint32_t minSleepSeconds;  ///< Shortest sleep worth scheduling
+    uint32_t maxSleepSeconds;  ///< Longest sleep allowed (0 = unlimited)
+    uint8_t quietStartHour;    ///< Start of the quiet window (local hour)
+    uint8_t quietEndHour;      ///< End of the quiet window (equal to start = disabled)
+    uint32_t directSeconds;    ///< Remaining time slept in one go (0 = disabled)
+};
+
+class SleepScheduler {
+public:
+    SleepScheduler();
+    explicit SleepScheduler(const SleepPolicy& policy);
+
+    uint32_t nextSleepSeconds(uint64_t now, uint64_t alarm) const;  // Next sleep interval
+    void setDriftPpm(uint32_t driftPpm);  // Update the drift estimate
+    const SleepPolicy& policy() const;
+
+    static SleepPolicy defaultPolicy();  // Policy built from Config.h
+
+private:
+    bool isQuiet(uint64_t timestamp) const;
+    uint64_t quietEnd(uint64_t timestamp) const;
+
+    SleepPolicy _policy;
+};
+
+#endif // SLEEP_SCHEDULER_H
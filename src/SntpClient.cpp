@@ -0,0 +1,388 @@
+#include "SntpClient.h"
+#include "TimeAccounting.h"
+#include "Crc32.h"
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#include <esp_timer.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR  // Host builds: plain static storage
+#endif
+
+// Server addresses preserved across deep sleep (zeroed on power-on)
+RTC_DATA_ATTR static SntpDnsCache rtcSntpDnsCache;
+
+/**
+ * @brief Local clock used to time the exchange.
+ */
+static uint64_t sntpMicros() {
+#ifdef ARDUINO
+    return (uint64_t)esp_timer_get_time();
+#else
+    return TimeAccounting::rtcMicros();
+#endif
+}
+
+static uint64_t readTimestamp(const uint8_t* bytes) {
+    uint64_t value = 0;
+    for (uint8_t i = 0; i < 8; i++) value = (value << 8) | bytes[i];
+    return value;
+}
+
+static void writeTimestamp(uint8_t* bytes, uint64_t value) {
+    for (int8_t i = 7; i >= 0; i--) {
+        bytes[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+/**
+ * @brief Constructs a client for a list of servers.
+ *
+ * @param servers Host names; only the first `NTP_MAX_SERVERS` are used.
+ * @param count Number of entries in `servers`.
+ */
+SntpClient::SntpClient(const char* const* servers, uint8_t count)
+    : _count(count < NTP_MAX_SERVERS ? count : NTP_MAX_SERVERS), _pending(0), _answered(0),
+      _state(SntpState::Idle), _best(), _startedMicros(0), _firstAnswerMicros(0), _timeoutMicros(0) {
+    memset(_servers, 0, sizeof(_servers));
+    for (uint8_t i = 0; i < _count; i++) _servers[i].name = servers[i];
+}
+
+/**
+ * @brief Starts an exchange: resolves every server and sends all requests.
+ *
+ * All servers are resolved before the first request leaves, so that no
+ * lookup delays the reception of an answer (which would inflate its delay
+ * and skew its offset). Servers that cannot be resolved are skipped; the
+ * exchange only fails to start when no request could be sent.
+ *
+ * @return true if at least one request is in flight.
+ */
+bool SntpClient::begin() {
+    if (!validate(rtcSntpDnsCache)) {
+        memset(&rtcSntpDnsCache, 0, sizeof(rtcSntpDnsCache));
+        rtcSntpDnsCache.magic = SNTP_DNS_MAGIC;
+        seal(rtcSntpDnsCache);
+    }
+
+    _udp.stop();
+    _udp.begin(NTP_LOCAL_PORT);
+    _pending = 0;
+    _answered = 0;
+    _firstAnswerMicros = 0;
+    _best = SntpSample();
+
+    bool resolved[NTP_MAX_SERVERS];
+    for (uint8_t i = 0; i < _count; i++) {
+        _servers[i].answered = false;
+        _servers[i].sentMicros = 0;
+        resolved[i] = resolve(i);
+    }
+
+    uint8_t packet[SNTP_PACKET_SIZE];
+    for (uint8_t i = 0; i < _count; i++) {
+        Server& server = _servers[i];
+        if (!resolved[i]) continue;
+
+        server.sentMicros = sntpMicros();
+        server.transmit = toNtp(server.sentMicros);  // Echoed back as the originate timestamp
+        buildRequest(packet, server.transmit);
+        _udp.beginPacket(IPAddress(server.ip), NTP_PORT);
+        _udp.write(packet, sizeof(packet));
+        if (!_udp.endPacket()) {
+            server.sentMicros = 0;  // Not in flight
+            continue;
+        }
+        _pending++;
+    }
+
+    _startedMicros = sntpMicros();
+    _timeoutMicros = NTP_TIMEOUT_MS * 1000UL;
+    _state = _pending ? SntpState::Pending : SntpState::Failed;
+    if (DEBUGMODE)Serial.printf("SNTP: %u request(s) sent\n", (unsigned)_pending);
+    return _pending > 0;
+}
+
+/**
+ * @brief Collects the answers received so far.
+ *
+ * @return Pending while waiting, then Done (best answer kept) or Failed.
+ */
+SntpState SntpClient::poll() {
+    if (_state != SntpState::Pending) return _state;
+    receive();
+
+    uint64_t now = sntpMicros();
+    bool settled = _firstAnswerMicros != 0 && now - _firstAnswerMicros >= NTP_SETTLE_MS * 1000ULL;
+    bool expired = now - _startedMicros >= _timeoutMicros;
+    if (_pending != 0 && !settled && !expired) return _state;
+
+    // Servers that stayed silent may have moved: resolve them again next time
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_servers[i].sentMicros != 0 && !_servers[i].answered) forget(i);
+    }
+    _state = _answered ? SntpState::Done : SntpState::Failed;
+    if (DEBUGMODE && _state == SntpState::Done) {
+        Serial.printf("SNTP: %u answer(s), best %s (stratum %u, delay %lu us)\n", (unsigned)_answered,
+                      _servers[_best.server].name, (unsigned)_best.stratum, (unsigned long)_best.delayMicros);
+    }
+    return _state;
+}
+
+/**
+ * @brief Runs a complete exchange, yielding to the system while waiting.
+ *
+ * @param timeoutMs Time given to the servers to answer.
+ * @return true if a valid answer was received.
+ */
+bool SntpClient::sync(uint32_t timeoutMs) {
+    if (!begin()) return false;
+    _timeoutMicros = timeoutMs * 1000UL;
+    while (poll() == SntpState::Pending) {
+        delay(1);
+    }
+    return _state == SntpState::Done;
+}
+
+/**
+ * @brief Closes the socket.
+ */
+void SntpClient::stop() {
+    _udp.stop();
+}
+
+SntpState SntpClient::state() const {
+    return _state;
+}
+
+const SntpSample& SntpClient::best() const {
+    return _best;
+}
+
+uint8_t SntpClient::answered() const {
+    return _answered;
+}
+
+/**
+ * @brief Current UTC time from the lowest-delay answer.
+ *
+ * @return Unix time in microseconds (0 if no answer was received).
+ */
+uint64_t SntpClient::unixMicros() const {
+    if (_answered == 0) return 0;
+    return (uint64_t)((int64_t)sntpMicros() + _best.offsetMicros);
+}
+
+/**
+ * @brief Gives read access to the address cache.
+ *
+ * @return Reference to the cache stored in RTC slow memory.
+ */
+const SntpDnsCache& SntpClient::dnsCache() {
+    return rtcSntpDnsCache;
+}
+
+/**
+ * @brief Resolves a server, from the cache when possible.
+ *
+ * @param slot Index of the server.
+ * @return true if an address is available.
+ */
+bool SntpClient::resolve(uint8_t slot) {
+    Server& server = _servers[slot];
+    uint32_t nameHash = crc32Update(server.name, strlen(server.name));
+    uint64_t now = TimeAccounting::rtcMicros();
+
+    server.cached = lookup(rtcSntpDnsCache, slot, nameHash, now, &server.ip);
+    if (server.cached) return true;
+
+    IPAddress address;
+    if (!WiFi.hostByName(server.name, address)) {
+        if (DEBUGMODE)Serial.printf("SNTP: Cannot resolve %s\n", server.name);
+        server.ip = 0;
+        return false;
+    }
+    server.ip = (uint32_t)address;
+    store(rtcSntpDnsCache, slot, nameHash, server.ip, now + NTP_DNS_TTL * 1000000ULL);
+    return server.ip != 0;
+}
+
+/**
+ * @brief Reads every datagram waiting on the socket.
+ */
+void SntpClient::receive() {
+    uint8_t packet[SNTP_PACKET_SIZE];
+    while (_udp.parsePacket() > 0) {
+        uint64_t received = sntpMicros();
+        int length = _udp.read(packet, sizeof(packet));
+        uint32_t from = (uint32_t)_udp.remoteIP();
+
+        for (uint8_t i = 0; i < _count; i++) {
+            Server& server = _servers[i];
+            if (server.answered || server.sentMicros == 0 || server.ip != from) continue;
+
+            SntpSample sample;
+            if (!parseResponse(packet, length > 0 ? (size_t)length : 0, server.transmit,
+                               server.sentMicros, received, &sample)) continue;
+            sample.server = i;
+            server.answered = true;
+            _pending--;
+            if (_answered == 0 || sample.delayMicros < _best.delayMicros) _best = sample;
+            if (_answered++ == 0) _firstAnswerMicros = received;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Drops the cached address of a server.
+ *
+ * @param slot Index of the server.
+ */
+void SntpClient::forget(uint8_t slot) {
+    if (!_servers[slot].cached) return;
+    store(rtcSntpDnsCache, slot, 0, 0, 0);
+    if (DEBUGMODE)Serial.printf("SNTP: No answer from %s, address dropped\n", _servers[slot].name);
+}
+
+/**
+ * @brief Fills a client request (version 4, mode 3).
+ *
+ * @param packet Buffer of `SNTP_PACKET_SIZE` bytes.
+ * @param transmit Transmit timestamp (NTP format), echoed by the server.
+ */
+void SntpClient::buildRequest(uint8_t* packet, uint64_t transmit) {
+    memset(packet, 0, SNTP_PACKET_SIZE);
+    packet[0] = (0 << 6) | (4 << 3) | 3;  // LI = 0, VN = 4, Mode = client
+    writeTimestamp(packet + 40, transmit);
+}
+
+/**
+ * @brief Validates a server answer and computes offset and delay.
+ *
+ * The answer is rejected if it is not a server reply, the server is not
+ * synchronized (leap indicator 3, stratum 0 "kiss-o'-death" or above 15),
+ * its transmit timestamp is empty, or it does not echo our request.
+ *
+ * @param packet Received datagram.
+ * @param length Datagram length.
+ * @param transmit Transmit timestamp of our request.
+ * @param sentMicros Local clock when the request left (T1).
+ * @param receivedMicros Local clock when the answer arrived (T4).
+ * @param sample Receives the measurement.
+ * @return true if the answer is usable.
+ */
+bool SntpClient::parseResponse(const uint8_t* packet, size_t length, uint64_t transmit,
+                               uint64_t sentMicros, uint64_t receivedMicros, SntpSample* sample) {
+    if (length < SNTP_PACKET_SIZE) return false;
+    uint8_t leap = packet[0] >> 6;
+    uint8_t version = (packet[0] >> 3) & 0x07;
+    uint8_t mode = packet[0] & 0x07;
+    uint8_t stratum = packet[1];
+    if (leap == 3 || mode != 4 || version < 3 || version > 4) return false;
+    if (stratum == 0 || stratum > 15) return false;
+    if (readTimestamp(packet + 24) != transmit) return false;  // Originate must echo our request
+
+    uint64_t serverReceive = readTimestamp(packet + 32);
+    uint64_t serverTransmit = readTimestamp(packet + 40);
+    if (serverTransmit == 0 || serverReceive == 0) return false;
+
+    int64_t t1 = (int64_t)sentMicros;
+    int64_t t2 = (int64_t)fromNtp(serverReceive);
+    int64_t t3 = (int64_t)fromNtp(serverTransmit);
+    int64_t t4 = (int64_t)receivedMicros;
+    int64_t delay = (t4 - t1) - (t3 - t2);
+
+    sample->stratum = stratum;
+    sample->offsetMicros = ((t2 - t1) + (t3 - t4)) / 2;
+    sample->delayMicros = delay > 0 ? (uint32_t)delay : 0;
+    return true;
+}
+
+/**
+ * @brief Converts microseconds since the Unix epoch to an NTP timestamp.
+ *
+ * @param unixMicros Unix time in microseconds.
+ * @return 32.32 fixed-point seconds since 1900.
+ */
+uint64_t SntpClient::toNtp(uint64_t unixMicros) {
+    uint64_t seconds = unixMicros / 1000000ULL + SNTP_UNIX_OFFSET;
+    uint64_t fraction = ((unixMicros % 1000000ULL) << 32) / 1000000ULL;
+    return (seconds << 32) | fraction;
+}
+
+/**
+ * @brief Converts an NTP timestamp to microseconds since the Unix epoch.
+ *
+ * Timestamps with the top bit clear are taken from era 1 (after 2036-02-07),
+ * as recommended by RFC 4330.
+ *
+ * @param ntp 32.32 fixed-point seconds since 1900.
+ * @return Unix time in microseconds.
+ */
+uint64_t SntpClient::fromNtp(uint64_t ntp) {
+    uint64_t seconds = ntp >> 32;
+    if (!(seconds & 0x80000000ULL)) seconds += 0x100000000ULL;  // Era 1
+    uint64_t micros = ((ntp & 0xFFFFFFFFULL) * 1000000ULL) >> 32;
+    return (seconds - SNTP_UNIX_OFFSET) * 1000000ULL + micros;
+}
+
+/**
+ * @brief Looks up a cached address.
+ *
+ * @param cache The cache.
+ * @param slot Server slot.
+ * @param nameHash CRC-32 of the host name (a renamed server misses).
+ * @param nowMicros Current RTC timer value.
+ * @param ip Receives the address.
+ * @return true if a fresh entry was found.
+ */
+bool SntpClient::lookup(const SntpDnsCache& cache, uint8_t slot, uint32_t nameHash, uint64_t nowMicros, uint32_t* ip) {
+    if (slot >= NTP_MAX_SERVERS || !validate(cache)) return false;
+    const SntpDnsEntry& entry = cache.entries[slot];
+    if (entry.ip == 0 || entry.nameHash != nameHash || nowMicros >= entry.expiresMicros) return false;
+    *ip = entry.ip;
+    return true;
+}
+
+/**
+ * @brief Stores an address in the cache (ip 0 clears the slot).
+ *
+ * @param cache The cache.
+ * @param slot Server slot.
+ * @param nameHash CRC-32 of the host name.
+ * @param ip Address.
+ * @param expiresMicros RTC timer value after which the entry is stale.
+ */
+void SntpClient::store(SntpDnsCache& cache, uint8_t slot, uint32_t nameHash, uint32_t ip, uint64_t expiresMicros) {
+    if (slot >= NTP_MAX_SERVERS) return;
+    cache.magic = SNTP_DNS_MAGIC;
+    cache.entries[slot].nameHash = nameHash;
+    cache.entries[slot].ip = ip;
+    cache.entries[slot].expiresMicros = expiresMicros;
+    seal(cache);
+}
+
+/**
+ * @brief Validates magic and CRC of the cache.
+ *
+ * @param cache The cache.
+ * @return true if the cache is intact.
+ */
+bool SntpClient::validate(const SntpDnsCache& cache) {
+    return cache.magic == SNTP_DNS_MAGIC &&
+           cache.crc == crc32Update(&cache, offsetof(SntpDnsCache, crc));
+}
+
+/**
+ * @brief Recomputes the CRC of the cache.
+ *
+ * @param cache The cache.
+ */
+void SntpClient::seal(SntpDnsCache& cache) {
+    cache.crc = crc32Update(&cache, offsetof(SntpDnsCache, crc));
+}
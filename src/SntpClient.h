@@ -0,0 +1,132 @@
+#ifndef SNTP_CLIENT_H
+#define SNTP_CLIENT_H
+/**
+ * @file SntpClient.h
+ * @brief Non-blocking SNTP client querying several servers in parallel.
+ *
+ * `begin()` resolves the configured servers and sends one request to each
+ * of them at once; `poll()` collects the answers without blocking. Every
+ * answer yields the clock offset and the round-trip delay from the four
+ * NTP timestamps (RFC 4330):
+ *
+ *   offset = ((T2 - T1) + (T3 - T4)) / 2
+ *   delay  = (T4 - T1) - (T3 - T2)
+ *
+ * and the answer with the lowest delay is kept. The exchange completes when
+ * every server answered, `NTP_SETTLE_MS` after the first valid answer, or
+ * after `NTP_TIMEOUT_MS`, so a sync normally costs a single round trip.
+ *
+ * Resolved addresses are cached in RTC slow memory for `NTP_DNS_TTL`
+ * seconds (CRC protected, keyed by a hash of the host name); an entry is
+ * dropped as soon as its server fails to answer.
+ *
+ * The client talks through `WiFiUDP` and `WiFi.hostByName()`. Host builds
+ * use the simulator's shims, where they are backed by real UDP sockets and a
+ * local stand-in server.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "Config.h"
+
+#define SNTP_PACKET_SIZE 48                  ///< SNTP header without extensions
+#define SNTP_UNIX_OFFSET 2208988800ULL       ///< Seconds from 1900-01-01 to 1970-01-01
+#define SNTP_DNS_MAGIC 0x53444E53UL          ///< "SDNS"
+
+/**
+ * @brief Clock measurement from one server answer.
+ */
+struct SntpSample {
+    uint8_t server;        ///< Index of the answering server
+    uint8_t stratum;       ///< Stratum of the server
+    uint32_t delayMicros;  ///< Round-trip delay without the server processing time
+    int64_t offsetMicros;  ///< Server Unix time minus local clock
+};
+
+/**
+ * @brief Progress of an exchange.
+ */
+enum class SntpState : uint8_t {
+    Idle,     ///< No exchange started
+    Pending,  ///< Waiting for answers
+    Done,     ///< A valid answer was kept
+    Failed    ///< No server answered in time
+};
+
+/**
+ * @brief Cached address of one server.
+ */
+struct SntpDnsEntry {
+    uint32_t nameHash;       ///< CRC-32 of the host name
+    uint32_t ip;             ///< Address (0 = empty)
+    uint64_t expiresMicros;  ///< RTC timer value after which the entry is stale
+};
+
+/**
+ * @brief Address cache (RTC slow memory).
+ */
+struct SntpDnsCache {
+    uint32_t magic;                          ///< SNTP_DNS_MAGIC when valid
+    SntpDnsEntry entries[NTP_MAX_SERVERS];   ///< One slot per configured server
+    uint32_t crc;                            ///< CRC-32 of the preceding fields
+};
+
+class SntpClient {
+public:
+    SntpClient(const char* const* servers, uint8_t count);
+
+    bool begin();  // Resolve the servers and send all requests
+    SntpState poll();  // Collect answers (non-blocking)
+    bool sync(uint32_t timeoutMs = NTP_TIMEOUT_MS);  // begin() and poll() until done
+    void stop();  // Close the socket
+
+    SntpState state() const;
+    const SntpSample& best() const;  // Lowest-delay answer (valid when Done)
+    uint64_t unixMicros() const;  // Current UTC time from the best answer (0 if none)
+    uint8_t answered() const;  // Servers that answered the last exchange
+
+    static const SntpDnsCache& dnsCache();
+
+    // Pure helpers (host testable)
+    static void buildRequest(uint8_t* packet, uint64_t transmit);
+    static bool parseResponse(const uint8_t* packet, size_t length, uint64_t transmit,
+                              uint64_t sentMicros, uint64_t receivedMicros, SntpSample* sample);
+    static uint64_t toNtp(uint64_t unixMicros);
+    static uint64_t fromNtp(uint64_t ntp);
+    static bool lookup(const SntpDnsCache& cache, uint8_t slot, uint32_t nameHash, uint64_t nowMicros, uint32_t* ip);
+    static void store(SntpDnsCache& cache, uint8_t slot, uint32_t nameHash, uint32_t ip, uint64_t expiresMicros);
+    static bool validate(const SntpDnsCache& cache);
+    static void seal(SntpDnsCache& cache);
+
+private:
+    /**
+     * @brief Per-server progress of an exchange.
+     */
+    struct Server {
+        const char* name;
+        uint32_t ip;           ///< Resolved address (0 = unresolved)
+        uint64_t transmit;     ///< Transmit timestamp sent (echoed as originate)
+        uint64_t sentMicros;   ///< Local clock when the request left
+        bool answered;
+        bool cached;           ///< Address came from the cache
+    };
+
+    bool resolve(uint8_t slot);
+    void receive();
+    void forget(uint8_t slot);
+
+    WiFiUDP _udp;
+    Server _servers[NTP_MAX_SERVERS];
+    uint8_t _count;
+    uint8_t _pending;
+    uint8_t _answered;
+    SntpState _state;
+    SntpSample _best;
+    uint64_t _startedMicros;
+    uint64_t _firstAnswerMicros;
+    uint32_t _timeoutMicros;
+};
+
+#endif // SNTP_CLIENT_H
@@ -0,0 +1,182 @@
+#include "TimeAccounting.h"
+#include "Crc32.h"
+#include <stddef.h>
+#include <sys/time.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#include <esp_task_wdt.h>
+#include <esp32/rtc.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR  // Host builds: plain static storage
+#endif
+
+// Anchor preserved across deep sleep (zeroed on power-on)
+RTC_DATA_ATTR static TimeAnchor rtcTimeAnchor;
+
+#ifndef ARDUINO
+static uint64_t hostRtcMicros = 0;  // Virtual RTC timer for host builds
+
+/**
+ * @brief Sets the virtual RTC timer used in host builds.
+ *
+ * @param micros New RTC timer value in microseconds.
+ */
+void TimeAccounting::setHostRtcMicros(uint64_t micros) {
+    hostRtcMicros = micros;
+}
+#endif
+
+/**
+ * @brief Reads the RTC timer, which keeps running during deep sleep.
+ *
+ * @return RTC time in microseconds since power-on.
+ */
+uint64_t TimeAccounting::rtcMicros() {
+#ifdef ARDUINO
+    return esp_rtc_get_time_us();
+#else
+    return hostRtcMicros;
+#endif
+}
+
+/**
+ * @brief Sets the system clock to an authoritative Unix time and re-anchors.
+ *
+ * @param timestamp Unix time in seconds.
+ */
+void TimeAccounting::setUnixTime(uint64_t timestamp) {
+    setUnixMicros(timestamp * 1000000ULL);
+}
+
+/**
+ * @brief Sets the system clock to an authoritative Unix time and re-anchors.
+ *
+ * @param unixMicros Unix time in microseconds (e.g. from SNTP).
+ */
+void TimeAccounting::setUnixMicros(uint64_t unixMicros) {
+    int32_t driftPpb = isAnchored() ? rtcTimeAnchor.driftPpb : 0;  // Keep the current correction
+    rtcTimeAnchor = makeAnchor(unixMicros, rtcMicros(), driftPpb);
+
+    struct timeval tv;
+    tv.tv_sec = unixMicros / 1000000ULL;   // Set seconds since the Unix epoch
+    tv.tv_usec = unixMicros % 1000000ULL;  // Same instant as the anchor
+#ifdef ARDUINO
+    esp_task_wdt_reset();   // Reset the watchdog timer to prevent a system reset
+#endif
+    settimeofday(&tv, nullptr);
+}
+
+/**
+ * @brief Checks whether a valid anchor is available.
+ *
+ * @return true if the anchor can be used to rebuild the wall clock.
+ */
+bool TimeAccounting::isAnchored() {
+    return validate(rtcTimeAnchor);
+}
+
+/**
+ * @brief Current Unix time rebuilt from the anchor.
+ *
+ * @return Unix time in seconds (0 if not anchored).
+ */
+uint64_t TimeAccounting::now() {
+    return nowMicros() / 1000000ULL;
+}
+
+/**
+ * @brief Current Unix time rebuilt from the anchor, in microseconds.
+ *
+ * @return Unix time in microseconds (0 if not anchored).
+ */
+uint64_t TimeAccounting::nowMicros() {
+    if (!isAnchored()) return 0;
+    return reconstruct(rtcTimeAnchor, rtcMicros());
+}
+
+/**
+ * @brief Sets the system clock from the anchor without re-anchoring.
+ *
+ * Used after a deep-sleep wake; the sub-second part is preserved so no
+ * rounding error accumulates from one wake to the next.
+ */
+void TimeAccounting::restore() {
+    if (!isAnchored()) return;
+    uint64_t micros = nowMicros();
+    struct timeval tv;
+    tv.tv_sec = micros / 1000000ULL;
+    tv.tv_usec = micros % 1000000ULL;
+    settimeofday(&tv, nullptr);
+}
+
+/**
+ * @brief Sets the drift correction of the current anchor.
+ *
+ * Meant to be called right after an anchor was taken (NTP sync, cold boot),
+ * since the correction applies to the whole interval since the anchor.
+ *
+ * @param driftPpb Drift of the RTC timer in parts per billion (positive = slow).
+ */
+void TimeAccounting::setDriftPpb(int32_t driftPpb) {
+    if (!isAnchored()) return;
+    rtcTimeAnchor = makeAnchor(rtcTimeAnchor.unixMicros, rtcTimeAnchor.rtcMicros, driftPpb);
+}
+
+/**
+ * @brief Gives read access to the current anchor.
+ *
+ * @return Reference to the anchor stored in RTC slow memory.
+ */
+const TimeAnchor& TimeAccounting::anchor() {
+    return rtcTimeAnchor;
+}
+
+/**
+ * @brief Builds a sealed anchor.
+ *
+ * @param unixMicros Unix time in microseconds.
+ * @param rtcMicros RTC timer reading at the same instant.
+ * @param driftPpb Drift correction in parts per billion.
+ * @return The anchor with its CRC filled in.
+ */
+TimeAnchor TimeAccounting::makeAnchor(uint64_t unixMicros, uint64_t rtcMicros, int32_t driftPpb) {
+    TimeAnchor anchor = {};
+    anchor.magic = TIMEACCOUNT_MAGIC;
+    anchor.driftPpb = driftPpb;
+    anchor.unixMicros = unixMicros;
+    anchor.rtcMicros = rtcMicros;
+    anchor.crc = crc32Update(&anchor, offsetof(TimeAnchor, crc));
+    return anchor;
+}
+
+/**
+ * @brief Validates magic and CRC of an anchor.
+ *
+ * @param anchor The anchor to validate.
+ * @return true if the anchor is intact.
+ */
+bool TimeAccounting::validate(const TimeAnchor& anchor) {
+    return anchor.magic == TIMEACCOUNT_MAGIC &&
+           anchor.crc == crc32Update(&anchor, offsetof(TimeAnchor, crc));
+}
+
+/**
+ * @brief Rebuilds the Unix time from an anchor and an RTC reading.
+ *
+ * The elapsed RTC time is corrected by the anchor's drift. An RTC reading
+ * older than the anchor means the timer was reset; the anchor time is
+ * returned unchanged in that case.
+ *
+ * @param anchor A valid anchor.
+ * @param rtcMicros Current RTC timer reading.
+ * @return Unix time in microseconds.
+ */
+uint64_t TimeAccounting::reconstruct(const TimeAnchor& anchor, uint64_t rtcMicros) {
+    if (rtcMicros < anchor.rtcMicros) return anchor.unixMicros;
+    uint64_t elapsed = rtcMicros - anchor.rtcMicros;
+    int64_t correction = ((int64_t)(elapsed / 1000ULL) * anchor.driftPpb) / 1000000LL;
+    return anchor.unixMicros + elapsed + correction;
+}
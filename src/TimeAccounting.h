@@ -0,0 +1,61 @@
+#ifndef TIME_ACCOUNTING_H
+#define TIME_ACCOUNTING_H
+/**
+ * @file TimeAccounting.h
+ * @brief Monotonic wall-clock reconstruction across deep sleep.
+ *
+ * Every authoritative time set (NTP, web portal, serial, cold-boot restore)
+ * records an anchor: the Unix time in microseconds together with the value
+ * of the RTC timer (`esp_rtc_get_time_us()`) at that instant. The RTC timer
+ * keeps counting through deep sleep, so after any number of sleeps the wall
+ * clock is rebuilt exactly as anchor + elapsed RTC time. Awake time, boot
+ * time and early wakes are all accounted for, instead of adding a nominal
+ * sleep duration on every wake.
+ *
+ * The drift correction estimated by `DriftEstimator` is stored with the
+ * anchor and applied to the elapsed RTC time.
+ *
+ * The anchor lives in RTC slow memory and is CRC protected; a power-on reset
+ * clears both the anchor and the RTC timer. Host builds replace the RTC
+ * timer with a settable virtual clock.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+/**
+ * @brief Anchor pairing a Unix time with an RTC timer reading.
+ */
+struct TimeAnchor {
+    uint32_t magic;          ///< TIMEACCOUNT_MAGIC when valid
+    int32_t driftPpb;        ///< Drift correction applied to elapsed RTC time (parts per billion)
+    uint64_t unixMicros;     ///< Unix time at the anchor (microseconds)
+    uint64_t rtcMicros;      ///< RTC timer at the anchor (microseconds)
+    uint32_t crc;            ///< CRC-32 of the preceding fields
+};
+
+#define TIMEACCOUNT_MAGIC 0x54414E43UL  ///< "TANC"
+
+class TimeAccounting {
+public:
+    static void setUnixTime(uint64_t timestamp);  // Set the clock and re-anchor
+    static void setUnixMicros(uint64_t unixMicros);  // Same, with sub-second precision
+    static bool isAnchored();  // True if a valid anchor exists
+    static uint64_t now();  // Current Unix time (seconds) from the anchor
+    static uint64_t nowMicros();  // Current Unix time (microseconds) from the anchor
+    static void restore();  // Set the system clock from the anchor (no re-anchor)
+    static void setDriftPpb(int32_t driftPpb);  // Set the drift correction of the current anchor
+    static const TimeAnchor& anchor();
+
+    static uint64_t rtcMicros();  // RTC timer reading (virtual clock on the host)
+#ifndef ARDUINO
+    static void setHostRtcMicros(uint64_t micros);  // Drive the virtual RTC timer
+#endif
+
+    // Pure helpers (host testable)
+    static TimeAnchor makeAnchor(uint64_t unixMicros, uint64_t rtcMicros, int32_t driftPpb = 0);
+    static bool validate(const TimeAnchor& anchor);
+    static uint64_t reconstruct(const TimeAnchor& anchor, uint64_t rtcMicros);
+};
+
+#endif // TIME_ACCOUNTING_H
@@ -0,0 +1,197 @@
+#include "TimeJournal.h"
+#include "Crc32.h"
+#include <string.h>
+
+static_assert(sizeof(JournalRecord) == 32, "JournalRecord must stay 32 bytes");
+
+static PartitionFlash* journalFlash = nullptr;  // Open journal partition
+static size_t headSector = 0;                    // Sector receiving appends
+static size_t nextSlot = 0;                      // Next free record in the head sector
+static uint32_t nextSequence = 1;                // Sequence of the next record
+static JournalRecord newest;                     // Newest valid record
+static bool hasNewest = false;                   // A valid record exists
+
+/**
+ * @brief Opens the journal and recovers its head.
+ *
+ * An empty or unformatted partition starts a new journal in sector 0.
+ *
+ * @param flash An open partition.
+ * @return true if the journal is ready for appends.
+ */
+bool TimeJournal::begin(PartitionFlash& flash) {
+    journalFlash = nullptr;
+    hasNewest = false;
+    if (!flash.isOpen() || flash.sectorCount() < 2) return false;
+    journalFlash = &flash;
+
+    bool found;
+    headSector = findHeadSector(found);
+    if (!found) {
+        // Nothing valid yet: start over in an erased sector 0
+        headSector = 0;
+        nextSlot = 0;
+        nextSequence = 1;
+        if (!journalFlash->eraseSector(0)) {
+            journalFlash = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    // Written records form a prefix of the head sector: find its end
+    JournalRecord record;
+    size_t lo = 0, hi = TIME_JOURNAL_RECORDS_PER_SECTOR - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi + 1) / 2;
+        if (readRecord(headSector, mid, record) && !isErased(record)) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    nextSlot = lo + 1;
+
+    // The last written record may be torn: fall back to the previous valid one
+    for (size_t slot = lo + 1; slot-- > 0;) {
+        if (readRecord(headSector, slot, record) && validate(record)) {
+            newest = record;
+            hasNewest = true;
+            break;
+        }
+    }
+    nextSequence = hasNewest ? newest.sequence + 1 : 1;
+    return true;
+}
+
+/**
+ * @brief Checks whether the journal can take appends.
+ */
+bool TimeJournal::isReady() {
+    return journalFlash != nullptr;
+}
+
+/**
+ * @brief Appends a time checkpoint.
+ *
+ * Moving into the next sector erases it first; every other append is a
+ * single 32-byte write into erased flash.
+ *
+ * @param currentTime Current time to checkpoint.
+ * @param lastTimeSaved Last checked time to checkpoint.
+ * @return true if the record was written.
+ */
+bool TimeJournal::append(uint64_t currentTime, uint64_t lastTimeSaved) {
+    if (!isReady()) return false;
+
+    if (nextSlot >= TIME_JOURNAL_RECORDS_PER_SECTOR) {
+        size_t sector = (headSector + 1) % journalFlash->sectorCount();
+        if (!journalFlash->eraseSector(sector)) return false;
+        headSector = sector;
+        nextSlot = 0;
+    }
+
+    JournalRecord record = makeRecord(nextSequence, currentTime, lastTimeSaved);
+    size_t offset = headSector * PARTITION_FLASH_SECTOR + nextSlot * sizeof(JournalRecord);
+    nextSlot++;  // A failed write may have left bits behind: never reuse the slot
+    if (!journalFlash->write(offset, &record, sizeof(record))) return false;
+
+    nextSequence++;
+    newest = record;
+    hasNewest = true;
+    return true;
+}
+
+/**
+ * @brief Returns the newest valid checkpoint.
+ *
+ * @param record Receives the record.
+ * @return true if the journal holds a valid record.
+ */
+bool TimeJournal::latest(JournalRecord& record) {
+    if (!isReady() || !hasNewest) return false;
+    record = newest;
+    return true;
+}
+
+/**
+ * @brief Builds a sealed record.
+ */
+JournalRecord TimeJournal::makeRecord(uint32_t sequence, uint64_t currentTime, uint64_t lastTimeSaved) {
+    JournalRecord record = {};
+    record.sequence = sequence;
+    record.magic = TIME_JOURNAL_MAGIC;
+    record.currentTime = currentTime;
+    record.lastTimeSaved = lastTimeSaved;
+    record.crc = crc32Update(&record, offsetof(JournalRecord, crc));
+    return record;
+}
+
+/**
+ * @brief Validates magic and CRC of a record.
+ */
+bool TimeJournal::validate(const JournalRecord& record) {
+    return record.magic == TIME_JOURNAL_MAGIC &&
+           record.crc == crc32Update(&record, offsetof(JournalRecord, crc));
+}
+
+/**
+ * @brief Checks whether a record slot is still erased (all 0xFF).
+ */
+bool TimeJournal::isErased(const JournalRecord& record) {
+    const uint8_t* bytes = (const uint8_t*)&record;
+    for (size_t i = 0; i < sizeof(record); i++) {
+        if (bytes[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads one record slot.
+ */
+bool TimeJournal::readRecord(size_t sector, size_t slot, JournalRecord& record) {
+    return journalFlash->read(sector * PARTITION_FLASH_SECTOR + slot * sizeof(JournalRecord), &record, sizeof(record));
+}
+
+/**
+ * @brief Finds the sector holding the newest records.
+ *
+ * Sectors are used round robin, so walking the ring from sector 0 the first
+ * records increase up to the head and then drop (older or erased sectors).
+ * With a valid sector 0 the head is the last sector whose first record is
+ * valid and not older than sector 0's, found by binary search. Otherwise
+ * (interrupted erase of sector 0) every sector is scanned.
+ *
+ * @param found Set to false if no sector holds a valid record.
+ * @return Index of the head sector.
+ */
+size_t TimeJournal::findHeadSector(bool& found) {
+    size_t sectors = journalFlash->sectorCount();
+    JournalRecord first, record;
+    found = false;
+
+    if (readRecord(0, 0, first) && validate(first)) {
+        size_t lo = 0, hi = sectors - 1;
+        while (lo < hi) {
+            size_t mid = (lo + hi + 1) / 2;
+            if (readRecord(mid, 0, record) && validate(record) && record.sequence >= first.sequence) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        found = true;
+        return lo;
+    }
+
+    size_t head = 0;
+    uint32_t best = 0;
+    for (size_t sector = 1; sector < sectors; sector++) {
+        if (readRecord(sector, 0, record) && validate(record) && (!found || record.sequence > best)) {
+            best = record.sequence;
+            head = sector;
+            found = true;
+        }
+    }
+    return head;
+}
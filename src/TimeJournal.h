@@ -0,0 +1,62 @@
+#ifndef TIME_JOURNAL_H
+#define TIME_JOURNAL_H
+/**
+ * @file TimeJournal.h
+ * @brief Append-only, wear-levelled time checkpoint journal on a raw partition.
+ *
+ * Time checkpoints are the most frequently written data of the firmware.
+ * Instead of rewriting NVS keys (page churn and garbage collection), they
+ * are appended as fixed 32-byte records to the `journal` partition:
+ * - a record carries a sequence number and a CRC-32; a torn write simply
+ *   fails the CRC and the previous record is used;
+ * - sectors are filled front to back and used round robin, so an append
+ *   is a single write and only one in `TIME_JOURNAL_RECORDS_PER_SECTOR`
+ *   appends erases the next sector;
+ * - at boot the head sector is found by binary search over the first record
+ *   of each sector and the newest record by binary search inside it.
+ *
+ * Every sector is erased once per pass over the ring, so with S sectors the
+ * journal absorbs S * 128 checkpoints per erase cycle of the flash.
+ *
+ * Only the journal logic lives here; flash access goes through
+ * `PartitionFlash`, which has a file-backed emulator for host builds.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Config.h"
+#include "PartitionFlash.h"
+
+#define TIME_JOURNAL_MAGIC 0x544A524EUL  ///< "TJRN"
+#define TIME_JOURNAL_RECORDS_PER_SECTOR (PARTITION_FLASH_SECTOR / sizeof(JournalRecord))
+
+/**
+ * @brief One time checkpoint (32 bytes).
+ */
+struct JournalRecord {
+    uint32_t sequence;        ///< Increases by one per record
+    uint32_t magic;           ///< TIME_JOURNAL_MAGIC
+    uint64_t currentTime;     ///< Checkpointed current time (Unix seconds)
+    uint64_t lastTimeSaved;   ///< Checkpointed last checked time (Unix seconds)
+    uint32_t reserved;        ///< Always 0
+    uint32_t crc;             ///< CRC-32 of the preceding fields
+};
+
+class TimeJournal {
+public:
+    static bool begin(PartitionFlash& flash);  // Recover the head of the journal
+    static bool isReady();
+    static bool append(uint64_t currentTime, uint64_t lastTimeSaved);  // Add a checkpoint
+    static bool latest(JournalRecord& record);  // Newest valid checkpoint
+
+    // Pure helpers (host testable)
+    static JournalRecord makeRecord(uint32_t sequence, uint64_t currentTime, uint64_t lastTimeSaved);
+    static bool validate(const JournalRecord& record);
+    static bool isErased(const JournalRecord& record);
+
+private:
+    static bool readRecord(size_t sector, size_t slot, JournalRecord& record);
+    static size_t findHeadSector(bool& found);
+};
+
+#endif // TIME_JOURNAL_H
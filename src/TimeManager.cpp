@@ -1,56 +1,62 @@
 #include "TimeManager.h"
+#include "DriftEstimator.h"
+#include "TimeAccounting.h"
 
 /**
  * @brief Constructor for the TimeManager class.
  * 
- * Initializes the NTPClient with parameters defined in Config.h.
- * The RTCManager pointer is initialized to handle the internal RTC.
+ * Initializes the SNTP client with the servers defined in Config.h; the
+ * given server is queried first, in parallel with `NTP_SERVER_2` and
+ * `NTP_SERVER_3`. The RTCManager pointer is initialized to handle the
+ * internal RTC.
  * 
- * @param ntpServer The NTP server to use for time synchronization (default: defined in Config.h).
+ * @param ntpServer The primary NTP server (default: defined in Config.h).
  * @param timeOffset The time offset to apply to the NTP time (default: defined in Config.h).
  * @param updateInterval The interval (in milliseconds) between NTP updates (default: defined in Config.h).
  * @param RTC Pointer to an RTCManager object to handle internal RTC operations.
  */
 TimeManager::TimeManager(const char* ntpServer, long timeOffset, unsigned long updateInterval, RTCManager* RTC) 
-    : timeClient(ntpUDP, ntpServer, timeOffset, updateInterval) {
+    : servers{ntpServer, NTP_SERVER_2, NTP_SERVER_3}, timeClient(servers, NTP_MAX_SERVERS) {
     this->timeOffset = timeOffset;
     this->updateInterval = updateInterval;
     this->RTC = RTC;  // Initialize RTCManager pointer
 }
 
 /**
- * @brief Initializes the NTP client and Wi-Fi connection.
+ * @brief Initializes the SNTP client.
  * 
- * This function starts the NTPClient and establishes a Wi-Fi connection
- * to synchronize time with an NTP server.
+ * Nothing needs to be prepared: the socket is opened and the servers are
+ * resolved (or taken from the address cache) when a sync starts.
  */
 void TimeManager::initialize() {
-    // Initialize NTPClient
-    timeClient.begin();
 }
 
 /**
  * @brief Updates the time by fetching the latest time from the NTP server.
  * 
- * This function fetches the current time from the NTP server and updates
- * the internal RTC by setting it to the current time in Unix timestamp format.
- * It also prints the fetched time in a human-readable format.
+ * This function queries all configured servers in parallel, keeps the
+ * lowest-delay answer and updates the internal RTC with it, to the
+ * microsecond. It also prints the fetched time in a human-readable format.
  * 
  * @return True if the time was successfully fetched and updated; false otherwise.
  */
 bool TimeManager::UpdateTimeFromNTP() {
     esp_task_wdt_reset(); // Reset the watchdog timer to prevent a system reset
+    EnergyScope phase(EnergyPhase::Ntp);
     
     Serial.println("Fetching time from NTP server...");
     
-    // Update the time from the NTP server
-    if (!timeClient.update()) {
+    // Update the time from the NTP servers
+    bool synced = timeClient.sync();
+    timeClient.stop();
+    if (!synced) {
         if (DEBUGMODE)Serial.println("Failed to fetch time from NTP server.");
         return false; // Return false if the NTP update fails
     }
     
     // Get the updated Unix time
-    long ntpTime = getUnixTime();
+    uint64_t ntpMicros = timeClient.unixMicros() + (int64_t)timeOffset * 1000000LL;
+    long ntpTime = ntpMicros / 1000000ULL;
     
     // Validate the NTP time (e.g., ensure it's a reasonable value)
     if (ntpTime < 946684800) { // Unix time for 2000-01-01 00:00:00
@@ -76,10 +82,20 @@ bool TimeManager::UpdateTimeFromNTP() {
                   timeInfo->tm_sec);
     if (DEBUGMODE)Serial.println("################################");
 
+    // Feed the drift estimator with the offset of the local clock before correcting it
+    if (DriftEstimator::recordSync(ntpMicros)) {
+        const DriftHistory& drift = DriftEstimator::history();
+        const DriftSample& sample = drift.samples[(drift.head + DRIFT_HISTORY_SIZE - 1) % DRIFT_HISTORY_SIZE];
+        if (DEBUGMODE)Serial.printf("Clock offset: %lld ms over %llu s\n",
+                      (long long)(sample.offsetMicros / 1000), (unsigned long long)(sample.elapsedMicros / 1000000ULL));
+    }
+
     // Update the RTC with the fetched time
     if (DEBUGMODE)Serial.println("Updating RTC with the fetched time...");
-    RTC->setUnixTime(ntpTime);
-    if (DEBUGMODE)Serial.println("RTC successfully updated.");
+    TimeAccounting::setUnixMicros(timeClient.unixMicros() + (int64_t)timeOffset * 1000000LL);  // Keep the sub-second part
+    DriftEstimator::markSynced();  // Anchor the next drift sample and apply the new fit
+    if (DEBUGMODE)Serial.printf("RTC successfully updated (drift %ld ppb, +/- %lu ppb).\n",
+                  (long)DriftEstimator::driftPpb(), (unsigned long)DriftEstimator::uncertaintyPpb());
     
     return true; // Return true if the time was successfully fetched and updated
 }
@@ -94,18 +110,23 @@ bool TimeManager::UpdateTimeFromNTP() {
  * @return The current Unix timestamp.
  */
 unsigned long TimeManager::getUnixTime() {
-    return timeClient.getEpochTime();  // Return Unix timestamp
+    uint64_t micros = timeClient.unixMicros();
+    if (micros == 0) return 0;  // No answer yet
+    return micros / 1000000ULL + timeOffset;  // Return Unix timestamp
 }
 
 /**
  * @brief Retrieves the current formatted time as a string (HH:MM:SS).
  * 
  * This function formats the current time into a string in the format "HH:MM:SS"
- * using the NTPClient library's built-in formatting.
+ * from the last NTP answer.
  * 
  * @return A string representing the formatted time (e.g., "12:34:56").
  */
 String TimeManager::getFormattedTime() {
-    String formattedTime = timeClient.getFormattedTime();  // Get formatted time string
-    return formattedTime;
+    unsigned long epoch = getUnixTime();
+    char formattedTime[9];
+    snprintf(formattedTime, sizeof(formattedTime), "%02lu:%02lu:%02lu",
+             (epoch % 86400UL) / 3600UL, (epoch % 3600UL) / 60UL, epoch % 60UL);  // Get formatted time string
+    return String(formattedTime);
 }
@@ -4,20 +4,21 @@
 
 #include "ConfigManager.h"
 #include "RTCManager.h"
+#include "SntpClient.h"
 
 class TimeManager {
 public:
     TimeManager(const char* ntpServer = NTP_SERVER, long timeOffset = TIMEOFFSET, unsigned long updateInterval = NTP_UPDATE_INTERVAL,RTCManager* RTC = nullptr);
 
-    void initialize();          // Initialize Wi-Fi and NTP client
+    void initialize();          // Initialize the SNTP client
     bool UpdateTimeFromNTP();          // Update time from NTP server
     unsigned long getUnixTime();  // Get current time in Unix timestamp format (seconds since 1970)
     String getFormattedTime();   // Get formatted time as a string (e.g., HH:MM:SS)
 
 private:
 
-    WiFiUDP ntpUDP;
-    NTPClient timeClient;
+    const char* servers[NTP_MAX_SERVERS];
+    SntpClient timeClient;
     long timeOffset;
     unsigned long updateInterval;
     RTCManager* RTC;
@@ -0,0 +1,179 @@
+#include "TimerWheel.h"
+
+#define TIMER_UNLINKED 0xFFFF  // WheelTimer::slot of a timer not in any slot list
+
+/**
+ * @brief Constructs an empty wheel.
+ */
+TimerWheel::TimerWheel() {
+    clear();
+}
+
+/**
+ * @brief Arms a timer.
+ *
+ * @param delayTicks Ticks before the first expiry (0 is treated as 1).
+ * @param callback Function called on expiry.
+ * @param context Passed to the callback.
+ * @param periodTicks Re-arm period in ticks (0 = one-shot).
+ * @return The timer id, or -1 if the pool is exhausted.
+ */
+int TimerWheel::schedule(uint32_t delayTicks, TimerCallback callback, void* context, uint32_t periodTicks) {
+    if (callback == nullptr) return -1;
+    for (int id = 0; id < EVENTLOOP_MAX_TIMERS; id++) {
+        if (_timers[id].callback != nullptr) continue;
+        _timers[id].callback = callback;
+        _timers[id].context = context;
+        _timers[id].period = periodTicks;
+        _armed++;
+        insert(id, delayTicks);
+        return id;
+    }
+    return -1;
+}
+
+/**
+ * @brief Disarms a timer (also one that expired but has not run yet).
+ *
+ * @param id Timer id returned by schedule().
+ * @return true if the timer was armed.
+ */
+bool TimerWheel::cancel(int id) {
+    if (!isArmed(id)) return false;
+    unlink(id);
+    _timers[id].callback = nullptr;
+    _armed--;
+    return true;
+}
+
+/**
+ * @brief Checks whether a timer is armed.
+ *
+ * @param id Timer id returned by schedule().
+ * @return true if the timer will still run.
+ */
+bool TimerWheel::isArmed(int id) const {
+    return id >= 0 && id < EVENTLOOP_MAX_TIMERS && _timers[id].callback != nullptr;
+}
+
+/**
+ * @brief Moves time forward and runs the expired timers.
+ *
+ * The timers of a slot are unlinked first and run afterwards, so callbacks
+ * can arm and cancel timers freely. Periodic timers are re-armed before
+ * their callback runs.
+ *
+ * @param ticks Ticks elapsed since the last call.
+ * @return Number of callbacks run.
+ */
+uint32_t TimerWheel::advance(uint32_t ticks) {
+    uint32_t fired = 0;
+    while (ticks > 0) {
+        if (_armed == 0) {
+            _cursor = (_cursor + ticks) % EVENTLOOP_WHEEL_SLOTS;  // Nothing to visit
+            break;
+        }
+        ticks--;
+        _cursor = (_cursor + 1) % EVENTLOOP_WHEEL_SLOTS;
+
+        // Collect the expired timers of this slot
+        int16_t due[EVENTLOOP_MAX_TIMERS];
+        uint8_t count = 0;
+        int16_t id = _slots[_cursor];
+        while (id >= 0) {
+            int16_t next = _timers[id].next;
+            if (_timers[id].rounds == 0) {
+                unlink(id);
+                due[count++] = id;
+            } else {
+                _timers[id].rounds--;
+            }
+            id = next;
+        }
+
+        for (uint8_t i = 0; i < count; i++) {
+            WheelTimer& timer = _timers[due[i]];
+            if (timer.callback == nullptr) continue;  // Cancelled by an earlier callback
+            TimerCallback callback = timer.callback;
+            void* context = timer.context;
+            if (timer.period != 0) {
+                insert(due[i], timer.period);
+            } else {
+                timer.callback = nullptr;
+                _armed--;
+            }
+            callback(context);
+            fired++;
+        }
+    }
+    return fired;
+}
+
+/**
+ * @brief Ticks before the next expiry, i.e. how long the owner may block.
+ *
+ * @return Ticks to the earliest timer, or TIMER_WHEEL_NONE if none is armed.
+ */
+uint32_t TimerWheel::ticksUntilNext() const {
+    uint32_t best = TIMER_WHEEL_NONE;
+    for (int id = 0; id < EVENTLOOP_MAX_TIMERS; id++) {
+        const WheelTimer& timer = _timers[id];
+        if (timer.callback == nullptr || timer.slot == TIMER_UNLINKED) continue;
+        uint32_t distance = (timer.slot + EVENTLOOP_WHEEL_SLOTS - _cursor) % EVENTLOOP_WHEEL_SLOTS;
+        if (distance == 0) distance = EVENTLOOP_WHEEL_SLOTS;
+        distance += timer.rounds * EVENTLOOP_WHEEL_SLOTS;
+        if (distance < best) best = distance;
+    }
+    return best;
+}
+
+/**
+ * @brief Number of timers currently armed.
+ */
+uint8_t TimerWheel::armed() const {
+    return _armed;
+}
+
+/**
+ * @brief Disarms every timer and rewinds the cursor.
+ */
+void TimerWheel::clear() {
+    for (int id = 0; id < EVENTLOOP_MAX_TIMERS; id++) {
+        _timers[id] = WheelTimer();
+        _timers[id].slot = TIMER_UNLINKED;
+        _timers[id].next = -1;
+    }
+    for (int slot = 0; slot < EVENTLOOP_WHEEL_SLOTS; slot++) _slots[slot] = -1;
+    _cursor = 0;
+    _armed = 0;
+}
+
+/**
+ * @brief Hashes a timer into the slot of its expiry.
+ *
+ * @param id Timer id.
+ * @param delayTicks Ticks from now (0 is treated as 1).
+ */
+void TimerWheel::insert(int id, uint32_t delayTicks) {
+    if (delayTicks == 0) delayTicks = 1;
+    WheelTimer& timer = _timers[id];
+    timer.slot = (_cursor + delayTicks) % EVENTLOOP_WHEEL_SLOTS;
+    timer.rounds = (delayTicks - 1) / EVENTLOOP_WHEEL_SLOTS;
+    timer.next = _slots[timer.slot];
+    _slots[timer.slot] = id;
+}
+
+/**
+ * @brief Removes a timer from its slot list.
+ *
+ * @param id Timer id.
+ */
+void TimerWheel::unlink(int id) {
+    WheelTimer& timer = _timers[id];
+    if (timer.slot == TIMER_UNLINKED) return;
+    int16_t* link = &_slots[timer.slot];
+    while (*link >= 0 && *link != id) link = &_timers[*link].next;
+    if (*link == id) *link = timer.next;
+    timer.slot = TIMER_UNLINKED;
+    timer.next = -1;
+}
@@ -0,0 +1,60 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+/**
+ * @file TimerWheel.h
+ * @brief Hashed timer wheel driving the software timers of the event loop.
+ *
+ * Time is divided in ticks of `EVENTLOOP_TICK_MS`. A timer due in `d` ticks
+ * is hashed into slot `(cursor + d) % slots` with `(d - 1) / slots` full
+ * rotations left, so arming and cancelling are O(1) and a tick only visits
+ * the timers of one slot. Timers come from a fixed pool (no allocation) and
+ * are either one-shot or periodic.
+ *
+ * The wheel does not read any clock: the owner advances it by the ticks
+ * elapsed and asks how long it may block until the next expiry. Callbacks
+ * run from `advance()` in the owner's task and may arm or cancel timers.
+ * The class is pure C++ and compiles unchanged in host builds.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+#define TIMER_WHEEL_NONE 0xFFFFFFFFUL  ///< ticksUntilNext() with no timer armed
+
+typedef void (*TimerCallback)(void* context);
+
+/**
+ * @brief One timer of the pool.
+ */
+struct WheelTimer {
+    TimerCallback callback;  ///< Called on expiry (nullptr = slot free)
+    void* context;           ///< Passed to the callback
+    uint32_t period;         ///< Re-arm period in ticks (0 = one-shot)
+    uint32_t rounds;         ///< Full wheel rotations left before expiry
+    uint16_t slot;           ///< Wheel slot holding the timer
+    int16_t next;            ///< Next timer in the same slot (-1 = last)
+};
+
+class TimerWheel {
+public:
+    TimerWheel();
+
+    int schedule(uint32_t delayTicks, TimerCallback callback, void* context, uint32_t periodTicks = 0);  // Arm, returns the id or -1
+    bool cancel(int id);  // Disarm a timer
+    bool isArmed(int id) const;
+    uint32_t advance(uint32_t ticks);  // Move time forward, returns the callbacks run
+    uint32_t ticksUntilNext() const;  // Ticks before the next expiry
+    uint8_t armed() const;  // Timers currently armed
+    void clear();  // Disarm every timer
+
+private:
+    void insert(int id, uint32_t delayTicks);
+    void unlink(int id);
+
+    WheelTimer _timers[EVENTLOOP_MAX_TIMERS];
+    int16_t _slots[EVENTLOOP_WHEEL_SLOTS];  ///< Head of the timer list of each slot
+    uint16_t _cursor;                       ///< Slot of the current tick
+    uint8_t _armed;
+};
+
+#endif // TIMER_WHEEL_H
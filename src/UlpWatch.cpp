@@ -0,0 +1,225 @@
+#include <Arduino.h>
+#include "UlpWatch.h"
+#include <esp_sleep.h>
+#include <driver/rtc_io.h>
+#include <esp32/ulp.h>
+#include <soc/rtc.h>
+#include <soc/rtc_cntl_reg.h>
+#include <soc/rtc_io_reg.h>
+
+// The deadline is compared modulo 2^32 ticks: keep countdowns well inside half of that at 150 kHz
+static_assert(ULP_COUNTDOWN_MAX_S < 14000, "ULP countdown longer than the RTC tick window");
+
+#define ULP_VAR(var) ((uint8_t)UlpVar::var)  // Word offset of a shared variable from R3
+
+// Labels of the ULP program
+enum : uint32_t {
+    LABEL_RELEASED,
+    LABEL_COUNTDOWN,
+    LABEL_TIME_VALID,
+    LABEL_BORROW,
+    LABEL_HIGH,
+    LABEL_DUE,
+    LABEL_WAKE,
+    LABEL_WAKE_READY,
+    LABEL_DONE
+};
+
+// ULP program, mirrored step by step by ulpWatchStep()
+static const ulp_insn_t ulpProgram[] = {
+    I_MOVI(R3, ULP_DATA_OFFSET),  // R3 = shared variables
+    I_LD(R0, R3, ULP_VAR(Runs)),
+    I_ADDI(R0, R0, 1),
+    I_ST(R0, R3, ULP_VAR(Runs)),
+
+    // Buttons: a watched input low for Debounce runs in a row
+    READ_RTC_REG(RTC_GPIO_IN_REG, RTC_GPIO_IN_NEXT_S, 16),
+    I_ST(R0, R3, ULP_VAR(Levels)),
+    I_LD(R1, R3, ULP_VAR(WatchMask)),
+    I_ANDR(R0, R0, R1),
+    I_SUBR(R0, R1, R0),  // Zero when every watched input reads high
+    M_BXZ(LABEL_RELEASED),
+    I_LD(R0, R3, ULP_VAR(PressCount)),
+    I_ADDI(R0, R0, 1),
+    I_ST(R0, R3, ULP_VAR(PressCount)),
+    I_LD(R1, R3, ULP_VAR(Debounce)),
+    I_SUBR(R0, R0, R1),  // Overflow while PressCount < Debounce
+    M_BXF(LABEL_COUNTDOWN),
+    I_MOVI(R0, (uint16_t)UlpReason::Button),
+    M_BX(LABEL_WAKE),
+    M_LABEL(LABEL_RELEASED),
+    I_MOVI(R0, 0),
+    I_ST(R0, R3, ULP_VAR(PressCount)),
+
+    // Countdown: remaining = deadline - now on the low 32 bits of the RTC timer
+    M_LABEL(LABEL_COUNTDOWN),
+    I_LD(R0, R3, ULP_VAR(Countdown)),
+    M_BL(LABEL_DONE, 1),
+    WRITE_RTC_REG(RTC_CNTL_TIME_UPDATE_REG, RTC_CNTL_TIME_UPDATE_S, 1, 1),  // Latch the RTC timer
+    M_LABEL(LABEL_TIME_VALID),
+    READ_RTC_REG(RTC_CNTL_TIME_UPDATE_REG, RTC_CNTL_TIME_VALID_S, 1),
+    M_BL(LABEL_TIME_VALID, 1),
+    READ_RTC_REG(RTC_CNTL_TIME0_REG, 0, 16),
+    I_MOVR(R1, R0),  // R1 = now, low half
+    READ_RTC_REG(RTC_CNTL_TIME0_REG, 16, 16),
+    I_MOVR(R2, R0),  // R2 = now, high half
+    I_LD(R0, R3, ULP_VAR(DeadlineLo)),
+    I_SUBR(R1, R0, R1),  // R1 = remaining, low half
+    M_BXF(LABEL_BORROW),
+    I_LD(R0, R3, ULP_VAR(DeadlineHi)),
+    M_BX(LABEL_HIGH),
+    M_LABEL(LABEL_BORROW),
+    I_LD(R0, R3, ULP_VAR(DeadlineHi)),
+    I_SUBI(R0, R0, 1),
+    M_LABEL(LABEL_HIGH),
+    I_SUBR(R2, R0, R2),  // R2 = remaining, high half
+    I_MOVR(R0, R2),
+    M_BGE(LABEL_DUE, 0x8000),  // Negative: the deadline has passed
+    I_ORR(R0, R1, R2),
+    M_BXZ(LABEL_DUE),
+    M_BX(LABEL_DONE),
+    M_LABEL(LABEL_DUE),
+    I_MOVI(R0, (uint16_t)UlpReason::Deadline),
+
+    // Wake the main CPU once it is asleep, then stop the ULP timer
+    M_LABEL(LABEL_WAKE),
+    I_ST(R0, R3, ULP_VAR(Reason)),
+    M_LABEL(LABEL_WAKE_READY),
+    READ_RTC_REG(RTC_CNTL_LOW_POWER_ST_REG, RTC_CNTL_RDY_FOR_WAKEUP_S, 1),
+    M_BL(LABEL_WAKE_READY, 1),
+    I_WAKE(),
+    I_END(),
+    M_LABEL(LABEL_DONE),
+    I_HALT()
+};
+
+/**
+ * @brief RTC IO input bit of a button, as seen by the ULP.
+ *
+ * @param pin GPIO number of the (active-low) button.
+ * @return The bit in the 16 low RTC IO inputs, 0 if the ULP cannot read the pin.
+ */
+static uint16_t watchBit(int pin) {
+    if (!rtc_gpio_is_valid_gpio((gpio_num_t)pin)) return 0;
+    int io = rtc_io_number_get((gpio_num_t)pin);
+    return (io >= 0 && io < 16) ? (uint16_t)(1U << io) : 0;
+}
+
+/**
+ * @brief Hands a deep sleep to the ULP, right before entering it.
+ *
+ * The deadline is the RTC timer now plus the sleep, converted with the
+ * current slow clock calibration (same conversion as the wake stub). The
+ * buttons must already be RTC inputs with their pull-ups held.
+ *
+ * @param sleepMicros Sleep length (in microseconds).
+ * @param watchButton Wake on the user button.
+ * @param watchSwitch Wake on the programming switch.
+ * @return true if the ULP runs, false if the sleep is too long for it or loading failed.
+ */
+bool UlpWatch::start(uint64_t sleepMicros, bool watchButton, bool watchSwitch) {
+    if (sleepMicros > ULP_COUNTDOWN_MAX_S * 1000000ULL) return false;
+
+    uint32_t cal = REG_READ(RTC_SLOW_CLK_CAL_REG);
+    uint32_t deadline = (uint32_t)(rtc_time_get() + rtc_time_us_to_slowclk(sleepMicros, cal));
+    UlpShared shared = {};
+    shared.deadlineLo = (uint16_t)deadline;
+    shared.deadlineHi = (uint16_t)(deadline >> 16);
+    shared.countdown = 1;
+    shared.watchMask = (watchButton ? watchBit(SWITCH_PIN) : 0) | (watchSwitch ? watchBit(PROG_SWITCH_PIN) : 0);
+    shared.debounce = ULP_DEBOUNCE_SAMPLES;
+    write(shared);
+
+    size_t size = sizeof(ulpProgram) / sizeof(ulp_insn_t);
+    if (ulp_process_macros_and_load(ULP_PROG_OFFSET, ulpProgram, &size) != ESP_OK) return false;
+    ulp_set_wakeup_period(0, ULP_PERIOD_MS * 1000UL);
+    if (ulp_run(ULP_PROG_OFFSET) != ESP_OK) return false;
+    if (DEBUGMODE)Serial.printf("ULP counts down %lu ms (%u words)\n", (unsigned long)(sleepMicros / 1000ULL), (unsigned)size);
+    return true;
+}
+
+/**
+ * @brief Stops the ULP timer and clears what it watches.
+ *
+ * The wake reason is kept, so it can still be read after the stop.
+ */
+void UlpWatch::stop() {
+    CLEAR_PERI_REG_MASK(RTC_CNTL_STATE0_REG, RTC_CNTL_ULP_CP_SLP_TIMER_EN);
+    UlpShared shared = read();
+    shared.countdown = 0;
+    shared.watchMask = 0;
+    write(shared);
+}
+
+/**
+ * @brief Why the ULP woke the main CPU.
+ *
+ * Only meaningful when the wake cause is ESP_SLEEP_WAKEUP_ULP.
+ */
+UlpReason UlpWatch::reason() {
+    return (UlpReason)read().reason;
+}
+
+/**
+ * @brief Maps a ULP wake to the wake it stands for.
+ *
+ * @return ESP_SLEEP_WAKEUP_TIMER for the deadline, ESP_SLEEP_WAKEUP_EXT0 for
+ *         the user button and ESP_SLEEP_WAKEUP_EXT1 for the programming switch.
+ */
+int UlpWatch::wakeCause() {
+    UlpShared shared = read();
+    if (shared.reason != (uint16_t)UlpReason::Button) return ESP_SLEEP_WAKEUP_TIMER;
+    uint16_t button = watchBit(SWITCH_PIN);
+    return (button != 0 && (shared.levels & button) == 0) ? ESP_SLEEP_WAKEUP_EXT0 : ESP_SLEEP_WAKEUP_EXT1;
+}
+
+/**
+ * @brief Reads the shared variables from RTC slow memory.
+ */
+UlpShared UlpWatch::read() {
+    return unpack(RTC_SLOW_MEM + ULP_DATA_OFFSET);
+}
+
+/**
+ * @brief Writes the shared variables to RTC slow memory.
+ */
+void UlpWatch::write(const UlpShared& shared) {
+    pack(shared, RTC_SLOW_MEM + ULP_DATA_OFFSET);
+}
+
+/**
+ * @brief Decodes the shared variables (low 16 bits of each word).
+ *
+ * @param words ULP_VAR_COUNT words, in UlpVar order.
+ */
+UlpShared UlpWatch::unpack(const uint32_t* words) {
+    UlpShared shared;
+    shared.runs = words[ULP_VAR(Runs)] & 0xFFFF;
+    shared.deadlineLo = words[ULP_VAR(DeadlineLo)] & 0xFFFF;
+    shared.deadlineHi = words[ULP_VAR(DeadlineHi)] & 0xFFFF;
+    shared.countdown = words[ULP_VAR(Countdown)] & 0xFFFF;
+    shared.watchMask = words[ULP_VAR(WatchMask)] & 0xFFFF;
+    shared.debounce = words[ULP_VAR(Debounce)] & 0xFFFF;
+    shared.pressCount = words[ULP_VAR(PressCount)] & 0xFFFF;
+    shared.levels = words[ULP_VAR(Levels)] & 0xFFFF;
+    shared.reason = words[ULP_VAR(Reason)] & 0xFFFF;
+    return shared;
+}
+
+/**
+ * @brief Encodes the shared variables, one per word.
+ *
+ * @param shared Values to store.
+ * @param words ULP_VAR_COUNT words, in UlpVar order.
+ */
+void UlpWatch::pack(const UlpShared& shared, uint32_t* words) {
+    words[ULP_VAR(Runs)] = shared.runs;
+    words[ULP_VAR(DeadlineLo)] = shared.deadlineLo;
+    words[ULP_VAR(DeadlineHi)] = shared.deadlineHi;
+    words[ULP_VAR(Countdown)] = shared.countdown;
+    words[ULP_VAR(WatchMask)] = shared.watchMask;
+    words[ULP_VAR(Debounce)] = shared.debounce;
+    words[ULP_VAR(PressCount)] = shared.pressCount;
+    words[ULP_VAR(Levels)] = shared.levels;
+    words[ULP_VAR(Reason)] = shared.reason;
+}
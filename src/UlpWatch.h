@@ -0,0 +1,119 @@
+#ifndef ULP_WATCH_H
+#define ULP_WATCH_H
+/**
+ * @file UlpWatch.h
+ * @brief ULP coprocessor program that counts down short sleeps and watches the buttons.
+ *
+ * Sleeps of up to `ULP_COUNTDOWN_MAX_S` (the final approach to an alarm,
+ * the rest between alarm indications) are handed to the ULP FSM instead of
+ * the main cores. Every `ULP_PERIOD_MS` the ULP:
+ * - samples the (active-low) buttons through RTC IO and wakes the main CPU
+ *   once one of them reads low for `ULP_DEBOUNCE_SAMPLES` runs in a row, so
+ *   contact bounce and glitches never boot the application;
+ * - latches the RTC timer and wakes the main CPU when its low 32 bits pass
+ *   the deadline (compared modulo 2^32, so a wrap during the countdown is
+ *   harmless).
+ * Otherwise it halts again without touching the main cores. Longer sleeps
+ * keep the RTC timer, the wake stub and the ext0/ext1 wakes, which cost
+ * nothing while waiting.
+ *
+ * The ULP and the application share a few 16-bit variables in RTC slow
+ * memory at `ULP_DATA_OFFSET` (`UlpShared`, typed access through
+ * `UlpWatch::read()`/`write()`). The decision logic of the program is
+ * mirrored by the header-only `ulpWatchStep()`, with the same 16-bit
+ * arithmetic, so host builds can check the program against it run by run.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+/**
+ * @brief Why the ULP woke the main CPU.
+ */
+enum class UlpReason : uint16_t {
+    None,      ///< No wake (yet)
+    Deadline,  ///< Countdown reached
+    Button     ///< A watched button was held low for the debounce time
+};
+
+/**
+ * @brief Shared variables, one per 32-bit word of RTC slow memory (the ULP uses the low 16 bits).
+ */
+enum class UlpVar : uint8_t {
+    Runs,        ///< ULP runs since the program was started (wraps)
+    DeadlineLo,  ///< Low half of the deadline (RTC timer, low 32 bits)
+    DeadlineHi,  ///< High half of the deadline
+    Countdown,   ///< Non-zero while the deadline is watched
+    WatchMask,   ///< RTC IO input bits (0 to 15) of the watched buttons
+    Debounce,    ///< Low samples in a row that make a press
+    PressCount,  ///< Current run of low samples
+    Levels,      ///< RTC IO inputs 0 to 15 at the last run
+    Reason,      ///< UlpReason of the wake
+    Count
+};
+
+#define ULP_VAR_COUNT ((uint8_t)UlpVar::Count)
+
+/**
+ * @brief Typed copy of the shared variables.
+ */
+struct UlpShared {
+    uint16_t runs;
+    uint16_t deadlineLo;
+    uint16_t deadlineHi;
+    uint16_t countdown;
+    uint16_t watchMask;
+    uint16_t debounce;
+    uint16_t pressCount;
+    uint16_t levels;
+    uint16_t reason;
+};
+
+/**
+ * @brief Model of one ULP run (same steps and 16-bit arithmetic as the program).
+ *
+ * @param shared Shared variables, updated like the program does.
+ * @param nowTicks Low 32 bits of the RTC timer at the run.
+ * @param levels RTC IO inputs 0 to 15.
+ * @return The wake reason, UlpReason::None if the ULP halts without waking.
+ */
+inline UlpReason ulpWatchStep(UlpShared& shared, uint32_t nowTicks, uint16_t levels) {
+    shared.runs++;
+    shared.levels = levels;
+    if ((uint16_t)(shared.watchMask - (levels & shared.watchMask)) != 0) {  // A watched button reads low
+        shared.pressCount++;
+        if (shared.pressCount >= shared.debounce) {
+            shared.reason = (uint16_t)UlpReason::Button;
+            return UlpReason::Button;
+        }
+    } else {
+        shared.pressCount = 0;
+    }
+    if (shared.countdown == 0) return UlpReason::None;
+
+    uint16_t remainingLo = shared.deadlineLo - (uint16_t)nowTicks;
+    uint16_t high = shared.deadlineHi;
+    if ((uint16_t)nowTicks > shared.deadlineLo) high--;  // Borrow
+    uint16_t remainingHi = high - (uint16_t)(nowTicks >> 16);
+    if (remainingHi >= 0x8000 || (remainingHi | remainingLo) == 0) {  // Deadline reached or passed
+        shared.reason = (uint16_t)UlpReason::Deadline;
+        return UlpReason::Deadline;
+    }
+    return UlpReason::None;
+}
+
+class UlpWatch {
+public:
+    static bool start(uint64_t sleepMicros, bool watchButton, bool watchSwitch);  // Load and run before deep sleep
+    static void stop();  // Stop the ULP timer, keep the wake reason
+    static UlpReason reason();  // Why the ULP woke us (None if it did not)
+    static int wakeCause();  // ESP-IDF wake cause the ULP wake stands for (timer, ext0 or ext1)
+    static UlpShared read();
+    static void write(const UlpShared& shared);
+
+    // Pure helpers (host testable)
+    static UlpShared unpack(const uint32_t* words);  // From RTC slow memory words
+    static void pack(const UlpShared& shared, uint32_t* words);
+};
+
+#endif // ULP_WATCH_H
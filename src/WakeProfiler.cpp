@@ -0,0 +1,242 @@
+#include "WakeProfiler.h"
+#include "Crc32.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#include <esp_timer.h>
+#else
+#include "TimeAccounting.h"
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR  // Host builds: plain static storage
+#endif
+
+// Ring preserved across deep sleep (zeroed on power-on)
+RTC_DATA_ATTR static WakeProfileRing rtcProfileRing;
+
+static bool profileActive = false;                     // A run is being recorded
+static uint32_t profileOpenMask = 0;                   // Phases started and not stopped
+static uint32_t profileOpenAt[PROFILE_POINT_COUNT];    // Start time of the open phases
+
+#ifndef ARDUINO
+static uint64_t profileEpoch = 0;  // Virtual RTC timer at the start of the run
+#endif
+
+/**
+ * @brief Microseconds since the application started.
+ */
+static uint32_t profileMicros() {
+#ifdef ARDUINO
+    return (uint32_t)esp_timer_get_time();
+#else
+    return (uint32_t)(TimeAccounting::rtcMicros() - profileEpoch);
+#endif
+}
+
+/**
+ * @brief Adds a measured duration to the record of the current run.
+ */
+static void profileAdd(ProfilePoint point, uint32_t micros) {
+    WakeProfile& record = rtcProfileRing.records[rtcProfileRing.head];
+    record.micros[(uint8_t)point] += micros;
+    record.hitMask |= 1UL << (uint8_t)point;
+    WakeProfiler::seal(record);
+}
+
+/**
+ * @brief Opens the record of this application run.
+ *
+ * Called first thing in setup(); the time the application needed to get
+ * there is recorded as the startup phase.
+ */
+void WakeProfiler::begin() {
+#ifndef ARDUINO
+    profileEpoch = TimeAccounting::rtcMicros();
+#endif
+    if (!validate(rtcProfileRing)) reset(rtcProfileRing);
+    open(rtcProfileRing);
+    profileOpenMask = 0;
+    profileActive = true;
+    profileAdd(ProfilePoint::Startup, profileMicros());
+}
+
+/**
+ * @brief Starts timing a phase.
+ *
+ * @param point The phase.
+ */
+void WakeProfiler::start(ProfilePoint point) {
+    if (!profileActive || point >= ProfilePoint::Count) return;
+    profileOpenAt[(uint8_t)point] = profileMicros();
+    profileOpenMask |= 1UL << (uint8_t)point;
+}
+
+/**
+ * @brief Stops timing a phase and accumulates its duration.
+ *
+ * @param point The phase (ignored if it was not started).
+ */
+void WakeProfiler::stop(ProfilePoint point) {
+    if (!profileActive || point >= ProfilePoint::Count) return;
+    uint32_t bit = 1UL << (uint8_t)point;
+    if (!(profileOpenMask & bit)) return;
+    profileOpenMask &= ~bit;
+    profileAdd(point, profileMicros() - profileOpenAt[(uint8_t)point]);
+}
+
+/**
+ * @brief Closes the run right before deep sleep.
+ *
+ * Phases still open (the callers never return from deep sleep) are
+ * stopped now and the whole awake time is recorded.
+ */
+void WakeProfiler::finish() {
+    if (!profileActive) return;
+    for (uint8_t i = 0; i < PROFILE_POINT_COUNT; i++) {
+        if (profileOpenMask & (1UL << i)) stop((ProfilePoint)i);
+    }
+    profileAdd(ProfilePoint::Awake, profileMicros());
+    profileActive = false;
+}
+
+/**
+ * @brief Gives read access to the ring.
+ *
+ * @return Reference to the ring stored in RTC slow memory.
+ */
+const WakeProfileRing& WakeProfiler::ring() {
+    return rtcProfileRing;
+}
+
+/**
+ * @brief Statistics of a phase over the recorded runs.
+ *
+ * @param point The phase.
+ * @return Min/avg/max and histogram (samples = 0 if never measured).
+ */
+ProfileStats WakeProfiler::stats(ProfilePoint point) {
+    return compute(rtcProfileRing, point);
+}
+
+/**
+ * @brief Short name of a phase, for dumps.
+ *
+ * @param point The phase.
+ * @return A static string.
+ */
+const char* WakeProfiler::pointName(ProfilePoint point) {
+    switch (point) {
+        case ProfilePoint::Startup:       return "startup";
+        case ProfilePoint::DeviceInit:    return "device";
+        case ProfilePoint::FastWake:      return "fastwake";
+        case ProfilePoint::ConfigLoad:    return "config";
+        case ProfilePoint::ClockRestore:  return "clock";
+        case ProfilePoint::LedCheck:      return "led";
+        case ProfilePoint::Countdown:     return "countdown";
+        case ProfilePoint::PowerFailSafe: return "powerfail";
+        case ProfilePoint::TimeSync:      return "timesync";
+        case ProfilePoint::WifiConnect:   return "wifi";
+        case ProfilePoint::NtpUpdate:     return "ntp";
+        case ProfilePoint::NormalMode:    return "normal";
+        case ProfilePoint::SleepPrep:     return "sleepprep";
+        case ProfilePoint::Awake:         return "awake";
+        default:                          return "?";
+    }
+}
+
+/**
+ * @brief Starts an empty ring.
+ *
+ * @param ring The ring to reset.
+ */
+void WakeProfiler::reset(WakeProfileRing& ring) {
+    memset(&ring, 0, sizeof(ring));
+    ring.magic = PROFILER_MAGIC;
+    ring.version = PROFILER_VERSION;
+    seal(ring);
+}
+
+/**
+ * @brief Moves to the next record, overwriting the oldest one when full.
+ *
+ * @param ring A valid ring.
+ * @return The cleared record of the new run.
+ */
+WakeProfile& WakeProfiler::open(WakeProfileRing& ring) {
+    if (ring.count > 0) ring.head = (ring.head + 1) % PROFILER_HISTORY_SIZE;
+    if (ring.count < PROFILER_HISTORY_SIZE) ring.count++;
+    ring.wakes++;
+    seal(ring);
+
+    WakeProfile& record = ring.records[ring.head];
+    memset(&record, 0, sizeof(record));
+    record.wake = ring.wakes;
+    seal(record);
+    return record;
+}
+
+/**
+ * @brief Computes the statistics of a phase over a ring.
+ *
+ * Runs whose record fails its CRC are skipped.
+ *
+ * @param ring The ring.
+ * @param point The phase.
+ * @return The statistics.
+ */
+ProfileStats WakeProfiler::compute(const WakeProfileRing& ring, ProfilePoint point) {
+    ProfileStats stats = {};
+    if (!validate(ring) || point >= ProfilePoint::Count) return stats;
+
+    uint64_t sum = 0;
+    uint32_t bit = 1UL << (uint8_t)point;
+    for (uint8_t i = 0; i < ring.count && i < PROFILER_HISTORY_SIZE; i++) {
+        const WakeProfile& record = ring.records[i];
+        if (!validate(record) || !(record.hitMask & bit)) continue;
+        uint32_t micros = record.micros[(uint8_t)point];
+        if (stats.samples == 0 || micros < stats.minMicros) stats.minMicros = micros;
+        if (micros > stats.maxMicros) stats.maxMicros = micros;
+        sum += micros;
+        stats.samples++;
+
+        uint8_t bucket = 0;
+        for (uint32_t limit = 1000; bucket < PROFILER_BUCKETS - 1 && micros >= limit; limit *= 10) bucket++;
+        stats.buckets[bucket]++;
+    }
+    if (stats.samples > 0) stats.avgMicros = (uint32_t)(sum / stats.samples);
+    return stats;
+}
+
+/**
+ * @brief Validates magic, version and CRC of the ring header.
+ */
+bool WakeProfiler::validate(const WakeProfileRing& ring) {
+    return ring.magic == PROFILER_MAGIC &&
+           ring.version == PROFILER_VERSION &&
+           ring.head < PROFILER_HISTORY_SIZE &&
+           ring.crc == crc32Update(&ring, offsetof(WakeProfileRing, crc));
+}
+
+/**
+ * @brief Validates the CRC of a record.
+ */
+bool WakeProfiler::validate(const WakeProfile& record) {
+    return record.crc == crc32Update(&record, offsetof(WakeProfile, crc));
+}
+
+/**
+ * @brief Recomputes and stores the CRC of the ring header.
+ */
+void WakeProfiler::seal(WakeProfileRing& ring) {
+    ring.crc = crc32Update(&ring, offsetof(WakeProfileRing, crc));
+}
+
+/**
+ * @brief Recomputes and stores the CRC of a record.
+ */
+void WakeProfiler::seal(WakeProfile& record) {
+    record.crc = crc32Update(&record, offsetof(WakeProfile, crc));
+}
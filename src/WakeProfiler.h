@@ -0,0 +1,119 @@
+#ifndef WAKE_PROFILER_H
+#define WAKE_PROFILER_H
+/**
+ * @file WakeProfiler.h
+ * @brief Per-phase timing of the last wakes, kept across deep sleep.
+ *
+ * Scoped timers (`ProfileScope`, or `start()`/`stop()` pairs for linear
+ * code) measure each phase of the boot flow with `esp_timer_get_time()`.
+ * The durations of one application run are accumulated into a record of a
+ * ring in RTC slow memory that spans the last `PROFILER_HISTORY_SIZE` wakes.
+ * Deep sleep never returns, so `finish()` closes the phases still open and
+ * the total awake time right before sleeping.
+ *
+ * `stats()` derives min/avg/max and a per-decade histogram of each phase
+ * over the ring; the firmware dumps them on request (serial command, HTTP).
+ *
+ * Host builds time the phases on the virtual RTC timer.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+#define PROFILER_MAGIC 0x50524F46UL  ///< "PROF"
+#define PROFILER_VERSION 1           ///< Layout version of the ring
+#define PROFILER_BUCKETS 6           ///< Histogram decades: <1 ms, <10 ms, <100 ms, <1 s, <10 s, >= 10 s
+
+/**
+ * @brief Measured phases of a wake.
+ */
+enum class ProfilePoint : uint8_t {
+    Startup,        ///< Application start to setup()
+    DeviceInit,     ///< Serial and GPIO setup
+    FastWake,       ///< Fast wake evaluation
+    ConfigLoad,     ///< Preferences open and settings load
+    ClockRestore,   ///< System clock and drift history restore
+    LedCheck,       ///< LED flag check (and blinking)
+    Countdown,      ///< User action countdown
+    PowerFailSafe,  ///< PowerFailSafeMode()
+    TimeSync,       ///< connectAndUpdateTime()
+    WifiConnect,    ///< Wi-Fi association attempts
+    NtpUpdate,      ///< NTP exchange and clock update
+    NormalMode,     ///< NormalMode()
+    SleepPrep,      ///< Sleep scheduling and settings commit
+    Awake,          ///< Whole application run
+    Count
+};
+
+#define PROFILE_POINT_COUNT ((uint8_t)ProfilePoint::Count)
+
+/**
+ * @brief Phase durations of one application run.
+ */
+struct WakeProfile {
+    uint32_t wake;                            ///< Sequence number of the run
+    uint32_t hitMask;                         ///< Bit per ProfilePoint that was measured
+    uint32_t micros[PROFILE_POINT_COUNT];     ///< Accumulated duration per phase
+    uint32_t crc;                             ///< CRC-32 of the preceding fields
+};
+
+/**
+ * @brief Ring of the last runs (RTC slow memory).
+ */
+struct WakeProfileRing {
+    uint32_t magic;                              ///< PROFILER_MAGIC when valid
+    uint16_t version;                            ///< PROFILER_VERSION
+    uint8_t head;                                ///< Record of the current run
+    uint8_t count;                               ///< Valid records
+    uint32_t wakes;                              ///< Runs recorded since power-on
+    uint32_t crc;                                ///< CRC-32 of the preceding header fields
+    WakeProfile records[PROFILER_HISTORY_SIZE];  ///< Records, oldest overwritten first
+};
+
+/**
+ * @brief Statistics of one phase over the ring.
+ */
+struct ProfileStats {
+    uint16_t samples;                   ///< Runs in which the phase was measured
+    uint32_t minMicros;
+    uint32_t avgMicros;
+    uint32_t maxMicros;
+    uint16_t buckets[PROFILER_BUCKETS]; ///< Runs per duration decade
+};
+
+class WakeProfiler {
+public:
+    static void begin();  // Open the record of this run (first thing in setup())
+    static void start(ProfilePoint point);
+    static void stop(ProfilePoint point);
+    static void finish();  // Close open phases and the run (right before deep sleep)
+
+    static const WakeProfileRing& ring();
+    static ProfileStats stats(ProfilePoint point);
+    static const char* pointName(ProfilePoint point);
+
+    // Pure helpers operating on an arbitrary ring (host testable)
+    static void reset(WakeProfileRing& ring);
+    static WakeProfile& open(WakeProfileRing& ring);
+    static ProfileStats compute(const WakeProfileRing& ring, ProfilePoint point);
+    static bool validate(const WakeProfileRing& ring);
+    static bool validate(const WakeProfile& record);
+    static void seal(WakeProfileRing& ring);
+    static void seal(WakeProfile& record);
+};
+
+/**
+ * @brief Times a phase for the lifetime of the object.
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfilePoint point) : _point(point) { WakeProfiler::start(point); }
+    ~ProfileScope() { WakeProfiler::stop(_point); }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfilePoint _point;
+};
+
+#endif // WAKE_PROFILER_H
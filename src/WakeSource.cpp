@@ -0,0 +1,211 @@
+#include <Arduino.h>
+#include "WakeSource.h"
+#include "Crc32.h"
+#include "UlpWatch.h"
+#include <esp_sleep.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR  // Host builds: plain static storage
+#endif
+
+// Statistics preserved across deep sleep (zeroed on power-on)
+RTC_DATA_ATTR static WakeStats rtcWakeStats;
+
+static WakeKind wakeKind = WakeKind::PowerOn;  // Source of this boot
+static bool wakeTimed = false;                 // Latency of this button wake recorded
+
+/**
+ * @brief Gives back valid statistics, starting over if RTC memory was lost.
+ */
+static WakeStats& wakeStats() {
+    if (!WakeSource::validate(rtcWakeStats)) {
+        memset(&rtcWakeStats, 0, sizeof(rtcWakeStats));
+        rtcWakeStats.magic = WAKESOURCE_MAGIC;
+        WakeSource::seal(rtcWakeStats);
+    }
+    return rtcWakeStats;
+}
+
+/**
+ * @brief Classifies and counts the wake of this boot.
+ *
+ * Called once per boot, before the fast-wake path, so timer wakes served
+ * from RTC memory are counted too.
+ *
+ * @param stubWakes Timer wakes the deep-sleep stub absorbed before this boot.
+ */
+void WakeSource::begin(uint32_t stubWakes) {
+    wakeKind = resolve(esp_sleep_get_wakeup_cause());
+    wakeTimed = false;
+    WakeStats& stats = wakeStats();
+    stats.wakes[(uint8_t)wakeKind]++;
+    stats.wakes[(uint8_t)WakeKind::Stub] += stubWakes;
+    seal(stats);
+    if (DEBUGMODE && isButton())Serial.printf("Woken by the %s\n", kindName(wakeKind));
+}
+
+/**
+ * @brief Source of this boot.
+ */
+WakeKind WakeSource::current() {
+    return wakeKind;
+}
+
+/**
+ * @brief Checks whether a button ended the deep sleep.
+ *
+ * @return true for the user button and the programming switch.
+ */
+bool WakeSource::isButton() {
+    return wakeKind == WakeKind::Button || wakeKind == WakeKind::ProgSwitch;
+}
+
+/**
+ * @brief Counts an action.
+ *
+ * The first action of a button wake also records the wake-to-action
+ * latency (millis(), so application time only). Answering or expiring an
+ * alarm ends the run of unanswered indications.
+ *
+ * @param action The action taken.
+ */
+void WakeSource::acted(WakeAction action) {
+    WakeStats& stats = wakeStats();
+    stats.actions[(uint8_t)action]++;
+    if (isButton() && !wakeTimed) {
+        uint32_t latency = millis();
+        stats.latencySamples++;
+        stats.latencySumMs += latency;
+        if (latency > stats.latencyMaxMs) stats.latencyMaxMs = latency;
+        wakeTimed = true;
+    }
+    if (action == WakeAction::Snooze || action == WakeAction::Dismiss || action == WakeAction::Expire) {
+        stats.unanswered = 0;
+    }
+    seal(stats);
+    if (DEBUGMODE)Serial.printf("Wake action: %s\n", actionName(action));
+}
+
+/**
+ * @brief Counts an alarm indication nobody answered.
+ *
+ * @return Unanswered indications in a row, this one included.
+ */
+uint8_t WakeSource::missed() {
+    WakeStats& stats = wakeStats();
+    if (stats.unanswered < UINT8_MAX) stats.unanswered++;
+    seal(stats);
+    return stats.unanswered;
+}
+
+/**
+ * @brief Gives read access to the statistics.
+ */
+const WakeStats& WakeSource::stats() {
+    return wakeStats();
+}
+
+/**
+ * @brief Short name of a wake source, for reports.
+ */
+const char* WakeSource::kindName(WakeKind kind) {
+    switch (kind) {
+        case WakeKind::PowerOn:    return "reset";
+        case WakeKind::Timer:      return "timer";
+        case WakeKind::Stub:       return "stub";
+        case WakeKind::Ulp:        return "ulp";
+        case WakeKind::Button:     return "button";
+        case WakeKind::ProgSwitch: return "prog";
+        case WakeKind::Other:      return "other";
+        default:                   return "?";
+    }
+}
+
+/**
+ * @brief Short name of an action, for reports.
+ */
+const char* WakeSource::actionName(WakeAction action) {
+    switch (action) {
+        case WakeAction::None:       return "none";
+        case WakeAction::Snooze:     return "snooze";
+        case WakeAction::Dismiss:    return "dismiss";
+        case WakeAction::Expire:     return "expire";
+        case WakeAction::Admin:      return "admin";
+        case WakeAction::SerialMode: return "serial";
+        default:                     return "?";
+    }
+}
+
+/**
+ * @brief Maps the wake cause of this boot to a wake source.
+ *
+ * Like classify(), except that a ULP wake caused by a button is reported
+ * as that button, so it gets the same actions as an ext0/ext1 wake.
+ *
+ * @param cause Value returned by esp_sleep_get_wakeup_cause().
+ */
+WakeKind WakeSource::resolve(int cause) {
+    if (cause == ESP_SLEEP_WAKEUP_ULP && UlpWatch::reason() == UlpReason::Button) cause = UlpWatch::wakeCause();
+    return classify(cause);
+}
+
+/**
+ * @brief Maps the ESP-IDF wake cause to a wake source.
+ *
+ * @param cause Value returned by esp_sleep_get_wakeup_cause().
+ * @return The wake source (ext0 is the user button, ext1 the programming switch,
+ *         a ULP wake its countdown).
+ */
+WakeKind WakeSource::classify(int cause) {
+    switch (cause) {
+        case ESP_SLEEP_WAKEUP_UNDEFINED: return WakeKind::PowerOn;
+        case ESP_SLEEP_WAKEUP_TIMER:     return WakeKind::Timer;
+        case ESP_SLEEP_WAKEUP_EXT0:      return WakeKind::Button;
+        case ESP_SLEEP_WAKEUP_EXT1:      return WakeKind::ProgSwitch;
+        case ESP_SLEEP_WAKEUP_ULP:       return WakeKind::Ulp;
+        default:                         return WakeKind::Other;
+    }
+}
+
+/**
+ * @brief Chooses the action of a button wake.
+ *
+ * @param kind Wake source.
+ * @param alarmRinging true while an alarm waits for an answer (LED flag set).
+ * @param holdMs How long the user button was held (capped at longPressMs).
+ * @param longPressMs Hold that makes a long press.
+ * @return The action.
+ */
+WakeAction WakeSource::decide(WakeKind kind, bool alarmRinging, uint32_t holdMs, uint32_t longPressMs) {
+    bool longPress = holdMs >= longPressMs;
+    switch (kind) {
+        case WakeKind::ProgSwitch:
+            return WakeAction::SerialMode;
+        case WakeKind::Button:
+            if (alarmRinging) return longPress ? WakeAction::Dismiss : WakeAction::Snooze;
+            return longPress ? WakeAction::Admin : WakeAction::None;
+        default:
+            return WakeAction::None;
+    }
+}
+
+/**
+ * @brief Validates magic and CRC of the statistics.
+ */
+bool WakeSource::validate(const WakeStats& stats) {
+    return stats.magic == WAKESOURCE_MAGIC &&
+           stats.crc == crc32Update(&stats, offsetof(WakeStats, crc));
+}
+
+/**
+ * @brief Recomputes the CRC of the statistics.
+ */
+void WakeSource::seal(WakeStats& stats) {
+    stats.crc = crc32Update(&stats, offsetof(WakeStats, crc));
+}
@@ -0,0 +1,94 @@
+#ifndef WAKE_SOURCE_H
+#define WAKE_SOURCE_H
+/**
+ * @file WakeSource.h
+ * @brief Button wakes from deep sleep, their actions and wake statistics.
+ *
+ * Besides the timer, deep sleep is left on the buttons: ext0 on the user
+ * button (`SWITCH_PIN`) and ext1 on the programming switch
+ * (`PROG_SWITCH_PIN`), both active low, or the ULP on their behalf during
+ * the sleeps it counts down (see UlpWatch). A button wake skips the user-action
+ * countdown and goes straight to its action, chosen from the wake source,
+ * whether an alarm is ringing and how long the button is held:
+ *
+ * | wake        | alarm ringing              | no alarm                    |
+ * |-------------|----------------------------|-----------------------------|
+ * | user button | short: snooze, long: dismiss | short: none, long: admin  |
+ * | prog switch | serial mode                | serial mode                 |
+ *
+ * Wakes per source, the actions taken and the wake-to-action latency of
+ * button wakes (application time, without ROM and bootloader) are counted
+ * in RTC slow memory, together with the indications in a row that nobody
+ * answered, so an alarm stops ringing after `ALARM_MAX_UNANSWERED` of them.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+#define WAKESOURCE_MAGIC 0x574B5352UL  ///< "WKSR"
+
+/**
+ * @brief What ended the deep sleep (or reset the device).
+ */
+enum class WakeKind : uint8_t {
+    PowerOn,     ///< Power-on or reset
+    Timer,       ///< Deep-sleep timer, application booted
+    Stub,        ///< Deep-sleep timer, absorbed by the wake stub
+    Ulp,         ///< ULP countdown reached
+    Button,      ///< User button (ext0)
+    ProgSwitch,  ///< Programming switch (ext1)
+    Other,       ///< Any other wake source
+    Count
+};
+
+/**
+ * @brief Action taken on a button wake or a ringing alarm.
+ */
+enum class WakeAction : uint8_t {
+    None,        ///< Back to sleep
+    Snooze,      ///< Ring again in ALARM_SNOOZE_SECONDS
+    Dismiss,     ///< Stop the ringing alarm
+    Expire,      ///< Alarm stopped after ALARM_MAX_UNANSWERED indications
+    Admin,       ///< Admin (Wi-Fi portal) mode
+    SerialMode,  ///< Serial programming mode
+    Count
+};
+
+#define WAKE_KIND_COUNT ((uint8_t)WakeKind::Count)
+#define WAKE_ACTION_COUNT ((uint8_t)WakeAction::Count)
+
+/**
+ * @brief Wake statistics (RTC slow memory, cleared on power-on).
+ */
+struct WakeStats {
+    uint32_t magic;                       ///< WAKESOURCE_MAGIC when valid
+    uint32_t wakes[WAKE_KIND_COUNT];      ///< Wakes per source
+    uint32_t actions[WAKE_ACTION_COUNT];  ///< Actions taken
+    uint32_t latencySamples;              ///< Button wakes timed
+    uint32_t latencySumMs;                ///< Sum of the wake-to-action latencies
+    uint32_t latencyMaxMs;                ///< Longest wake-to-action latency
+    uint8_t unanswered;                   ///< Alarm indications in a row without a press
+    uint8_t reserved[3];
+    uint32_t crc;                         ///< CRC-32 of the preceding fields
+};
+
+class WakeSource {
+public:
+    static void begin(uint32_t stubWakes);  // Classify and count this wake (and the absorbed ones)
+    static WakeKind current();
+    static bool isButton();  // Woken by the user button or the programming switch
+    static void acted(WakeAction action);  // Count an action (times button wakes)
+    static uint8_t missed();  // Count an unanswered indication, return the run length
+    static const WakeStats& stats();
+    static const char* kindName(WakeKind kind);
+    static const char* actionName(WakeAction action);
+    static WakeKind resolve(int cause);  // classify(), with ULP button wakes reported as the button
+
+    // Pure helpers (host testable)
+    static WakeKind classify(int cause);  // esp_sleep_wakeup_cause_t to WakeKind
+    static WakeAction decide(WakeKind kind, bool alarmRinging, uint32_t holdMs, uint32_t longPressMs);
+    static bool validate(const WakeStats& stats);
+    static void seal(WakeStats& stats);
+};
+
+#endif // WAKE_SOURCE_H
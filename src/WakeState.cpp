@@ -0,0 +1,142 @@
+#include "WakeState.h"
+#include "Crc32.h"
+#include <stddef.h>
+#include <string.h>
+
+// State block preserved across deep sleep (zeroed on any other reset)
+RTC_DATA_ATTR static WakeStateData rtcWakeState;
+
+/**
+ * @brief Checks whether the RTC state block can be trusted.
+ *
+ * @return true if the block carries the expected magic, version and CRC.
+ */
+bool WakeState::isValid() {
+    return validate(rtcWakeState);
+}
+
+/**
+ * @brief Gives read access to the RTC state block.
+ *
+ * @return Reference to the block stored in RTC slow memory.
+ */
+const WakeStateData& WakeState::data() {
+    return rtcWakeState;
+}
+
+/**
+ * @brief Captures the values needed by the next timer wake.
+ *
+ * Called right before entering deep sleep from the normal flow, once the
+ * NVS copy of these values is known to be up to date.
+ *
+ * @param currentTime Current Unix time.
+ * @param lastTimeSaved Last saved Unix time.
+ * @param alertTimestamp Alarm Unix timestamp.
+ * @param ledFlag LED/alarm flag.
+ */
+void WakeState::capture(uint64_t currentTime, uint64_t lastTimeSaved, uint64_t alertTimestamp, bool ledFlag) {
+    WakeStateData state = {};
+    state.magic = WAKESTATE_MAGIC;
+    state.version = WAKESTATE_VERSION;
+    state.flags = ledFlag ? WAKESTATE_FLAG_LED : 0;
+    state.currentTime = currentTime;
+    state.lastTimeSaved = lastTimeSaved;
+    state.alertTimestamp = alertTimestamp;
+    if (validate(rtcWakeState)) {
+        // Keep the counters running across captures
+        state.wakeCount = rtcWakeState.wakeCount;
+        state.fastWakeCount = rtcWakeState.fastWakeCount;
+    }
+    seal(state);
+    rtcWakeState = state;
+}
+
+/**
+ * @brief Invalidates the RTC state block.
+ *
+ * Any path that may change the mirrored values outside of the fast path
+ * (admin mode, serial programming, alarm handling) calls this so the next
+ * wake reloads everything from NVS.
+ */
+void WakeState::invalidate() {
+    memset(&rtcWakeState, 0, sizeof(rtcWakeState));
+}
+
+/**
+ * @brief Evaluates a timer wake against the RTC state block.
+ *
+ * @param now Current Unix time.
+ * @param wakes Number of timer wakes this covers (including those absorbed by the wake stub).
+ * @return The action the caller should take.
+ */
+FastWakeAction WakeState::onTimerWake(uint64_t now, uint32_t wakes) {
+    return evaluate(rtcWakeState, now, wakes, WAKESTATE_CHECKPOINT_WAKES);
+}
+
+/**
+ * @brief Validates magic, version and CRC of a state block.
+ *
+ * @param state The block to validate.
+ * @return true if the block is intact.
+ */
+bool WakeState::validate(const WakeStateData& state) {
+    return state.magic == WAKESTATE_MAGIC &&
+           state.version == WAKESTATE_VERSION &&
+           state.crc == checksum(state);
+}
+
+/**
+ * @brief Computes the CRC-32 of a state block, excluding the CRC field.
+ *
+ * @param state The block to checksum.
+ * @return The CRC-32 value.
+ */
+uint32_t WakeState::checksum(const WakeStateData& state) {
+    return crc32Update(&state, offsetof(WakeStateData, crc));
+}
+
+/**
+ * @brief Recomputes and stores the CRC of a state block.
+ *
+ * @param state The block to seal.
+ */
+void WakeState::seal(WakeStateData& state) {
+    state.crc = checksum(state);
+}
+
+/**
+ * @brief Pure decision logic of the fast wake path.
+ *
+ * When the alarm is not due the block is advanced to the current time and
+ * resealed. When a full boot is required the block is left untouched.
+ *
+ * @param state The state block to evaluate and update.
+ * @param now Current Unix time.
+ * @param wakes Number of timer wakes this covers.
+ * @param checkpointWakes Number of fast wakes between NVS time checkpoints (0 = never).
+ * @return The action the caller should take.
+ */
+FastWakeAction WakeState::evaluate(WakeStateData& state, uint64_t now, uint32_t wakes, uint32_t checkpointWakes) {
+    if (!validate(state) || (state.flags & WAKESTATE_FLAG_LED)) {
+        return FastWakeAction::FullBoot;
+    }
+
+    if (now >= state.alertTimestamp) {
+        return FastWakeAction::FullBoot;  // Alarm due: NormalMode() handles it
+    }
+
+    state.currentTime = now;
+    state.lastTimeSaved = now;
+    state.wakeCount += wakes;
+    state.fastWakeCount += wakes;
+    state.wakesSinceCheckpoint += wakes;
+
+    FastWakeAction action = FastWakeAction::Sleep;
+    if (checkpointWakes != 0 && state.wakesSinceCheckpoint >= checkpointWakes) {
+        state.wakesSinceCheckpoint = 0;
+        action = FastWakeAction::Checkpoint;
+    }
+    seal(state);
+    return action;
+}
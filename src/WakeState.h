@@ -0,0 +1,76 @@
+#ifndef WAKE_STATE_H
+#define WAKE_STATE_H
+/**
+ * @file WakeState.h
+ * @brief Fast-wake state cache kept in RTC slow memory.
+ *
+ * The `WakeState` block mirrors the few configuration values a timer wake
+ * needs (current time, last saved time, alarm timestamp and LED flag) in
+ * RTC slow memory, which survives deep sleep. As long as the block is valid
+ * a timer wake can be serviced without opening the NVS partition at all;
+ * NVS is only touched on cold boot, when a value changes, or for a periodic
+ * time checkpoint.
+ *
+ * The block is versioned and CRC protected. Anything that is not a clean
+ * deep-sleep wake (power-on, brown-out, firmware update) leaves the block
+ * zeroed or stale, fails validation and forces a regular boot from NVS.
+ *
+ * This header and its implementation only depend on the C standard library
+ * so the fast path can be compiled and exercised in host builds.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR  // Host builds: plain static storage
+#endif
+
+#define WAKESTATE_MAGIC 0x57414B45UL  ///< "WAKE"
+#define WAKESTATE_FLAG_LED 0x0001     ///< LED/alarm flag is set
+
+/**
+ * @brief Layout of the state block stored in RTC slow memory.
+ */
+struct WakeStateData {
+    uint32_t magic;                 ///< Must be WAKESTATE_MAGIC
+    uint16_t version;               ///< Layout version (WAKESTATE_VERSION)
+    uint16_t flags;                 ///< WAKESTATE_FLAG_* bits
+    uint64_t currentTime;           ///< Mirror of CURRENT_TIME_SAVED
+    uint64_t lastTimeSaved;         ///< Mirror of LAST_TIME_SAVED
+    uint64_t alertTimestamp;        ///< Mirror of ALERT_TIMESTAMP_SAVED
+    uint32_t wakeCount;             ///< Timer wakes since the block was captured
+    uint32_t fastWakeCount;         ///< Timer wakes served without NVS
+    uint32_t wakesSinceCheckpoint;  ///< Fast wakes since the last time checkpoint
+    uint32_t crc;                   ///< CRC-32 of all preceding fields
+};
+
+/**
+ * @brief Outcome of a timer wake evaluated against the cached state.
+ */
+enum class FastWakeAction : uint8_t {
+    Sleep,       ///< Alarm not due: go straight back to sleep
+    Checkpoint,  ///< Alarm not due, but persist the time to NVS first
+    FullBoot     ///< Alarm due, LED flag set or cache unusable: run the full boot
+};
+
+class WakeState {
+public:
+    static bool isValid();  // Check the RTC block
+    static const WakeStateData& data();  // Access the RTC block
+    static void capture(uint64_t currentTime, uint64_t lastTimeSaved, uint64_t alertTimestamp, bool ledFlag);
+    static void invalidate();  // Force the next wake through the full boot
+    static FastWakeAction onTimerWake(uint64_t now, uint32_t wakes = 1);  // Advance and decide
+
+    // Pure helpers operating on an arbitrary block (host testable)
+    static bool validate(const WakeStateData& state);
+    static uint32_t checksum(const WakeStateData& state);
+    static void seal(WakeStateData& state);
+    static FastWakeAction evaluate(WakeStateData& state, uint64_t now, uint32_t wakes, uint32_t checkpointWakes);
+};
+
+#endif // WAKE_STATE_H
@@ -0,0 +1,158 @@
+#include "WakeStub.h"
+#include "TimeAccounting.h"
+
+#ifdef ARDUINO
+#include <esp_sleep.h>
+#include <driver/rtc_io.h>
+#include <soc/rtc.h>
+#include <soc/rtc_cntl_reg.h>
+#include <soc/rtc_io_reg.h>
+#include <esp32/rom/rtc.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR  // Host builds: plain static storage
+#endif
+
+// State shared with the stub, preserved across deep sleep
+RTC_DATA_ATTR static WakeStubState rtcStubState;
+
+#ifdef ARDUINO
+/**
+ * @brief Reads the 48-bit RTC timer from the stub.
+ *
+ * Mirrors `rtc_time_get()`, which lives in flash and cannot be called before
+ * the application has been loaded.
+ */
+static WAKESTUB_INLINE uint64_t stubReadRtcTicks() {
+    SET_PERI_REG_MASK(RTC_CNTL_TIME_UPDATE_REG, RTC_CNTL_TIME_UPDATE);
+    while (GET_PERI_REG_MASK(RTC_CNTL_TIME_UPDATE_REG, RTC_CNTL_TIME_VALID) == 0) {
+    }
+    SET_PERI_REG_MASK(RTC_CNTL_INT_CLR_REG, RTC_CNTL_TIME_VALID_INT_CLR);
+    uint64_t ticks = READ_PERI_REG(RTC_CNTL_TIME0_REG);
+    ticks |= ((uint64_t)READ_PERI_REG(RTC_CNTL_TIME1_REG)) << 32;
+    return ticks;
+}
+
+/**
+ * @brief Deep-sleep wake stub, executed from RTC fast memory by the ROM.
+ *
+ * Only register accesses and RTC memory are available here: no flash code,
+ * no ROM printf, no heap.
+ */
+static void RTC_IRAM_ATTR wakeStub() {
+    uint64_t now = stubReadRtcTicks();
+    uint32_t levels = REG_GET_FIELD(RTC_GPIO_IN_REG, RTC_GPIO_IN_NEXT);
+    uint32_t cause = REG_GET_FIELD(RTC_CNTL_WAKEUP_STATE_REG, RTC_CNTL_WAKEUP_CAUSE);
+    bool pressed = (levels & rtcStubState.buttonMask) != rtcStubState.buttonMask ||  // Active low
+                   (cause & (RTC_EXT0_TRIG_EN | RTC_EXT1_TRIG_EN)) != 0;  // Button wake, the tap may be over already
+    bool ulp = (cause & RTC_ULP_TRIG_EN) != 0;  // The ULP only wakes us when there is something to do
+
+    if (!ulp && wakeStubDecide(rtcStubState, now, pressed) == WakeStubDecision::SleepAgain) {
+        rtcStubState.tickCount++;
+
+        // Program the next timer wake
+        uint64_t target = now + rtcStubState.sleepTicks;
+        WRITE_PERI_REG(RTC_CNTL_SLP_TIMER0_REG, (uint32_t)target);
+        WRITE_PERI_REG(RTC_CNTL_SLP_TIMER1_REG, (uint32_t)(target >> 32) & RTC_CNTL_SLP_VAL_HI_V);
+        SET_PERI_REG_MASK(RTC_CNTL_SLP_TIMER1_REG, RTC_CNTL_MAIN_TIMER_ALARM_EN);
+
+        // Come back here on the next wake and re-enter deep sleep
+        REG_WRITE(RTC_ENTRY_ADDR_REG, (uint32_t)&wakeStub);
+        CLEAR_PERI_REG_MASK(RTC_CNTL_STATE0_REG, RTC_CNTL_SLEEP_EN);
+        SET_PERI_REG_MASK(RTC_CNTL_STATE0_REG, RTC_CNTL_SLEEP_EN);
+        while (true) {
+        }
+    }
+
+    esp_default_wake_deep_sleep();  // Continue with the regular boot
+}
+
+/**
+ * @brief Configures a button pin as an RTC input readable from the stub.
+ *
+ * @param pin GPIO number of the (active-low) button.
+ * @return The RTC IO input bit of the pin, or 0 if the pin is not an RTC IO.
+ */
+static uint32_t stubWatchButton(gpio_num_t pin) {
+    if (!rtc_gpio_is_valid_gpio(pin)) return 0;
+    rtc_gpio_init(pin);
+    rtc_gpio_set_direction(pin, RTC_GPIO_MODE_INPUT_ONLY);
+    rtc_gpio_pulldown_dis(pin);
+    rtc_gpio_pullup_en(pin);
+    return 1UL << rtc_io_number_get(pin);
+}
+#endif
+
+/**
+ * @brief Arms the wake stub right before entering deep sleep.
+ *
+ * Converts the alarm distance and the sleep duration to RTC slow clock
+ * ticks using the current calibration, configures the buttons as RTC inputs
+ * and installs the stub.
+ *
+ * @param secondsToAlarm Seconds left until the alarm is due.
+ * @param sleepDuration Duration of one sleep period (in milliseconds).
+ */
+void WakeStub::arm(uint64_t secondsToAlarm, unsigned long sleepDuration) {
+    WakeStubState state = {};
+    state.maxSkippedWakes = WAKESTUB_MAX_SKIPPED_WAKES;
+#ifdef ARDUINO
+    uint32_t cal = REG_READ(RTC_SLOW_CLK_CAL_REG);
+    uint64_t now = rtc_time_get();
+    state.deadlineTicks = now + rtc_time_us_to_slowclk(secondsToAlarm * 1000000ULL, cal);
+    state.sleepTicks = rtc_time_us_to_slowclk((uint64_t)sleepDuration * 1000ULL, cal);
+    state.buttonMask = stubWatchButton((gpio_num_t)SWITCH_PIN) | stubWatchButton((gpio_num_t)PROG_SWITCH_PIN);
+    state.armed = WAKESTUB_ARMED;
+    rtcStubState = state;
+    esp_set_deep_sleep_wake_stub(&wakeStub);
+#else
+    uint64_t now = TimeAccounting::rtcMicros();  // Host builds count in microseconds
+    state.deadlineTicks = now + secondsToAlarm * 1000000ULL;
+    state.sleepTicks = (uint64_t)sleepDuration * 1000ULL;
+    state.armed = WAKESTUB_ARMED;
+    rtcStubState = state;
+#endif
+}
+
+#ifndef ARDUINO
+/**
+ * @brief Runs the stub on a timer wake in host builds.
+ *
+ * Applies the same decision as the RTC-resident stub to the virtual RTC
+ * timer, so the simulator can skip application boots exactly like the
+ * device does.
+ *
+ * @param buttonPressed true if a watched button reads as pressed.
+ * @return true if the stub re-sleeps for `sleepTicks`, false if the app boots.
+ */
+bool WakeStub::runOnHost(bool buttonPressed) {
+    if (wakeStubDecide(rtcStubState, TimeAccounting::rtcMicros(), buttonPressed) != WakeStubDecision::SleepAgain) return false;
+    rtcStubState.tickCount++;
+    return true;
+}
+#endif
+
+/**
+ * @brief Disarms the stub and reports how many wakes it absorbed.
+ *
+ * Called once per application boot. Each absorbed wake stands for one
+ * `sleepDuration` the application did not see.
+ *
+ * @return Number of wakes the stub re-slept through since it was armed.
+ */
+uint32_t WakeStub::takeSkippedWakes() {
+    uint32_t skipped = (rtcStubState.armed == WAKESTUB_ARMED) ? rtcStubState.tickCount : 0;
+    rtcStubState.armed = 0;
+    rtcStubState.tickCount = 0;
+    return skipped;
+}
+
+/**
+ * @brief Gives read access to the shared stub state.
+ *
+ * @return Reference to the state stored in RTC slow memory.
+ */
+const WakeStubState& WakeStub::state() {
+    return rtcStubState;
+}
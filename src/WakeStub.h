@@ -0,0 +1,79 @@
+#ifndef WAKE_STUB_H
+#define WAKE_STUB_H
+/**
+ * @file WakeStub.h
+ * @brief Deep-sleep wake stub that re-enters sleep while the alarm is not due.
+ *
+ * When armed, a small stub running from RTC fast memory is executed by the
+ * ROM right after every deep-sleep wake, before the bootloader loads the
+ * application. It compares the RTC timer against the alarm deadline kept in
+ * RTC slow memory and, if nothing needs to be done, programs the next timer
+ * wake and goes back to sleep immediately. The application only boots when
+ * another full sleep period would overshoot the alarm (the application then
+ * schedules the final approach), a button is held or woke the device, the
+ * ULP woke it (see UlpWatch), or
+ * `WAKESTUB_MAX_SKIPPED_WAKES` wakes have been skipped (NVS checkpoint).
+ *
+ * The decision logic is the header-only `wakeStubDecide()` so it can be
+ * inlined into the RTC-resident stub and compiled unchanged on the host.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#define WAKESTUB_INLINE __attribute__((always_inline)) inline
+#else
+#define WAKESTUB_INLINE inline
+#endif
+
+#define WAKESTUB_ARMED 0x53545542UL  ///< "STUB"
+
+/**
+ * @brief State shared between the application and the wake stub (RTC slow memory).
+ */
+struct WakeStubState {
+    uint32_t armed;            ///< WAKESTUB_ARMED while the stub may re-sleep
+    uint32_t buttonMask;       ///< RTC IO input bits of the (active-low) buttons
+    uint64_t deadlineTicks;    ///< RTC timer value at which the alarm is due
+    uint64_t sleepTicks;       ///< Length of one re-sleep in RTC slow clock ticks
+    uint32_t tickCount;        ///< Wakes handled by the stub since it was armed
+    uint32_t maxSkippedWakes;  ///< Wakes the stub may absorb before booting the app
+};
+
+/**
+ * @brief Decision taken by the wake stub.
+ */
+enum class WakeStubDecision : uint8_t {
+    SleepAgain,  ///< Nothing to do: program the timer and re-enter deep sleep
+    BootApp      ///< Continue into the bootloader and the full application
+};
+
+/**
+ * @brief Pure decision function of the wake stub.
+ *
+ * @param state Shared stub state.
+ * @param nowTicks Current RTC timer value.
+ * @param buttonPressed true if any watched button reads as pressed.
+ * @return Whether the stub should re-sleep or boot the application.
+ */
+WAKESTUB_INLINE WakeStubDecision wakeStubDecide(const WakeStubState& state, uint64_t nowTicks, bool buttonPressed) {
+    if (state.armed != WAKESTUB_ARMED) return WakeStubDecision::BootApp;
+    if (buttonPressed) return WakeStubDecision::BootApp;
+    if (state.tickCount >= state.maxSkippedWakes) return WakeStubDecision::BootApp;
+    if (nowTicks + state.sleepTicks > state.deadlineTicks) return WakeStubDecision::BootApp;  // Let the app land on the alarm
+    return WakeStubDecision::SleepAgain;
+}
+
+class WakeStub {
+public:
+    static void arm(uint64_t secondsToAlarm, unsigned long sleepDuration);  // Arm before deep sleep
+    static uint32_t takeSkippedWakes();  // Disarm and return the number of absorbed wakes
+    static const WakeStubState& state();
+#ifndef ARDUINO
+    static bool runOnHost(bool buttonPressed);  // Emulate the stub on the virtual RTC timer
+#endif
+};
+
+#endif // WAKE_STUB_H
@@ -4,6 +4,26 @@
 #include "ConfigManager.h"
 #include "RTCManager.h"
 #include "Device.h"
+#include "WifiLease.h"
+#include "EventLoop.h"
+#include "PatternEngine.h"
+#include "PortalMessages.h"
+
+struct WebAsset;
+
+/**
+ * @brief Hot-path counters of a portal endpoint.
+ */
+struct PortalCounters {
+    uint32_t requests;      ///< Requests answered
+    uint32_t rebuilds;      ///< Replies rendered again (cache misses)
+    uint32_t alarmReloads;  ///< Alarm part reloaded after a settings change
+    uint32_t lastMicros;    ///< Handler time of the last request
+    uint32_t maxMicros;     ///< Longest handler time
+    uint64_t totalMicros;   ///< Handler time of all requests
+    int32_t lastHeapBytes;  ///< Heap held by the last response when the handler returned
+    int32_t maxHeapBytes;   ///< Largest of those
+};
 
 
 
@@ -20,16 +40,23 @@ public:
     char Message[100];
     bool isStillConnected();
     void connectToWiFi();
+    void disconnect();  // Station and radio off
+    const PortalCounters& getSettingsCounters() const;  // /getSettings latency and heap use
 
 private:
     
     void startAccessPoint();
+    bool connectStation(const String& ssid, const String& password, WifiConnectMode mode);
     void handleRoot(AsyncWebServerRequest* request);
     void handleSettings(AsyncWebServerRequest* request);
     void handleSetWiFi(AsyncWebServerRequest* request);
     void handleSaveWiFi(AsyncWebServerRequest* request);
     void handleRestart(AsyncWebServerRequest* request) ;
     void handleReset(AsyncWebServerRequest* request) ;
+    void sendAsset(AsyncWebServerRequest* request, const WebAsset& asset);  // Embedded page, 304 on ETag match
+    void sendReport(AsyncWebServerRequest* request, const JsonWriter& json);  // JSON report, 500 if it was cut off
+    void handleGetSettings(AsyncWebServerRequest* request);
+    bool refreshSettings();  // Render the /getSettings reply again if the alarm or the minute changed
     
 
     ConfigManager* configManager;
@@ -40,6 +67,14 @@ private:
     String apSSID;
     String apPassword;
     WiFiUDP ntpUDP;
+
+    // Cached /getSettings reply
+    SettingsReply settingsReply;
+    char settingsBody[128];
+    size_t settingsLength;
+    uint32_t settingsRevision;  // Settings revision the alarm part was read at
+    int64_t settingsMinute;     // Unix minute of the clock part (-1 = none yet)
+    PortalCounters settingsCounters;
 };
 
 
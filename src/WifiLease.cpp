@@ -0,0 +1,198 @@
+#include <Arduino.h>
+#include "WifiLease.h"
+#include "TimeAccounting.h"
+#include "Crc32.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR  // Host builds: plain static storage
+#endif
+
+// Connection cache and attempt log preserved across deep sleep (zeroed on power-on)
+RTC_DATA_ATTR static WifiLeaseRecord rtcWifiLease;
+RTC_DATA_ATTR static WifiAttemptLog rtcWifiLog;
+
+/**
+ * @brief Chooses how to connect with the given credentials.
+ *
+ * @param ssid Network name.
+ * @param password Network password.
+ * @return The fastest mode the cache allows.
+ */
+WifiConnectMode WifiLease::plan(const char* ssid, const char* password) {
+    return choose(rtcWifiLease, hashCredentials(ssid, password), TimeAccounting::rtcMicros(),
+                  WIFI_LEASE_TTL * 1000000ULL);
+}
+
+/**
+ * @brief Stores the parameters of a successful connection.
+ *
+ * @param ssid Network name.
+ * @param password Network password.
+ * @param bssid Access point (6 bytes).
+ * @param channel Primary channel.
+ * @param ip Station address.
+ * @param gateway Gateway address.
+ * @param subnet Subnet mask.
+ * @param dns1 Primary DNS server.
+ * @param dns2 Secondary DNS server.
+ * @param dhcp true if the address was just obtained by DHCP (restarts the lease age).
+ */
+void WifiLease::remember(const char* ssid, const char* password, const uint8_t* bssid, uint8_t channel,
+                         uint32_t ip, uint32_t gateway, uint32_t subnet, uint32_t dns1, uint32_t dns2, bool dhcp) {
+    uint64_t leasedMicros = (!dhcp && validate(rtcWifiLease)) ? rtcWifiLease.leasedMicros : TimeAccounting::rtcMicros();
+
+    WifiLeaseRecord lease = {};
+    lease.magic = WIFI_LEASE_MAGIC;
+    lease.credentialHash = hashCredentials(ssid, password);
+    memcpy(lease.bssid, bssid, sizeof(lease.bssid));
+    lease.channel = channel;
+    lease.ip = ip;
+    lease.gateway = gateway;
+    lease.subnet = subnet;
+    lease.dns1 = dns1;
+    lease.dns2 = dns2;
+    lease.leasedMicros = leasedMicros;
+    seal(lease);
+    rtcWifiLease = lease;
+}
+
+/**
+ * @brief Drops the cached connection; the next attempt scans.
+ */
+void WifiLease::forget() {
+    memset(&rtcWifiLease, 0, sizeof(rtcWifiLease));
+}
+
+/**
+ * @brief Logs a connection attempt.
+ *
+ * @param mode How the attempt was made.
+ * @param connected Outcome.
+ * @param millis Time spent.
+ */
+void WifiLease::recordAttempt(WifiConnectMode mode, bool connected, uint32_t millis) {
+    if (!validate(rtcWifiLog)) {
+        memset(&rtcWifiLog, 0, sizeof(rtcWifiLog));
+        rtcWifiLog.magic = WIFI_LOG_MAGIC;
+    }
+    append(rtcWifiLog, mode, connected, millis);
+    if (DEBUGMODE)Serial.printf("WiFiManager: %s connect %s in %lu ms\n", modeName(mode),
+                                connected ? "succeeded" : "failed", (unsigned long)millis);
+}
+
+/**
+ * @brief Gives read access to the cached connection.
+ */
+const WifiLeaseRecord& WifiLease::record() {
+    return rtcWifiLease;
+}
+
+/**
+ * @brief Gives read access to the attempt log.
+ */
+const WifiAttemptLog& WifiLease::log() {
+    return rtcWifiLog;
+}
+
+/**
+ * @brief Short name of a connect mode, for reports.
+ */
+const char* WifiLease::modeName(WifiConnectMode mode) {
+    switch (mode) {
+        case WifiConnectMode::Scan: return "scan";
+        case WifiConnectMode::Channel: return "channel";
+        case WifiConnectMode::Lease: return "lease";
+    }
+    return "?";
+}
+
+/**
+ * @brief Chooses the connect mode from a cached record.
+ *
+ * @param lease Cached record.
+ * @param credentialHash Hash of the credentials about to be used.
+ * @param nowMicros Current RTC timer value.
+ * @param ttlMicros Age after which the address must be renewed by DHCP.
+ * @return Lease, Channel or Scan.
+ */
+WifiConnectMode WifiLease::choose(const WifiLeaseRecord& lease, uint32_t credentialHash, uint64_t nowMicros, uint64_t ttlMicros) {
+    if (!validate(lease) || lease.credentialHash != credentialHash) return WifiConnectMode::Scan;
+    if (lease.channel == 0 || lease.channel > 14) return WifiConnectMode::Scan;
+    if (lease.ip == 0 || nowMicros < lease.leasedMicros || nowMicros - lease.leasedMicros >= ttlMicros) {
+        return WifiConnectMode::Channel;
+    }
+    return WifiConnectMode::Lease;
+}
+
+/**
+ * @brief Hashes a pair of credentials.
+ *
+ * @param ssid Network name.
+ * @param password Network password.
+ * @return CRC-32 over both strings (with their terminators).
+ */
+uint32_t WifiLease::hashCredentials(const char* ssid, const char* password) {
+    uint32_t crc = crc32Update(ssid, strlen(ssid) + 1);
+    return crc32Update(password, strlen(password) + 1, crc);
+}
+
+/**
+ * @brief Appends an attempt to a log and updates the totals.
+ *
+ * @param log A valid log.
+ * @param mode How the attempt was made.
+ * @param connected Outcome.
+ * @param millis Time spent.
+ */
+void WifiLease::append(WifiAttemptLog& log, WifiConnectMode mode, bool connected, uint32_t millis) {
+    uint8_t index = (uint8_t)mode;
+    if (index > (uint8_t)WifiConnectMode::Lease) return;
+
+    log.attempts[index]++;
+    if (!connected) log.failures[index]++;
+    log.millis[index] += millis;
+
+    WifiAttempt& attempt = log.recent[log.head];
+    attempt.millis = millis;
+    attempt.mode = index;
+    attempt.connected = connected ? 1 : 0;
+    log.head = (log.head + 1) % WIFI_ATTEMPT_HISTORY;
+    if (log.count < WIFI_ATTEMPT_HISTORY) log.count++;
+    seal(log);
+}
+
+/**
+ * @brief Validates magic and CRC of a cached record.
+ */
+bool WifiLease::validate(const WifiLeaseRecord& lease) {
+    return lease.magic == WIFI_LEASE_MAGIC &&
+           lease.crc == crc32Update(&lease, offsetof(WifiLeaseRecord, crc));
+}
+
+/**
+ * @brief Validates magic and CRC of an attempt log.
+ */
+bool WifiLease::validate(const WifiAttemptLog& log) {
+    return log.magic == WIFI_LOG_MAGIC &&
+           log.crc == crc32Update(&log, offsetof(WifiAttemptLog, crc));
+}
+
+/**
+ * @brief Recomputes the CRC of a cached record.
+ */
+void WifiLease::seal(WifiLeaseRecord& lease) {
+    lease.crc = crc32Update(&lease, offsetof(WifiLeaseRecord, crc));
+}
+
+/**
+ * @brief Recomputes the CRC of an attempt log.
+ */
+void WifiLease::seal(WifiAttemptLog& log) {
+    log.crc = crc32Update(&log, offsetof(WifiAttemptLog, crc));
+}
@@ -0,0 +1,98 @@
+#ifndef WIFI_LEASE_H
+#define WIFI_LEASE_H
+/**
+ * @file WifiLease.h
+ * @brief Cached access point and IP configuration for fast Wi-Fi reconnects.
+ *
+ * After every successful connection the BSSID and channel of the access
+ * point and the IP, gateway, subnet and DNS configuration are kept in RTC
+ * slow memory. The next connection then skips the scan (`Channel`) and,
+ * while the DHCP address is younger than `WIFI_LEASE_TTL`, DHCP as well
+ * (`Lease`, static configuration). A failed fast attempt drops the cache
+ * and the caller falls back to a full scan with DHCP (`Scan`).
+ *
+ * The record is keyed by a hash of the credentials so a new SSID or
+ * password never reuses a stale AP. The duration and outcome of every
+ * attempt are logged in a small RTC ring.
+ */
+
+#include <stdint.h>
+#include "Config.h"
+
+#define WIFI_LEASE_MAGIC 0x574C4541UL  ///< "WLEA"
+#define WIFI_LOG_MAGIC 0x574C4F47UL    ///< "WLOG"
+
+/**
+ * @brief How the next connection is made.
+ */
+enum class WifiConnectMode : uint8_t {
+    Scan,     ///< Full scan and DHCP
+    Channel,  ///< Cached AP and channel, DHCP
+    Lease     ///< Cached AP and channel, cached address (no DHCP)
+};
+
+/**
+ * @brief Last successful connection (RTC slow memory).
+ */
+struct WifiLeaseRecord {
+    uint32_t magic;            ///< WIFI_LEASE_MAGIC when valid
+    uint32_t credentialHash;   ///< CRC-32 of SSID and password
+    uint64_t leasedMicros;     ///< RTC timer when the address was obtained by DHCP
+    uint8_t bssid[6];          ///< Access point
+    uint8_t channel;           ///< Primary channel of the access point
+    uint8_t reserved;
+    uint32_t ip;               ///< Addresses, packed as IPAddress
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns1;
+    uint32_t dns2;
+    uint32_t crc;              ///< CRC-32 of the preceding fields
+};
+
+/**
+ * @brief One connection attempt.
+ */
+struct WifiAttempt {
+    uint32_t millis;     ///< Time to connect (or to give up)
+    uint8_t mode;        ///< WifiConnectMode
+    uint8_t connected;   ///< 1 if the attempt succeeded
+    uint16_t reserved;
+};
+
+/**
+ * @brief Connection attempts since power-on (RTC slow memory).
+ */
+struct WifiAttemptLog {
+    uint32_t magic;                                ///< WIFI_LOG_MAGIC when valid
+    uint8_t head;                                  ///< Next slot to write
+    uint8_t count;                                 ///< Valid entries
+    uint16_t reserved;
+    uint32_t attempts[3];                          ///< Attempts per WifiConnectMode
+    uint32_t failures[3];                          ///< Failed attempts per WifiConnectMode
+    uint64_t millis[3];                            ///< Total connect time per WifiConnectMode
+    WifiAttempt recent[WIFI_ATTEMPT_HISTORY];      ///< Last attempts, oldest overwritten first
+    uint32_t crc;                                  ///< CRC-32 of the preceding fields
+};
+
+class WifiLease {
+public:
+    static WifiConnectMode plan(const char* ssid, const char* password);  // Mode of the next attempt
+    static void remember(const char* ssid, const char* password, const uint8_t* bssid, uint8_t channel,
+                         uint32_t ip, uint32_t gateway, uint32_t subnet, uint32_t dns1, uint32_t dns2, bool dhcp);
+    static void forget();  // Drop the cached AP and address
+    static void recordAttempt(WifiConnectMode mode, bool connected, uint32_t millis);
+    static const WifiLeaseRecord& record();
+    static const WifiAttemptLog& log();
+    static const char* modeName(WifiConnectMode mode);
+
+    // Pure helpers (host testable)
+    static WifiConnectMode choose(const WifiLeaseRecord& lease, uint32_t credentialHash, uint64_t nowMicros, uint64_t ttlMicros);
+    static uint32_t hashCredentials(const char* ssid, const char* password);
+    static void append(WifiAttemptLog& log, WifiConnectMode mode, bool connected, uint32_t millis);
+    static bool validate(const WifiLeaseRecord& lease);
+    static bool validate(const WifiAttemptLog& log);
+    static void seal(WifiLeaseRecord& lease);
+    static void seal(WifiAttemptLog& log);
+};
+
+#endif // WIFI_LEASE_H
@@ -3,6 +3,19 @@
 #include "WiFiManager.h"    // Include WiFiManager library for Wi-Fi connectivity
 #include "TimeManager.h"    // Include TimeManager library for time synchronization
 #include "Device.h"         // Include Device library for device control
+#include "WakeState.h"      // Include WakeState for the RTC-memory fast-wake cache
+#include "WakeStub.h"       // Include WakeStub for the deep-sleep wake stub
+#include "SleepScheduler.h" // Include SleepScheduler to size deep sleeps from the alarm deadline
+#include "TimeAccounting.h" // Include TimeAccounting to rebuild the wall clock across deep sleep
+#include "DriftEstimator.h" // Include DriftEstimator for drift correction and resync scheduling
+#include "EnergyMeter.h"    // Include EnergyMeter for the per-phase charge accounting
+#include "WakeProfiler.h"   // Include WakeProfiler for the per-phase wake timing
+#include "RetryPolicy.h"    // Include RetryPolicy for the backoff of failed time syncs
+#include "EventLoop.h"      // Include EventLoop for the event group, timers and light sleep between events
+#include "PatternEngine.h"  // Include PatternEngine for the LED/buzzer patterns played by the LEDC
+#include "WakeSource.h"     // Include WakeSource for the button wakes and the wake statistics
+#include "PortalMessages.h" // Include PortalMessages for the fixed-schema alarm command
+#include "CivilTime.h"      // Include CivilTime for the alarm date/time parsing
 
 struct tm timeInfo;
 
@@ -14,8 +27,18 @@ void AdminSetupMode();  // Starts the Wi-Fi setup mode and waits for a connectio
 void connectAndUpdateTime();  // Connects to Wi-Fi and updates RTC time from NTP server
 void PowerFailSafeMode();  // Manages power failure safe mode to correct RTC time
 void NormalMode();  // Handles the normal mode of device operation
+void FastWakeMode();  // Services a timer wake from the RTC-memory cache
+void SleepUntilNextWake(uint64_t now, uint64_t alarm);  // Schedules and enters the next deep sleep
+bool timeSyncDue();  // True when an NTP sync (or its retry) should run now
 void setUnixTime(unsigned long timestamp);
 void setFromSerial();
+void printEnergyReport();  // Prints the charge consumption and battery life projection
+void printWakeProfile();  // Prints the phase timing statistics of the last wakes
+void printWakeSources();  // Prints the wake source statistics
+void handleButtonWake();  // Acts on a button wake without the countdown
+void answerAlarm(WakeAction action);  // Snoozes, dismisses or expires the ringing alarm
+uint32_t waitForRelease(unsigned long pressedAt);  // Times a press of the user button
+void SerialProgMode();  // Serves serial commands forever
 
 Preferences prefs;  // Create a Preferences object for storing configuration settings
 
@@ -25,49 +48,96 @@ RTCManager *RTC = nullptr;        // RTC manager pointer
 TimeManager *Time = nullptr;      // Time manager pointer
 WiFiManager *wifi = nullptr;      // Wi-Fi manager pointer
 Device *device = nullptr;         // Device pointer
+SleepScheduler scheduler;         // Deep sleep interval policy
+
+uint32_t timerWakes = 1;                          // Timer wakes since the application last ran
+unsigned long sleptSeconds = DEEPSLEEP_TIME / 1000;  // Time slept since the application last ran
+bool clockRestored = false;                       // System time rebuilt from the RTC anchor
 
 void setup() {
+    WakeProfiler::begin();  // Time the phases of this run
+    WakeProfiler::start(ProfilePoint::DeviceInit);
+
     // Start serial communication
     Serial.begin(SERIAL_BAUD_RATE);  
     
+    // Create a Device instance and initialize it
+    device = new Device();  
+    device->begin();  // Initialize the Device
+    WakeProfiler::stop(ProfilePoint::DeviceInit);
+
+    // Account for the wakes the deep-sleep stub absorbed without booting us
+    timerWakes = 1 + WakeStub::takeSkippedWakes();
+    sleptSeconds = timerWakes * (device->lastSleepDuration() / 1000);
+    EnergyMeter::begin(timerWakes);  // Close the sleep and boot phases
+    WakeSource::begin(timerWakes - 1);  // Count the wake sources
+
+    // Timer wakes with a valid RTC cache go back to sleep from here
+    WakeProfiler::start(ProfilePoint::FastWake);
+    FastWakeMode();
+    WakeProfiler::stop(ProfilePoint::FastWake);
+
+    // Event group and timers for every wait below
+    EventLoop::begin();
+    
     // Open Preferences in read-write mode
+    WakeProfiler::start(ProfilePoint::ConfigLoad);
     prefs.begin(CONFIG_PARTITION, false);  
     
     // Initialize ConfigManager instance with Preferences
     Config = new ConfigManager(&prefs);  
     Config->begin();  // Initialize the ConfigManager
+    WakeProfiler::stop(ProfilePoint::ConfigLoad);
     
-    // Create a Device instance and initialize it
-    device = new Device();  
-    device->begin();  // Initialize the Device
-    
-    // Set the system time using the alarm time (Unix timestamp)
-    setUnixTime(Config->GetULong64(CURRENT_TIME_SAVED, 0));  
-    
-    // Check if the LED flag is set, and blink LED if necessary
-    handleLEDFlagAndSleep();  
+    // Restore the system time: exactly from the RTC anchor after a deep sleep, otherwise from the last checkpoint
+    WakeProfiler::start(ProfilePoint::ClockRestore);
+    clockRestored = TimeAccounting::isAnchored();
+    if (clockRestored) {
+        TimeAccounting::restore();
+    } else {
+        setUnixTime(Config->LoadTime());
+    }
+
+    // Bring the drift history back from NVS after a power loss
+    if (!DriftEstimator::isValid()) {
+        DriftHistory saved;
+        if (Config->GetBytes(DRIFT_HISTORY_SAVED, &saved, sizeof(saved)) == sizeof(saved)) {
+            DriftEstimator::restore(saved);
+        } else {
+            DriftEstimator::reset();
+        }
+        TimeAccounting::setDriftPpb(DriftEstimator::driftPpb());
+    }
+    WakeProfiler::stop(ProfilePoint::ClockRestore);
+    WakeState::invalidate();  // Values may change below, NormalMode() captures them again
+    if (DEBUGMODE) printEnergyReport();
     
     // Create an RTCManager instance
     RTC = new RTCManager(&timeInfo);  
 
+    // Check if the LED flag is set, and blink LED if necessary
+    WakeProfiler::start(ProfilePoint::LedCheck);
+    handleLEDFlagAndSleep();  
+    WakeProfiler::stop(ProfilePoint::LedCheck);
+
+    // Button wakes act right away, without the countdown
+    if (WakeSource::isButton()) {
+        handleButtonWake();
+        goto out;
+    }
+
 // Countdown delay of 1.2 seconds before user action
-Config->CountdownDelay(4000);  
+// Deadline wakes (timer or ULP countdown) skip it: an alarm due now would ring late,
+// and a press during the sleep already woke us as a button wake
+if (WakeSource::current() != WakeKind::Timer && WakeSource::current() != WakeKind::Ulp) {
+    WakeProfiler::start(ProfilePoint::Countdown);
+    Config->CountdownDelay(4000);  
+    WakeProfiler::stop(ProfilePoint::Countdown);
+}
 
     // Check if the program button is pressed
     if (!device->isProgButtonPressed()) {
-        if (DEBUGMODE) {
-            Serial.println("Serial Prog Mode");
-        }
-        
-        // Blink the LED 4 times with a loop to avoid repetitive code
-        for (int i = 0; i < 7; i++) {
-            device->blinkLED(100);
-        }
-
-        // Enter serial mode and continuously process data
-        while (true) {
-            setFromSerial();
-        }
+        SerialProgMode();
     }
 
     // Check if the user button is pressed
@@ -75,10 +145,6 @@ Config->CountdownDelay(4000);
         if (DEBUGMODE) {
             Serial.println("Entering Admin Mode");
         };
-        // Blink the LED 2 times with a loop to avoid repetitive code
-        for (int i = 0; i < 4; i++) {
-            device->blinkLED(100);
-        };
         // Enter setup mode if the button is pressed
         AdminSetupMode();
         goto out;  // Exit to the out label if the button is pressed
@@ -94,8 +160,8 @@ void loop() {
     // Reset the watchdog timer to prevent system reset
     esp_task_wdt_reset();
     
-    // Small delay to reduce CPU usage
-    delay(50);  
+    // Sleep until the next event or timer (the web server runs in its own task)
+    EventLoop::waitFor(0, EVENTLOOP_WDT_FEED_MS);
 }
 
 
@@ -108,33 +174,148 @@ void loop() {
  * @return `true` if the LED state is enabled, `false` otherwise.
  */
 bool isLEDFlagSet() {
-    return Config->GetBool(LED_STATE, false);
+    return Config->Get<ConfigField::LedState>();
 }
 /**
  * @brief Checks if the LED flag is set and handles LED blinking and deep sleep.
  *
- * This function checks if the LED flag is set, and if so, it blinks the LED
- * for 2 minutes. After the blinking duration, the device enters deep sleep 
- * mode for 5 minutes.
+ * This function checks if the LED flag is set, and if so, it plays the
+ * pattern of the alarm that fired for up to 2 minutes. The pattern runs in
+ * the LEDC peripheral and the button is an interrupt, so the CPU sleeps
+ * between two pattern steps. A short press snoozes the alarm and a long one
+ * dismisses it. Unanswered, the device enters deep sleep for 5 minutes and
+ * rings again, up to `ALARM_MAX_UNANSWERED` times. Either way it then
+ * sleeps until the next wake.
  */
 void handleLEDFlagAndSleep() {
     // Check if the LED flag is set
     if (isLEDFlagSet()) {
-        unsigned long startMillis = millis(); // Start time for LED blinking
-        unsigned long blinkDuration = 120000; // 2 minutes in milliseconds
-        unsigned long blinkInterval = 300;   // 300ms blink interval
-
-        // Blink LED for 2 minutes
-        while (millis() - startMillis < blinkDuration) {
-            if (device->isButtonPressed()!= false) return;
-            device->blinkLED(blinkInterval);  // Blink LED at the specified interval
+        EnergyScope phase(EnergyPhase::LedBlink);
+        if (WakeSource::isButton()) return;  // The press that woke us answers it, see handleButtonWake()
+        if (device->isButtonPressed()) return;  // Already held: go on to the user modes
+
+        // Play the alarm's pattern for 2 minutes, until it ends or the button is pressed
+        EventLoop::resetStats();
+        device->watchButton(true);
+        EventLoop::clear(EVENT_PATTERN_DONE);
+        PatternEngine::start(Config->Get<ConfigField::AlarmPattern>());
+        uint32_t events = EventLoop::waitFor(EVENT_BUTTON | EVENT_PATTERN_DONE, ALARM_BLINK_DURATION_MS);
+        PatternEngine::stop();
+        device->watchButton(false);
+        if (DEBUGMODE)Serial.printf("Alarm indication: CPU busy %u%%, %lu wakeups\n",
+                                    (unsigned)EventLoop::busyPercent(), (unsigned long)EventLoop::stats().wakeups);
+
+        WakeAction action;
+        if (events & EVENT_BUTTON) {
+            action = WakeSource::decide(WakeKind::Button, true, waitForRelease(millis()), BUTTON_LONG_PRESS_MS);
+        } else if (WakeSource::missed() >= ALARM_MAX_UNANSWERED) {
+            action = WakeAction::Expire;
+        } else {
+            // Unanswered: enter deep sleep for 5 minutes, then ring again
+            Config->commit();  // Flush cached settings before sleeping
+            device->deepSleep(ALARM_REST_SLEEP_MS);
+            return;
+        }
+        WakeSource::acted(action);
+        answerAlarm(action);
+        NormalMode();  // Sleep until the next alarm
+    }
+}
+
+
+/**
+ * @brief Serves the serial programming mode, never returns.
+ *
+ * The LED acknowledges the mode and stays on. The CPU sleeps until data
+ * arrives, then every complete line is processed.
+ */
+void SerialProgMode() {
+    if (DEBUGMODE) {
+        Serial.println("Serial Prog Mode");
+    }
+
+    // Acknowledge with a short blink, then keep the LED on (played by the LEDC)
+    PatternEngine::start(PATTERN_SERIAL_MODE);
+
+    Serial.onReceive([]() { EventLoop::post(EVENT_SERIAL); });
+    while (true) {
+        EventLoop::waitFor(EVENT_SERIAL, EVENTLOOP_WDT_FEED_MS);
+        esp_task_wdt_reset();
+        while (Serial.available() > 0) {
+            setFromSerial();
         }
+    }
+}
+
+/**
+ * @brief Acts on a button wake without the user-action countdown.
+ *
+ * The programming switch enters the serial mode. The user button is timed
+ * until it is released (see WakeSource::decide()): on a ringing alarm a
+ * short press snoozes and a long press dismisses it; otherwise a long press
+ * opens the admin mode and a short one just goes back to sleep.
+ */
+void handleButtonWake() {
+    WakeKind wake = WakeSource::current();
+    uint32_t hold = wake == WakeKind::Button ? waitForRelease(0) : 0;  // Pressed since the wake
+    WakeAction action = WakeSource::decide(wake, isLEDFlagSet(), hold, BUTTON_LONG_PRESS_MS);
+    WakeSource::acted(action);
+
+    switch (action) {
+        case WakeAction::SerialMode:
+            SerialProgMode();
+            break;
+        case WakeAction::Admin:
+            AdminSetupMode();
+            break;
+        default:
+            answerAlarm(action);
+            if (clockRestored) {
+                NormalMode();  // Sleep until the next alarm
+            } else {
+                PowerFailSafeMode();  // No RTC anchor: fix the time first
+            }
+            break;
+    }
+}
 
-        // After 2 minutes of blinking, enter deep sleep for 5 minutes
-        device->deepSleep(300000);  // 5 minutes in milliseconds
+/**
+ * @brief Times a press of the user button, up to a long press.
+ *
+ * The CPU sleeps between two polls of the pin.
+ *
+ * @param pressedAt millis() when the press started (0 = before the wake).
+ * @return Hold time in milliseconds.
+ */
+uint32_t waitForRelease(unsigned long pressedAt) {
+    while (device->isButtonPressed() && millis() - pressedAt < BUTTON_LONG_PRESS_MS) {
+        EventLoop::waitFor(0, BUTTON_POLL_MS);
     }
+    return millis() - pressedAt;
 }
 
+/**
+ * @brief Applies an answer to the ringing alarm.
+ *
+ * A snooze stores a one-shot alarm `ALARM_SNOOZE_SECONDS` from now with the
+ * same pattern. Snoozing, dismissing and expiring all clear the LED flag;
+ * other actions leave it alone.
+ *
+ * @param action The action taken.
+ */
+void answerAlarm(WakeAction action) {
+    if (action == WakeAction::Snooze) {
+        uint32_t now = RTC->getUnixTime();
+        AlarmEntry rule = {};
+        rule.start = now + ALARM_SNOOZE_SECONDS;
+        rule.repeat = ALARM_ONCE;
+        rule.pattern = Config->Get<ConfigField::AlarmPattern>();
+        Config->StoreAlarm(rule, true, now);
+    }
+    if (action == WakeAction::Snooze || action == WakeAction::Dismiss || action == WakeAction::Expire) {
+        Config->Put<ConfigField::LedState>(false);
+    }
+}
 
 /**
  * @brief Initiates the Wi-Fi setup mode and waits for a connection.
@@ -147,57 +328,57 @@ void handleLEDFlagAndSleep() {
  * @note The function will restart the system if the connection attempt times out.
  */
 void AdminSetupMode() {
+    PatternEngine::start(PATTERN_ADMIN_MODE);  // Acknowledge with two blinks (played by the LEDC while Wi-Fi starts)
     wifi = new WiFiManager(Config, RTC, device);  // Create a Wi-Fi Manager instance
     wifi->begin();// Try to start Wi-Fi   
 }
 /**
  * @brief Attempts to connect to Wi-Fi and update the time from the NTP server.
  * 
- * This function tries to connect to Wi-Fi up to 10 times. If successful, it initializes and updates the RTC time 
- * from the NTP server. If the connection fails after 10 attempts, the device will restart.
+ * One attempt is made per wake. If successful, it updates the RTC time from the NTP server. On failure the
+ * next attempt is scheduled with a jittered exponential backoff (RetryPolicy) and the device carries on in
+ * normal mode on its drift-compensated clock, sleeping until the alarm or the retry, whichever comes first.
  */
 void connectAndUpdateTime() {
+    ProfileScope profile(ProfilePoint::TimeSync);
+
     // Initialize TimeManager instance
     Time = new TimeManager(NTP_SERVER, TIMEOFFSET, NTP_UPDATE_INTERVAL, RTC); 
     
     // Create a Wi-Fi Manager instance
     wifi = new WiFiManager(Config, RTC, device);  
     
-    const int maxAttempts = 10; // Maximum number of connection attempts
-    int attempts = 0;          // Initialize attempt counter
-
     // Attempt to connect to Wi-Fi
-    while (attempts < maxAttempts) {
-        wifi->connectToWiFi(); // Attempt to connect to Wi-Fi
-
-        // If Wi-Fi is successfully connected
-        if (wifi->isStillConnected()) {
-            if (DEBUGMODE)Serial.println("Initialize the time manager only if Wi-Fi is connected");
-            Time->initialize(); // Initialize the time manager only if Wi-Fi is connected
-
-            if (DEBUGMODE)Serial.println("Update the RTC time from the NTP server");
-            if (Time->UpdateTimeFromNTP()) { // Update the RTC time from the NTP server
-                if (DEBUGMODE)Serial.println("Start Normal Mode");
-                int unix = RTC->getUnixTime();
-                Config->PutULong64(CURRENT_TIME_SAVED, unix);
-                Config->PutULong64(LAST_TIME_SAVED, unix);
-                NormalMode(); // Make normal mode
-                return;       // Exit the function after successful setup
-            } else {
-                if (DEBUGMODE)Serial.println("Failed to update time from NTP. Retrying...");
-                attempts++;      // Increment attempt counter
-                delay(1000);     // Wait for 1 second before the next attempt
-                continue;     // Retry if time update fails
-            }
+    WakeProfiler::start(ProfilePoint::WifiConnect);
+    wifi->connectToWiFi(); // Attempt to connect to Wi-Fi
+    WakeProfiler::stop(ProfilePoint::WifiConnect);
+
+    // If Wi-Fi is successfully connected
+    if (wifi->isStillConnected()) {
+        if (DEBUGMODE)Serial.println("Initialize the time manager only if Wi-Fi is connected");
+        WakeProfiler::start(ProfilePoint::NtpUpdate);
+        Time->initialize(); // Initialize the time manager only if Wi-Fi is connected
+
+        if (DEBUGMODE)Serial.println("Update the RTC time from the NTP server");
+        bool synced = Time->UpdateTimeFromNTP();  // Update the RTC time from the NTP server
+        WakeProfiler::stop(ProfilePoint::NtpUpdate);
+        wifi->disconnect();  // Radio off: the rest of the wake can light sleep
+        if (synced) {
+            if (DEBUGMODE)Serial.println("Start Normal Mode");
+            RetryPolicy::succeeded();
+            uint64_t unixTime = RTC->getUnixTime();
+            Config->SaveTime(unixTime, unixTime);
+            Config->PutBytes(DRIFT_HISTORY_SAVED, &DriftEstimator::history(), sizeof(DriftHistory));
+            NormalMode(); // Make normal mode
+            return;       // Exit the function after successful setup
         }
-
-        attempts++;      // Increment attempt counter
-        delay(1000);     // Wait for 1 second before the next attempt
+        if (DEBUGMODE)Serial.println("Failed to update time from NTP.");
     }
 
-    // If connection fails after max attempts, restart the device
-    if (DEBUGMODE)Serial.println("Wi-Fi connection failed after 10 attempts. Restarting...");
-    Config->RestartSysDelay(5000); // Restart the system after 5 seconds
+    // Back off in deep sleep and keep time locally meanwhile
+    RetryPolicy::failed();
+    if (DEBUGMODE)Serial.println("Continuing on the local clock until the next attempt");
+    NormalMode();
 }
 
 
@@ -209,21 +390,29 @@ void connectAndUpdateTime() {
  * If the conditions do not meet, it sets the system mode to PowerFail and attempts to connect to Wi-Fi and update the time.
  */
 void PowerFailSafeMode() {
+    ProfileScope profile(ProfilePoint::PowerFailSafe);
     if (DEBUGMODE)Serial.println("Entering Power safe Mode");
     // If the wake-up cause is not a timer or if the time difference exceeds the threshold
     if (device->getWakeUpCause() == 0) {
         // Set the system mode to Normal if the condition is met
         if (DEBUGMODE)Serial.println(" Wakeup by timer Entering Normal mode");
-        RTC->getUnixTime();
-        
-        RTC->setUnixTime(RTC->getUnixTime() + (DEEPSLEEP_TIME/1000));
-        if (DEBUGMODE)Serial.print("#############################################################");
-        if (DEBUGMODE)Serial.print("Adding: ");
-        if (DEBUGMODE)Serial.print((DEEPSLEEP_TIME/1000));
-        if (DEBUGMODE)Serial.println(" seconds.");
-        if (DEBUGMODE)Serial.print("#############################################################");
-        Config->PutULong64(CURRENT_TIME_SAVED, RTC->getUnixTime());  // Save the current time
-        Config->PutULong64(LAST_TIME_SAVED, RTC->getUnixTime());  // Save the last checked time
+        if (!clockRestored) {
+            // No RTC anchor survived: fall back to the nominal sleep duration
+            RTC->setUnixTime(RTC->getUnixTime() + sleptSeconds);
+            if (DEBUGMODE)Serial.print("#############################################################");
+            if (DEBUGMODE)Serial.print("Adding: ");
+            if (DEBUGMODE)Serial.print(sleptSeconds);
+            if (DEBUGMODE)Serial.println(" seconds.");
+            if (DEBUGMODE)Serial.print("#############################################################");
+        }
+
+        // Resync once the drift model predicts more error than we tolerate (unless backing off)
+        if (timeSyncDue()) {
+            if (DEBUGMODE)Serial.println("Predicted clock error above threshold, resyncing");
+            connectAndUpdateTime();
+            return;
+        }
+        Config->SaveTime(RTC->getUnixTime(), RTC->getUnixTime());  // Save the current and last checked time
         NormalMode();// go normal mode.
 
     } else {
@@ -243,17 +432,26 @@ void PowerFailSafeMode() {
  * the alarm time, the function updates the saved time and enters deep sleep.
  */
 void NormalMode() {
+    ProfileScope profile(ProfilePoint::NormalMode);
     
     // Get the current time from the RTC (Real-Time Clock) and the last saved alarm time from the configuration
-    long currentTime = RTC->getUnixTime();  // Get the current Unix time (seconds since 1970)
-    long AlarmSavedTime = Config->GetULong64(ALERT_TIMESTAMP_SAVED, 0);  // Retrieve the last saved alarm time
+    uint64_t currentTime = RTC->getUnixTime();  // Get the current Unix time (seconds since 1970)
+    uint64_t AlarmSavedTime = Config->Get<ConfigField::AlertTimestamp>();  // Next fire time of the alarm table
     
     // Check if the current time is greater than or equal to the alarm saved time
     if (DEBUGMODE)Serial.println("Check if the current time");
     if (currentTime >= AlarmSavedTime) {
         // If the current time is past the alarm time, update the LED state flag to true
         if (DEBUGMODE)Serial.println("Set Led FLag");
-        Config->PutBool(LED_STATE, true);  // Set the LED state to ON
+        Config->Put<ConfigField::LedState>(true);  // Set the LED state to ON
+
+        // Consume the fired alarm(s) and publish the next fire time
+        AlarmSchedule alarms;
+        Config->LoadAlarms(alarms);
+        const AlarmEntry* fired = alarms.next();
+        Config->Put<ConfigField::AlarmPattern>(fired != nullptr ? fired->pattern : (uint8_t)DEFAULT_ALARM_PATTERN);
+        alarms.advance(currentTime);
+        Config->SaveAlarms(alarms);
         
         // Handle LED flag and sleep behavior (e.g., blink or hold the LED on before sleeping)
         if (DEBUGMODE)Serial.println("Handle LED flag and sleep behavior");
@@ -262,19 +460,96 @@ void NormalMode() {
     } else {
         // If the current time is less than the alarm time, update the saved time
         if (DEBUGMODE)Serial.println("update the saved time");
-        Config->PutULong64(CURRENT_TIME_SAVED, RTC->getUnixTime());  // Save the current time
-        Config->PutULong64(LAST_TIME_SAVED, RTC->getUnixTime());  // Save the last checked time
+        Config->SaveTime(RTC->getUnixTime(), RTC->getUnixTime());  // Save the current and last checked time
         
-        // Enter deep sleep mode for the specified duration
-        device->deepSleep(DEEPSLEEP_TIME);  // The device will enter deep sleep for a predefined amount of time
+        // Let the next timer wakes run from RTC memory
+        WakeState::capture(RTC->getUnixTime(), RTC->getUnixTime(), AlarmSavedTime, false);
+        // Enter deep sleep for as long as the alarm and resync deadlines allow
+        SleepUntilNextWake(currentTime, AlarmSavedTime);
+    }
+}
+
+/**
+ * @brief Services a timer wake entirely from the RTC-memory state cache.
+ *
+ * If the device woke from the deep sleep timer, no button is held and the
+ * `WakeState` block is valid, the alarm check runs against the cached values
+ * and the device goes straight back to sleep without opening NVS. Every
+ * `WAKESTATE_CHECKPOINT_WAKES` wakes the current time is checkpointed (journal) so a
+ * power loss only loses a bounded amount of time.
+ *
+ * The function returns only when a full boot is required (cold boot, alarm
+ * due, LED flag set, user action or invalid cache).
+ */
+void FastWakeMode() {
+    if (device->getWakeUpCause() != 0 || !WakeState::isValid() || !TimeAccounting::isAnchored()) return;
+    if (device->isButtonPressed() || !device->isProgButtonPressed()) return;  // User wants a mode
+    if (timeSyncDue()) return;  // NTP resync runs in the full boot
+
+    FastWakeAction action = WakeState::onTimerWake(TimeAccounting::now(), timerWakes);
+    if (action == FastWakeAction::FullBoot) {
+        if (DEBUGMODE)Serial.println("Fast wake: full boot required");
+        return;
+    }
+
+    const WakeStateData& state = WakeState::data();
+    TimeAccounting::restore();
+    if (DEBUGMODE)Serial.print("Fast wake #");
+    if (DEBUGMODE)Serial.println(state.fastWakeCount);
+
+    if (action == FastWakeAction::Checkpoint) {
+        if (DEBUGMODE)Serial.println("Fast wake: checkpointing time");
+        prefs.begin(CONFIG_PARTITION, false);
+        Config = new ConfigManager(&prefs);
+        Config->SaveTime(state.currentTime, state.lastTimeSaved);  // Save the current and last checked time
+        Config->end();
     }
+
+    SleepUntilNextWake(state.currentTime, state.alertTimestamp);
+}
+
+/**
+ * @brief Checks whether an NTP sync should run on this wake.
+ *
+ * A sync is wanted when the drift model predicts too much error or a failed
+ * sync is being retried; while backing off, it waits for the retry time.
+ *
+ * @return true if connectAndUpdateTime() should run now.
+ */
+bool timeSyncDue() {
+    return (DriftEstimator::needsResync() || RetryPolicy::pending()) && RetryPolicy::due();
+}
+
+/**
+ * @brief Schedules the next wake and enters deep sleep.
+ *
+ * The wake deadline is the earlier of the alarm and the next NTP resync
+ * predicted by the drift model (or the next retry after a failed sync). The
+ * scheduler margin follows the residual drift uncertainty, and the wake stub
+ * is armed with the same deadline.
+ *
+ * @param now Current Unix time.
+ * @param alarm Alarm Unix time.
+ */
+void SleepUntilNextWake(uint64_t now, uint64_t alarm) {
+    ProfileScope profile(ProfilePoint::SleepPrep);
+    scheduler.setDriftPpm(DriftEstimator::uncertaintyPpb() / 1000 + 1);
+
+    uint64_t deadline = alarm > now ? alarm - now : 0;
+    uint64_t resync = RetryPolicy::pending() ? RetryPolicy::secondsUntilRetry() : DriftEstimator::secondsUntilResync();
+    if (resync < deadline) deadline = resync;
+
+    unsigned long sleepDuration = scheduler.nextSleepSeconds(now, now + deadline) * 1000UL;
+    WakeStub::arm(deadline, sleepDuration);
+    if (Config != nullptr) Config->commit();  // Flush cached settings before sleeping
+    device->deepSleep(sleepDuration);
 }
 
 /**
  * @brief Sets the system time to a specified Unix timestamp.
  * 
  * This function sets the system time to the provided Unix timestamp. The timestamp is in seconds since the Unix epoch 
- * (January 1, 1970). The function also resets the system watchdog timer to prevent a system reset while setting the time.
+ * (January 1, 1970). The time is also recorded as the new RTC anchor, so later wakes rebuild the clock from it.
  * 
  * @param timestamp The Unix timestamp (seconds since epoch) to set the system time to.
  * 
@@ -283,11 +558,7 @@ void NormalMode() {
  * @warning Ensure that the timestamp is valid and within an appropriate range for your application.
  */
 void setUnixTime(unsigned long timestamp) { 
-    struct timeval tv;        ///< Struct to hold the time value
-    tv.tv_sec = timestamp;    ///< Set seconds since the Unix epoch
-    tv.tv_usec = 0;           ///< No microseconds
-    esp_task_wdt_reset();     ///< Reset the watchdog timer to prevent a system reset
-    settimeofday(&tv, nullptr); ///< Set system time
+    TimeAccounting::setUnixTime(timestamp);  ///< Set system time and re-anchor
 }
 /**
  * @brief Sets parameters from received serial data.
@@ -305,88 +576,178 @@ void setUnixTime(unsigned long timestamp) {
  *   "year": "YYYY"    // Year in four digits (e.g., "2025")
  * }
  *
- * @note The timestamp is saved in the ESP32's preferences partition using the 
- *       `Config->PutULong64(ALERT_TIME_SAVED, alarmTimeUnix)` function.
+ * Optional fields turn the alarm into a recurring rule:
+ *   "repeat": "once" | "daily" | "weekly" | "interval",
+ *   "weekdays": 62,   // Weekly mask, bit 0 = Sunday (62 = Monday to Friday)
+ *   "interval": 90,   // Period of interval rules in minutes
+ *   "pattern": "gentle", // LED/buzzer pattern: "classic", "gentle", "beep" or "urgent"
+ *   "add": true       // Add to the alarm table instead of replacing it
  *
- * @see ArduinoJson library for JSON parsing
- * @see `strptime` and `mktime` functions for date/time parsing and conversion
+ * @note The rule is saved in the alarm table with `Config->StoreAlarm()`, which also
+ *       publishes the next fire time in `ALERT_TIMESTAMP_SAVED`.
+ *
+ * @see AlarmRequest (PortalMessages.h) for the accepted members and their checks
+ * @see CivilTime::parse() for the date/time validation and conversion
  * 
  * @return void
  */
 void setFromSerial() {
   if (Serial.available() > 0) {
-    device->blinkLED(100);
+    PatternEngine::start(PATTERN_SERIAL_MODE);  // Acknowledge the line
     String jsonData = Serial.readStringUntil('\n'); // Read the incoming JSON data
 
-    // Parse the JSON data
-    StaticJsonDocument<200> doc;
-    DeserializationError error = deserializeJson(doc, jsonData);
-
-    if (error) {
-      Serial.print("Error parsing JSON: ");
-      Serial.println(error.f_str());
+    // Plain-text report commands
+    jsonData.trim();
+    if (jsonData == "profile") {
+      printWakeProfile();
+      return;
+    }
+    if (jsonData == "energy") {
+      printEnergyReport();
+      return;
+    }
+    if (jsonData == "wakes") {
+      printWakeSources();
       return;
     }
 
-    // Extract date and time values from the JSON
-    String alarmDate = doc["alarmDate"].as<String>();  // Format: YYYY-MM-DD
-    String alarmTime = doc["alarmTime"].as<String>();  // Format: HH:MM
+    // Parse the JSON data (optional fields keep these defaults)
+    AlarmRequest alarmRequest = {};
+    strlcpy(alarmRequest.pattern, "classic", sizeof(alarmRequest.pattern));
+    JsonError error = JsonCodec::parse(jsonData.c_str(), jsonData.length(), alarmRequest);
 
-    if (alarmDate.isEmpty() || alarmTime.isEmpty()) {
-      Serial.println("Error: Missing alarmDate or alarmTime");
+    if (error == JsonError::Missing) {
+      if (DEBUGMODE)Serial.println("Error: Missing alarmDate or alarmTime");
+      return;
+    }
+    if (error != JsonError::Ok) {
+      if (DEBUGMODE)Serial.print("Error parsing JSON: ");
+      if (DEBUGMODE)Serial.println(JsonCodec::errorName(error));
       return;
     }
 
+    // Extract date and time values from the JSON
+    const char* alarmDate = alarmRequest.alarmDate;  // Format: YYYY-MM-DD
+    const char* alarmTime = alarmRequest.alarmTime;  // Format: HH:MM[:SS]
+
     // Debug output
-    Serial.println("################################");
-    Serial.println("Alarm Time Set by USER");
-    Serial.println("Alarm Date: " + alarmDate);
-    Serial.println("Alarm Time: " + alarmTime);
-    Serial.println("################################");
+    if (DEBUGMODE)Serial.println("################################");
+    if (DEBUGMODE)Serial.println("Alarm Time Set by USER");
+    if (DEBUGMODE)Serial.printf("Alarm Date: %s\n", alarmDate);
+    if (DEBUGMODE)Serial.printf("Alarm Time: %s\n", alarmTime);
+    if (DEBUGMODE)Serial.println("################################");
+
+    // Validate the date and time and convert them to a Unix timestamp
+    uint32_t alarmTimeUnix = 0;
+    if (!CivilTime::parse(alarmDate, alarmTime, alarmTimeUnix)) {
+      if (DEBUGMODE)Serial.println("Error: Invalid alarm date or time");
+      return;
+    }
 
-    // Manually parse the date and time strings (format: "YYYY-MM-DD" and "HH:MM")
-    int year = alarmDate.substring(0, 4).toInt();
-    int month = alarmDate.substring(5, 7).toInt();
-    int day = alarmDate.substring(8, 10).toInt();
-    int hour = alarmTime.substring(0, 2).toInt();
-    int minute = alarmTime.substring(3, 5).toInt();
-    int second = 0;
-
-    // Debug output for parsed values
-    Serial.println("Parsed Alarm Date and Time:");
-    Serial.println("Year: " + String(year));
-    Serial.println("Month: " + String(month));
-    Serial.println("Day: " + String(day));
-    Serial.println("Hour: " + String(hour));
-    Serial.println("Minute: " + String(minute));
-    Serial.println("Second: " + String(second));
-
-    // Create a tm struct and set its fields
-    struct tm timeStruct = {};
-    timeStruct.tm_year = year - 1900;  // tm_year is years since 1900
-    timeStruct.tm_mon = month - 1;     // tm_mon is 0-based
-    timeStruct.tm_mday = day;
-    timeStruct.tm_hour = hour;
-    timeStruct.tm_min = minute;
-    timeStruct.tm_sec = second;
-
-    // Convert to Unix timestamp
-    time_t alarmTimeUnix = mktime(&timeStruct);
-    if (alarmTimeUnix == -1) {
-      Serial.println("Failed to convert time to Unix timestamp");
+    // Build the alarm rule (optional fields default to a single one-shot alarm)
+    AlarmEntry rule = {};
+    rule.start = alarmTimeUnix;
+    int repeat = AlarmSchedule::parseRepeat(alarmRequest.repeat);
+    rule.weekdays = alarmRequest.weekdays;
+    rule.interval = alarmRequest.interval * 60UL;  // Minutes
+    int pattern = PatternEngine::find(alarmRequest.pattern);
+    if (repeat < 0) {
+      if (DEBUGMODE)Serial.println("Error: Unknown repeat rule");
+      return;
+    }
+    if (pattern < 0) {
+      if (DEBUGMODE)Serial.println("Error: Unknown pattern");
       return;
     }
+    rule.repeat = repeat;
+    rule.pattern = pattern;
 
-    // Store alarm date, time, and Unix timestamp in preferences
-    Config->PutString(ALERT_DATE_, alarmDate);
-    Config->PutString(ALERT_TIME_, alarmTime);
-    Config->PutULong64(ALERT_TIMESTAMP_SAVED, alarmTimeUnix);
+    // Store the alarm table, alarm date, time and next fire time in preferences
+    if (Config->StoreAlarm(rule, alarmRequest.add, RTC->getUnixTime()) < 0) {
+      if (DEBUGMODE)Serial.println("Error: Alarm rejected (table full or never fires)");
+      return;
+    }
+    // The portal shows HH:MM; the exact second lives in the alarm rule
+    char alertTime[6];
+    CivilTime::formatTime(alarmTimeUnix, alertTime);
+    Config->Put<ConfigField::AlertDate>(alarmDate);
+    Config->Put<ConfigField::AlertTime>(alertTime);
+    Config->commit();  // Persist the new alarm right away
 
     // Debug output before saving values
-    Serial.println("#########################################");
-    Serial.println("Saving Alert Date: " + alarmDate);
-    Serial.println("Saving Alert Time: " + alarmTime);
-    Serial.println("Saving Alert Unix Timestamp: " + String(alarmTimeUnix));
-    Serial.println("#########################################");
+    if (DEBUGMODE)Serial.println("#########################################");
+    if (DEBUGMODE)Serial.printf("Saving Alert Date: %s\n", alarmDate);
+    if (DEBUGMODE)Serial.printf("Saving Alert Time: %s\n", alertTime);
+    if (DEBUGMODE)Serial.printf("Saving Alert Unix Timestamp: %lu\n", (unsigned long)alarmTimeUnix);
+    if (DEBUGMODE)Serial.println("#########################################");
   }
 }
+
+/**
+ * @brief Prints the consumption accounted by the energy meter.
+ *
+ * Shows the average charge per day, the projected battery life and the
+ * share of each wake phase since the last power-on.
+ */
+void printEnergyReport() {
+    EnergyReport report = EnergyMeter::report();
+    const EnergyLedger& ledger = EnergyMeter::ledger();
+    Serial.println("################################");
+    Serial.printf("Energy: %.3f mAh/day, battery %.0f days (%lu boots in %.1f h)\n",
+                  report.mahPerDay, report.batteryDays, (unsigned long)report.boots, report.elapsedMicros / 3600e6);
+    for (uint8_t i = 0; i < ENERGY_PHASE_COUNT; i++) {
+        if (ledger.phaseMicros[i] == 0) continue;
+        Serial.printf("  %-9s %10.1f s %9.4f mAh\n", EnergyMeter::phaseName((EnergyPhase)i),
+                      ledger.phaseMicros[i] / 1e6, ledger.chargeNc[i] / 3.6e9);
+    }
+    Serial.println("################################");
+}
+
+/**
+ * @brief Prints the phase timing statistics of the last wakes.
+ *
+ * One line per measured phase with the number of runs, min/avg/max in
+ * milliseconds and the histogram of durations per decade.
+ */
+void printWakeProfile() {
+    const WakeProfileRing& ring = WakeProfiler::ring();
+    Serial.println("################################");
+    Serial.printf("Wake profile: last %u of %lu runs\n", (unsigned)ring.count, (unsigned long)ring.wakes);
+    Serial.println("phase          n   min ms   avg ms   max ms   <1ms <10ms <100ms <1s <10s >10s");
+    for (uint8_t i = 0; i < PROFILE_POINT_COUNT; i++) {
+        ProfileStats stats = WakeProfiler::stats((ProfilePoint)i);
+        if (stats.samples == 0) continue;
+        Serial.printf("%-10s %5u %8.1f %8.1f %8.1f   %4u %5u %6u %3u %4u %4u\n",
+                      WakeProfiler::pointName((ProfilePoint)i), (unsigned)stats.samples,
+                      stats.minMicros / 1000.0, stats.avgMicros / 1000.0, stats.maxMicros / 1000.0,
+                      (unsigned)stats.buckets[0], (unsigned)stats.buckets[1], (unsigned)stats.buckets[2],
+                      (unsigned)stats.buckets[3], (unsigned)stats.buckets[4], (unsigned)stats.buckets[5]);
+    }
+    Serial.println("################################");
+}
+
+/**
+ * @brief Prints the wake source statistics.
+ *
+ * Wakes per source and actions taken since power-on, plus the
+ * wake-to-action latency of button wakes.
+ */
+void printWakeSources() {
+    const WakeStats& stats = WakeSource::stats();
+    Serial.println("################################");
+    Serial.print("Wakes:");
+    for (uint8_t i = 0; i < WAKE_KIND_COUNT; i++) {
+        Serial.printf(" %s %lu", WakeSource::kindName((WakeKind)i), (unsigned long)stats.wakes[i]);
+    }
+    Serial.println();
+    Serial.print("Actions:");
+    for (uint8_t i = 0; i < WAKE_ACTION_COUNT; i++) {
+        Serial.printf(" %s %lu", WakeSource::actionName((WakeAction)i), (unsigned long)stats.actions[i]);
+    }
+    Serial.println();
+    if (stats.latencySamples > 0) {
+        Serial.printf("Button wake to action: avg %lu ms, max %lu ms\n",
+                      (unsigned long)(stats.latencySumMs / stats.latencySamples), (unsigned long)stats.latencyMaxMs);
+    }
+    Serial.println("################################");
+}
@@ -9,6 +9,11 @@
  * Wi-Fi settings and GPIO controls.
  */
 #include "WiFiManager.h"
+#include "WebAssets.h"  // Generated from data/ by tools/embed_web.py
+#include "RequestBody.h"
+#include "EntityTag.h"
+#include "PortalMessages.h"
+#include "CivilTime.h"
 
 
 /**
@@ -17,12 +22,13 @@
  * Initializes the WiFiManager object, setting default values for the access point 
  * credentials and other configurations.
  */
-WiFiManager::WiFiManager(ConfigManager* configManager, RTCManager* RTC,Device* device):configManager(configManager),server(80),isAPMode(false), apSSID(DEFAULT_AP_SSID),apPassword(DEFAULT_AP_PASSWORD),RTC(RTC),device(device){}
+WiFiManager::WiFiManager(ConfigManager* configManager, RTCManager* RTC,Device* device):configManager(configManager),server(80),isAPMode(false), apSSID(DEFAULT_AP_SSID),apPassword(DEFAULT_AP_PASSWORD),RTC(RTC),device(device),settingsReply(),settingsLength(0),settingsRevision(0),settingsMinute(-1),settingsCounters(){}
 /**
  * @brief Begins the WiFiManager initialization process.
  *
- * This method mounts the SPIFFS filesystem, checks the configuration for 
- * the connection mode (AP or Wi-Fi), and starts the appropriate connection process.
+ * This method checks the configuration for the connection mode (AP or Wi-Fi)
+ * and starts the appropriate connection process. The portal pages are
+ * embedded in flash (see sendAsset), so no filesystem is mounted.
  */
 void WiFiManager::begin() {
     if (DEBUGMODE) {
@@ -30,12 +36,6 @@ void WiFiManager::begin() {
         Serial.println("###########################################################");
         Serial.println("#                 Starting WIFI Manager                   #");
         Serial.println("###########################################################");
-        
-        if (!SPIFFS.begin(true)) {
-            Serial.println("An error has occurred while mounting SPIFFS");
-            return;
-        }
-        Serial.println("SPIFFS mounted successfully");
         Serial.println("WiFiManager: Begin initialization");
     };
         if(device->isButtonPressed() != false){
@@ -48,16 +48,16 @@ void WiFiManager::begin() {
 /**
  * @brief Connects to the specified Wi-Fi network.
  *
- * Attempts to connect to the Wi-Fi using stored credentials. If the connection fails, 
- * it defaults to starting the access point.
+ * Attempts to connect to the Wi-Fi using stored credentials. The access point,
+ * channel and address of the last connection are tried first (see WifiLease);
+ * a full scan with DHCP is only made when they are unknown or fail. If the
+ * connection fails, it defaults to starting the access point.
  */
 void WiFiManager::connectToWiFi() {
-    String ssid = configManager->GetString(WIFISSID, DEFAULT_WIFI_SSID);
-    String password = configManager->GetString(WIFIPASS, DEFAULT_WIFI_PASSWORD);
-    // Formatted message
-    char text[50]; // Ensure this is large enough to hold your formatted string
-    sprintf(text, "WiFiManager:Attempting to connect to WiFi - %s...", ssid);
-    
+    EnergyScope phase(EnergyPhase::WifiConnect);
+    String ssid = configManager->Get<ConfigField::WifiSsid>();
+    String password = configManager->Get<ConfigField::WifiPass>();
+
     if (DEBUGMODE) {
         Serial.print("WiFiManager: Attempting to connect to WiFi\n - SSID: ");
         Serial.print(ssid);
@@ -68,26 +68,22 @@ void WiFiManager::connectToWiFi() {
     if (ssid == "" || password == "") {
         startAccessPoint();
     } else {
-        WiFi.begin(ssid.c_str(), password.c_str());
-        unsigned long startAttemptTime = millis();
-
         if (DEBUGMODE) {
             Serial.println("WiFiManager: Connecting to WiFi...");
         }
 
-        while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < 10000) {
-            delay(500);
-            if (DEBUGMODE) {
-                Serial.print(".");
-            }
+        WiFi.persistent(false);  // Credentials come from the settings: no flash write per connect
+        WiFi.mode(WIFI_STA);
+
+        WifiConnectMode mode = WifiLease::plan(ssid.c_str(), password.c_str());
+        bool connected = connectStation(ssid, password, mode);
+        if (!connected && mode != WifiConnectMode::Scan) {
+            WifiLease::forget();  // AP moved or address taken: scan and ask DHCP
+            WiFi.disconnect();
+            connected = connectStation(ssid, password, WifiConnectMode::Scan);
         }
 
-        if (WiFi.status() == WL_CONNECTED) {
-           
-            IPAddress localIP = WiFi.localIP();
-                // Formatted message
-            char text[100]; // Ensure this is large enough to hold your formatted string
-            sprintf(text, "WiFiManager: Connected to WiFi IP Address: %d.%d.%d.%d", localIP[0], localIP[1], localIP[2], localIP[3]);
+        if (connected) {
             if (DEBUGMODE) {
                 Serial.print("\nWiFiManager: Connected to WiFi,\nIP Address: ");
                 Serial.println(WiFi.localIP());
@@ -95,15 +91,61 @@ void WiFiManager::connectToWiFi() {
             }
             //server.begin(); // Start web server
         } else {
-            
-             if (DEBUGMODE) {
-                Serial.println("WiFiManager: Failed to connect to WiFi.\nSwitching to AP mode.");
-                esp_task_wdt_reset(); // Reset the watchdog timer to prevent a system reset
-                configManager->RestartSysDelay(3000);
+            // The caller backs off in deep sleep (RetryPolicy) instead of restarting
+            WiFi.disconnect(true);  // Radio off until the next attempt
+            esp_task_wdt_reset(); // Reset the watchdog timer to prevent a system reset
+            if (DEBUGMODE) {
+                Serial.println("WiFiManager: Failed to connect to WiFi.");
             }
         }
     }
 }
+/**
+ * @brief Makes one station connection attempt and logs it.
+ *
+ * @param ssid Network name.
+ * @param password Network password.
+ * @param mode Scan (full scan, DHCP), Channel (cached AP and channel, DHCP)
+ *             or Lease (cached AP, channel and static address).
+ * @return true if connected.
+ */
+bool WiFiManager::connectStation(const String& ssid, const String& password, WifiConnectMode mode) {
+    const WifiLeaseRecord& lease = WifiLease::record();
+    unsigned long timeout = WIFI_CONNECT_TIMEOUT_MS;
+    unsigned long startAttemptTime = millis();
+
+    // The Wi-Fi event task posts the address; the loop task sleeps until then
+    EventLoop::clear(EVENT_WIFI_UP);
+    wifi_event_id_t gotIp = WiFi.onEvent([](WiFiEvent_t, WiFiEventInfo_t) {
+        EventLoop::post(EVENT_WIFI_UP);
+    }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+
+    if (mode == WifiConnectMode::Lease) {
+        WiFi.config(IPAddress(lease.ip), IPAddress(lease.gateway), IPAddress(lease.subnet),
+                    IPAddress(lease.dns1), IPAddress(lease.dns2));
+    } else {
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);  // DHCP
+    }
+    if (mode == WifiConnectMode::Scan) {
+        WiFi.begin(ssid.c_str(), password.c_str());
+    } else {
+        WiFi.begin(ssid.c_str(), password.c_str(), lease.channel, lease.bssid);
+        timeout = WIFI_FAST_TIMEOUT_MS;
+    }
+
+    EventLoop::waitFor(EVENT_WIFI_UP, timeout);
+    WiFi.removeEvent(gotIp);
+
+    bool connected = WiFi.status() == WL_CONNECTED;
+    WifiLease::recordAttempt(mode, connected, millis() - startAttemptTime);
+    if (connected) {
+        WifiLease::remember(ssid.c_str(), password.c_str(), WiFi.BSSID(), WiFi.channel(),
+                            WiFi.localIP(), WiFi.gatewayIP(), WiFi.subnetMask(),
+                            WiFi.dnsIP(0), WiFi.dnsIP(1), mode != WifiConnectMode::Lease);
+    }
+    return connected;
+}
+
 /**
  * @brief Starts the access point mode.
  *
@@ -149,24 +191,85 @@ void WiFiManager::setServerCallback() {
 
     // New routes for Alarm and RTC settings
     // Endpoint to get both alarm and RTC settings
-    server.on("/getSettings", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        // Create a JSON document
-        DynamicJsonDocument doc(1024);
-        
-        // Fill the JSON with alarm and RTC data
-        JsonObject alarm = doc.createNestedObject("alarm");
-        alarm["date"] = configManager->GetString(ALERT_DATE_, "2025-01-01");
-        alarm["time"] = configManager->GetString(ALERT_TIME_, "00:00");
-
-        JsonObject rtc = doc.createNestedObject("rtc");
-        RTC->update(); // update the containing variables
-        rtc["date"] = RTC->getDate();
-        rtc["time"] = RTC->getTime();
-
-        // Send the response as JSON
-        String response;
-        serializeJson(doc, response);
-        request->send(200, "application/json", response);
+    server.on("/getSettings", HTTP_GET, [this](AsyncWebServerRequest *request) { handleGetSettings(request); });
+
+    // Endpoint reporting the hot-path counters of the portal
+    server.on("/getPortalStats", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        const PortalCounters& counters = settingsCounters;
+        char response[256];
+        JsonWriter json(response, sizeof(response));
+
+        json.beginObject();
+        json.beginObject("getSettings");
+        json.addInt("requests", counters.requests);
+        json.addInt("rebuilds", counters.rebuilds);
+        json.addInt("alarmReloads", counters.alarmReloads);
+        json.addInt("lastUs", counters.lastMicros);
+        json.addInt("avgUs", counters.requests ? counters.totalMicros / counters.requests : 0);
+        json.addInt("maxUs", counters.maxMicros);
+        json.addInt("lastHeap", counters.lastHeapBytes);
+        json.addInt("maxHeap", counters.maxHeapBytes);
+        json.endObject();
+        json.endObject();
+
+        sendReport(request, json);
+    });
+
+    // Endpoint reporting the charge consumption accounted by the energy meter
+    server.on("/getEnergy", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        EnergyReport report = EnergyMeter::report();
+        const EnergyLedger& ledger = EnergyMeter::ledger();
+        char response[WEB_JSON_MAX_BYTES];
+        JsonWriter json(response, sizeof(response));
+
+        json.beginObject();
+        json.addFloat("mahPerDay", report.mahPerDay);
+        json.addFloat("batteryDays", report.batteryDays, 1);
+        json.addInt("batteryMah", EnergyMeter::model().batteryMah);
+        json.addFloat("hours", report.elapsedMicros / 3600e6);
+        json.addInt("boots", report.boots);
+        json.addBool("lightSleep", EventLoop::lightSleepEnabled());  // false: waits are plain halts, charged as active
+
+        json.beginObject("phases");
+        for (uint8_t i = 0; i < ENERGY_PHASE_COUNT; i++) {
+            json.beginObject(EnergyMeter::phaseName((EnergyPhase)i));
+            json.addFloat("seconds", ledger.phaseMicros[i] / 1e6);
+            json.addFloat("mAh", ledger.chargeNc[i] / 3.6e9, 6);
+            json.endObject();
+        }
+        json.endObject();
+        json.endObject();
+
+        sendReport(request, json);
+    });
+
+    server.on("/getProfile", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        const WakeProfileRing& ring = WakeProfiler::ring();
+        char response[WEB_JSON_MAX_BYTES];
+        JsonWriter json(response, sizeof(response));
+
+        json.beginObject();
+        json.addInt("runs", ring.wakes);
+        json.addInt("window", ring.count);
+
+        json.beginObject("phases");
+        for (uint8_t i = 0; i < PROFILE_POINT_COUNT; i++) {
+            ProfileStats stats = WakeProfiler::stats((ProfilePoint)i);
+            if (stats.samples == 0) continue;
+            json.beginObject(WakeProfiler::pointName((ProfilePoint)i));
+            json.addInt("n", stats.samples);
+            json.addFloat("minMs", stats.minMicros / 1000.0);
+            json.addFloat("avgMs", stats.avgMicros / 1000.0);
+            json.addFloat("maxMs", stats.maxMicros / 1000.0);
+            json.beginArray("hist");
+            for (uint8_t b = 0; b < PROFILER_BUCKETS; b++) json.addInt(nullptr, stats.buckets[b]);
+            json.endArray();
+            json.endObject();
+        }
+        json.endObject();
+        json.endObject();
+
+        sendReport(request, json);
     });
 
     server.on("/setAlarm", HTTP_POST, [this](AsyncWebServerRequest *request) {}, 
@@ -174,97 +277,95 @@ void WiFiManager::setServerCallback() {
             if (DEBUGMODE) Serial.println("Handling Alarm set request");
             esp_task_wdt_reset();
             
-            static String jsonData;
-            jsonData += String((char*)data, len);
+            // Chunks are copied into this request's own buffer (freed with the request)
+            RequestBody* body = RequestBody::collect(request->_tempObject, data, len, index, total);
 
             // Check if we've received the complete data
             if (index + len == total) {
                 esp_task_wdt_reset();
-                
-                if (DEBUGMODE) {
-                    Serial.println("Received complete data for Alarm settings, processing...");
-                    Serial.println("jsonData content: " + jsonData);
-                }
 
-                // Parse the JSON data
-                StaticJsonDocument<200> doc;
-                DeserializationError error = deserializeJson(doc, jsonData);
-                
-                if (error) {
-                    if (DEBUGMODE) Serial.println("Failed to parse JSON");
-                    request->send(400, "application/json", "{\"error\":\"Invalid JSON format\"}");
-                    jsonData = "";  // Clear static String for next request
+                if (body == nullptr) {
+                    request->send(413, "application/json", "{\"error\":\"Request body too large\"}");
                     return;
                 }
+                if (DEBUGMODE) {
+                    Serial.println("Received complete data for Alarm settings, processing...");
+                    Serial.println(String("Body content: ") + body->text());
+                }
 
-                String alarmDate = doc["alarmDate"].as<String>();
-                String alarmTime = doc["alarmTime"].as<String>();
+                // Parse the JSON data straight from the request buffer (optional fields keep these defaults)
+                AlarmRequest alarmRequest = {};
+                strlcpy(alarmRequest.pattern, "classic", sizeof(alarmRequest.pattern));
+                JsonError error = JsonCodec::parse(body->text(), body->length(), alarmRequest);
 
-                if (alarmDate.isEmpty() || alarmTime.isEmpty()) {
+                if (error == JsonError::Missing) {
                     request->send(400, "application/json", "{\"error\":\"Missing alarmDate or alarmTime\"}");
-                    jsonData = "";  // Clear static String for next request
                     return;
                 }
+                if (error != JsonError::Ok) {
+                    if (DEBUGMODE) Serial.println("Failed to parse JSON");
+                    request->send(400, "application/json", String("{\"error\":\"Invalid JSON format (") + JsonCodec::errorName(error) + ")\"}");
+                    return;
+                }
+
+                const char* alarmDate = alarmRequest.alarmDate;
+                const char* alarmTime = alarmRequest.alarmTime;
 
                 // Debug output
                 if (DEBUGMODE)Serial.println("################################");
                 if (DEBUGMODE)Serial.println("Alarm Time Set by USER");
-                if (DEBUGMODE)Serial.println("Alarm Date: " + alarmDate);
-                if (DEBUGMODE)Serial.println("Alarm Time: " + alarmTime);
+                if (DEBUGMODE)Serial.printf("Alarm Date: %s\n", alarmDate);
+                if (DEBUGMODE)Serial.printf("Alarm Time: %s\n", alarmTime);
                 if (DEBUGMODE)Serial.println("################################");
 
-                // Manually parse the date and time strings (format: "YYYY-MM-DD" and "HH:MM")
-                int year = alarmDate.substring(0, 4).toInt();
-                int month = alarmDate.substring(5, 7).toInt();
-                int day = alarmDate.substring(8, 10).toInt();
-                int hour = alarmTime.substring(0, 2).toInt();
-                int minute = alarmTime.substring(3, 5).toInt();
-                int second = 0;
-
-                // Debug output
-                if (DEBUGMODE)Serial.println("Parsed Alarm Date and Time:");
-                if (DEBUGMODE)Serial.println("Year: " + String(year));
-                if (DEBUGMODE)Serial.println("Month: " + String(month));
-                if (DEBUGMODE)Serial.println("Day: " + String(day));
-                if (DEBUGMODE)Serial.println("Hour: " + String(hour));
-                if (DEBUGMODE)Serial.println("Minute: " + String(minute));
-                if (DEBUGMODE)Serial.println("Second: " + String(second));
-
-                // Create a tm struct and set its fields
-                struct tm timeStruct = {};
-                timeStruct.tm_year = year - 1900;  // tm_year is years since 1900
-                timeStruct.tm_mon = month - 1;     // tm_mon is 0-based
-                timeStruct.tm_mday = day;
-                timeStruct.tm_hour = hour;
-                timeStruct.tm_min = minute;
-                timeStruct.tm_sec = second;
-
-                // Convert to Unix timestamp
-                time_t alarmTimeUnix = mktime(&timeStruct);
-                if (alarmTimeUnix == -1) {
-                    if (DEBUGMODE) Serial.println("Failed to convert time to Unix timestamp");
+                // Validate the date and time and convert them to a Unix timestamp
+                uint32_t alarmTimeUnix = 0;
+                if (!CivilTime::parse(alarmDate, alarmTime, alarmTimeUnix)) {
+                    if (DEBUGMODE) Serial.println("Invalid alarm date or time");
                     request->send(400, "application/json", "{\"error\":\"Invalid alarm time\"}");
-                    jsonData = "";  // Clear static String for next request
                     return;
                 }
 
-                // Store alarm date, time, and Unix timestamp in preferences
-                configManager->PutString(ALERT_DATE_, alarmDate);
-                configManager->PutString(ALERT_TIME_, alarmTime);
-                configManager->PutULong64(ALERT_TIMESTAMP_SAVED, alarmTimeUnix);
+                // Build the alarm rule (optional fields default to a single one-shot alarm)
+                AlarmEntry rule = {};
+                rule.start = alarmTimeUnix;
+                int repeat = AlarmSchedule::parseRepeat(alarmRequest.repeat);
+                rule.weekdays = alarmRequest.weekdays;
+                rule.interval = alarmRequest.interval * 60UL;  // Minutes
+                int pattern = PatternEngine::find(alarmRequest.pattern);
+                if (repeat < 0) {
+                    request->send(400, "application/json", "{\"error\":\"Unknown repeat rule\"}");
+                    return;
+                }
+                if (pattern < 0) {
+                    request->send(400, "application/json", "{\"error\":\"Unknown pattern\"}");
+                    return;
+                }
+                rule.repeat = repeat;
+                rule.pattern = pattern;
+
+                // Store the alarm table, alarm date, time and next fire time in preferences
+                if (configManager->StoreAlarm(rule, alarmRequest.add, RTC->getUnixTime()) < 0) {
+                    request->send(400, "application/json", "{\"error\":\"Alarm rejected\"}");
+                    return;
+                }
+                // The portal shows HH:MM; the exact second lives in the alarm rule
+                char alertTime[6];
+                CivilTime::formatTime(alarmTimeUnix, alertTime);
+                configManager->Put<ConfigField::AlertDate>(alarmDate);
+                configManager->Put<ConfigField::AlertTime>(alertTime);
+                configManager->commit();  // Persist the new alarm right away
                 // Debug output before saving values
                 if (DEBUGMODE)Serial.println("#########################################");
-                if (DEBUGMODE)Serial.println("Saving Alert Date: " + alarmDate);
-                if (DEBUGMODE)Serial.println("Saving Alert Time: " + alarmTime);
-                if (DEBUGMODE)Serial.println("Saving Alert Unix Timestamp: " + String(alarmTimeUnix));
+                if (DEBUGMODE)Serial.printf("Saving Alert Date: %s\n", alarmDate);
+                if (DEBUGMODE)Serial.printf("Saving Alert Time: %s\n", alertTime);
+                if (DEBUGMODE)Serial.printf("Saving Alert Unix Timestamp: %lu\n", (unsigned long)alarmTimeUnix);
                 if (DEBUGMODE)Serial.println("#########################################");
                 esp_task_wdt_reset();  // Reset the watchdog timer to prevent a system reset
 
                 // Respond with success message
                 String successResponse = "{\"success\":true}";
                 request->send(200, "application/json", successResponse);
-
-                jsonData = "";  // Clear static String for next request
             }
         }
     );
@@ -274,70 +375,55 @@ void WiFiManager::setServerCallback() {
             if (DEBUGMODE) Serial.println("Handling RTC set request");
             esp_task_wdt_reset();
             
-            static String jsonData;
-            jsonData += String((char*)data, len);
+            // Chunks are copied into this request's own buffer (freed with the request)
+            RequestBody* body = RequestBody::collect(request->_tempObject, data, len, index, total);
 
             // Check if we've received the complete data
             if (index + len == total) {
                 esp_task_wdt_reset();
-                
-                if (DEBUGMODE) {
-                    Serial.println("Received complete data for RTC settings, processing...");
-                    Serial.println("jsonData content: " + jsonData);
-                }
 
-                // Parse the JSON data
-                StaticJsonDocument<200> doc;
-                DeserializationError error = deserializeJson(doc, jsonData);
-                
-                if (error) {
-                    if (DEBUGMODE) Serial.println("Failed to parse JSON");
-                    request->send(400, "application/json", "{\"error\":\"Invalid JSON format\"}");
-                    jsonData = "";  // Clear static String for next request
+                if (body == nullptr) {
+                    request->send(413, "application/json", "{\"error\":\"Request body too large\"}");
                     return;
                 }
+                if (DEBUGMODE) {
+                    Serial.println("Received complete data for RTC settings, processing...");
+                    Serial.println(String("Body content: ") + body->text());
+                }
 
-                String rtcDate = doc["rtcDate"].as<String>();
-                String rtcTime = doc["rtcTime"].as<String>();
+                // Parse the JSON data straight from the request buffer
+                RtcRequest rtcRequest = {};
+                JsonError error = JsonCodec::parse(body->text(), body->length(), rtcRequest);
 
-                if (rtcDate.isEmpty() || rtcTime.isEmpty()) {
+                if (error == JsonError::Missing) {
                     request->send(400, "application/json", "{\"error\":\"Missing rtcDate or rtcTime\"}");
-                    jsonData = "";  // Clear static String for next request
+                    return;
+                }
+                if (error != JsonError::Ok) {
+                    if (DEBUGMODE) Serial.println("Failed to parse JSON");
+                    request->send(400, "application/json", String("{\"error\":\"Invalid JSON format (") + JsonCodec::errorName(error) + ")\"}");
                     return;
                 }
 
                 // Debug output
                 if (DEBUGMODE)Serial.println("################################");
                 if (DEBUGMODE)Serial.println("RTC Time Set by USER");
-                if (DEBUGMODE)Serial.println("RTC Date: " + rtcDate);
-                if (DEBUGMODE)Serial.println("RTC Time: " + rtcTime);
+                if (DEBUGMODE)Serial.printf("RTC Date: %s\n", rtcRequest.rtcDate);
+                if (DEBUGMODE)Serial.printf("RTC Time: %s\n", rtcRequest.rtcTime);
                 if (DEBUGMODE)Serial.println("################################");
 
-                // Combine date and time into a single string
-                String dateTimeString = rtcDate + " " + rtcTime;
-                struct tm timeStruct;
-                
-                // Manually parse the date and time strings (format: "YYYY-MM-DD" and "HH:MM")
-                int year = rtcDate.substring(0, 4).toInt();
-                int month = rtcDate.substring(5, 7).toInt();
-                int day = rtcDate.substring(8, 10).toInt();
-                int hour = rtcTime.substring(0, 2).toInt();
-                int minute = rtcTime.substring(3, 5).toInt();
-                int second = 0;
-
-                // Debug output
-                if (DEBUGMODE)Serial.println("Parsed Date and Time:");
-                if (DEBUGMODE)Serial.println("Year: " + String(year));
-                if (DEBUGMODE)Serial.println("Month: " + String(month));
-                if (DEBUGMODE)Serial.println("Day: " + String(day));
-                if (DEBUGMODE)Serial.println("Hour: " + String(hour));
-                if (DEBUGMODE)Serial.println("Minute: " + String(minute));
-                if (DEBUGMODE)Serial.println("Second: " + String(second));
-
-                // Set the RTC time using the parsed values
-                RTC->setRTCTime(year, month, day, hour, minute, second);
-                configManager->PutULong64(CURRENT_TIME_SAVED, RTC->getUnixTime());
-                configManager->PutULong64(LAST_TIME_SAVED, RTC->getUnixTime());
+                // Validate the date and time (format: "YYYY-MM-DD" and "HH:MM[:SS]") and set the RTC
+                CivilDateTime rtcTime = {};
+                if (!CivilTime::parseDate(rtcRequest.rtcDate, strlen(rtcRequest.rtcDate), rtcTime) ||
+                    !CivilTime::parseTime(rtcRequest.rtcTime, strlen(rtcRequest.rtcTime), rtcTime) ||
+                    !RTC->setRTCTime(rtcTime.year, rtcTime.month, rtcTime.day, rtcTime.hour, rtcTime.minute, rtcTime.second)) {
+                    if (DEBUGMODE) Serial.println("Invalid RTC date or time");
+                    request->send(400, "application/json", "{\"error\":\"Invalid RTC time\"}");
+                    return;
+                }
+                settingsMinute = -1;  // The cached /getSettings clock is stale
+                configManager->SaveTime(RTC->getUnixTime(), RTC->getUnixTime());
+                configManager->commit();  // Persist the new time right away
 
                 // Debug output for current and last saved time
                 if (DEBUGMODE)Serial.println("################################################################");
@@ -349,14 +435,11 @@ void WiFiManager::setServerCallback() {
                 // Respond with success message
                 String successResponse = "{\"success\":true}";
                 request->send(200, "application/json", successResponse);
-
-                jsonData = "";  // Clear static String for next request
             }
         }
     );
 
-    // Serve static files like icons, CSS, JS, etc.
-    server.serveStatic("/icons/", SPIFFS, "/icons/").setCacheControl("max-age=86400");
+    // Icons are inlined into the embedded pages, nothing else is served statically
     esp_task_wdt_reset(); // Reset the watchdog timer to prevent a system reset
 
     // Start the server
@@ -395,7 +478,7 @@ void WiFiManager::handleReset(AsyncWebServerRequest* request) {
     if (DEBUGMODE) {
         Serial.println("WiFiManager: setting rst flag");
     };
-    configManager->PutBool(RESET_FLAG, true);
+    configManager->Put<ConfigField::ResetFlag>(true);
     esp_task_wdt_reset(); // Reset the watchdog timer to prevent a system reset
     delay(1000);  // Wait briefly
     configManager->RestartSysDelay(3000);  // Restart the system after 3 seconds
@@ -428,8 +511,7 @@ void WiFiManager::handleRestart(AsyncWebServerRequest* request) {
 
     // Send the JavaScript response to the client
     request->send(200, "text/html", response);
-    configManager->PutULong64(CURRENT_TIME_SAVED, RTC->getUnixTime());// save time before restarting
-    configManager->PutULong64(LAST_TIME_SAVED, RTC->getUnixTime());// save time before restarting
+    configManager->SaveTime(RTC->getUnixTime(), RTC->getUnixTime());// save time before restarting
     // Trigger the system restart
     esp_task_wdt_reset(); // Reset the watchdog timer to prevent a system reset
     delay(1000);  // Wait briefly
@@ -437,6 +519,122 @@ void WiFiManager::handleRestart(AsyncWebServerRequest* request) {
 }
 
 
+/**
+ * @brief Sends an embedded page, or 304 when the client already has it.
+ *
+ * The body is stored gzipped in flash and sent as is with
+ * `Content-Encoding: gzip` (every browser accepts it). The strong ETag is a
+ * hash of that body, so `Cache-Control: no-cache` lets the browser keep the
+ * page and revalidate it in one small request; a firmware update changes the
+ * ETag and the new page is fetched. `If-None-Match` is matched tag by tag
+ * (see EntityTag), not as a substring.
+ *
+ * @param request The incoming web request.
+ * @param asset The embedded page (WebAssets.h).
+ */
+void WiFiManager::sendAsset(AsyncWebServerRequest* request, const WebAsset& asset) {
+    AsyncWebServerResponse* response;
+    if (request->hasHeader("If-None-Match") &&
+        EntityTag::matches(request->getHeader("If-None-Match")->value().c_str(), asset.etag)) {
+        response = request->beginResponse(304);
+    } else {
+        response = request->beginResponse_P(200, asset.type, asset.data, asset.length);
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
+/**
+ * @brief Sends a report built with JsonWriter.
+ *
+ * A report that did not fit its buffer is cut off and no longer valid
+ * JSON, so it is answered with 500 instead.
+ *
+ * @param request The incoming web request.
+ * @param json The finished report.
+ */
+void WiFiManager::sendReport(AsyncWebServerRequest* request, const JsonWriter& json) {
+    if (!json.ok()) {
+        if (DEBUGMODE)Serial.println("WiFiManager: Report does not fit its buffer");
+        request->send(500, "application/json", "{\"error\":\"Report too large\"}");
+        return;
+    }
+    request->send(200, "application/json", json.c_str());
+}
+
+/**
+ * @brief Answers /getSettings from the cached reply.
+ *
+ * The settings page polls this endpoint, so the reply is kept rendered:
+ * the alarm part is read again only when the settings revision changes,
+ * the clock part once per minute (it shows HH:MM), from the strings
+ * RTCManager keeps formatted (empty while the clock is unset). The
+ * response gets its own copy of the body (an AsyncResponseStream): the
+ * server sends a response lazily, as the TCP window allows, so it must not
+ * point into the shared buffer the next request renders into.
+ *
+ * @param request The incoming web request.
+ */
+void WiFiManager::handleGetSettings(AsyncWebServerRequest* request) {
+    uint32_t start = micros();
+    uint32_t heapBefore = ESP.getFreeHeap();
+
+    refreshSettings();
+    AsyncResponseStream* response = request->beginResponseStream("application/json", settingsLength);
+    response->write((const uint8_t*)settingsBody, settingsLength);
+    request->send(response);
+
+    PortalCounters& counters = settingsCounters;
+    counters.requests++;
+    counters.lastHeapBytes = (int32_t)(heapBefore - ESP.getFreeHeap());
+    if (counters.lastHeapBytes > counters.maxHeapBytes) counters.maxHeapBytes = counters.lastHeapBytes;
+    counters.lastMicros = micros() - start;
+    if (counters.lastMicros > counters.maxMicros) counters.maxMicros = counters.lastMicros;
+    counters.totalMicros += counters.lastMicros;
+}
+
+/**
+ * @brief Renders the /getSettings reply again if one of its parts changed.
+ *
+ * @return true if the reply was rendered.
+ */
+bool WiFiManager::refreshSettings() {
+    bool changed = false;
+    if (settingsLength == 0 || configManager->revision() != settingsRevision) {
+        strlcpy(settingsReply.alarm.date, configManager->Get<ConfigField::AlertDate>(), sizeof(settingsReply.alarm.date));
+        strlcpy(settingsReply.alarm.time, configManager->Get<ConfigField::AlertTime>(), sizeof(settingsReply.alarm.time));
+        settingsRevision = configManager->revision();  // After the reads, which may load the settings
+        settingsCounters.alarmReloads++;
+        changed = true;
+    }
+
+    uint32_t now = RTC->getUnixTime();  // 0 while the clock is unset
+    if (changed || now / 60 != settingsMinute) {
+        strlcpy(settingsReply.rtc.date, RTC->getDate(), sizeof(settingsReply.rtc.date));
+        strlcpy(settingsReply.rtc.time, RTC->getTime(), sizeof(settingsReply.rtc.time));
+        settingsMinute = now / 60;
+        changed = true;
+    }
+    if (!changed) return false;
+
+    JsonWriter json(settingsBody, sizeof(settingsBody));
+    JsonCodec::write(json, settingsReply);
+    settingsLength = json.length();
+    settingsCounters.rebuilds++;
+    return true;
+}
+
+/**
+ * @brief Gives the counters of the /getSettings handler.
+ *
+ * @return The counters since the portal started.
+ */
+const PortalCounters& WiFiManager::getSettingsCounters() const {
+    return settingsCounters;
+}
+
 /**
  * @brief Handles requests to the Settings endpoint.
  *
@@ -447,7 +645,7 @@ void WiFiManager::handleSettings(AsyncWebServerRequest* request) {
         Serial.println("WiFiManager: Handling Settings root request");
     };
 
-    request->send(SPIFFS, "/BoardSetting.html", "text/html");
+    sendAsset(request, WEB_BOARD_SETTING);
 }
 /**
  * @brief Handles requests to the root endpoint.
@@ -459,7 +657,7 @@ void WiFiManager::handleRoot(AsyncWebServerRequest* request) {
         Serial.println("WiFiManager: Handling welcome root request");
     }
 
-    request->send(SPIFFS, "/welcome.html", "text/html");
+    sendAsset(request, WEB_WELCOME);
 }
 
 /**
@@ -472,7 +670,7 @@ void WiFiManager::handleSetWiFi(AsyncWebServerRequest* request) {
         Serial.println("WiFiManager: Handling set wifi request");
     }
 
-    request->send(SPIFFS, "/wifiCredentialsPage.html", "text/html");
+    sendAsset(request, WEB_WIFI_CREDENTIALS);
 }
 /**
  * @brief Handles saving the Wi-Fi credentials.
@@ -499,12 +697,11 @@ void WiFiManager::handleSaveWiFi(AsyncWebServerRequest* request) {
             // Formatted message
             char text[50]; // Ensure this is large enough to hold your formatted string
             sprintf(text, "WiFiManager: Saving Wifi Credentials...");
-            configManager->PutString(WIFISSID, ssid);
-            configManager->PutString(WIFIPASS, password);
-            request->send(SPIFFS, "/thankyou_page.html", "text/html");
+            configManager->Put<ConfigField::WifiSsid>(ssid);
+            configManager->Put<ConfigField::WifiPass>(password);
+            sendAsset(request, WEB_THANK_YOU);
             sprintf(text, "WiFiManager: Device Restarting in 3 Sec");
-            configManager->PutULong64(CURRENT_TIME_SAVED, RTC->getUnixTime());// save time before restarting
-            configManager->PutULong64(LAST_TIME_SAVED, RTC->getUnixTime());// save time before restarting
+            configManager->SaveTime(RTC->getUnixTime(), RTC->getUnixTime());// save time before restarting
             configManager->RestartSysDelay(3000);
         } else {
             request->send(400, "text/plain", "Invalid SSID or Password.");
@@ -537,4 +734,15 @@ uint8_t WiFiManager::getSignalStrengthPercent() {
  */
 bool WiFiManager::isStillConnected() {
     return WiFi.status() == WL_CONNECTED;
+}
+
+/**
+ * @brief Disconnects the station and turns the radio off.
+ *
+ * Called once the time is synchronized, so the rest of the wake (alarm
+ * indication included) can light sleep between events.
+ */
+void WiFiManager::disconnect() {
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
 }
\ No newline at end of file
@@ -0,0 +1,384 @@
+/**
+ * @file test_main.cpp
+ * @brief AlarmSchedule rules, heap ordering, exceptions, table format and a
+ *        10k-alarm benchmark over a decade.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "AlarmSchedule.h"
+#include "CivilTime.h"
+#include "Crc32.h"
+
+#define DAY 86400UL
+#define HOUR 3600UL
+
+// 2025-01-15 00:00 (a Wednesday)
+static const uint32_t kStart = (uint32_t)daysFromCivil(2025, 1, 15) * DAY;
+
+// Layout of the serialized header (private to AlarmSchedule.cpp)
+struct TableHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint16_t exceptionCount;
+    uint16_t nextId;
+    uint32_t crc;
+};
+
+static AlarmEntry rule(uint8_t repeat, uint32_t start, uint32_t interval = 0, uint8_t weekdays = 0) {
+    AlarmEntry entry = {};
+    entry.repeat = repeat;
+    entry.start = start;
+    entry.interval = interval;
+    entry.weekdays = weekdays;
+    return entry;
+}
+
+// Deterministic pseudo-random numbers
+static uint32_t nextRandom(uint32_t& seed) {
+    seed = seed * 1664525UL + 1013904223UL;
+    return seed >> 8;
+}
+
+static AlarmEntry randomRule(uint32_t& seed, uint32_t from, uint32_t span) {
+    uint32_t start = from + nextRandom(seed) % span;
+    switch (nextRandom(seed) % 10) {
+        case 0: case 1: case 2: case 3:
+            return rule(ALARM_ONCE, start);
+        case 4: case 5: case 6:
+            return rule(ALARM_WEEKLY, start, 0, (uint8_t)(nextRandom(seed) % 127 + 1));
+        case 7: case 8:
+            return rule(ALARM_DAILY, start);
+        default:
+            return rule(ALARM_INTERVAL, start, (nextRandom(seed) % 30 + 1) * DAY + nextRandom(seed) % DAY);
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_weekday_and_repeat_names() {
+    TEST_ASSERT_EQUAL_UINT8(4, AlarmSchedule::weekday(0));  // 1970-01-01 was a Thursday
+    TEST_ASSERT_EQUAL_UINT8(3, AlarmSchedule::weekday(kStart / DAY));
+    TEST_ASSERT_EQUAL(ALARM_ONCE, AlarmSchedule::parseRepeat(nullptr));
+    TEST_ASSERT_EQUAL(ALARM_ONCE, AlarmSchedule::parseRepeat(""));
+    TEST_ASSERT_EQUAL(ALARM_DAILY, AlarmSchedule::parseRepeat("daily"));
+    TEST_ASSERT_EQUAL(ALARM_WEEKLY, AlarmSchedule::parseRepeat("weekly"));
+    TEST_ASSERT_EQUAL(ALARM_INTERVAL, AlarmSchedule::parseRepeat("interval"));
+    TEST_ASSERT_EQUAL(-1, AlarmSchedule::parseRepeat("monthly"));
+}
+
+static void test_next_occurrence_of_each_rule() {
+    uint32_t at7 = kStart + 7 * HOUR;
+    uint32_t noon = kStart + 12 * HOUR;
+
+    TEST_ASSERT_EQUAL_UINT32(at7, AlarmSchedule::nextOccurrence(rule(ALARM_ONCE, at7), kStart, nullptr, 0));
+    TEST_ASSERT_EQUAL_UINT32(ALARM_NEVER, AlarmSchedule::nextOccurrence(rule(ALARM_ONCE, at7), noon, nullptr, 0));
+    TEST_ASSERT_EQUAL_UINT32(at7 + DAY, AlarmSchedule::nextOccurrence(rule(ALARM_DAILY, at7), noon, nullptr, 0));
+    TEST_ASSERT_EQUAL_UINT32(at7 + 3 * HOUR, AlarmSchedule::nextOccurrence(rule(ALARM_INTERVAL, at7, 90 * 60), at7 + 2 * HOUR, nullptr, 0));
+
+    // Monday to Friday from a Wednesday noon: Thursday, then Monday after Friday
+    AlarmEntry weekdays = rule(ALARM_WEEKLY, at7, 0, 0x3E);
+    TEST_ASSERT_EQUAL_UINT32(at7 + DAY, AlarmSchedule::nextOccurrence(weekdays, noon, nullptr, 0));
+    TEST_ASSERT_EQUAL_UINT32(at7 + 5 * DAY, AlarmSchedule::nextOccurrence(weekdays, at7 + 2 * DAY + 1, nullptr, 0));
+    TEST_ASSERT_EQUAL_UINT32(ALARM_NEVER, AlarmSchedule::nextOccurrence(rule(ALARM_WEEKLY, at7, 0, 0), noon, nullptr, 0));
+
+    // End time
+    AlarmEntry bounded = rule(ALARM_DAILY, at7);
+    bounded.until = at7 + DAY;
+    TEST_ASSERT_EQUAL_UINT32(at7 + DAY, AlarmSchedule::nextOccurrence(bounded, noon, nullptr, 0));
+    TEST_ASSERT_EQUAL_UINT32(ALARM_NEVER, AlarmSchedule::nextOccurrence(bounded, at7 + DAY + 1, nullptr, 0));
+}
+
+static void test_heap_fires_rules_in_time_order() {
+    AlarmSchedule schedule(16, 16);
+    const uint32_t offsets[] = {9 * HOUR, 2 * HOUR, 30 * HOUR, 5 * HOUR, 1 * HOUR, 17 * HOUR, 3 * HOUR};
+    for (uint32_t offset : offsets) {
+        TEST_ASSERT_GREATER_THAN(0, schedule.add(rule(ALARM_ONCE, kStart + offset), kStart));
+    }
+    TEST_ASSERT_EQUAL_UINT16(7, schedule.count());
+
+    const uint32_t sorted[] = {1 * HOUR, 2 * HOUR, 3 * HOUR, 5 * HOUR, 9 * HOUR, 17 * HOUR, 30 * HOUR};
+    for (uint32_t offset : sorted) {
+        TEST_ASSERT_EQUAL_UINT32(kStart + offset, schedule.nextFire());
+        TEST_ASSERT_EQUAL_UINT32(kStart + offset, schedule.next()->nextFire);
+        schedule.advance(kStart + offset);
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, schedule.count());
+    TEST_ASSERT_EQUAL_UINT32(ALARM_NEVER, schedule.nextFire());
+    TEST_ASSERT_NULL(schedule.next());
+}
+
+static void test_advance_consumes_due_occurrences() {
+    AlarmSchedule schedule(8, 8);
+    uint32_t at7 = kStart + 7 * HOUR;
+    schedule.add(rule(ALARM_DAILY, at7), kStart);
+    schedule.add(rule(ALARM_ONCE, at7 + HOUR), kStart);
+
+    // Nothing due yet
+    TEST_ASSERT_EQUAL_UINT32(at7, schedule.advance(at7 - 1));
+    TEST_ASSERT_EQUAL_UINT16(2, schedule.count());
+
+    // Woken three days late: both fire once, missed days are not replayed
+    uint32_t late = at7 + 3 * DAY + 5 * HOUR;
+    TEST_ASSERT_EQUAL_UINT32(at7 + 4 * DAY, schedule.advance(late));
+    TEST_ASSERT_EQUAL_UINT16(1, schedule.count());  // The one-shot alarm is gone
+    TEST_ASSERT_EQUAL_UINT8(ALARM_DAILY, schedule.next()->repeat);
+}
+
+static void test_add_rejects_full_table_and_dead_rules() {
+    AlarmSchedule schedule(2, 2);
+    TEST_ASSERT_EQUAL(-1, schedule.add(rule(ALARM_WEEKLY, kStart, 0, 0), kStart));  // No weekday
+    TEST_ASSERT_GREATER_THAN(0, schedule.add(rule(ALARM_DAILY, kStart), kStart));
+    TEST_ASSERT_GREATER_THAN(0, schedule.add(rule(ALARM_ONCE, kStart - DAY), kStart));  // Past one-shot still fires
+    TEST_ASSERT_EQUAL(-1, schedule.add(rule(ALARM_DAILY, kStart), kStart));
+    TEST_ASSERT_EQUAL_UINT32(kStart - DAY, schedule.nextFire());
+}
+
+static void test_exception_skips_a_day() {
+    AlarmSchedule schedule(8, 8);
+    uint32_t at7 = kStart + 7 * HOUR;
+    int daily = schedule.add(rule(ALARM_DAILY, at7), kStart);
+    int later = schedule.add(rule(ALARM_ONCE, at7 + 2 * HOUR), kStart);
+
+    // Skipping today moves the daily alarm behind the one-shot alarm
+    TEST_ASSERT_TRUE(schedule.addException(daily, kStart / DAY, kStart));
+    TEST_ASSERT_EQUAL_UINT32(at7 + 2 * HOUR, schedule.nextFire());
+    TEST_ASSERT_EQUAL_UINT16(later, schedule.next()->id);
+    schedule.advance(at7 + 2 * HOUR);
+    TEST_ASSERT_EQUAL_UINT32(at7 + DAY, schedule.nextFire());
+
+    // Skipping several days in a row, and the same day twice
+    TEST_ASSERT_TRUE(schedule.addException(daily, kStart / DAY + 1, kStart));
+    TEST_ASSERT_TRUE(schedule.addException(daily, kStart / DAY + 2, kStart));
+    TEST_ASSERT_TRUE(schedule.addException(daily, kStart / DAY + 2, kStart));
+    TEST_ASSERT_EQUAL_UINT16(3, schedule.exceptionCount());
+    TEST_ASSERT_EQUAL_UINT32(at7 + 3 * DAY, schedule.nextFire());
+
+    // Unknown alarm
+    TEST_ASSERT_FALSE(schedule.addException(999, kStart / DAY, kStart));
+
+    // Removing the alarm drops its exceptions
+    TEST_ASSERT_TRUE(schedule.remove(daily));
+    TEST_ASSERT_EQUAL_UINT16(0, schedule.exceptionCount());
+    TEST_ASSERT_FALSE(schedule.remove(daily));
+}
+
+static void test_exception_on_a_one_shot_alarm_removes_it() {
+    AlarmSchedule schedule(8, 8);
+    int once = schedule.add(rule(ALARM_ONCE, kStart + 7 * HOUR), kStart);
+    TEST_ASSERT_TRUE(schedule.addException(once, kStart / DAY, kStart));
+    TEST_ASSERT_EQUAL_UINT16(0, schedule.count());
+}
+
+static void test_remove_keeps_heap_order() {
+    AlarmSchedule schedule(32, 4);
+    int ids[20];
+    for (int i = 0; i < 20; i++) {
+        ids[i] = schedule.add(rule(ALARM_ONCE, kStart + (uint32_t)((i * 7) % 20) * HOUR), kStart);
+    }
+    for (int i = 0; i < 20; i += 3) schedule.remove(ids[i]);
+
+    uint32_t previous = 0;
+    while (schedule.count() > 0) {
+        uint32_t fire = schedule.nextFire();
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(previous, fire);
+        previous = fire;
+        schedule.advance(fire);
+    }
+}
+
+static void test_serialize_round_trip() {
+    AlarmSchedule schedule(8, 8);
+    int daily = schedule.add(rule(ALARM_DAILY, kStart + 7 * HOUR), kStart);
+    AlarmEntry weekly = rule(ALARM_WEEKLY, kStart + 8 * HOUR, 0, 0x41);
+    weekly.pattern = 2;
+    schedule.add(weekly, kStart);
+    schedule.addException(daily, kStart / DAY + 1, kStart);
+
+    uint8_t blob[512];
+    size_t length = schedule.serialize(blob, sizeof(blob));
+    TEST_ASSERT_EQUAL_size_t(schedule.serializedSize(), length);
+    TEST_ASSERT_EQUAL_size_t(0, schedule.serialize(blob, length - 1));
+
+    AlarmSchedule loaded(8, 8);
+    TEST_ASSERT_TRUE(loaded.deserialize(blob, length));
+    TEST_ASSERT_EQUAL_UINT16(2, loaded.count());
+    TEST_ASSERT_EQUAL_UINT16(1, loaded.exceptionCount());
+    TEST_ASSERT_EQUAL_MEMORY(schedule.entries(), loaded.entries(), 2 * sizeof(AlarmEntry));
+    TEST_ASSERT_EQUAL(daily + 2, loaded.add(rule(ALARM_ONCE, kStart + DAY), kStart));  // Ids continue
+
+    // Corruption, truncation and a table larger than the capacity are rejected
+    blob[length - 1] ^= 1;
+    TEST_ASSERT_FALSE(loaded.deserialize(blob, length));
+    blob[length - 1] ^= 1;
+    TEST_ASSERT_FALSE(loaded.deserialize(blob, length - 1));
+    AlarmSchedule small(1, 8);
+    TEST_ASSERT_FALSE(small.deserialize(blob, length));
+}
+
+static void test_version_1_table_migrates() {
+    AlarmSchedule schedule(8, 8);
+    int daily = schedule.add(rule(ALARM_DAILY, kStart + 7 * HOUR), kStart);
+    schedule.add(rule(ALARM_INTERVAL, kStart + HOUR, 5 * HOUR), kStart);
+    schedule.addException(daily, kStart / DAY + 2, kStart);
+
+    // Rewrite the table the way version 1 stored it: 20-byte entries, no pattern
+    TableHeader header = {};
+    header.magic = ALARM_TABLE_MAGIC;
+    header.version = 1;
+    header.count = schedule.count();
+    header.exceptionCount = schedule.exceptionCount();
+    header.nextId = daily + 2;
+    uint8_t blob[512];
+    size_t length = sizeof(header);
+    for (uint16_t i = 0; i < schedule.count(); i++) {
+        memcpy(blob + length, &schedule.entries()[i], ALARM_ENTRY_V1_SIZE);
+        length += ALARM_ENTRY_V1_SIZE;
+    }
+    uint32_t exception = ((uint32_t)daily << 16) | (kStart / DAY + 2);
+    memcpy(blob + length, &exception, sizeof(exception));
+    length += sizeof(exception);
+    header.crc = crc32Update(&header, offsetof(TableHeader, crc));
+    header.crc = crc32Update(blob + sizeof(header), length - sizeof(header), header.crc);
+    memcpy(blob, &header, sizeof(header));
+
+    AlarmSchedule loaded(8, 8);
+    TEST_ASSERT_TRUE(loaded.deserialize(blob, length));
+    TEST_ASSERT_EQUAL_UINT16(2, loaded.count());
+    TEST_ASSERT_EQUAL_UINT16(1, loaded.exceptionCount());
+    for (uint16_t i = 0; i < loaded.count(); i++) {
+        TEST_ASSERT_EQUAL_MEMORY(&schedule.entries()[i], &loaded.entries()[i], ALARM_ENTRY_V1_SIZE);
+        TEST_ASSERT_EQUAL_UINT8(0, loaded.entries()[i].pattern);  // Default pattern
+    }
+
+    // The migrated table behaves like the original, including the exception
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT_EQUAL_UINT32(schedule.nextFire(), loaded.nextFire());
+        uint32_t fire = schedule.nextFire();
+        schedule.advance(fire);
+        loaded.advance(fire);
+    }
+
+    // Saving it again writes version 2
+    length = loaded.serialize(blob, sizeof(blob));
+    memcpy(&header, blob, sizeof(header));
+    TEST_ASSERT_EQUAL_UINT16(ALARM_TABLE_VERSION, header.version);
+}
+
+static void test_matches_brute_force_reference() {
+    // 500 random rules with exceptions over two years, checked against a linear scan
+    const uint16_t count = 500;
+    static AlarmEntry reference[500];
+    static uint32_t keys[200];
+    uint16_t keyCount = 0;
+    AlarmSchedule schedule(count, 200);
+    uint32_t seed = 4242;
+    for (uint16_t i = 0; i < count; i++) {
+        reference[i] = randomRule(seed, kStart, 730 * DAY);
+        int id = schedule.add(reference[i], kStart);
+        TEST_ASSERT_GREATER_THAN(0, id);
+        reference[i].id = id;
+    }
+    for (uint16_t i = 0; i < 200; i++) {
+        uint16_t index = nextRandom(seed) % count;
+        uint16_t day = kStart / DAY + nextRandom(seed) % 730;
+        if (schedule.addException(reference[index].id, day, kStart)) {
+            uint32_t key = ((uint32_t)reference[index].id << 16) | day;
+            bool known = false;
+            for (uint16_t k = 0; k < keyCount; k++) known = known || keys[k] == key;
+            if (!known) keys[keyCount++] = key;
+        }
+    }
+    // Reference exception list, sorted like the schedule keeps it
+    for (uint16_t i = 1; i < keyCount; i++) {
+        for (uint16_t j = i; j > 0 && keys[j - 1] > keys[j]; j--) {
+            uint32_t tmp = keys[j];
+            keys[j] = keys[j - 1];
+            keys[j - 1] = tmp;
+        }
+    }
+
+    uint32_t now = kStart;
+    for (int step = 0; step < 3000 && schedule.count() > 0; step++) {
+        uint32_t expected = ALARM_NEVER;
+        for (uint16_t i = 0; i < count; i++) {
+            AlarmEntry& entry = reference[i];
+            uint32_t from = entry.repeat == ALARM_ONCE && step == 0 ? entry.start : now;
+            uint32_t fire = AlarmSchedule::nextOccurrence(entry, from, keys, keyCount);
+            if (fire < expected) expected = fire;
+        }
+        TEST_ASSERT_EQUAL_UINT32(expected, schedule.nextFire());
+        now = expected;
+        schedule.advance(now);
+        now++;
+    }
+}
+
+static void test_benchmark_10k_alarms_over_a_decade() {
+    const uint16_t count = 10000;
+    const uint32_t decade = 3653 * DAY;
+    AlarmSchedule schedule(count, 1000);
+    uint32_t seed = 2025;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint16_t i = 0; i < count; i++) {
+        TEST_ASSERT_GREATER_THAN(0, schedule.add(randomRule(seed, kStart, decade), kStart));
+    }
+    for (uint16_t i = 0; i < 1000; i++) {
+        schedule.addException(schedule.entries()[nextRandom(seed) % count].id,
+                              kStart / DAY + nextRandom(seed) % 3653, kStart);
+    }
+
+    // Fire everything due over the decade; fire times never go backwards
+    auto t1 = std::chrono::steady_clock::now();
+    uint32_t fires = 0;
+    uint32_t previous = 0;
+    uint32_t end = kStart + decade;
+    while (schedule.nextFire() < end) {
+        uint32_t fire = schedule.nextFire();
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(previous, fire);
+        previous = fire;
+        schedule.advance(fire);
+        fires++;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    uint8_t* blob = new uint8_t[schedule.serializedSize()];
+    size_t length = schedule.serialize(blob, schedule.serializedSize());
+    AlarmSchedule loaded(count, 1000);
+    TEST_ASSERT_TRUE(loaded.deserialize(blob, length));
+    auto t3 = std::chrono::steady_clock::now();
+    delete[] blob;
+    TEST_ASSERT_EQUAL_UINT32(schedule.nextFire(), loaded.nextFire());
+
+    double addMicros = std::chrono::duration<double, std::micro>(t1 - t0).count();
+    double fireMicros = std::chrono::duration<double, std::micro>(t2 - t1).count();
+    double loadMicros = std::chrono::duration<double, std::micro>(t3 - t2).count();
+    char message[160];
+    snprintf(message, sizeof(message), "%u alarms: add %.3f us each, %lu fires at %.3f us each, save+load %.0f us",
+             count, addMicros / count, (unsigned long)fires, fireMicros / fires, loadMicros);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN_UINT32(count, fires);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_weekday_and_repeat_names);
+    RUN_TEST(test_next_occurrence_of_each_rule);
+    RUN_TEST(test_heap_fires_rules_in_time_order);
+    RUN_TEST(test_advance_consumes_due_occurrences);
+    RUN_TEST(test_add_rejects_full_table_and_dead_rules);
+    RUN_TEST(test_exception_skips_a_day);
+    RUN_TEST(test_exception_on_a_one_shot_alarm_removes_it);
+    RUN_TEST(test_remove_keeps_heap_order);
+    RUN_TEST(test_serialize_round_trip);
+    RUN_TEST(test_version_1_table_migrates);
+    RUN_TEST(test_matches_brute_force_reference);
+    RUN_TEST(test_benchmark_10k_alarms_over_a_decade);
+    return UNITY_END();
+}
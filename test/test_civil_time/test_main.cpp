@@ -0,0 +1,237 @@
+/**
+ * @file test_main.cpp
+ * @brief CivilTime parsing, validation, conversion and formatting over the
+ *        whole 32-bit range (1970-01-01 to 2106-02-07 06:28:15), plus a
+ *        microbenchmark against mktime()/strftime().
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include "CivilTime.h"
+
+#define DAY 86400UL
+#define LAST_DAY 49710UL  // 2106-02-07
+
+static CivilDateTime civil(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t minute = 0, uint8_t second = 0) {
+    CivilDateTime value = {year, month, day, hour, minute, second};
+    return value;
+}
+
+static bool dateAccepted(const char* text) {
+    CivilDateTime value = {};
+    return CivilTime::parseDate(text, strlen(text), value);
+}
+
+static bool timeAccepted(const char* text) {
+    CivilDateTime value = {};
+    return CivilTime::parseTime(text, strlen(text), value);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_every_day_round_trips_against_gmtime() {
+    for (uint32_t day = 0; day <= LAST_DAY; day++) {
+        uint32_t timestamp = day * DAY;
+        time_t reference = timestamp;
+        struct tm expected;
+        gmtime_r(&reference, &expected);
+
+        CivilDateTime value = CivilTime::fromUnix(timestamp);
+        TEST_ASSERT_EQUAL_UINT16(expected.tm_year + 1900, value.year);
+        TEST_ASSERT_EQUAL_UINT8(expected.tm_mon + 1, value.month);
+        TEST_ASSERT_EQUAL_UINT8(expected.tm_mday, value.day);
+        TEST_ASSERT_EQUAL_INT32(day, daysFromCivil(value.year, value.month, value.day));
+
+        char text[11];
+        char expectedText[16];
+        CivilTime::formatDate(timestamp, text);
+        strftime(expectedText, sizeof(expectedText), "%Y-%m-%d", &expected);
+        TEST_ASSERT_EQUAL_STRING(expectedText, text);
+
+        uint32_t parsed = 0;
+        TEST_ASSERT_TRUE(CivilTime::parse(text, "00:00", parsed));
+        TEST_ASSERT_EQUAL_UINT32(timestamp, parsed);
+    }
+}
+
+static void test_every_time_of_day_round_trips() {
+    for (uint32_t second = 0; second < DAY; second++) {
+        char text[9];
+        CivilDateTime value = {};
+        CivilTime::formatTime(second, text, true);
+        TEST_ASSERT_TRUE(CivilTime::parseTime(text, 8, value));
+        TEST_ASSERT_EQUAL_UINT32(second, value.hour * 3600UL + value.minute * 60UL + value.second);
+
+        CivilTime::formatTime(second, text);
+        TEST_ASSERT_EQUAL_size_t(5, strlen(text));
+        TEST_ASSERT_TRUE(CivilTime::parseTime(text, 5, value));
+        TEST_ASSERT_EQUAL_UINT8(0, value.second);
+    }
+}
+
+static void test_whole_range_round_trips() {
+    // Every 997th second (prime stride, so every time of day is hit) and the last day entirely
+    uint32_t timestamp = 0;
+    for (uint64_t t = 0; t <= 0xFFFFFFFFULL; t += 997) {
+        timestamp = (uint32_t)t;
+        uint32_t back = 0;
+        TEST_ASSERT_TRUE(CivilTime::toUnix(CivilTime::fromUnix(timestamp), back));
+        TEST_ASSERT_EQUAL_UINT32(timestamp, back);
+    }
+    for (uint64_t t = LAST_DAY * DAY; t <= 0xFFFFFFFFULL; t++) {
+        uint32_t back = 0;
+        TEST_ASSERT_TRUE(CivilTime::toUnix(CivilTime::fromUnix((uint32_t)t), back));
+        TEST_ASSERT_EQUAL_UINT32((uint32_t)t, back);
+    }
+}
+
+static void test_range_limits() {
+    uint32_t timestamp = 1;
+    TEST_ASSERT_TRUE(CivilTime::parse("1970-01-01", "00:00", timestamp));
+    TEST_ASSERT_EQUAL_UINT32(0, timestamp);
+    TEST_ASSERT_TRUE(CivilTime::parse("2106-02-07", "06:28:15", timestamp));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFUL, timestamp);
+    TEST_ASSERT_FALSE(CivilTime::parse("2106-02-07", "06:28:16", timestamp));
+    TEST_ASSERT_FALSE(CivilTime::parse("2106-02-08", "00:00", timestamp));
+    TEST_ASSERT_FALSE(CivilTime::parse("1969-12-31", "23:59:59", timestamp));
+    TEST_ASSERT_FALSE(CivilTime::parse(nullptr, "00:00", timestamp));
+    TEST_ASSERT_FALSE(CivilTime::parse("2025-01-01", nullptr, timestamp));
+
+    TEST_ASSERT_FALSE(CivilTime::toUnix(civil(2106, 12, 31), timestamp));
+    TEST_ASSERT_FALSE(CivilTime::toUnix(civil(1969, 12, 31, 23, 59, 59), timestamp));
+}
+
+static void test_leap_days() {
+    TEST_ASSERT_TRUE(dateAccepted("2024-02-29"));
+    TEST_ASSERT_TRUE(dateAccepted("2000-02-29"));  // Divisible by 400
+    TEST_ASSERT_FALSE(dateAccepted("2100-02-29"));  // Divisible by 100
+    TEST_ASSERT_FALSE(dateAccepted("2025-02-29"));
+    TEST_ASSERT_TRUE(dateAccepted("1972-02-29"));
+
+    uint32_t leap = 0;
+    uint32_t march = 0;
+    TEST_ASSERT_TRUE(CivilTime::parse("2024-02-29", "12:00", leap));
+    TEST_ASSERT_TRUE(CivilTime::parse("2024-03-01", "12:00", march));
+    TEST_ASSERT_EQUAL_UINT32(DAY, march - leap);
+
+    TEST_ASSERT_EQUAL_UINT8(29, CivilTime::daysInMonth(2024, 2));
+    TEST_ASSERT_EQUAL_UINT8(28, CivilTime::daysInMonth(2100, 2));
+    TEST_ASSERT_EQUAL_UINT8(29, CivilTime::daysInMonth(2000, 2));
+}
+
+static void test_month_lengths() {
+    static const uint8_t kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    char text[16];
+    for (uint8_t month = 1; month <= 12; month++) {
+        TEST_ASSERT_EQUAL_UINT8(kDays[month - 1], CivilTime::daysInMonth(2025, month));
+        snprintf(text, sizeof(text), "2025-%02u-%02u", (unsigned)month, (unsigned)kDays[month - 1]);
+        TEST_ASSERT_TRUE_MESSAGE(dateAccepted(text), text);
+        snprintf(text, sizeof(text), "2025-%02u-%02u", (unsigned)month, kDays[month - 1] + 1U);
+        TEST_ASSERT_FALSE_MESSAGE(dateAccepted(text), text);
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, CivilTime::daysInMonth(2025, 0));
+    TEST_ASSERT_EQUAL_UINT8(0, CivilTime::daysInMonth(2025, 13));
+}
+
+static void test_malformed_text_is_rejected() {
+    const char* dates[] = {"2025-00-10", "2025-13-01", "2025-01-00", "2025-1-01", "2025/01/01", "20a5-01-01",
+                           "2025-01-01 ", "", "2107-01-01", "1969-12-31", "2025-01-+1"};
+    for (const char* date : dates) {
+        TEST_ASSERT_FALSE_MESSAGE(dateAccepted(date), date);
+    }
+    const char* times[] = {"24:00", "12:60", "12:00:60", "1:00", "12:00:", "12-00", "ab:cd", "12:00:0", "12:00-00", ""};
+    for (const char* time : times) {
+        TEST_ASSERT_FALSE_MESSAGE(timeAccepted(time), time);
+    }
+
+    // Spans: only `length` characters are read
+    CivilDateTime value = {};
+    TEST_ASSERT_TRUE(CivilTime::parseDate("2025-06-15T07:30", 10, value));
+    TEST_ASSERT_TRUE(CivilTime::parseTime("07:30:15Z", 8, value));
+    TEST_ASSERT_EQUAL_UINT8(15, value.second);
+}
+
+static void test_failed_parse_leaves_output_untouched() {
+    CivilDateTime value = civil(2025, 6, 15, 7, 30, 15);
+    TEST_ASSERT_FALSE(CivilTime::parseDate("2025-02-30", 10, value));
+    TEST_ASSERT_FALSE(CivilTime::parseTime("25:00", 5, value));
+    TEST_ASSERT_EQUAL_UINT16(2025, value.year);
+    TEST_ASSERT_EQUAL_UINT8(6, value.month);
+    TEST_ASSERT_EQUAL_UINT8(15, value.day);
+    TEST_ASSERT_EQUAL_UINT8(7, value.hour);
+}
+
+static void test_benchmark_against_mktime_and_strftime() {
+    // The firmware keeps local time as UTC
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    const int rounds = 1000000;
+    volatile uint32_t sink = 0;
+    char date[11] = "2025-06-15";
+    char out[11];
+    char outTime[6];
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        date[9] = '1' + i % 9;
+        uint32_t timestamp = 0;
+        CivilTime::parse(date, "07:30", timestamp);
+        sink += timestamp;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        struct tm value = {};
+        value.tm_year = 125;
+        value.tm_mon = 5;
+        value.tm_mday = 1 + i % 9;
+        value.tm_hour = 7;
+        value.tm_min = 30;
+        sink += (uint32_t)mktime(&value);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        uint32_t timestamp = 1750000000UL + i * 37UL;
+        CivilTime::formatDate(timestamp, out);
+        CivilTime::formatTime(timestamp, outTime);
+        sink += out[9] + outTime[4];
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        time_t timestamp = 1750000000L + i * 37L;
+        struct tm value;
+        localtime_r(&timestamp, &value);
+        strftime(out, sizeof(out), "%Y-%m-%d", &value);
+        strftime(outTime, sizeof(outTime), "%H:%M", &value);
+        sink += out[9] + outTime[4];
+    }
+    auto t4 = std::chrono::steady_clock::now();
+
+    char message[160];
+    snprintf(message, sizeof(message), "parse %.1f ns (mktime %.1f ns), format %.1f ns (localtime_r + strftime %.1f ns)",
+             std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds,
+             std::chrono::duration<double, std::nano>(t2 - t1).count() / rounds,
+             std::chrono::duration<double, std::nano>(t3 - t2).count() / rounds,
+             std::chrono::duration<double, std::nano>(t4 - t3).count() / rounds);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_NOT_EQUAL(0, sink);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_day_round_trips_against_gmtime);
+    RUN_TEST(test_every_time_of_day_round_trips);
+    RUN_TEST(test_whole_range_round_trips);
+    RUN_TEST(test_range_limits);
+    RUN_TEST(test_leap_days);
+    RUN_TEST(test_month_lengths);
+    RUN_TEST(test_malformed_text_is_rejected);
+    RUN_TEST(test_failed_parse_leaves_output_untouched);
+    RUN_TEST(test_benchmark_against_mktime_and_strftime);
+    return UNITY_END();
+}
@@ -0,0 +1,170 @@
+/**
+ * @file test_main.cpp
+ * @brief ConfigManager write-back cache, counted on the emulated Preferences.
+ *
+ * `Sim::counters().nvsWrites` counts every put/remove that reaches the
+ * emulated NVS, so the tests measure flash writes, not cache bookkeeping.
+ * Each manager stands for one boot: it opens the preferences and its
+ * destructor commits and closes them.
+ */
+
+#include <unity.h>
+#include "ConfigManager.h"
+
+static Preferences preferences;
+
+static uint32_t nvsWrites() {
+    return Sim::counters().nvsWrites;
+}
+
+static uint32_t nvsReads() {
+    return Sim::counters().nvsReads;
+}
+
+// A configuration already written by an earlier boot
+static void storeSettings() {
+    ConfigManager config(&preferences);
+    config.startPreferencesReadWrite();
+    config.Put<ConfigField::LedState>(true);
+    config.PutInt("counter", 7);
+    config.PutString("name", "alarm");
+    config.commit();
+}
+
+void setUp() {
+    Sim::powerOn(1750000000ULL * 1000000ULL, 0);
+    simNvsStore().clear();
+    storeSettings();
+    Sim::resetCounters();
+}
+
+void tearDown() {}
+
+static void test_unchanged_values_are_never_written() {
+    ConfigManager config(&preferences);
+    config.startPreferencesReadWrite();
+    for (int i = 0; i < 100; i++) {
+        config.Put<ConfigField::LedState>(true);
+        config.PutInt("counter", 7);
+        config.PutString("name", "alarm");
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, config.commit());
+    TEST_ASSERT_EQUAL_UINT32(0, nvsWrites());
+    TEST_ASSERT_EQUAL_UINT32(300, config.getStats().skippedWrites);
+}
+
+static void test_changes_are_written_once_on_commit() {
+    ConfigManager config(&preferences);
+    config.startPreferencesReadWrite();
+    for (int i = 0; i < 100; i++) {
+        config.PutInt("counter", i);
+        config.Put<ConfigField::AlarmPattern>((uint8_t)(i % 4));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, nvsWrites());  // Nothing reaches NVS before commit()
+    config.commit();
+    TEST_ASSERT_EQUAL_UINT32(2, nvsWrites());  // One key and one settings blob
+    TEST_ASSERT_EQUAL_UINT8(0, config.commit());
+    TEST_ASSERT_EQUAL_UINT32(2, nvsWrites());
+}
+
+static void test_value_changed_back_is_still_written_once() {
+    ConfigManager config(&preferences);
+    config.startPreferencesReadWrite();
+    config.PutInt("counter", 8);
+    config.PutInt("counter", 7);
+    config.commit();
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(1, nvsWrites());
+}
+
+static void test_reads_hit_nvs_once() {
+    ConfigManager config(&preferences);
+    config.startPreferencesReadWrite();
+    for (int i = 0; i < 50; i++) {
+        TEST_ASSERT_EQUAL_INT(7, config.GetInt("counter", 0));
+        TEST_ASSERT_EQUAL_STRING("alarm", config.GetString("name", "").c_str());
+        TEST_ASSERT_TRUE(config.Get<ConfigField::LedState>());
+    }
+    TEST_ASSERT_EQUAL_UINT32(7, nvsReads());  // isKey + get per key, isKey + length + get for the blob
+}
+
+static void test_missing_key_returns_default_without_writing() {
+    ConfigManager config(&preferences);
+    config.startPreferencesReadWrite();
+    TEST_ASSERT_EQUAL_INT(-1, config.GetInt("absent", -1));
+    TEST_ASSERT_EQUAL_INT(-1, config.GetInt("absent", -1));
+    config.commit();
+    TEST_ASSERT_EQUAL_UINT32(0, nvsWrites());
+}
+
+static void test_committed_values_survive_a_reboot() {
+    {
+        ConfigManager config(&preferences);
+        config.startPreferencesReadWrite();
+        config.PutInt("counter", 42);
+        config.Put<ConfigField::WifiSsid>("home");
+        config.commit();
+    }
+    ConfigManager config(&preferences);
+    config.startPreferencesReadWrite();
+    TEST_ASSERT_EQUAL_INT(42, config.GetInt("counter", 0));
+    TEST_ASSERT_EQUAL_STRING("home", config.Get<ConfigField::WifiSsid>());
+}
+
+static void test_type_change_replaces_the_key() {
+    ConfigManager config(&preferences);
+    config.startPreferencesReadWrite();
+    config.PutString("counter", "seven");
+    config.commit();
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, nvsWrites());  // At most remove the int, write the string
+
+    ConfigManager reloaded(&preferences);
+    reloaded.startPreferencesReadWrite();
+    TEST_ASSERT_EQUAL_STRING("seven", reloaded.GetString("counter", "").c_str());
+}
+
+static void test_a_day_of_unchanged_wakes_writes_nothing() {
+    // 1440 boots that load, read and re-put the same settings
+    for (int wake = 0; wake < 1440; wake++) {
+        ConfigManager config(&preferences);
+        config.startPreferencesReadWrite();
+        bool led = config.Get<ConfigField::LedState>();
+        config.Put<ConfigField::LedState>(led);
+        config.PutInt("counter", config.GetInt("counter", 0));
+        config.commit();
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, nvsWrites());
+}
+
+static void test_full_cache_writes_through() {
+    ConfigManager config(&preferences);
+    config.startPreferencesReadWrite();
+    char key[16];
+    for (int i = 0; i < CONFIG_CACHE_SIZE + 4; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        config.PutInt(key, i);
+    }
+    uint32_t before = nvsWrites();
+    TEST_ASSERT_GREATER_THAN_UINT32(0, before);  // Keys that found no slot went straight to NVS
+    config.commit();
+
+    ConfigManager reloaded(&preferences);
+    reloaded.startPreferencesReadWrite();
+    for (int i = 0; i < CONFIG_CACHE_SIZE + 4; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        TEST_ASSERT_EQUAL_INT(i, reloaded.GetInt(key, -1));
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_unchanged_values_are_never_written);
+    RUN_TEST(test_changes_are_written_once_on_commit);
+    RUN_TEST(test_value_changed_back_is_still_written_once);
+    RUN_TEST(test_reads_hit_nvs_once);
+    RUN_TEST(test_missing_key_returns_default_without_writing);
+    RUN_TEST(test_committed_values_survive_a_reboot);
+    RUN_TEST(test_type_change_replaces_the_key);
+    RUN_TEST(test_a_day_of_unchanged_wakes_writes_nothing);
+    RUN_TEST(test_full_cache_writes_through);
+    return UNITY_END();
+}
@@ -0,0 +1,208 @@
+/**
+ * @file test_main.cpp
+ * @brief ConfigSchema blob encoding across schema versions, and the
+ *        ConfigManager load paths: migration of the per-key layout, an
+ *        unreadable blob and a blob left by newer firmware.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include <vector>
+#include "ConfigManager.h"
+#include "Crc32.h"
+
+static Preferences preferences;
+
+// Blob of the given version holding the first `size` bytes of `data`
+static std::vector<uint8_t> makeBlob(uint16_t version, const ConfigData& data, size_t size) {
+    const uint8_t* fields = (const uint8_t*)&data;
+    std::vector<uint8_t> payload(fields, fields + (size < sizeof(data) ? size : sizeof(data)));
+    payload.resize(size, 0x5A);  // Fields of a newer schema
+    ConfigBlobHeader header = {};
+    header.magic = CONFIG_BLOB_MAGIC;
+    header.version = version;
+    header.size = (uint16_t)size;
+    header.crc = crc32Update(payload.data(), size);
+    std::vector<uint8_t> bytes((const uint8_t*)&header, (const uint8_t*)&header + sizeof(header));
+    bytes.insert(bytes.end(), payload.begin(), payload.end());
+    return bytes;
+}
+
+static ConfigData sampleSettings() {
+    ConfigData data = ConfigSchema::defaults();
+    data.ledState = true;
+    data.currentTime = 1750000000ULL;
+    strcpy(data.wifiSsid.value, "home");
+    strcpy(data.wifiPass.value, "secret");
+    data.alarmPattern = 3;
+    return data;
+}
+
+static void storeBytes(const char* key, const void* bytes, size_t length) {
+    preferences.begin(CONFIG_PARTITION, false);
+    preferences.putBytes(key, bytes, length);
+    preferences.end();
+}
+
+static bool storedKey(const char* key) {
+    preferences.begin(CONFIG_PARTITION, true);
+    bool present = preferences.isKey(key);
+    preferences.end();
+    return present;
+}
+
+void setUp() {
+    Sim::powerOn(1750000000ULL * 1000000ULL, 0);
+    simNvsStore().clear();
+    Sim::resetCounters();
+}
+
+void tearDown() {}
+
+static void test_seal_and_decode_round_trip() {
+    ConfigBlob blob;
+    ConfigData data = sampleSettings();
+    ConfigSchema::seal(blob, data);
+    TEST_ASSERT_EQUAL_HEX32(CONFIG_BLOB_MAGIC, blob.header.magic);
+    TEST_ASSERT_EQUAL_UINT16(CONFIG_SCHEMA_VERSION, blob.header.version);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(ConfigData), blob.header.size);
+
+    ConfigData back = ConfigSchema::defaults();
+    TEST_ASSERT_TRUE(ConfigSchema::decode(&blob, sizeof(blob), back));
+    TEST_ASSERT_EQUAL_MEMORY(&data, &back, sizeof(data));
+}
+
+static void test_older_blob_gets_defaults_for_new_fields() {
+    // Schema 1 ended before alarmPattern
+    ConfigData data = sampleSettings();
+    std::vector<uint8_t> blob = makeBlob(1, data, offsetof(ConfigData, alarmPattern));
+    ConfigData back = {};
+    TEST_ASSERT_TRUE(ConfigSchema::decode(blob.data(), blob.size(), back));
+    TEST_ASSERT_EQUAL_STRING("home", back.wifiSsid.value);
+    TEST_ASSERT_EQUAL_UINT64(1750000000ULL, back.currentTime);
+    TEST_ASSERT_EQUAL_UINT8(ConfigSchema::defaults().alarmPattern, back.alarmPattern);
+}
+
+static void test_damaged_blobs_are_rejected() {
+    ConfigData data = sampleSettings();
+    ConfigData untouched = ConfigSchema::defaults();
+    ConfigData out = untouched;
+
+    std::vector<uint8_t> blob = makeBlob(CONFIG_SCHEMA_VERSION, data, sizeof(data));
+    blob[sizeof(ConfigBlobHeader) + 3] ^= 0x01;  // Bad CRC
+    TEST_ASSERT_FALSE(ConfigSchema::decode(blob.data(), blob.size(), out));
+
+    blob = makeBlob(CONFIG_SCHEMA_VERSION, data, sizeof(data));
+    blob[0] ^= 0xFF;  // Bad magic
+    TEST_ASSERT_FALSE(ConfigSchema::decode(blob.data(), blob.size(), out));
+
+    blob = makeBlob(CONFIG_SCHEMA_VERSION, data, sizeof(data));
+    TEST_ASSERT_FALSE(ConfigSchema::decode(blob.data(), blob.size() - 1, out));  // Cut short
+    TEST_ASSERT_FALSE(ConfigSchema::decode(blob.data(), sizeof(ConfigBlobHeader) - 1, out));
+    TEST_ASSERT_EQUAL_MEMORY(&untouched, &out, sizeof(out));
+}
+
+static void test_future_version_needs_decode_newer() {
+    ConfigData data = sampleSettings();
+    std::vector<uint8_t> blob = makeBlob(CONFIG_SCHEMA_VERSION + 1, data, sizeof(data) + 16);
+    ConfigData out = ConfigSchema::defaults();
+    TEST_ASSERT_FALSE(ConfigSchema::decode(blob.data(), blob.size(), out));
+    TEST_ASSERT_TRUE(ConfigSchema::decodeNewer(blob.data(), blob.size(), out));
+    TEST_ASSERT_EQUAL_MEMORY(&data, &out, sizeof(out));
+
+    // decodeNewer() only takes valid blobs of a later version
+    std::vector<uint8_t> current = makeBlob(CONFIG_SCHEMA_VERSION, data, sizeof(data));
+    TEST_ASSERT_FALSE(ConfigSchema::decodeNewer(current.data(), current.size(), out));
+    blob[blob.size() - 1] ^= 0x01;
+    TEST_ASSERT_FALSE(ConfigSchema::decodeNewer(blob.data(), blob.size(), out));
+}
+
+static void test_legacy_keys_migrate_into_one_blob() {
+    preferences.begin(CONFIG_PARTITION, false);
+    preferences.putBool(RESET_FLAG, false);
+    preferences.putBool(LED_STATE, true);
+    preferences.putULong64(CURRENT_TIME_SAVED, 1750000000ULL);
+    preferences.putString(WIFISSID, "home");
+    preferences.putString(WIFIPASS, "secret");
+    preferences.putString(ALERT_TIME_, "07:30");
+    preferences.end();
+
+    {
+        ConfigManager config(&preferences);
+        config.startPreferencesReadWrite();
+        TEST_ASSERT_EQUAL_STRING("home", config.Get<ConfigField::WifiSsid>());
+        TEST_ASSERT_EQUAL_STRING("secret", config.Get<ConfigField::WifiPass>());
+        TEST_ASSERT_EQUAL_STRING("07:30", config.Get<ConfigField::AlertTime>());
+        TEST_ASSERT_TRUE(config.Get<ConfigField::LedState>());
+        TEST_ASSERT_EQUAL_UINT64(1750000000ULL, config.Get<ConfigField::CurrentTime>());
+    }
+
+    const char* legacy[] = {RESET_FLAG, LED_STATE, CURRENT_TIME_SAVED, WIFISSID, WIFIPASS, ALERT_TIME_};
+    for (const char* key : legacy) TEST_ASSERT_FALSE_MESSAGE(storedKey(key), key);
+
+    preferences.begin(CONFIG_PARTITION, true);
+    ConfigBlob blob;
+    size_t length = preferences.getBytes(CONFIG_DATA_SAVED, &blob, sizeof(blob));
+    preferences.end();
+    ConfigData data;
+    TEST_ASSERT_TRUE(ConfigSchema::decode(&blob, length, data));
+    TEST_ASSERT_EQUAL_STRING("home", data.wifiSsid.value);
+    TEST_ASSERT_FALSE(data.resetFlag);
+}
+
+static void test_unreadable_blob_keeps_the_alarm_table() {
+    ConfigBlob blob;
+    ConfigSchema::seal(blob, sampleSettings());
+    blob.data.ledState = !blob.data.ledState;  // CRC no longer matches
+    storeBytes(CONFIG_DATA_SAVED, &blob, sizeof(blob));
+    const uint8_t table[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    storeBytes(ALARM_TABLE_SAVED, table, sizeof(table));
+    Sim::resetCounters();
+
+    {
+        ConfigManager config(&preferences);
+        config.startPreferencesReadWrite();
+        config.begin();  // Must neither factory-reset nor restart
+        TEST_ASSERT_EQUAL_STRING(DEFAULT_WIFI_SSID, config.Get<ConfigField::WifiSsid>());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, Sim::counters().nvsWrites);
+    TEST_ASSERT_TRUE(storedKey(ALARM_TABLE_SAVED));
+    TEST_ASSERT_TRUE(storedKey(CONFIG_DATA_SAVED));
+}
+
+static void test_blob_from_newer_firmware_is_read() {
+    // Rolled back after a schema with one more field wrote its settings
+    std::vector<uint8_t> blob = makeBlob(CONFIG_SCHEMA_VERSION + 1, sampleSettings(), sizeof(ConfigData) + 8);
+    storeBytes(CONFIG_DATA_SAVED, blob.data(), blob.size());
+    Sim::resetCounters();
+
+    {
+        ConfigManager config(&preferences);
+        config.startPreferencesReadWrite();
+        config.begin();
+        TEST_ASSERT_EQUAL_STRING("home", config.Get<ConfigField::WifiSsid>());
+        TEST_ASSERT_EQUAL_UINT8(3, config.Get<ConfigField::AlarmPattern>());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, Sim::counters().nvsWrites);  // Left as the newer firmware wrote it
+
+    // The first change rewrites it in this layout
+    ConfigManager config(&preferences);
+    config.startPreferencesReadWrite();
+    config.Put<ConfigField::LedState>(false);
+    config.commit();
+    preferences.begin(CONFIG_PARTITION, true);
+    TEST_ASSERT_EQUAL_size_t(sizeof(ConfigBlob), preferences.getBytesLength(CONFIG_DATA_SAVED));
+    preferences.end();
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_seal_and_decode_round_trip);
+    RUN_TEST(test_older_blob_gets_defaults_for_new_fields);
+    RUN_TEST(test_damaged_blobs_are_rejected);
+    RUN_TEST(test_future_version_needs_decode_newer);
+    RUN_TEST(test_legacy_keys_migrate_into_one_blob);
+    RUN_TEST(test_unreadable_blob_keeps_the_alarm_table);
+    RUN_TEST(test_blob_from_newer_firmware_is_read);
+    return UNITY_END();
+}
@@ -0,0 +1,184 @@
+/**
+ * @file test_main.cpp
+ * @brief DriftEstimator fit, uncertainty and resync scheduling on synthetic
+ *        drift traces.
+ *
+ * A trace is a series of NTP syncs against a clock with a known drift: each
+ * sample's offset is drift * elapsed, optionally with a reference jitter of
+ * up to half the sync resolution.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "DriftEstimator.h"
+
+#define DAY_MICROS 86400000000ULL
+#define HOUR_MICROS 3600000000ULL
+
+static DriftHistory history;
+
+static void resetHistory() {
+    memset(&history, 0, sizeof(history));
+    history.magic = DRIFT_MAGIC;
+    history.syncRtcMicros = DRIFT_NO_SYNC;
+    DriftEstimator::seal(history);
+}
+
+// Offset accumulated over `elapsed` by a clock drifting `ppb`
+static int64_t offsetFor(double ppb, uint64_t elapsed) {
+    return (int64_t)(ppb * (double)elapsed / 1e9);
+}
+
+// Deterministic reference jitter in [-500, 500] ms
+static int64_t jitterMicros(uint32_t& seed) {
+    seed = seed * 1664525UL + 1013904223UL;
+    return (int64_t)(seed >> 8) % 1000001 - 500000;
+}
+
+void setUp() {
+    resetHistory();
+}
+
+void tearDown() {}
+
+static void test_fit_without_samples_is_zero() {
+    TEST_ASSERT_EQUAL_INT32(0, DriftEstimator::fitPpb(history));
+}
+
+static void test_fit_recovers_constant_drift() {
+    for (int i = 0; i < DRIFT_HISTORY_SIZE; i++) {
+        DriftEstimator::addSample(history, offsetFor(-1234500, DAY_MICROS), DAY_MICROS);
+    }
+    TEST_ASSERT_INT32_WITHIN(1, -1234500, DriftEstimator::fitPpb(history));
+}
+
+static void test_fit_weights_samples_by_elapsed_time() {
+    DriftEstimator::addSample(history, offsetFor(100000, HOUR_MICROS), HOUR_MICROS);  // 100 ppm over 1 h
+    DriftEstimator::addSample(history, 0, 23 * HOUR_MICROS);                         // 0 ppm over 23 h
+    TEST_ASSERT_INT32_WITHIN(1, 100000 / 24, DriftEstimator::fitPpb(history));
+}
+
+static void test_ring_keeps_the_newest_samples() {
+    for (int i = 0; i < DRIFT_HISTORY_SIZE; i++) {
+        DriftEstimator::addSample(history, offsetFor(500000, DAY_MICROS), DAY_MICROS);
+    }
+    for (int i = 0; i < DRIFT_HISTORY_SIZE; i++) {
+        DriftEstimator::addSample(history, offsetFor(-20000, DAY_MICROS), DAY_MICROS);
+    }
+    TEST_ASSERT_EQUAL_UINT8(DRIFT_HISTORY_SIZE, history.count);
+    TEST_ASSERT_INT32_WITHIN(1, -20000, DriftEstimator::fitPpb(history));
+}
+
+static void test_fit_converges_with_reference_jitter() {
+    // Daily syncs against a 40 ppm clock; each reference is off by up to 0.5 s
+    uint32_t seed = 12345;
+    for (int i = 0; i < DRIFT_HISTORY_SIZE; i++) {
+        DriftEstimator::addSample(history, offsetFor(40000, DAY_MICROS) + jitterMicros(seed), DAY_MICROS);
+        int32_t error = DriftEstimator::fitPpb(history) - 40000;
+        if (error < 0) error = -error;
+        TEST_ASSERT_LESS_OR_EQUAL(6000, error);  // 0.5 s per day is 5.8 ppm
+        if (history.count >= 2) {
+            TEST_ASSERT_LESS_OR_EQUAL_UINT32(DriftEstimator::uncertaintyPpb(history), (uint32_t)error);
+        }
+    }
+}
+
+static void test_uncertainty_defaults_before_two_samples() {
+    TEST_ASSERT_EQUAL_UINT32(DRIFT_DEFAULT_UNCERTAINTY_PPM * 1000UL, DriftEstimator::uncertaintyPpb(history));
+    DriftEstimator::addSample(history, offsetFor(40000, DAY_MICROS), DAY_MICROS);
+    TEST_ASSERT_EQUAL_UINT32(DRIFT_DEFAULT_UNCERTAINTY_PPM * 1000UL, DriftEstimator::uncertaintyPpb(history));
+}
+
+static void test_uncertainty_is_spread_plus_quantization() {
+    // +10 ppm and -10 ppm: fit 0, spread 10 ppm, 1 s resolution over 1 day
+    DriftEstimator::addSample(history, offsetFor(10000, DAY_MICROS), DAY_MICROS);
+    DriftEstimator::addSample(history, offsetFor(-10000, DAY_MICROS), DAY_MICROS);
+    uint32_t quantization = (uint32_t)(DRIFT_SYNC_RESOLUTION_MS * 1000.0 * 1e9 / DAY_MICROS);
+    TEST_ASSERT_EQUAL_INT32(0, DriftEstimator::fitPpb(history));
+    TEST_ASSERT_UINT32_WITHIN(2, 10000 + quantization, DriftEstimator::uncertaintyPpb(history));
+}
+
+static void test_uncertainty_has_a_floor() {
+    // A perfect trace over weekly syncs is limited by DRIFT_MIN_UNCERTAINTY_PPM
+    for (int i = 0; i < DRIFT_HISTORY_SIZE; i++) {
+        DriftEstimator::addSample(history, offsetFor(40000, 7 * DAY_MICROS), 7 * DAY_MICROS);
+    }
+    TEST_ASSERT_EQUAL_UINT32(DRIFT_MIN_UNCERTAINTY_PPM * 1000UL, DriftEstimator::uncertaintyPpb(history));
+}
+
+static void test_micros_until_error_matches_prediction() {
+    for (int i = 0; i < DRIFT_HISTORY_SIZE; i++) {
+        DriftEstimator::addSample(history, offsetFor(40000, 7 * DAY_MICROS), 7 * DAY_MICROS);
+    }
+    // (5 s bound - 1 s resolution) at 5 ppm
+    uint64_t until = DriftEstimator::microsUntilError(history, 5000000ULL);
+    TEST_ASSERT_UINT64_WITHIN(1, 800000ULL * 1000000ULL, until);
+    TEST_ASSERT_UINT64_WITHIN(1, 5000000ULL, DriftEstimator::predictedErrorMicros(history, until));
+}
+
+static void test_micros_until_error_below_resolution_is_zero() {
+    TEST_ASSERT_EQUAL_UINT64(0, DriftEstimator::microsUntilError(history, DRIFT_SYNC_RESOLUTION_MS * 1000ULL));
+}
+
+static void test_resync_interval_is_clamped() {
+    // Default uncertainty: the bound is reached in under a second, wait for a usable sample
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)DRIFT_MIN_SAMPLE_INTERVAL * 1000000ULL, DriftEstimator::resyncIntervalMicros(history));
+
+    // Spread 10 ppm plus 11.6 ppm quantization: in between
+    DriftEstimator::addSample(history, offsetFor(10000, DAY_MICROS), DAY_MICROS);
+    DriftEstimator::addSample(history, offsetFor(-10000, DAY_MICROS), DAY_MICROS);
+    uint64_t expected = DriftEstimator::microsUntilError(history, (uint64_t)DRIFT_MAX_ERROR_MS * 1000ULL);
+    TEST_ASSERT_GREATER_THAN_UINT64((uint64_t)DRIFT_MIN_SAMPLE_INTERVAL * 1000000ULL, expected);
+    TEST_ASSERT_LESS_THAN_UINT64((uint64_t)DRIFT_MAX_RESYNC_INTERVAL * 1000000ULL, expected);
+    TEST_ASSERT_EQUAL_UINT64(expected, DriftEstimator::resyncIntervalMicros(history));
+
+    // Uncertainty floor: never longer than DRIFT_MAX_RESYNC_INTERVAL
+    resetHistory();
+    for (int i = 0; i < DRIFT_HISTORY_SIZE; i++) {
+        DriftEstimator::addSample(history, offsetFor(40000, 7 * DAY_MICROS), 7 * DAY_MICROS);
+    }
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)DRIFT_MAX_RESYNC_INTERVAL * 1000000ULL, DriftEstimator::resyncIntervalMicros(history));
+}
+
+static void test_resync_keeps_error_within_bound_once_converged() {
+    // Each resync interval follows from the fit so far; the true error at the
+    // resync must stay within DRIFT_MAX_ERROR_MS once two samples exist
+    uint32_t seed = 777;
+    uint64_t interval = (uint64_t)DRIFT_MIN_SAMPLE_INTERVAL * 1000000ULL;
+    for (int i = 0; i < 20; i++) {
+        int64_t offset = offsetFor(-1234500, interval) + jitterMicros(seed);
+        if (history.count >= 2) {
+            int64_t corrected = offset - offsetFor(DriftEstimator::fitPpb(history), interval);
+            if (corrected < 0) corrected = -corrected;
+            TEST_ASSERT_LESS_OR_EQUAL_INT64((int64_t)DRIFT_MAX_ERROR_MS * 1000LL, corrected);
+        }
+        DriftEstimator::addSample(history, offset, interval);
+        interval = DriftEstimator::resyncIntervalMicros(history);
+    }
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)DRIFT_MAX_RESYNC_INTERVAL * 1000000ULL, interval);
+}
+
+static void test_validate_detects_corruption() {
+    DriftEstimator::addSample(history, 1000, DAY_MICROS);
+    TEST_ASSERT_TRUE(DriftEstimator::validate(history));
+    history.samples[0].offsetMicros++;
+    TEST_ASSERT_FALSE(DriftEstimator::validate(history));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fit_without_samples_is_zero);
+    RUN_TEST(test_fit_recovers_constant_drift);
+    RUN_TEST(test_fit_weights_samples_by_elapsed_time);
+    RUN_TEST(test_ring_keeps_the_newest_samples);
+    RUN_TEST(test_fit_converges_with_reference_jitter);
+    RUN_TEST(test_uncertainty_defaults_before_two_samples);
+    RUN_TEST(test_uncertainty_is_spread_plus_quantization);
+    RUN_TEST(test_uncertainty_has_a_floor);
+    RUN_TEST(test_micros_until_error_matches_prediction);
+    RUN_TEST(test_micros_until_error_below_resolution_is_zero);
+    RUN_TEST(test_resync_interval_is_clamped);
+    RUN_TEST(test_resync_keeps_error_within_bound_once_converged);
+    RUN_TEST(test_validate_detects_corruption);
+    return UNITY_END();
+}
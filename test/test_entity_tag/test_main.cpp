@@ -0,0 +1,62 @@
+/**
+ * @file test_main.cpp
+ * @brief EntityTag matching of If-None-Match lists against the strong ETag
+ *        of an embedded page.
+ */
+
+#include <unity.h>
+#include "EntityTag.h"
+
+#define ETAG "\"5f3a9c01\""
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_exact_tag_matches() {
+    TEST_ASSERT_TRUE(EntityTag::matches("\"5f3a9c01\"", ETAG));
+    TEST_ASSERT_TRUE(EntityTag::matches("  \"5f3a9c01\"  ", ETAG));
+    TEST_ASSERT_FALSE(EntityTag::matches("\"5f3a9c02\"", ETAG));
+    TEST_ASSERT_FALSE(EntityTag::matches(nullptr, ETAG));
+    TEST_ASSERT_FALSE(EntityTag::matches("", ETAG));
+}
+
+static void test_list_is_compared_tag_by_tag() {
+    TEST_ASSERT_TRUE(EntityTag::matches("\"aa\", \"5f3a9c01\"", ETAG));
+    TEST_ASSERT_TRUE(EntityTag::matches("\"5f3a9c01\",\"aa\"", ETAG));
+    TEST_ASSERT_TRUE(EntityTag::matches(", ,\"aa\" ,\t\"5f3a9c01\"", ETAG));
+    TEST_ASSERT_FALSE(EntityTag::matches("\"aa\", \"bb\"", ETAG));
+    // A substring is not a match
+    TEST_ASSERT_FALSE(EntityTag::matches("\"x5f3a9c01\"", ETAG));
+    TEST_ASSERT_FALSE(EntityTag::matches("\"5f3a9c01x\"", ETAG));
+    TEST_ASSERT_FALSE(EntityTag::matches("\"5f3a9c01\"\"\"", ETAG));
+    // A comma inside a tag belongs to the tag
+    TEST_ASSERT_FALSE(EntityTag::matches("\"a,\"5f3a9c01\"", ETAG));
+}
+
+static void test_weak_tag_does_not_match() {
+    TEST_ASSERT_FALSE(EntityTag::matches("W/\"5f3a9c01\"", ETAG));
+    TEST_ASSERT_TRUE(EntityTag::matches("W/\"5f3a9c01\", \"5f3a9c01\"", ETAG));
+}
+
+static void test_wildcard_matches() {
+    TEST_ASSERT_TRUE(EntityTag::matches("*", ETAG));
+    TEST_ASSERT_TRUE(EntityTag::matches(" *", ETAG));
+}
+
+static void test_malformed_list_matches_nothing() {
+    TEST_ASSERT_FALSE(EntityTag::matches("5f3a9c01", ETAG));  // Unquoted
+    TEST_ASSERT_FALSE(EntityTag::matches("\"5f3a9c01", ETAG));  // Unterminated
+    TEST_ASSERT_FALSE(EntityTag::matches("\"aa\" \"5f3a9c01\"", ETAG));  // No comma
+    TEST_ASSERT_FALSE(EntityTag::matches("w/\"aa\", \"5f3a9c01\"", ETAG));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_exact_tag_matches);
+    RUN_TEST(test_list_is_compared_tag_by_tag);
+    RUN_TEST(test_weak_tag_does_not_match);
+    RUN_TEST(test_wildcard_matches);
+    RUN_TEST(test_malformed_list_matches_nothing);
+    return UNITY_END();
+}
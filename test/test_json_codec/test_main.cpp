@@ -0,0 +1,200 @@
+/**
+ * @file test_main.cpp
+ * @brief JsonCodec parsing and writing of the portal messages, the
+ *        JsonWriter overflow report, and a parse/write microbenchmark.
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "PortalMessages.h"
+
+static JsonError parseAlarm(const char* text, AlarmRequest& request) {
+    return JsonCodec::parse(text, strlen(text), request);
+}
+
+static JsonError parseAlarm(const char* text) {
+    AlarmRequest request = {};
+    return parseAlarm(text, request);
+}
+
+static void assertError(JsonError expected, JsonError actual, const char* text) {
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(JsonCodec::errorName(expected), JsonCodec::errorName(actual), text);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_parses_a_full_alarm_request() {
+    AlarmRequest request = {};
+    const char* text = " {\"alarmDate\":\"2025-06-15\", \"alarmTime\":\"07:30:15\",\"repeat\":\"weekly\","
+                       "\"weekdays\":62,\"interval\":0,\"pattern\":\"sunrise\",\"add\":true}\r\n";
+    assertError(JsonError::Ok, parseAlarm(text, request), text);
+    TEST_ASSERT_EQUAL_STRING("2025-06-15", request.alarmDate);
+    TEST_ASSERT_EQUAL_STRING("07:30:15", request.alarmTime);
+    TEST_ASSERT_EQUAL_STRING("weekly", request.repeat);
+    TEST_ASSERT_EQUAL_INT32(62, request.weekdays);
+    TEST_ASSERT_EQUAL_STRING("sunrise", request.pattern);
+    TEST_ASSERT_TRUE(request.add);
+}
+
+static void test_missing_optional_members_keep_their_defaults() {
+    AlarmRequest request = {};
+    strcpy(request.pattern, "default");
+    request.interval = 15;
+    assertError(JsonError::Ok, parseAlarm("{\"alarmTime\":\"07:30\",\"alarmDate\":\"2025-06-15\"}", request), "");
+    TEST_ASSERT_EQUAL_STRING("default", request.pattern);
+    TEST_ASSERT_EQUAL_INT32(15, request.interval);
+    TEST_ASSERT_FALSE(request.add);
+}
+
+static void test_rejects_bad_messages() {
+    struct Case {
+        const char* text;
+        JsonError error;
+    };
+    const Case cases[] = {
+        {"", JsonError::Syntax},
+        {"[]", JsonError::Syntax},
+        {"{\"alarmDate\":\"2025-06-15\"}", JsonError::Missing},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\",\"snooze\":1}", JsonError::UnknownField},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\",\"alarmTime\":\"07:31\"}", JsonError::Duplicate},
+        {"{\"alarmDate\":\"2025/06/15\",\"alarmTime\":\"07:30\"}", JsonError::Format},
+        {"{\"alarmDate\":\"2025-06-155\",\"alarmTime\":\"07:30\"}", JsonError::TooLong},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30:15:00\"}", JsonError::TooLong},
+        {"{\"alarmDate\":20250615,\"alarmTime\":\"07:30\"}", JsonError::Type},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\",\"weekdays\":128}", JsonError::Range},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\",\"weekdays\":1.5}", JsonError::Type},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\",\"interval\":99999999999}", JsonError::Range},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\",\"weekdays\":01}", JsonError::Syntax},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\",\"add\":1}", JsonError::Type},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\"} x", JsonError::Syntax},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\",}", JsonError::Syntax},
+        {"{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30", JsonError::Syntax},
+    };
+    for (const Case& c : cases) {
+        assertError(c.error, parseAlarm(c.text), c.text);
+    }
+}
+
+static void test_decodes_escapes() {
+    AlarmRequest request = {};
+    assertError(JsonError::Ok, parseAlarm("{\"alarmDate\":\"2025\\u002d06-15\",\"alarmTime\":\"07:30\",\"pattern\":\"a\\/b\\\"c\"}", request), "");
+    TEST_ASSERT_EQUAL_STRING("2025-06-15", request.alarmDate);
+    TEST_ASSERT_EQUAL_STRING("a/b\"c", request.pattern);
+    assertError(JsonError::Format, parseAlarm("{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\",\"pattern\":\"\\u00e9\"}"), "");
+}
+
+static void test_parses_only_the_given_length() {
+    const char* text = "{\"rtcDate\":\"2025-06-15\",\"rtcTime\":\"07:30\"}garbage";
+    RtcRequest request = {};
+    assertError(JsonError::Ok, JsonCodec::parse(text, strlen(text) - 7, request), text);
+    TEST_ASSERT_EQUAL_STRING("07:30", request.rtcTime);
+}
+
+static void test_writes_the_settings_reply() {
+    SettingsReply reply = {};
+    strcpy(reply.alarm.date, "2025-06-15");
+    strcpy(reply.alarm.time, "07:30");
+    strcpy(reply.rtc.date, "2025-06-14");
+    strcpy(reply.rtc.time, "23:59");
+    char buffer[128];
+    JsonWriter json(buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(JsonCodec::write(json, reply));
+    TEST_ASSERT_EQUAL_STRING("{\"alarm\":{\"date\":\"2025-06-15\",\"time\":\"07:30\"},"
+                             "\"rtc\":{\"date\":\"2025-06-14\",\"time\":\"23:59\"}}", buffer);
+    TEST_ASSERT_EQUAL_size_t(strlen(buffer), json.length());
+
+    SettingsReply back = {};
+    assertError(JsonError::Ok, JsonCodec::parse(buffer, json.length(), back), buffer);
+    TEST_ASSERT_EQUAL_MEMORY(&reply, &back, sizeof(reply));
+}
+
+static void test_writer_escapes_and_formats_numbers() {
+    char buffer[128];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.beginObject();
+    json.add("text", "a\"b\\c\n");
+    json.addInt("min", INT64_MIN);
+    json.addFloat("f", -1.0005, 3);
+    json.addFloat("nan", NAN);
+    json.beginArray("list").addBool(nullptr, true).addInt(nullptr, 0).endArray();
+    json.endObject();
+    TEST_ASSERT_TRUE(json.ok());
+    TEST_ASSERT_EQUAL_STRING("{\"text\":\"a\\\"b\\\\c\\n\",\"min\":-9223372036854775808,\"f\":-1.001,"
+                             "\"nan\":null,\"list\":[true,0]}", buffer);
+}
+
+static void test_writer_reports_overflow() {
+    // The /getEnergy and /getProfile handlers answer 500 when ok() is false
+    char buffer[16];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.beginObject();
+    json.add("mahPerDay", "0.485");
+    json.endObject();
+    TEST_ASSERT_FALSE(json.ok());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(buffer) - 1, strlen(buffer));  // Cut off, still NUL terminated
+
+    char fits[64];
+    JsonWriter open(fits, sizeof(fits));
+    open.beginObject();
+    TEST_ASSERT_FALSE(open.ok());  // Unclosed object
+}
+
+static void test_benchmark_parse_and_write() {
+    const char* alarm = "{\"alarmDate\":\"2025-06-15\",\"alarmTime\":\"07:30\",\"repeat\":\"daily\",\"pattern\":\"sunrise\"}";
+    const char* rtc = "{\"rtcDate\":\"2025-06-15\",\"rtcTime\":\"07:30:15\"}";
+    size_t alarmLength = strlen(alarm);
+    size_t rtcLength = strlen(rtc);
+    const int rounds = 1000000;
+    volatile uint32_t sink = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        AlarmRequest request = {};
+        sink += (uint32_t)JsonCodec::parse(alarm, alarmLength, request) + request.alarmTime[4];
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        RtcRequest request = {};
+        sink += (uint32_t)JsonCodec::parse(rtc, rtcLength, request) + request.rtcTime[7];
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    SettingsReply reply = {{"2025-06-15", "07:30"}, {"2025-06-14", "23:59"}};
+    char buffer[128];
+    for (int i = 0; i < rounds; i++) {
+        reply.rtc.time[4] = '0' + i % 10;
+        JsonWriter json(buffer, sizeof(buffer));
+        JsonCodec::write(json, reply);
+        sink += json.length();
+    }
+    auto t3 = std::chrono::steady_clock::now();
+
+    char message[200];
+    snprintf(message, sizeof(message),
+             "parse AlarmRequest %.1f ns, RtcRequest %.1f ns, write SettingsReply %.1f ns; "
+             "message RAM %u + %u + %u bytes",
+             std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds,
+             std::chrono::duration<double, std::nano>(t2 - t1).count() / rounds,
+             std::chrono::duration<double, std::nano>(t3 - t2).count() / rounds,
+             (unsigned)sizeof(AlarmRequest), (unsigned)sizeof(RtcRequest), (unsigned)sizeof(SettingsReply));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_NOT_EQUAL(0, sink);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_parses_a_full_alarm_request);
+    RUN_TEST(test_missing_optional_members_keep_their_defaults);
+    RUN_TEST(test_rejects_bad_messages);
+    RUN_TEST(test_decodes_escapes);
+    RUN_TEST(test_parses_only_the_given_length);
+    RUN_TEST(test_writes_the_settings_reply);
+    RUN_TEST(test_writer_escapes_and_formats_numbers);
+    RUN_TEST(test_writer_reports_overflow);
+    RUN_TEST(test_benchmark_parse_and_write);
+    return UNITY_END();
+}
@@ -0,0 +1,187 @@
+/**
+ * @file test_main.cpp
+ * @brief PatternEngine stepping, output levels and the LEDC timer solver,
+ *        plus a finite pattern played through the event loop.
+ */
+
+#include <unity.h>
+#include <Arduino.h>
+#include "PatternEngine.h"
+#include "EventLoop.h"
+
+#define CLOCK_HZ PATTERN_LEDC_CLOCK_HZ
+
+static const PatternStep kTwoSteps[] = {patternOff(10), patternLevel(200, 20)};
+static const PatternStep kBlinkThenHold[] = {patternBlink(100, 100, 3), patternLevel(255, 0)};
+static const PatternStep kFadeUpDown[] = {patternFade(255, 1000), patternFade(0, 1000)};
+
+// PWM period the timer really runs at, in microseconds
+static double periodOf(const LedcSetting& setting, uint32_t clockHz) {
+    return (double)setting.divider / 256.0 * (double)(1UL << setting.resolution) * 1e6 / clockHz;
+}
+
+void setUp() {
+    Sim::powerOn(1750000000ULL * 1000000ULL, 0);
+}
+
+void tearDown() {
+    PatternEngine::stop();
+}
+
+static void test_table_lookup() {
+    TEST_ASSERT_EQUAL_INT(PATTERN_GENTLE, PatternEngine::find("gentle"));
+    TEST_ASSERT_EQUAL_INT(PATTERN_ADMIN_MODE, PatternEngine::find("admin"));
+    TEST_ASSERT_EQUAL_INT(-1, PatternEngine::find("disco"));
+    TEST_ASSERT_EQUAL_INT(-1, PatternEngine::find(nullptr));
+    TEST_ASSERT_EQUAL_STRING("classic", PatternEngine::pattern(PATTERN_COUNT).name);
+}
+
+static void test_pattern_durations() {
+    TEST_ASSERT_EQUAL_UINT32(PATTERN_FOREVER, PatternEngine::duration(PatternEngine::pattern(PATTERN_CLASSIC)));
+    TEST_ASSERT_EQUAL_UINT32(PATTERN_FOREVER, PatternEngine::duration(PatternEngine::pattern(PATTERN_SERIAL_MODE)));
+    TEST_ASSERT_EQUAL_UINT32(400, PatternEngine::duration(PatternEngine::pattern(PATTERN_ADMIN_MODE)));
+    TEST_ASSERT_EQUAL_UINT32(600, PatternEngine::stepDuration(kBlinkThenHold[0]));
+    TEST_ASSERT_EQUAL_UINT32(0, PatternEngine::stepDuration(kBlinkThenHold[1]));
+}
+
+static void test_alarm_indications_need_no_step_wake_for_two_minutes() {
+    const uint8_t alarms[] = {PATTERN_CLASSIC, PATTERN_BEEP, PATTERN_URGENT};
+    for (uint8_t index : alarms) {
+        const Pattern& pattern = PatternEngine::pattern(index);
+        PatternTrack track;
+        PatternEngine::rewind(track, pattern.led, pattern.ledSteps, pattern.repeat, 0);
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(120000, PatternEngine::stepEnd(track));
+        if (pattern.buzzer == nullptr) continue;
+        PatternEngine::rewind(track, pattern.buzzer, pattern.buzzerSteps, pattern.repeat, 0);
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(120000, PatternEngine::stepEnd(track));
+    }
+}
+
+static void test_steps_and_repeats() {
+    PatternTrack track;
+    PatternEngine::rewind(track, kTwoSteps, 2, 3, 1000);
+    uint32_t starts[6];
+    uint8_t steps = 0;
+    do {
+        TEST_ASSERT_LESS_THAN_UINT8(6, steps);
+        starts[steps++] = track.stepStartMs;
+    } while (PatternEngine::next(track));
+
+    // Three plays of 10 + 20 ms, each step starting where the previous ended
+    const uint32_t expected[6] = {1000, 1010, 1030, 1040, 1060, 1070};
+    TEST_ASSERT_EQUAL_UINT8(6, steps);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expected, starts, 6);
+    TEST_ASSERT_TRUE(track.done);
+    TEST_ASSERT_EQUAL_UINT32(PATTERN_FOREVER, PatternEngine::stepEnd(track));
+    TEST_ASSERT_FALSE(PatternEngine::next(track));
+}
+
+static void test_endless_play_and_held_step() {
+    PatternTrack track;
+    PatternEngine::rewind(track, kTwoSteps, 2, 0, 0);
+    for (int i = 0; i < 1000; i++) TEST_ASSERT_TRUE(PatternEngine::next(track));
+    TEST_ASSERT_EQUAL_UINT32(15000, track.stepStartMs);  // 500 plays of 30 ms
+    TEST_ASSERT_FALSE(track.done);
+
+    // A level of 0 ms holds until stopped
+    PatternEngine::rewind(track, kBlinkThenHold, 2, 1, 0);
+    TEST_ASSERT_TRUE(PatternEngine::next(track));
+    TEST_ASSERT_EQUAL_UINT8(1, track.index);
+    TEST_ASSERT_EQUAL_UINT32(PATTERN_FOREVER, PatternEngine::stepEnd(track));
+    TEST_ASSERT_TRUE(PatternEngine::next(track));
+    TEST_ASSERT_EQUAL_UINT8(1, track.index);
+
+    PatternEngine::rewind(track, nullptr, 3, 1, 0);
+    TEST_ASSERT_TRUE(track.done);
+}
+
+static void test_levels_during_a_step() {
+    const PatternStep& blink = kBlinkThenHold[0];
+    TEST_ASSERT_EQUAL_UINT8(255, PatternEngine::levelAt(blink, 0, 0));
+    TEST_ASSERT_EQUAL_UINT8(255, PatternEngine::levelAt(blink, 0, 99));
+    TEST_ASSERT_EQUAL_UINT8(0, PatternEngine::levelAt(blink, 0, 100));
+    TEST_ASSERT_EQUAL_UINT8(255, PatternEngine::levelAt(blink, 0, 400));
+    TEST_ASSERT_EQUAL_UINT8(0, PatternEngine::levelAt(blink, 0, 600));  // Ends with its off time
+    TEST_ASSERT_EQUAL_UINT8(200, PatternEngine::levelAt(kTwoSteps[1], 0, 5));
+    TEST_ASSERT_EQUAL_UINT8(0, PatternEngine::levelAt(kTwoSteps[0], 200, 5));
+}
+
+static void test_fade_starts_from_the_previous_level() {
+    PatternTrack track;
+    PatternEngine::rewind(track, kFadeUpDown, 2, 1, 0);
+    TEST_ASSERT_EQUAL_UINT8(127, PatternEngine::levelAt(kFadeUpDown[0], track.fromLevel, 500));
+    TEST_ASSERT_TRUE(PatternEngine::next(track));
+    TEST_ASSERT_EQUAL_UINT8(255, track.fromLevel);
+    TEST_ASSERT_EQUAL_UINT8(255, PatternEngine::levelAt(kFadeUpDown[1], track.fromLevel, 0));
+    TEST_ASSERT_EQUAL_UINT8(128, PatternEngine::levelAt(kFadeUpDown[1], track.fromLevel, 500));
+    TEST_ASSERT_EQUAL_UINT8(0, PatternEngine::levelAt(kFadeUpDown[1], track.fromLevel, 1000));
+}
+
+static void test_timer_solver_covers_the_blink_periods() {
+    // From 1 ms to two minutes, within the 1/256 step of the divider
+    for (uint64_t period = 1000; period <= 120000000ULL; period = period * 5 / 4) {
+        LedcSetting setting;
+        TEST_ASSERT_TRUE(PatternEngine::solveTimer(period, CLOCK_HZ, setting));
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(256, setting.divider);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(0x3FFFF, setting.divider);
+        TEST_ASSERT_DOUBLE_WITHIN(period / 256.0, (double)period, periodOf(setting, CLOCK_HZ));
+    }
+    LedcSetting setting;
+    TEST_ASSERT_FALSE(PatternEngine::solveTimer(200000000ULL, CLOCK_HZ, setting));
+
+    // Steady levels: 5 kHz PWM with 10-bit duty
+    TEST_ASSERT_TRUE(PatternEngine::solveTimer(1000000ULL / PATTERN_PWM_HZ, CLOCK_HZ, setting));
+    TEST_ASSERT_EQUAL_UINT8(10, setting.resolution);
+}
+
+static void test_compiled_steps() {
+    LedcSetting setting;
+    TEST_ASSERT_TRUE(PatternEngine::compile(patternBlink(300, 300, 200), 0, CLOCK_HZ, setting));
+    TEST_ASSERT_EQUAL_UINT32(1UL << (setting.resolution - 1), setting.duty);  // Half on
+    TEST_ASSERT_DOUBLE_WITHIN(600000.0 / 256, 600000.0, periodOf(setting, CLOCK_HZ));
+
+    TEST_ASSERT_TRUE(PatternEngine::compile(patternFade(0, 1500), 255, CLOCK_HZ, setting));
+    TEST_ASSERT_TRUE(setting.fade);
+    TEST_ASSERT_EQUAL_UINT32(1UL << setting.resolution, setting.startDuty);
+    TEST_ASSERT_EQUAL_UINT32(0, setting.duty);
+    TEST_ASSERT_EQUAL_UINT32(1500, setting.fadeMs);
+
+    TEST_ASSERT_TRUE(PatternEngine::compile(patternOff(10), 255, CLOCK_HZ, setting));
+    TEST_ASSERT_EQUAL_UINT32(0, setting.duty);
+    TEST_ASSERT_FALSE(PatternEngine::compile(patternBlink(0, 0, 1), 0, CLOCK_HZ, setting));
+
+    // Gamma 2: half the level is a quarter of the duty
+    TEST_ASSERT_UINT32_WITHIN(2, 256, PatternEngine::levelToDuty(128, 10));
+    TEST_ASSERT_EQUAL_UINT32(0, PatternEngine::levelToDuty(0, 10));
+}
+
+static void test_finite_pattern_plays_through_the_event_loop() {
+    EventLoop::begin();  // As setup() does on every boot
+    TEST_ASSERT_FALSE(PatternEngine::start(PATTERN_COUNT));
+    TEST_ASSERT_TRUE(PatternEngine::start(PATTERN_ADMIN_MODE));
+    TEST_ASSERT_EQUAL_UINT8(PATTERN_ADMIN_MODE, PatternEngine::current());
+    TEST_ASSERT_EQUAL_UINT8(255, PatternEngine::level(PatternOutput::Led));
+    TEST_ASSERT_EQUAL_UINT8(0, PatternEngine::level(PatternOutput::Buzzer));
+
+    unsigned long start = millis();
+    TEST_ASSERT_EQUAL_UINT32(EVENT_PATTERN_DONE, EventLoop::waitFor(EVENT_PATTERN_DONE, 2000));
+    TEST_ASSERT_UINT32_WITHIN(EVENTLOOP_TICK_MS, 400, millis() - start);
+    TEST_ASSERT_EQUAL_UINT32(1, EventLoop::stats().timersRun);  // One step: one wake at its end
+    TEST_ASSERT_FALSE(PatternEngine::isPlaying());
+    TEST_ASSERT_EQUAL_UINT8(PATTERN_NONE, PatternEngine::current());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_table_lookup);
+    RUN_TEST(test_pattern_durations);
+    RUN_TEST(test_alarm_indications_need_no_step_wake_for_two_minutes);
+    RUN_TEST(test_steps_and_repeats);
+    RUN_TEST(test_endless_play_and_held_step);
+    RUN_TEST(test_levels_during_a_step);
+    RUN_TEST(test_fade_starts_from_the_previous_level);
+    RUN_TEST(test_timer_solver_covers_the_blink_periods);
+    RUN_TEST(test_compiled_steps);
+    RUN_TEST(test_finite_pattern_plays_through_the_event_loop);
+    return UNITY_END();
+}
@@ -0,0 +1,169 @@
+/**
+ * @file test_main.cpp
+ * @brief RequestBody chunk collection, with several uploads interleaved the
+ *        way ESPAsyncWebServer delivers them.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "RequestBody.h"
+
+/**
+ * @brief Stand-in for AsyncWebServerRequest: owns `_tempObject` and frees
+ *        it when destroyed, also when the upload never completed.
+ */
+struct Upload {
+    void* _tempObject = nullptr;
+    std::string body;          // What the client sends
+    size_t sent = 0;           // Bytes delivered so far
+    RequestBody* done = nullptr;
+    int completions = 0;
+
+    ~Upload() { free(_tempObject); }
+
+    // Delivers the next chunk of up to `chunk` bytes
+    void deliver(size_t chunk) {
+        size_t len = body.size() - sent < chunk ? body.size() - sent : chunk;
+        RequestBody* result = RequestBody::collect(_tempObject, (const uint8_t*)body.data() + sent, len, sent, body.size());
+        sent += len;
+        if (result != nullptr) {
+            done = result;
+            completions++;
+        }
+    }
+    bool finished() const { return sent == body.size(); }
+};
+
+static std::string makeJson(int id, size_t length) {
+    std::string text = "{\"id\":" + std::to_string(id) + ",\"pad\":\"";
+    while (text.size() < length - 2) text += (char)('a' + (text.size() + id) % 26);
+    return text + "\"}";
+}
+
+static uint32_t nextRandom(uint32_t& seed) {
+    seed = seed * 1664525UL + 1013904223UL;
+    return seed >> 8;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_single_chunk_body() {
+    Upload upload;
+    upload.body = "{\"alarmDate\":\"2025-06-15\"}";
+    upload.deliver(1000);
+    TEST_ASSERT_EQUAL_INT(1, upload.completions);
+    TEST_ASSERT_EQUAL_PTR(upload._tempObject, upload.done);
+    TEST_ASSERT_EQUAL_STRING(upload.body.c_str(), upload.done->text());
+    TEST_ASSERT_EQUAL_size_t(upload.body.size(), upload.done->length());
+}
+
+static void test_chunked_body_completes_on_the_last_chunk() {
+    Upload upload;
+    upload.body = makeJson(1, 300);
+    while (!upload.finished()) {
+        TEST_ASSERT_EQUAL_INT(0, upload.completions);
+        upload.deliver(64);
+    }
+    TEST_ASSERT_EQUAL_INT(1, upload.completions);
+    TEST_ASSERT_EQUAL_STRING(upload.body.c_str(), upload.done->text());
+}
+
+static void test_interleaved_uploads_do_not_share_state() {
+    // 8 concurrent uploads, random chunk sizes, delivered in random order
+    const int count = 8;
+    uint32_t seed = 2024;
+    for (int round = 0; round < 200; round++) {
+        Upload uploads[count];
+        for (int i = 0; i < count; i++) {
+            uploads[i].body = makeJson(round * count + i, 20 + nextRandom(seed) % (WEB_BODY_MAX_BYTES - 20));
+        }
+        int remaining = count;
+        while (remaining > 0) {
+            Upload& upload = uploads[nextRandom(seed) % count];
+            if (upload.finished()) continue;
+            upload.deliver(1 + nextRandom(seed) % 200);
+            if (upload.finished()) remaining--;
+        }
+        for (int i = 0; i < count; i++) {
+            TEST_ASSERT_EQUAL_INT(1, uploads[i].completions);
+            TEST_ASSERT_EQUAL_STRING(uploads[i].body.c_str(), uploads[i].done->text());
+            for (int j = 0; j < i; j++) {
+                TEST_ASSERT_TRUE(uploads[i]._tempObject != uploads[j]._tempObject);
+            }
+        }
+    }
+}
+
+static void test_dropped_upload_is_released_by_its_request() {
+    // The request frees its buffer; the other upload is unaffected
+    Upload kept;
+    kept.body = makeJson(1, 200);
+    {
+        Upload dropped;
+        dropped.body = makeJson(2, 200);
+        dropped.deliver(50);
+        kept.deliver(50);
+        TEST_ASSERT_NOT_NULL(dropped._tempObject);
+    }
+    while (!kept.finished()) kept.deliver(50);
+    TEST_ASSERT_EQUAL_STRING(kept.body.c_str(), kept.done->text());
+}
+
+static void test_body_at_the_limit_is_accepted() {
+    Upload upload;
+    upload.body = makeJson(1, WEB_BODY_MAX_BYTES);
+    while (!upload.finished()) upload.deliver(100);
+    TEST_ASSERT_EQUAL_INT(1, upload.completions);
+    TEST_ASSERT_EQUAL_size_t(WEB_BODY_MAX_BYTES, strlen(upload.done->text()));
+}
+
+static void test_oversized_body_gets_no_buffer() {
+    Upload upload;
+    upload.body = makeJson(1, WEB_BODY_MAX_BYTES + 1);
+    while (!upload.finished()) upload.deliver(100);
+    TEST_ASSERT_EQUAL_INT(0, upload.completions);
+    TEST_ASSERT_NULL(upload._tempObject);
+}
+
+static void test_chunk_without_a_first_chunk_is_dropped() {
+    void* slot = nullptr;
+    const uint8_t data[4] = {'a', 'b', 'c', 'd'};
+    TEST_ASSERT_NULL(RequestBody::collect(slot, data, sizeof(data), 4, 8));
+    TEST_ASSERT_NULL(slot);
+}
+
+static void test_chunk_outside_the_body_is_rejected() {
+    RequestBody* body = RequestBody::create(8);
+    TEST_ASSERT_NOT_NULL(body);
+    const uint8_t data[8] = {'0', '1', '2', '3', '4', '5', '6', '7'};
+    TEST_ASSERT_FALSE(body->append(data, 8, 1));
+    TEST_ASSERT_FALSE(body->append(data, 1, 9));
+    TEST_ASSERT_FALSE(body->complete());
+    TEST_ASSERT_TRUE(body->append(data, 8, 0));
+    TEST_ASSERT_TRUE(body->complete());
+    TEST_ASSERT_EQUAL_STRING("01234567", body->text());
+    free(body);
+}
+
+static void test_empty_body_gets_no_buffer() {
+    TEST_ASSERT_NULL(RequestBody::create(0));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_chunk_body);
+    RUN_TEST(test_chunked_body_completes_on_the_last_chunk);
+    RUN_TEST(test_interleaved_uploads_do_not_share_state);
+    RUN_TEST(test_dropped_upload_is_released_by_its_request);
+    RUN_TEST(test_body_at_the_limit_is_accepted);
+    RUN_TEST(test_oversized_body_gets_no_buffer);
+    RUN_TEST(test_chunk_without_a_first_chunk_is_dropped);
+    RUN_TEST(test_chunk_outside_the_body_is_rejected);
+    RUN_TEST(test_empty_body_gets_no_buffer);
+    return UNITY_END();
+}
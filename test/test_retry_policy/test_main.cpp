@@ -0,0 +1,130 @@
+/**
+ * @file test_main.cpp
+ * @brief RetryPolicy backoff schedule, jitter bounds and the RTC-memory
+ *        state, driven by the virtual RTC timer.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "RetryPolicy.h"
+#include "TimeAccounting.h"
+
+#define SECOND_MICROS 1000000ULL
+
+static void sleepSeconds(uint64_t seconds) {
+    TimeAccounting::setHostRtcMicros(TimeAccounting::rtcMicros() + seconds * SECOND_MICROS);
+}
+
+void setUp() {
+    TimeAccounting::setHostRtcMicros(1000 * SECOND_MICROS);
+    RetryPolicy::succeeded();
+}
+
+void tearDown() {}
+
+static void test_backoff_doubles_up_to_the_cap() {
+    const uint32_t expected[] = {60, 120, 240, 480, 960, 1920, 3840, 7680, 15360, 21600, 21600};
+    for (uint16_t failures = 1; failures <= 11; failures++) {
+        TEST_ASSERT_EQUAL_UINT32(expected[failures - 1], RetryPolicy::backoffSeconds(failures, 60, 21600, 0, 12345));
+    }
+    TEST_ASSERT_EQUAL_UINT32(21600, RetryPolicy::backoffSeconds(UINT16_MAX, 60, 21600, 0, 0));
+}
+
+static void test_jitter_stays_within_bounds() {
+    // +/- 25 % of 240 s: 180 to 300 s, both ends reachable
+    TEST_ASSERT_EQUAL_UINT32(180, RetryPolicy::backoffSeconds(3, 60, 21600, 25, 0));
+    TEST_ASSERT_EQUAL_UINT32(300, RetryPolicy::backoffSeconds(3, 60, 21600, 25, 120));
+    uint32_t seed = 1;
+    for (int i = 0; i < 10000; i++) {
+        seed = seed * 1664525UL + 1013904223UL;
+        uint32_t wait = RetryPolicy::backoffSeconds(10, 60, 21600, 25, seed);
+        TEST_ASSERT_UINT32_WITHIN(5400, 21600, wait);
+    }
+}
+
+static void test_wait_is_at_least_one_second() {
+    TEST_ASSERT_EQUAL_UINT32(1, RetryPolicy::backoffSeconds(1, 0, 21600, 25, 7));
+    TEST_ASSERT_EQUAL_UINT32(1, RetryPolicy::backoffSeconds(1, 1, 21600, 100, 0));
+}
+
+static void test_failure_schedules_the_retry_on_the_rtc_timer() {
+    TEST_ASSERT_FALSE(RetryPolicy::pending());
+    TEST_ASSERT_TRUE(RetryPolicy::due());
+
+    uint32_t wait = RetryPolicy::failed();
+    TEST_ASSERT_UINT32_WITHIN(RETRY_BASE_SECONDS * RETRY_JITTER_PERCENT / 100, RETRY_BASE_SECONDS, wait);
+    TEST_ASSERT_TRUE(RetryPolicy::pending());
+    TEST_ASSERT_FALSE(RetryPolicy::due());
+    TEST_ASSERT_EQUAL_UINT32(wait, RetryPolicy::secondsUntilRetry());
+
+    sleepSeconds(wait - 1);
+    TEST_ASSERT_EQUAL_UINT32(1, RetryPolicy::secondsUntilRetry());
+    sleepSeconds(1);
+    TEST_ASSERT_TRUE(RetryPolicy::due());
+    TEST_ASSERT_TRUE(RetryPolicy::pending());  // Still backing off until a sync succeeds
+}
+
+static void test_success_clears_the_backoff() {
+    RetryPolicy::failed();
+    RetryPolicy::failed();
+    TEST_ASSERT_EQUAL_UINT16(2, RetryPolicy::state().failures);
+    RetryPolicy::succeeded();
+    TEST_ASSERT_FALSE(RetryPolicy::pending());
+    TEST_ASSERT_TRUE(RetryPolicy::due());
+    TEST_ASSERT_EQUAL_UINT16(0, RetryPolicy::state().failures);
+
+    // The next failure starts from the base wait again
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(RETRY_BASE_SECONDS * (100 + RETRY_JITTER_PERCENT) / 100, RetryPolicy::failed());
+}
+
+static void test_total_failures_survive_a_success() {
+    uint32_t before = RetryPolicy::state().totalFailures;
+    RetryPolicy::failed();
+    RetryPolicy::succeeded();
+    RetryPolicy::failed();
+    TEST_ASSERT_EQUAL_UINT32(before + 2, RetryPolicy::state().totalFailures);
+}
+
+static void test_validate_detects_corruption() {
+    RetryPolicy::failed();
+    RetryPolicy::failed();
+    RetryState state = RetryPolicy::state();
+    TEST_ASSERT_TRUE(RetryPolicy::validate(state));
+    state.failures = 9;
+    TEST_ASSERT_FALSE(RetryPolicy::validate(state));
+    RetryPolicy::seal(state);
+    TEST_ASSERT_TRUE(RetryPolicy::validate(state));
+}
+
+static void test_day_long_outage_bounds_the_attempts() {
+    // Every attempt fails for 24 h; the device sleeps out each wait
+    uint64_t elapsed = 0;
+    uint32_t attempts = 0;
+    uint32_t lastWait = 0;
+    while (elapsed < 86400) {
+        lastWait = RetryPolicy::failed();
+        attempts++;
+        sleepSeconds(lastWait);
+        elapsed += lastWait;
+        TEST_ASSERT_TRUE(RetryPolicy::due());
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(16, attempts);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(RETRY_MAX_SECONDS * (100 - RETRY_JITTER_PERCENT) / 100, lastWait);
+
+    // Back online: the first attempt after the outage succeeds and resets the schedule
+    RetryPolicy::succeeded();
+    TEST_ASSERT_FALSE(RetryPolicy::pending());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_backoff_doubles_up_to_the_cap);
+    RUN_TEST(test_jitter_stays_within_bounds);
+    RUN_TEST(test_wait_is_at_least_one_second);
+    RUN_TEST(test_failure_schedules_the_retry_on_the_rtc_timer);
+    RUN_TEST(test_success_clears_the_backoff);
+    RUN_TEST(test_total_failures_survive_a_success);
+    RUN_TEST(test_validate_detects_corruption);
+    RUN_TEST(test_day_long_outage_bounds_the_attempts);
+    return UNITY_END();
+}
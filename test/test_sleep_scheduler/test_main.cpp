@@ -0,0 +1,166 @@
+/**
+ * @file test_main.cpp
+ * @brief SleepScheduler margin math, checkpoint and quiet-hour policies,
+ *        and the approach to an alarm weeks away in virtual time.
+ *
+ * The approach runs keep the clock right at every wake and let the sleep
+ * timer run fast or slow by the drift, which is what the margin has to
+ * absorb: no intermediate wake may end inside the guard band.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include "SleepScheduler.h"
+
+#define DAY 86400ULL
+#define NOW 1750032000ULL  // 2025-06-16 00:00:00
+
+static SleepPolicy plainPolicy() {
+    SleepPolicy policy = {};
+    policy.guardSeconds = 120;
+    policy.driftPpm = 5000;
+    policy.minSleepSeconds = 5;
+    return policy;
+}
+
+struct Approach {
+    uint32_t wakes;        // Boots before the alarm, the final one included
+    int64_t lateSeconds;   // Where the final sleep really ended, relative to the alarm
+};
+
+// Sleeps from `now` to the alarm, the timer running `timerPpm` off
+static Approach approach(const SleepScheduler& scheduler, uint64_t now, uint64_t alarm, int32_t timerPpm) {
+    Approach result = {0, 0};
+    while (true) {
+        uint32_t sleep = scheduler.nextSleepSeconds(now, alarm);
+        int64_t slept = (int64_t)sleep + (int64_t)sleep * timerPpm / 1000000;
+        result.wakes++;
+        if (sleep == alarm - now) {
+            result.lateSeconds = (int64_t)(now + slept) - (int64_t)alarm;
+            return result;
+        }
+        now += slept;
+        TEST_ASSERT_TRUE_MESSAGE(now + scheduler.policy().guardSeconds <= alarm, "Intermediate wake inside the guard band");
+        TEST_ASSERT_LESS_THAN_UINT32(1000, result.wakes);
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_margin_is_guard_plus_drift() {
+    SleepScheduler scheduler(plainPolicy());
+    // 10000 s left: 120 s guard + 50 s of drift at 5000 ppm
+    TEST_ASSERT_EQUAL_UINT32(10000 - 170, scheduler.nextSleepSeconds(NOW, NOW + 10000));
+    TEST_ASSERT_EQUAL_UINT32(DAY - 120 - 432, scheduler.nextSleepSeconds(NOW, NOW + DAY));
+
+    scheduler.setDriftPpm(40);
+    TEST_ASSERT_EQUAL_UINT32(10000 - 120, scheduler.nextSleepSeconds(NOW, NOW + 10000));
+}
+
+static void test_final_sleep_lands_on_the_alarm() {
+    SleepScheduler scheduler(plainPolicy());
+    // Within the margin plus the minimum sleep: one sleep to the alarm
+    TEST_ASSERT_EQUAL_UINT32(125, scheduler.nextSleepSeconds(NOW, NOW + 125));
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.nextSleepSeconds(NOW, NOW + 1));
+    // Just past it: one more approach wake
+    TEST_ASSERT_EQUAL_UINT32(6, scheduler.nextSleepSeconds(NOW, NOW + 126));
+}
+
+static void test_alarm_in_the_past_sleeps_the_minimum() {
+    SleepPolicy policy = plainPolicy();
+    SleepScheduler scheduler(policy);
+    TEST_ASSERT_EQUAL_UINT32(5, scheduler.nextSleepSeconds(NOW, NOW));
+    TEST_ASSERT_EQUAL_UINT32(5, scheduler.nextSleepSeconds(NOW, NOW - 60));
+    policy.minSleepSeconds = 0;
+    TEST_ASSERT_EQUAL_UINT32(1, SleepScheduler(policy).nextSleepSeconds(NOW, NOW - 60));
+}
+
+static void test_direct_approach_sleeps_in_one_go() {
+    SleepPolicy policy = plainPolicy();
+    policy.directSeconds = 600;
+    SleepScheduler scheduler(policy);
+    TEST_ASSERT_EQUAL_UINT32(600, scheduler.nextSleepSeconds(NOW, NOW + 600));
+    TEST_ASSERT_EQUAL_UINT32(601 - 123, scheduler.nextSleepSeconds(NOW, NOW + 601));
+}
+
+static void test_checkpoints_cap_the_sleep() {
+    SleepPolicy policy = plainPolicy();
+    policy.maxSleepSeconds = 3600;
+    SleepScheduler scheduler(policy);
+    TEST_ASSERT_EQUAL_UINT32(3600, scheduler.nextSleepSeconds(NOW, NOW + 3 * DAY));
+    TEST_ASSERT_EQUAL_UINT32(3000 - 135, scheduler.nextSleepSeconds(NOW, NOW + 3000));
+}
+
+static void test_sleep_fits_the_device_timer() {
+    // Device::deepSleep() takes 32-bit milliseconds
+    SleepScheduler scheduler(plainPolicy());
+    TEST_ASSERT_EQUAL_UINT32(4294967UL, scheduler.nextSleepSeconds(NOW, NOW + 365 * DAY));
+}
+
+static void test_quiet_hours_defer_checkpoints() {
+    SleepPolicy policy = plainPolicy();
+    policy.maxSleepSeconds = 6 * 3600;
+    policy.quietStartHour = 22;
+    policy.quietEndHour = 6;
+    SleepScheduler scheduler(policy);
+
+    // 20:00 + 6 h lands at 02:00: deferred to 06:00
+    uint64_t evening = NOW + 20 * 3600;
+    TEST_ASSERT_EQUAL_UINT32(10 * 3600, scheduler.nextSleepSeconds(evening, evening + 3 * DAY));
+    // 12:00 + 6 h is outside the window
+    uint64_t noon = NOW + 12 * 3600;
+    TEST_ASSERT_EQUAL_UINT32(6 * 3600, scheduler.nextSleepSeconds(noon, noon + 3 * DAY));
+    // Never past the last safe wake before an alarm inside the window
+    uint64_t alarm = NOW + DAY + 4 * 3600;
+    uint32_t sleep = scheduler.nextSleepSeconds(evening, alarm);
+    TEST_ASSERT_EQUAL_UINT32(8 * 3600 - 120 - 144, sleep);
+
+    // Equal hours disable the window
+    policy.quietStartHour = policy.quietEndHour = 6;
+    TEST_ASSERT_EQUAL_UINT32(6 * 3600, SleepScheduler(policy).nextSleepSeconds(evening, evening + 3 * DAY));
+}
+
+static void test_approach_never_overshoots_with_drift() {
+    // The timer runs up to the policy drift fast or slow, from every distance up to a week
+    SleepScheduler scheduler(plainPolicy());
+    const int32_t timerPpm[] = {-5000, -1000, 0, 1000, 5000};
+    for (int32_t ppm : timerPpm) {
+        for (uint64_t remaining = 1; remaining <= 7 * DAY; remaining = remaining * 3 / 2 + 1) {
+            Approach result = approach(scheduler, NOW, NOW + remaining, ppm);
+            TEST_ASSERT_INT64_WITHIN(2, 0, result.lateSeconds);
+            TEST_ASSERT_LESS_OR_EQUAL_UINT32(6, result.wakes);
+        }
+    }
+}
+
+static void test_three_week_alarm_with_the_default_policy() {
+    SleepScheduler scheduler;
+    const int32_t timerPpm[] = {-4000, 0, 4000};
+    for (int32_t ppm : timerPpm) {
+        Approach result = approach(scheduler, NOW, NOW + 21 * DAY, ppm);
+        // One checkpoint a day, then the approach
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(24, result.wakes);
+        TEST_ASSERT_INT64_WITHIN(3, 0, result.lateSeconds);
+
+        char message[80];
+        snprintf(message, sizeof(message), "timer %+ld ppm: %lu wakes, %+lld s", (long)ppm,
+                 (unsigned long)result.wakes, (long long)result.lateSeconds);
+        TEST_MESSAGE(message);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_margin_is_guard_plus_drift);
+    RUN_TEST(test_final_sleep_lands_on_the_alarm);
+    RUN_TEST(test_alarm_in_the_past_sleeps_the_minimum);
+    RUN_TEST(test_direct_approach_sleeps_in_one_go);
+    RUN_TEST(test_checkpoints_cap_the_sleep);
+    RUN_TEST(test_sleep_fits_the_device_timer);
+    RUN_TEST(test_quiet_hours_defer_checkpoints);
+    RUN_TEST(test_approach_never_overshoots_with_drift);
+    RUN_TEST(test_three_week_alarm_with_the_default_policy);
+    return UNITY_END();
+}
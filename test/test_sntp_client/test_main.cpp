@@ -0,0 +1,206 @@
+/**
+ * @file test_main.cpp
+ * @brief SntpClient answer validation, offset/delay math, NTP timestamp
+ *        conversion and the DNS cache, plus a parallel exchange against the
+ *        simulator's loopback NTP servers.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "SntpClient.h"
+#include "SimNetwork.h"
+#include "Crc32.h"
+
+#define LOCAL_T1 1000000ULL            // Local clock when the request left
+#define SERVER_T2 1750000000125000ULL  // Fractions that convert exactly (multiples of 1/64 s)
+#define SERVER_T3 1750000000375000ULL
+#define LOCAL_T4 1550000ULL
+#define TRANSMIT 0x1122334455667788ULL
+
+static void writeTimestamp(uint8_t* bytes, uint64_t value) {
+    for (int i = 7; i >= 0; i--) {
+        bytes[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+// A valid stratum 2 answer to the request stamped TRANSMIT
+static void makeAnswer(uint8_t* packet) {
+    memset(packet, 0, SNTP_PACKET_SIZE);
+    packet[0] = (0 << 6) | (4 << 3) | 4;  // LI = 0, VN = 4, Mode = server
+    packet[1] = 2;
+    writeTimestamp(packet + 24, TRANSMIT);
+    writeTimestamp(packet + 32, SntpClient::toNtp(SERVER_T2));
+    writeTimestamp(packet + 40, SntpClient::toNtp(SERVER_T3));
+}
+
+static bool parse(const uint8_t* packet, SntpSample* sample) {
+    return SntpClient::parseResponse(packet, SNTP_PACKET_SIZE, TRANSMIT, LOCAL_T1, LOCAL_T4, sample);
+}
+
+static uint32_t nameHash(const char* name) {
+    return crc32Update(name, strlen(name));
+}
+
+void setUp() {
+    Sim::powerOn(1750000000ULL * 1000000ULL, 0);
+    // Short round trips so that every server answers within NTP_SETTLE_MS
+    SimNetworkModel model = {1500, 600, 250, 4, 40, true};
+    SimNetwork::configure(model);
+}
+
+void tearDown() {
+    SimNetwork::shutdown();
+}
+
+static void test_offset_and_delay_from_the_four_timestamps() {
+    uint8_t packet[SNTP_PACKET_SIZE];
+    makeAnswer(packet);
+    SntpSample sample = {};
+    TEST_ASSERT_TRUE(parse(packet, &sample));
+
+    // delay = (T4 - T1) - (T3 - T2) = 550 ms - 250 ms
+    TEST_ASSERT_EQUAL_UINT32(300000, sample.delayMicros);
+    // offset = ((T2 - T1) + (T3 - T4)) / 2
+    int64_t expected = (((int64_t)SERVER_T2 - (int64_t)LOCAL_T1) + ((int64_t)SERVER_T3 - (int64_t)LOCAL_T4)) / 2;
+    TEST_ASSERT_EQUAL_INT64(expected, sample.offsetMicros);
+    TEST_ASSERT_EQUAL_UINT8(2, sample.stratum);
+}
+
+static void test_rejects_unusable_answers() {
+    uint8_t packet[SNTP_PACKET_SIZE];
+    SntpSample sample = {};
+
+    makeAnswer(packet);
+    writeTimestamp(packet + 24, TRANSMIT + 1);  // Answer to another request
+    TEST_ASSERT_FALSE(parse(packet, &sample));
+
+    makeAnswer(packet);
+    packet[1] = 0;  // Kiss-o'-death
+    TEST_ASSERT_FALSE(parse(packet, &sample));
+
+    makeAnswer(packet);
+    packet[1] = 16;  // Unsynchronized
+    TEST_ASSERT_FALSE(parse(packet, &sample));
+    packet[1] = 15;
+    TEST_ASSERT_TRUE(parse(packet, &sample));
+
+    makeAnswer(packet);
+    packet[0] |= 3 << 6;  // Leap indicator 3: clock not synchronized
+    TEST_ASSERT_FALSE(parse(packet, &sample));
+
+    makeAnswer(packet);
+    packet[0] = (0 << 6) | (4 << 3) | 3;  // A client request, not an answer
+    TEST_ASSERT_FALSE(parse(packet, &sample));
+
+    makeAnswer(packet);
+    memset(packet + 40, 0, 8);  // No transmit timestamp
+    TEST_ASSERT_FALSE(parse(packet, &sample));
+
+    makeAnswer(packet);
+    TEST_ASSERT_FALSE(SntpClient::parseResponse(packet, SNTP_PACKET_SIZE - 1, TRANSMIT, LOCAL_T1, LOCAL_T4, &sample));
+}
+
+static void test_request_layout() {
+    uint8_t packet[SNTP_PACKET_SIZE];
+    memset(packet, 0xAA, sizeof(packet));
+    SntpClient::buildRequest(packet, TRANSMIT);
+    TEST_ASSERT_EQUAL_HEX8(0x23, packet[0]);  // LI 0, VN 4, client
+    TEST_ASSERT_EQUAL_HEX8(0x11, packet[40]);
+    TEST_ASSERT_EQUAL_HEX8(0x88, packet[47]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, packet[24]);
+}
+
+static void test_ntp_timestamp_conversion() {
+    // Era 0: whole seconds convert exactly, fractions to within 1 us
+    TEST_ASSERT_EQUAL_UINT64(SNTP_UNIX_OFFSET << 32, SntpClient::toNtp(0));
+    TEST_ASSERT_EQUAL_UINT64(0, SntpClient::fromNtp(SNTP_UNIX_OFFSET << 32));
+    TEST_ASSERT_EQUAL_UINT64(SERVER_T2, SntpClient::fromNtp(SntpClient::toNtp(SERVER_T2)));
+    uint64_t seed = 1750000000ULL * 1000000ULL;
+    for (int i = 0; i < 1000; i++) {
+        seed += 987654321ULL;
+        TEST_ASSERT_UINT64_WITHIN(1, seed, SntpClient::fromNtp(SntpClient::toNtp(seed)));
+    }
+
+    // Era 1: seconds field 0 is 2036-02-07 06:28:16 UTC
+    TEST_ASSERT_EQUAL_UINT64(2085978496ULL * 1000000ULL, SntpClient::fromNtp(0));
+    uint64_t in2040 = 2208988800ULL * 1000000ULL + 500000ULL;
+    TEST_ASSERT_LESS_THAN_UINT64(0x80000000ULL, SntpClient::toNtp(in2040) >> 32);
+    TEST_ASSERT_EQUAL_UINT64(in2040, SntpClient::fromNtp(SntpClient::toNtp(in2040)));
+}
+
+static void test_dns_cache_expires_and_misses_on_a_new_name() {
+    SntpDnsCache cache = {};
+    uint32_t ip = 0;
+    TEST_ASSERT_FALSE(SntpClient::lookup(cache, 0, nameHash("pool.ntp.org"), 0, &ip));  // Never sealed
+
+    SntpClient::store(cache, 1, nameHash("pool.ntp.org"), 0x0A000001, 5000000);
+    TEST_ASSERT_TRUE(SntpClient::validate(cache));
+    TEST_ASSERT_TRUE(SntpClient::lookup(cache, 1, nameHash("pool.ntp.org"), 4999999, &ip));
+    TEST_ASSERT_EQUAL_HEX32(0x0A000001, ip);
+    TEST_ASSERT_FALSE(SntpClient::lookup(cache, 1, nameHash("pool.ntp.org"), 5000000, &ip));  // TTL over
+    TEST_ASSERT_FALSE(SntpClient::lookup(cache, 1, nameHash("time.google.com"), 0, &ip));    // Renamed server
+    TEST_ASSERT_FALSE(SntpClient::lookup(cache, 0, nameHash("pool.ntp.org"), 0, &ip));       // Other slot
+    TEST_ASSERT_FALSE(SntpClient::lookup(cache, NTP_MAX_SERVERS, nameHash("pool.ntp.org"), 0, &ip));
+
+    SntpClient::store(cache, 1, 0, 0, 0);  // forget()
+    TEST_ASSERT_FALSE(SntpClient::lookup(cache, 1, nameHash("pool.ntp.org"), 0, &ip));
+}
+
+static void test_corrupted_dns_cache_is_ignored() {
+    SntpDnsCache cache = {};
+    uint32_t ip = 0;
+    SntpClient::store(cache, 0, nameHash("pool.ntp.org"), 0x0A000001, 5000000);
+    cache.entries[0].ip = 0x0A000002;
+    TEST_ASSERT_FALSE(SntpClient::validate(cache));
+    TEST_ASSERT_FALSE(SntpClient::lookup(cache, 0, nameHash("pool.ntp.org"), 0, &ip));
+}
+
+static void test_parallel_exchange_keeps_the_lowest_delay() {
+    TEST_ASSERT_TRUE(SimNetwork::connect(SimNetwork::model().leaseMillis, 1000));
+
+    // "c.test" is resolved first, so its stand-in is the fastest: the last
+    // slot of the client wins, not the first one to be sent
+    uint32_t ip;
+    TEST_ASSERT_TRUE(SimNetwork::resolve("c.test", &ip));
+    SimNetwork::resolve("a.test", &ip);
+    SimNetwork::resolve("b.test", &ip);
+
+    const char* servers[] = {"a.test", "b.test", "c.test"};
+    SntpClient client(servers, 3);
+    TEST_ASSERT_TRUE(client.sync());
+    TEST_ASSERT_EQUAL(SntpState::Done, client.state());
+    TEST_ASSERT_EQUAL_UINT8(3, client.answered());
+    TEST_ASSERT_EQUAL_UINT8(2, client.best().server);
+    TEST_ASSERT_UINT32_WITHIN(1000, 4000, client.best().delayMicros);
+
+    // The best answer gives UTC to within the measurement error
+    uint64_t utc = Sim::trueMicros() - (uint64_t)TIMEOFFSET * 1000000ULL;
+    TEST_ASSERT_UINT64_WITHIN(2000, utc, client.unixMicros());
+    client.stop();
+}
+
+static void test_second_exchange_uses_the_cached_addresses() {
+    SimNetwork::connect(SimNetwork::model().leaseMillis, 1000);
+    const char* servers[] = {"a.test", "b.test", "c.test"};
+    SntpClient client(servers, 3);
+    TEST_ASSERT_TRUE(client.sync());
+    TEST_ASSERT_EQUAL_UINT8(3, client.answered());  // Silent servers would lose their cache entry
+    uint32_t lookups = Sim::counters().dnsLookups;
+    TEST_ASSERT_TRUE(client.sync());
+    TEST_ASSERT_EQUAL_UINT32(lookups, Sim::counters().dnsLookups);
+    client.stop();
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_offset_and_delay_from_the_four_timestamps);
+    RUN_TEST(test_rejects_unusable_answers);
+    RUN_TEST(test_request_layout);
+    RUN_TEST(test_ntp_timestamp_conversion);
+    RUN_TEST(test_dns_cache_expires_and_misses_on_a_new_name);
+    RUN_TEST(test_corrupted_dns_cache_is_ignored);
+    RUN_TEST(test_parallel_exchange_keeps_the_lowest_delay);
+    RUN_TEST(test_second_exchange_uses_the_cached_addresses);
+    return UNITY_END();
+}
@@ -0,0 +1,161 @@
+/**
+ * @file test_main.cpp
+ * @brief TimeAccounting anchors and wall-clock reconstruction, including a
+ *        30-day run of timer wakes on the virtual RTC timer.
+ *
+ * Each simulated wake stays awake for a variable time, then deep sleeps for
+ * one sleep period; the clock is only ever rebuilt from the anchor, like
+ * after a real deep-sleep wake.
+ */
+
+#include <unity.h>
+#include <sys/time.h>
+#include "TimeAccounting.h"
+
+#define SECOND_MICROS 1000000ULL
+#define DAY_MICROS (86400ULL * SECOND_MICROS)
+#define START_MICROS (1750000000ULL * SECOND_MICROS)
+#define SLEEP_MICROS (60ULL * SECOND_MICROS)
+
+// Correction (ppb, positive = slow) that cancels an RTC running `ppm` fast
+static int32_t correctionFor(double ppm) {
+    double rate = 1.0 + ppm / 1e6;
+    return (int32_t)(1e9 / rate - 1e9 + (ppm > 0 ? -0.5 : 0.5));
+}
+
+// Deterministic awake time in [0.2, 2.2) s
+static uint64_t awakeMicros(uint32_t& seed) {
+    seed = seed * 1664525UL + 1013904223UL;
+    return 200000ULL + (seed >> 8) % 2000000ULL;
+}
+
+static int64_t clockError() {
+    return (int64_t)TimeAccounting::nowMicros() - (int64_t)Sim::trueMicros();
+}
+
+static int64_t magnitude(int64_t value) {
+    return value < 0 ? -value : value;
+}
+
+struct RunResult {
+    int64_t maxError;    ///< Largest |anchor clock - reference| seen on a wake
+    int64_t naiveError;  ///< Error of a clock that adds one sleep period per wake
+    int64_t wakes;       ///< Number of wakes
+};
+
+// Sim::sleep() rounds the reference time down to whole microseconds, up to 1 us per wake
+static int64_t allowedError(const RunResult& result) {
+    return result.wakes + 1000;
+}
+
+// 30 days of wake, awake, sleep; the system clock is restored on every wake
+static RunResult runDays(uint32_t days, double driftPpm, int32_t driftPpb) {
+    Sim::powerOn(START_MICROS, driftPpm);
+    TimeAccounting::setUnixMicros(START_MICROS);
+    TimeAccounting::setDriftPpb(driftPpb);
+
+    RunResult result = {0, 0, 0};
+    uint64_t naive = START_MICROS;
+    uint32_t seed = 42;
+    uint64_t end = START_MICROS + days * DAY_MICROS;
+    while (Sim::trueMicros() < end) {
+        Sim::advance(awakeMicros(seed));
+        Sim::sleep(SLEEP_MICROS);
+        naive += SLEEP_MICROS;
+        result.wakes++;
+        TimeAccounting::restore();
+
+        int64_t error = magnitude(clockError());
+        if (error > result.maxError) result.maxError = error;
+
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        TEST_ASSERT_EQUAL_UINT64(TimeAccounting::nowMicros(), (uint64_t)tv.tv_sec * SECOND_MICROS + tv.tv_usec);
+    }
+    result.naiveError = magnitude((int64_t)naive - (int64_t)Sim::trueMicros());
+    return result;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_anchor_validates_and_detects_corruption() {
+    TimeAnchor anchor = TimeAccounting::makeAnchor(START_MICROS, 12345, -40000);
+    TEST_ASSERT_TRUE(TimeAccounting::validate(anchor));
+    anchor.rtcMicros++;
+    TEST_ASSERT_FALSE(TimeAccounting::validate(anchor));
+
+    TimeAnchor zeroed = {};
+    TEST_ASSERT_FALSE(TimeAccounting::validate(zeroed));
+}
+
+static void test_reconstruct_adds_elapsed_rtc_time() {
+    TimeAnchor anchor = TimeAccounting::makeAnchor(START_MICROS, 5 * SECOND_MICROS);
+    TEST_ASSERT_EQUAL_UINT64(START_MICROS, TimeAccounting::reconstruct(anchor, 5 * SECOND_MICROS));
+    TEST_ASSERT_EQUAL_UINT64(START_MICROS + DAY_MICROS, TimeAccounting::reconstruct(anchor, 5 * SECOND_MICROS + DAY_MICROS));
+}
+
+static void test_reconstruct_applies_drift() {
+    // +1000 ppb (slow RTC) over 1000 s adds 1 ms, -1000 ppb removes it
+    TimeAnchor slow = TimeAccounting::makeAnchor(START_MICROS, 0, 1000);
+    TimeAnchor fast = TimeAccounting::makeAnchor(START_MICROS, 0, -1000);
+    TEST_ASSERT_EQUAL_UINT64(START_MICROS + 1000 * SECOND_MICROS + 1000, TimeAccounting::reconstruct(slow, 1000 * SECOND_MICROS));
+    TEST_ASSERT_EQUAL_UINT64(START_MICROS + 1000 * SECOND_MICROS - 1000, TimeAccounting::reconstruct(fast, 1000 * SECOND_MICROS));
+}
+
+static void test_reconstruct_after_rtc_reset_returns_anchor() {
+    TimeAnchor anchor = TimeAccounting::makeAnchor(START_MICROS, DAY_MICROS);
+    TEST_ASSERT_EQUAL_UINT64(START_MICROS, TimeAccounting::reconstruct(anchor, 1000));
+}
+
+static void test_set_time_anchors_and_keeps_drift() {
+    Sim::powerOn(START_MICROS, 0);
+    TimeAccounting::setUnixTime(START_MICROS / SECOND_MICROS);
+    TimeAccounting::setDriftPpb(-25000);
+    Sim::advance(10 * SECOND_MICROS);
+    TimeAccounting::setUnixMicros(START_MICROS + 10 * SECOND_MICROS + 500000);
+    TEST_ASSERT_TRUE(TimeAccounting::isAnchored());
+    TEST_ASSERT_EQUAL_INT32(-25000, TimeAccounting::anchor().driftPpb);
+    TEST_ASSERT_EQUAL_UINT64(10 * SECOND_MICROS, TimeAccounting::anchor().rtcMicros);
+    TEST_ASSERT_EQUAL_UINT64(START_MICROS / SECOND_MICROS + 10, TimeAccounting::now());
+}
+
+static void test_30_days_without_drift_do_not_accumulate_error() {
+    // ~43k wakes with variable awake times: anchor time stays exact, a
+    // nominal-period clock loses every awake interval
+    RunResult result = runDays(30, 0, 0);
+    TEST_ASSERT_LESS_OR_EQUAL_INT64(1, result.maxError);
+    TEST_ASSERT_GREATER_THAN_INT64(40000, result.wakes);
+    TEST_ASSERT_GREATER_THAN_INT64(DAY_MICROS / 2, result.naiveError);
+}
+
+static void test_30_days_with_corrected_drift() {
+    RunResult result = runDays(30, 40, correctionFor(40));
+    TEST_ASSERT_LESS_OR_EQUAL_INT64(allowedError(result), result.maxError);
+}
+
+static void test_30_days_with_uncorrected_drift() {
+    // 40 ppm over 30 days is 103.7 s; the anchor adds no error of its own
+    RunResult result = runDays(30, 40, 0);
+    TEST_ASSERT_INT64_WITHIN(200000, 103680000LL, result.maxError);
+}
+
+static void test_30_days_with_slow_rtc() {
+    RunResult result = runDays(30, -120, correctionFor(-120));
+    TEST_ASSERT_LESS_OR_EQUAL_INT64(allowedError(result), result.maxError);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_anchor_validates_and_detects_corruption);
+    RUN_TEST(test_reconstruct_adds_elapsed_rtc_time);
+    RUN_TEST(test_reconstruct_applies_drift);
+    RUN_TEST(test_reconstruct_after_rtc_reset_returns_anchor);
+    RUN_TEST(test_set_time_anchors_and_keeps_drift);
+    RUN_TEST(test_30_days_without_drift_do_not_accumulate_error);
+    RUN_TEST(test_30_days_with_corrected_drift);
+    RUN_TEST(test_30_days_with_uncorrected_drift);
+    RUN_TEST(test_30_days_with_slow_rtc);
+    return UNITY_END();
+}
@@ -0,0 +1,193 @@
+/**
+ * @file test_main.cpp
+ * @brief TimeJournal head recovery on the file-backed partition emulator,
+ *        including power cuts in the middle of a record write and in the
+ *        middle of a sector erase.
+ *
+ * A "power cut" closes the image, patches its bytes directly (a record cut
+ * short, a sector half erased) and reopens it, which is what the next boot
+ * sees.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "TimeJournal.h"
+
+#define IMAGE "test_time_journal.img"
+#define SECTORS 4
+#define PER_SECTOR TIME_JOURNAL_RECORDS_PER_SECTOR
+#define BASE_TIME 1750000000ULL
+
+static PartitionFlash flash;
+
+// Boot: open the image and recover the journal
+static void reboot() {
+    flash.end();
+    TEST_ASSERT_TRUE(flash.begin(IMAGE, SECTORS * PARTITION_FLASH_SECTOR));
+    TEST_ASSERT_TRUE(TimeJournal::begin(flash));
+}
+
+static void appendRecords(uint32_t count, uint32_t first) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t time = BASE_TIME + first + i;
+        TEST_ASSERT_TRUE(TimeJournal::append(time, time));
+    }
+}
+
+static uint32_t latestSequence() {
+    JournalRecord record;
+    if (!TimeJournal::latest(record)) return 0;
+    TEST_ASSERT_EQUAL_UINT64(BASE_TIME + record.sequence, record.currentTime);  // Record n holds time n
+    return record.sequence;
+}
+
+// Power cut: the image is patched while the device is off
+static void patchImage(size_t offset, const void* data, size_t length) {
+    flash.end();
+    FILE* file = fopen(IMAGE, "r+b");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, (long)offset, SEEK_SET);
+    fwrite(data, 1, length, file);
+    fclose(file);
+}
+
+static size_t slotOffset(size_t sector, size_t slot) {
+    return sector * PARTITION_FLASH_SECTOR + slot * sizeof(JournalRecord);
+}
+
+void setUp() {
+    remove(IMAGE);
+    reboot();
+}
+
+void tearDown() {
+    flash.end();
+    remove(IMAGE);
+}
+
+static void test_empty_partition_starts_a_new_journal() {
+    JournalRecord record;
+    TEST_ASSERT_TRUE(TimeJournal::isReady());
+    TEST_ASSERT_FALSE(TimeJournal::latest(record));
+    appendRecords(1, 1);
+    TEST_ASSERT_EQUAL_UINT32(1, latestSequence());
+}
+
+static void test_head_is_recovered_at_every_position() {
+    // Three passes over the ring, rebooting after every append
+    for (uint32_t n = 1; n <= 3 * SECTORS * PER_SECTOR + 5; n++) {
+        appendRecords(1, n);
+        reboot();
+        TEST_ASSERT_EQUAL_UINT32(n, latestSequence());
+    }
+}
+
+static void test_recovered_journal_continues_the_sequence() {
+    appendRecords(PER_SECTOR + 10, 1);
+    reboot();
+    appendRecords(5, PER_SECTOR + 11);
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(PER_SECTOR + 15, latestSequence());
+}
+
+static void test_record_cut_mid_write_falls_back_to_the_previous_one() {
+    // Power cut while record 41 was being written: only its first half reached the flash
+    appendRecords(40, 1);
+    JournalRecord torn = TimeJournal::makeRecord(41, BASE_TIME + 41, BASE_TIME + 41);
+    patchImage(slotOffset(0, 40), &torn, sizeof(torn) / 2);
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(40, latestSequence());
+
+    // The torn slot is skipped, not rewritten
+    appendRecords(1, 41);
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(41, latestSequence());
+    JournalRecord record;
+    flash.read(slotOffset(0, 41), &record, sizeof(record));
+    TEST_ASSERT_TRUE(TimeJournal::validate(record));
+    TEST_ASSERT_EQUAL_UINT32(41, record.sequence);
+}
+
+static void test_record_cut_at_the_end_of_a_sector() {
+    appendRecords(PER_SECTOR - 1, 1);
+    JournalRecord torn = TimeJournal::makeRecord(PER_SECTOR, BASE_TIME + PER_SECTOR, BASE_TIME + PER_SECTOR);
+    patchImage(slotOffset(0, PER_SECTOR - 1), &torn, 20);
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(PER_SECTOR - 1, latestSequence());
+    appendRecords(1, PER_SECTOR);  // Moves on to sector 1
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(PER_SECTOR, latestSequence());
+}
+
+static void test_erase_cut_mid_sector_keeps_the_full_head() {
+    // After one pass sector 2 holds old records. Power cut while erasing it
+    // for record 2 * PER_SECTOR + 1: its first half is erased, the rest stale
+    uint32_t written = SECTORS * PER_SECTOR + 2 * PER_SECTOR;
+    appendRecords(written, 1);
+    uint8_t erased[PARTITION_FLASH_SECTOR / 2];
+    memset(erased, 0xFF, sizeof(erased));
+    patchImage(slotOffset(2, 0), erased, sizeof(erased));
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(written, latestSequence());
+
+    // The next append erases sector 2 again and starts it cleanly
+    appendRecords(1, written + 1);
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(written + 1, latestSequence());
+    JournalRecord record;
+    flash.read(slotOffset(2, PER_SECTOR - 1), &record, sizeof(record));
+    TEST_ASSERT_TRUE(TimeJournal::isErased(record));
+}
+
+static void test_erase_cut_in_sector_0_scans_the_ring() {
+    // Sector 0 is the one being erased when the ring wraps: no valid first record there
+    uint32_t written = SECTORS * PER_SECTOR;
+    appendRecords(written, 1);
+    uint8_t erased[PARTITION_FLASH_SECTOR / 2];
+    memset(erased, 0xFF, sizeof(erased));
+    patchImage(slotOffset(0, 0), erased, sizeof(erased));
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(written, latestSequence());
+
+    appendRecords(PER_SECTOR + 1, written + 1);
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(written + PER_SECTOR + 1, latestSequence());
+}
+
+static void test_partition_too_small_is_refused() {
+    PartitionFlash small;
+    TEST_ASSERT_TRUE(small.begin("test_time_journal_small.img", PARTITION_FLASH_SECTOR));
+    TEST_ASSERT_FALSE(TimeJournal::begin(small));
+    TEST_ASSERT_FALSE(TimeJournal::isReady());
+    TEST_ASSERT_FALSE(TimeJournal::append(BASE_TIME, BASE_TIME));
+    small.end();
+    remove("test_time_journal_small.img");
+}
+
+static void test_flash_writes_only_clear_bits() {
+    // The emulator must behave like NOR flash for the tests above to mean anything
+    uint8_t value = 0xF0;
+    TEST_ASSERT_TRUE(flash.write(slotOffset(3, 0), &value, 1));
+    value = 0x0F;
+    TEST_ASSERT_TRUE(flash.write(slotOffset(3, 0), &value, 1));
+    TEST_ASSERT_TRUE(flash.read(slotOffset(3, 0), &value, 1));
+    TEST_ASSERT_EQUAL_UINT8(0x00, value);
+    TEST_ASSERT_TRUE(flash.eraseSector(3));
+    TEST_ASSERT_TRUE(flash.read(slotOffset(3, 0), &value, 1));
+    TEST_ASSERT_EQUAL_UINT8(0xFF, value);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_partition_starts_a_new_journal);
+    RUN_TEST(test_head_is_recovered_at_every_position);
+    RUN_TEST(test_recovered_journal_continues_the_sequence);
+    RUN_TEST(test_record_cut_mid_write_falls_back_to_the_previous_one);
+    RUN_TEST(test_record_cut_at_the_end_of_a_sector);
+    RUN_TEST(test_erase_cut_mid_sector_keeps_the_full_head);
+    RUN_TEST(test_erase_cut_in_sector_0_scans_the_ring);
+    RUN_TEST(test_partition_too_small_is_refused);
+    RUN_TEST(test_flash_writes_only_clear_bits);
+    return UNITY_END();
+}
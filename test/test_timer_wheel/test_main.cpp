@@ -0,0 +1,171 @@
+/**
+ * @file test_main.cpp
+ * @brief TimerWheel hashing of delays into slots and rounds, periodic
+ *        re-arming, cancellation from callbacks and pool exhaustion.
+ */
+
+#include <unity.h>
+#include "TimerWheel.h"
+
+#define SLOTS EVENTLOOP_WHEEL_SLOTS
+
+static TimerWheel wheel;
+static uint32_t now;  // Ticks advanced since setUp()
+
+struct Probe {
+    uint32_t runs;
+    uint32_t lastTick;
+    int id;  // Timer to cancel from the callback (-1 = none)
+};
+
+static void record(void* context) {
+    Probe* probe = (Probe*)context;
+    probe->runs++;
+    probe->lastTick = now;
+    if (probe->id >= 0) wheel.cancel(probe->id);
+}
+
+// Advances one tick at a time so that callbacks see the tick they ran at
+static uint32_t step(uint32_t ticks) {
+    uint32_t fired = 0;
+    while (ticks-- > 0) {
+        now++;
+        fired += wheel.advance(1);
+    }
+    return fired;
+}
+
+void setUp() {
+    wheel.clear();
+    now = 0;
+}
+
+void tearDown() {}
+
+static void test_delays_hash_into_slots_and_rounds() {
+    const uint32_t delays[] = {1, SLOTS - 1, SLOTS, SLOTS + 1, 2 * SLOTS, 3 * SLOTS + 5};
+    for (uint32_t delay : delays) {
+        setUp();
+        Probe probe = {0, 0, -1};
+        TEST_ASSERT_GREATER_OR_EQUAL_INT(0, wheel.schedule(delay, record, &probe));
+        TEST_ASSERT_EQUAL_UINT32(delay, wheel.ticksUntilNext());
+        step(delay - 1);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, probe.runs, "Ran early");
+        TEST_ASSERT_EQUAL_UINT32(1, wheel.ticksUntilNext());
+        step(1);
+        TEST_ASSERT_EQUAL_UINT32(1, probe.runs);
+        TEST_ASSERT_EQUAL_UINT32(delay, probe.lastTick);
+        TEST_ASSERT_EQUAL_UINT8(0, wheel.armed());
+        TEST_ASSERT_EQUAL_UINT32(TIMER_WHEEL_NONE, wheel.ticksUntilNext());
+    }
+}
+
+static void test_zero_delay_runs_on_the_next_tick() {
+    Probe probe = {0, 0, -1};
+    wheel.schedule(0, record, &probe);
+    TEST_ASSERT_EQUAL_UINT32(1, wheel.ticksUntilNext());
+    TEST_ASSERT_EQUAL_UINT32(1, wheel.advance(1));
+}
+
+static void test_large_advance_runs_everything_due() {
+    Probe probe = {0, 0, -1};
+    wheel.schedule(SLOTS + 1, record, &probe);
+    wheel.schedule(5, record, &probe);
+    TEST_ASSERT_EQUAL_UINT32(1, wheel.advance(SLOTS));
+    TEST_ASSERT_EQUAL_UINT32(1, wheel.advance(1));
+    TEST_ASSERT_EQUAL_UINT32(2, probe.runs);
+}
+
+static void test_periodic_timer_does_not_drift() {
+    Probe probe = {0, 0, -1};
+    int id = wheel.schedule(7, record, &probe, 10);
+    step(7);
+    TEST_ASSERT_EQUAL_UINT32(1, probe.runs);
+    step(10 * 99);
+    TEST_ASSERT_EQUAL_UINT32(100, probe.runs);
+    TEST_ASSERT_EQUAL_UINT32(7 + 10 * 99, probe.lastTick);  // Re-armed from its due tick
+    TEST_ASSERT_TRUE(wheel.isArmed(id));
+    TEST_ASSERT_EQUAL_UINT32(10, wheel.ticksUntilNext());
+
+    // A period longer than the wheel
+    wheel.clear();
+    now = 0;
+    probe.runs = 0;
+    wheel.schedule(SLOTS * 2 + 3, record, &probe, SLOTS * 2 + 3);
+    step((SLOTS * 2 + 3) * 5);
+    TEST_ASSERT_EQUAL_UINT32(5, probe.runs);
+    TEST_ASSERT_EQUAL_UINT32((SLOTS * 2 + 3) * 5, probe.lastTick);
+}
+
+static void test_periodic_timer_cancels_itself() {
+    Probe probe = {0, 0, -1};
+    probe.id = wheel.schedule(3, record, &probe, 3);
+    TEST_ASSERT_EQUAL_UINT32(1, step(3));
+    TEST_ASSERT_FALSE(wheel.isArmed(probe.id));
+    TEST_ASSERT_EQUAL_UINT8(0, wheel.armed());
+    TEST_ASSERT_EQUAL_UINT32(0, step(SLOTS * 2));
+    TEST_ASSERT_EQUAL_UINT32(1, probe.runs);
+}
+
+static void test_callback_cancels_a_timer_due_on_the_same_tick() {
+    Probe first = {0, 0, -1};
+    Probe second = {0, 0, -1};
+    int a = wheel.schedule(4, record, &first);
+    int b = wheel.schedule(4, record, &second);
+    // Slot lists are LIFO: whichever runs first cancels the other
+    Probe& runsFirst = b > a ? second : first;
+    runsFirst.id = b > a ? a : b;
+    TEST_ASSERT_EQUAL_UINT32(1, step(4));
+    TEST_ASSERT_EQUAL_UINT32(1, first.runs + second.runs);
+    TEST_ASSERT_EQUAL_UINT8(0, wheel.armed());
+}
+
+static void test_pool_exhaustion() {
+    Probe probe = {0, 0, -1};
+    int ids[EVENTLOOP_MAX_TIMERS];
+    for (int i = 0; i < EVENTLOOP_MAX_TIMERS; i++) {
+        ids[i] = wheel.schedule(i + 1, record, &probe);
+        TEST_ASSERT_GREATER_OR_EQUAL_INT(0, ids[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(EVENTLOOP_MAX_TIMERS, wheel.armed());
+    TEST_ASSERT_EQUAL_INT(-1, wheel.schedule(1, record, &probe));
+    TEST_ASSERT_EQUAL_INT(-1, wheel.schedule(1, nullptr, &probe));
+
+    // A cancelled timer frees its entry
+    TEST_ASSERT_TRUE(wheel.cancel(ids[5]));
+    TEST_ASSERT_FALSE(wheel.cancel(ids[5]));
+    TEST_ASSERT_EQUAL_INT(ids[5], wheel.schedule(1, record, &probe));
+    TEST_ASSERT_FALSE(wheel.cancel(-1));
+    TEST_ASSERT_FALSE(wheel.isArmed(EVENTLOOP_MAX_TIMERS));
+}
+
+static void test_ticks_until_next_across_the_wrap() {
+    Probe probe = {0, 0, -1};
+    // Idle advances only move the cursor
+    TEST_ASSERT_EQUAL_UINT32(0, wheel.advance(SLOTS * 10 + SLOTS - 4));
+
+    wheel.schedule(10, record, &probe);      // Slot past the wrap
+    wheel.schedule(SLOTS + 2, record, &probe);
+    TEST_ASSERT_EQUAL_UINT32(10, wheel.ticksUntilNext());
+    wheel.advance(3);
+    TEST_ASSERT_EQUAL_UINT32(7, wheel.ticksUntilNext());
+    TEST_ASSERT_EQUAL_UINT32(1, wheel.advance(7));
+    TEST_ASSERT_EQUAL_UINT32(SLOTS + 2 - 10, wheel.ticksUntilNext());
+    TEST_ASSERT_EQUAL_UINT32(0, wheel.advance(SLOTS - 9));
+    TEST_ASSERT_EQUAL_UINT32(1, wheel.ticksUntilNext());
+    TEST_ASSERT_EQUAL_UINT32(1, wheel.advance(1));
+    TEST_ASSERT_EQUAL_UINT32(TIMER_WHEEL_NONE, wheel.ticksUntilNext());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_delays_hash_into_slots_and_rounds);
+    RUN_TEST(test_zero_delay_runs_on_the_next_tick);
+    RUN_TEST(test_large_advance_runs_everything_due);
+    RUN_TEST(test_periodic_timer_does_not_drift);
+    RUN_TEST(test_periodic_timer_cancels_itself);
+    RUN_TEST(test_callback_cancels_a_timer_due_on_the_same_tick);
+    RUN_TEST(test_pool_exhaustion);
+    RUN_TEST(test_ticks_until_next_across_the_wrap);
+    return UNITY_END();
+}
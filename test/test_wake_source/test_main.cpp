@@ -0,0 +1,203 @@
+/**
+ * @file test_main.cpp
+ * @brief WakeSource classification of wake causes, the actions of button
+ *        wakes and the statistics, with the wakes played on the simulator:
+ *        ext0/ext1 on long sleeps, the ULP on short ones.
+ */
+
+#include <unity.h>
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include "WakeSource.h"
+#include "UlpWatch.h"
+#include "Device.h"
+#include "EventLoop.h"
+
+#define SECOND 1000000ULL
+#define ULP_SLEEP_MS 60000UL     // Counted down by the ULP
+#define TIMER_SLEEP_MS 3600000UL  // Timer plus ext0/ext1
+
+extern Device* device;  // main.cpp
+uint32_t waitForRelease(unsigned long pressedAt);
+
+static Device board;
+
+// Drives a pin low for `ms`, `at` microseconds from now
+static void press(int pin, uint64_t at, uint32_t ms) {
+    Sim::schedulePin(Sim::trueMicros() + at, pin, LOW);
+    Sim::schedulePin(Sim::trueMicros() + at + ms * 1000ULL, pin, HIGH);
+}
+
+// Sleeps like the firmware does and boots on whatever ends the sleep
+static int sleepAndWake(unsigned long ms) {
+    try {
+        board.deepSleep(ms);
+    } catch (const SimDeepSleep&) {
+    }
+    int cause = Sim::sleep(Sim::wakeTimer());
+    Sim::boot(cause);
+    EventLoop::begin();
+    WakeSource::begin(0);
+    return cause;
+}
+
+void setUp() {
+    Sim::powerOn(1750000000ULL * SECOND, 0);
+    const_cast<WakeStats&>(WakeSource::stats()).magic = 0;  // Power-on clears RTC memory
+    device = &board;
+    EventLoop::begin();
+    WakeSource::begin(0);
+}
+
+void tearDown() {}
+
+static void test_classify_every_cause() {
+    TEST_ASSERT_EQUAL(WakeKind::PowerOn, WakeSource::classify(ESP_SLEEP_WAKEUP_UNDEFINED));
+    TEST_ASSERT_EQUAL(WakeKind::Timer, WakeSource::classify(ESP_SLEEP_WAKEUP_TIMER));
+    TEST_ASSERT_EQUAL(WakeKind::Button, WakeSource::classify(ESP_SLEEP_WAKEUP_EXT0));
+    TEST_ASSERT_EQUAL(WakeKind::ProgSwitch, WakeSource::classify(ESP_SLEEP_WAKEUP_EXT1));
+    TEST_ASSERT_EQUAL(WakeKind::Ulp, WakeSource::classify(ESP_SLEEP_WAKEUP_ULP));
+    TEST_ASSERT_EQUAL(WakeKind::Other, WakeSource::classify(ESP_SLEEP_WAKEUP_ULP + 100));
+    TEST_ASSERT_EQUAL(WakeKind::PowerOn, WakeSource::current());
+}
+
+static void test_actions_of_button_wakes() {
+    const uint32_t longPress = BUTTON_LONG_PRESS_MS;
+    TEST_ASSERT_EQUAL(WakeAction::Snooze, WakeSource::decide(WakeKind::Button, true, 200, longPress));
+    TEST_ASSERT_EQUAL(WakeAction::Dismiss, WakeSource::decide(WakeKind::Button, true, longPress, longPress));
+    TEST_ASSERT_EQUAL(WakeAction::None, WakeSource::decide(WakeKind::Button, false, longPress - 1, longPress));
+    TEST_ASSERT_EQUAL(WakeAction::Admin, WakeSource::decide(WakeKind::Button, false, longPress, longPress));
+    TEST_ASSERT_EQUAL(WakeAction::SerialMode, WakeSource::decide(WakeKind::ProgSwitch, true, 0, longPress));
+    TEST_ASSERT_EQUAL(WakeAction::SerialMode, WakeSource::decide(WakeKind::ProgSwitch, false, longPress, longPress));
+    TEST_ASSERT_EQUAL(WakeAction::None, WakeSource::decide(WakeKind::Timer, true, longPress, longPress));
+    TEST_ASSERT_EQUAL(WakeAction::None, WakeSource::decide(WakeKind::Ulp, true, longPress, longPress));
+}
+
+static void test_ext_wakes_on_long_sleeps() {
+    press(SWITCH_PIN, 10 * SECOND, 200);
+    TEST_ASSERT_EQUAL_INT(ESP_SLEEP_WAKEUP_EXT0, sleepAndWake(TIMER_SLEEP_MS));
+    TEST_ASSERT_EQUAL(WakeKind::Button, WakeSource::current());
+    TEST_ASSERT_TRUE(WakeSource::isButton());
+
+    press(PROG_SWITCH_PIN, 10 * SECOND, 200);
+    TEST_ASSERT_EQUAL_INT(ESP_SLEEP_WAKEUP_EXT1, sleepAndWake(TIMER_SLEEP_MS));
+    TEST_ASSERT_EQUAL(WakeKind::ProgSwitch, WakeSource::current());
+
+    Sim::advance(SECOND);  // Both released
+    TEST_ASSERT_EQUAL_INT(ESP_SLEEP_WAKEUP_TIMER, sleepAndWake(TIMER_SLEEP_MS));
+    TEST_ASSERT_EQUAL(WakeKind::Timer, WakeSource::current());
+    TEST_ASSERT_FALSE(WakeSource::isButton());
+
+    const WakeStats& stats = WakeSource::stats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.wakes[(uint8_t)WakeKind::Button]);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.wakes[(uint8_t)WakeKind::ProgSwitch]);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.wakes[(uint8_t)WakeKind::Timer]);
+}
+
+static void test_ulp_button_wakes_resolve_to_the_button() {
+    press(SWITCH_PIN, 10 * SECOND, 200);
+    TEST_ASSERT_EQUAL_INT(ESP_SLEEP_WAKEUP_ULP, sleepAndWake(ULP_SLEEP_MS));
+    TEST_ASSERT_EQUAL(UlpReason::Button, UlpWatch::reason());
+    TEST_ASSERT_EQUAL(WakeKind::Button, WakeSource::current());
+
+    Sim::advance(SECOND);
+    press(PROG_SWITCH_PIN, 10 * SECOND, 200);
+    TEST_ASSERT_EQUAL_INT(ESP_SLEEP_WAKEUP_ULP, sleepAndWake(ULP_SLEEP_MS));
+    TEST_ASSERT_EQUAL(WakeKind::ProgSwitch, WakeSource::current());
+
+    // The countdown itself stays a ULP wake
+    TEST_ASSERT_EQUAL_INT(ESP_SLEEP_WAKEUP_ULP, sleepAndWake(ULP_SLEEP_MS));
+    TEST_ASSERT_EQUAL(UlpReason::Deadline, UlpWatch::reason());
+    TEST_ASSERT_EQUAL(WakeKind::Ulp, WakeSource::current());
+    TEST_ASSERT_FALSE(WakeSource::isButton());
+}
+
+static void test_button_held_across_boot() {
+    // Pressed in the sleep and held through the boot: a long press
+    press(SWITCH_PIN, 10 * SECOND, 2500);
+    TEST_ASSERT_EQUAL_INT(ESP_SLEEP_WAKEUP_EXT0, sleepAndWake(TIMER_SLEEP_MS));
+    Sim::advance(150000);  // Boot to handleButtonWake()
+    uint32_t hold = waitForRelease(0);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(BUTTON_LONG_PRESS_MS, hold);
+    WakeAction action = WakeSource::decide(WakeSource::current(), true, hold, BUTTON_LONG_PRESS_MS);
+    TEST_ASSERT_EQUAL(WakeAction::Dismiss, action);
+    WakeSource::acted(action);
+    TEST_ASSERT_EQUAL_UINT32(1, WakeSource::stats().latencySamples);
+    TEST_ASSERT_UINT32_WITHIN(BUTTON_POLL_MS, BUTTON_LONG_PRESS_MS, WakeSource::stats().latencyMaxMs);
+
+    // Still held when the device goes back to sleep: the button is left out
+    // of the wake sources instead of waking it right away
+    TEST_ASSERT_EQUAL_INT(LOW, digitalRead(SWITCH_PIN));
+    Sim::schedulePin(Sim::trueMicros() + 60 * SECOND, SWITCH_PIN, HIGH);
+    TEST_ASSERT_EQUAL_INT(ESP_SLEEP_WAKEUP_TIMER, sleepAndWake(TIMER_SLEEP_MS));
+    TEST_ASSERT_EQUAL(WakeKind::Timer, WakeSource::current());
+}
+
+static void test_spurious_wake_with_the_pin_released() {
+    // A glitch on the ext0 pin wakes the device, the pin reads released
+    press(SWITCH_PIN, 10 * SECOND, 1);
+    TEST_ASSERT_EQUAL_INT(ESP_SLEEP_WAKEUP_EXT0, sleepAndWake(TIMER_SLEEP_MS));
+    Sim::advance(150000);
+    TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(SWITCH_PIN));
+    uint32_t hold = waitForRelease(0);
+    TEST_ASSERT_LESS_THAN_UINT32(BUTTON_LONG_PRESS_MS, hold);
+    TEST_ASSERT_EQUAL(WakeAction::None, WakeSource::decide(WakeSource::current(), false, hold, BUTTON_LONG_PRESS_MS));
+
+    // The ULP debounces: a glitch shorter than its samples does not wake it
+    press(SWITCH_PIN, 10 * SECOND, ULP_PERIOD_MS * (ULP_DEBOUNCE_SAMPLES - 1) - 5);
+    TEST_ASSERT_EQUAL_INT(ESP_SLEEP_WAKEUP_ULP, sleepAndWake(ULP_SLEEP_MS));
+    TEST_ASSERT_EQUAL(UlpReason::Deadline, UlpWatch::reason());
+    TEST_ASSERT_EQUAL(WakeKind::Ulp, WakeSource::current());
+}
+
+static void test_stats_count_wakes_and_unanswered_indications() {
+    WakeSource::begin(5);  // Timer wakes absorbed by the stub
+    const WakeStats& stats = WakeSource::stats();
+    TEST_ASSERT_EQUAL_UINT32(5, stats.wakes[(uint8_t)WakeKind::Stub]);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.wakes[(uint8_t)WakeKind::PowerOn]);
+
+    TEST_ASSERT_EQUAL_UINT8(1, WakeSource::missed());
+    TEST_ASSERT_EQUAL_UINT8(2, WakeSource::missed());
+    WakeSource::acted(WakeAction::None);
+    TEST_ASSERT_EQUAL_UINT8(2, stats.unanswered);
+    WakeSource::acted(WakeAction::Snooze);
+    TEST_ASSERT_EQUAL_UINT8(0, stats.unanswered);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.actions[(uint8_t)WakeAction::Snooze]);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.latencySamples);  // Not a button wake
+}
+
+static void test_stats_crc_rejection() {
+    WakeStats stats = {};
+    stats.magic = WAKESOURCE_MAGIC;
+    stats.wakes[(uint8_t)WakeKind::Timer] = 7;
+    WakeSource::seal(stats);
+    TEST_ASSERT_TRUE(WakeSource::validate(stats));
+    stats.wakes[(uint8_t)WakeKind::Timer]++;
+    TEST_ASSERT_FALSE(WakeSource::validate(stats));
+    WakeSource::seal(stats);
+    stats.magic ^= 1;
+    TEST_ASSERT_FALSE(WakeSource::validate(stats));
+
+    // Damaged RTC statistics start over
+    WakeSource::missed();
+    WakeStats& rtc = const_cast<WakeStats&>(WakeSource::stats());
+    rtc.wakes[(uint8_t)WakeKind::Timer] += 1000;  // Without a new CRC
+    const WakeStats& fresh = WakeSource::stats();
+    TEST_ASSERT_TRUE(WakeSource::validate(fresh));
+    TEST_ASSERT_EQUAL_UINT32(0, fresh.wakes[(uint8_t)WakeKind::Timer]);
+    TEST_ASSERT_EQUAL_UINT32(0, fresh.wakes[(uint8_t)WakeKind::PowerOn]);
+    TEST_ASSERT_EQUAL_UINT8(0, fresh.unanswered);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_classify_every_cause);
+    RUN_TEST(test_actions_of_button_wakes);
+    RUN_TEST(test_ext_wakes_on_long_sleeps);
+    RUN_TEST(test_ulp_button_wakes_resolve_to_the_button);
+    RUN_TEST(test_button_held_across_boot);
+    RUN_TEST(test_spurious_wake_with_the_pin_released);
+    RUN_TEST(test_stats_count_wakes_and_unanswered_indications);
+    RUN_TEST(test_stats_crc_rejection);
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+/**
+ * @file test_main.cpp
+ * @brief WakeState validation and fast-wake decisions, on the pure helpers
+ *        and on the RTC block itself.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "WakeState.h"
+
+#define NOW 1750000000ULL
+#define ALARM (NOW + 3600ULL)
+
+static WakeStateData makeState(uint64_t now, uint64_t alertTimestamp, bool ledFlag) {
+    WakeStateData state = {};
+    state.magic = WAKESTATE_MAGIC;
+    state.version = WAKESTATE_VERSION;
+    state.flags = ledFlag ? WAKESTATE_FLAG_LED : 0;
+    state.currentTime = now;
+    state.lastTimeSaved = now;
+    state.alertTimestamp = alertTimestamp;
+    WakeState::seal(state);
+    return state;
+}
+
+void setUp() {
+    WakeState::invalidate();
+}
+
+void tearDown() {}
+
+static void test_sealed_block_validates() {
+    WakeStateData state = makeState(NOW, ALARM, false);
+    TEST_ASSERT_TRUE(WakeState::validate(state));
+}
+
+static void test_zeroed_block_is_invalid() {
+    // What RTC memory holds after power-on or brown-out
+    WakeStateData state = {};
+    TEST_ASSERT_FALSE(WakeState::validate(state));
+    TEST_ASSERT_FALSE(WakeState::isValid());
+}
+
+static void test_corruption_is_detected() {
+    WakeStateData state = makeState(NOW, ALARM, false);
+    state.alertTimestamp++;
+    TEST_ASSERT_FALSE(WakeState::validate(state));
+
+    state = makeState(NOW, ALARM, false);
+    state.version++;
+    WakeState::seal(state);
+    TEST_ASSERT_FALSE(WakeState::validate(state));
+
+    state = makeState(NOW, ALARM, false);
+    state.magic ^= 1;
+    WakeState::seal(state);
+    TEST_ASSERT_FALSE(WakeState::validate(state));
+}
+
+static void test_wake_before_alarm_sleeps_and_advances() {
+    WakeStateData state = makeState(NOW, ALARM, false);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)FastWakeAction::Sleep, (uint8_t)WakeState::evaluate(state, NOW + 60, 1, 0));
+    TEST_ASSERT_TRUE(WakeState::validate(state));
+    TEST_ASSERT_EQUAL_UINT64(NOW + 60, state.currentTime);
+    TEST_ASSERT_EQUAL_UINT64(NOW + 60, state.lastTimeSaved);
+    TEST_ASSERT_EQUAL_UINT32(1, state.wakeCount);
+    TEST_ASSERT_EQUAL_UINT32(1, state.fastWakeCount);
+}
+
+static void test_due_alarm_forces_full_boot_and_keeps_block() {
+    WakeStateData state = makeState(NOW, ALARM, false);
+    WakeStateData before = state;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)FastWakeAction::FullBoot, (uint8_t)WakeState::evaluate(state, ALARM, 1, 0));
+    TEST_ASSERT_EQUAL_MEMORY(&before, &state, sizeof(state));
+}
+
+static void test_led_flag_or_invalid_block_forces_full_boot() {
+    WakeStateData state = makeState(NOW, ALARM, true);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)FastWakeAction::FullBoot, (uint8_t)WakeState::evaluate(state, NOW + 60, 1, 0));
+
+    state = makeState(NOW, ALARM, false);
+    state.currentTime++;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)FastWakeAction::FullBoot, (uint8_t)WakeState::evaluate(state, NOW + 60, 1, 0));
+}
+
+static void test_checkpoint_every_n_wakes() {
+    WakeStateData state = makeState(NOW, ALARM, false);
+    int checkpoints = 0;
+    for (uint32_t i = 1; i <= 30; i++) {
+        FastWakeAction action = WakeState::evaluate(state, NOW + i, 1, 10);
+        if (action == FastWakeAction::Checkpoint) {
+            checkpoints++;
+            TEST_ASSERT_EQUAL_UINT32(0, i % 10);
+        } else {
+            TEST_ASSERT_EQUAL_UINT8((uint8_t)FastWakeAction::Sleep, (uint8_t)action);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(3, checkpoints);
+    TEST_ASSERT_EQUAL_UINT32(30, state.fastWakeCount);
+}
+
+static void test_stub_wakes_count_towards_checkpoint() {
+    // Wakes absorbed by the wake stub are reported in one go
+    WakeStateData state = makeState(NOW, ALARM, false);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)FastWakeAction::Sleep, (uint8_t)WakeState::evaluate(state, NOW + 60, 9, 10));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)FastWakeAction::Checkpoint, (uint8_t)WakeState::evaluate(state, NOW + 120, 1, 10));
+    TEST_ASSERT_EQUAL_UINT32(10, state.wakeCount);
+    TEST_ASSERT_EQUAL_UINT32(0, state.wakesSinceCheckpoint);
+}
+
+static void test_capture_keeps_counters_and_invalidate_clears() {
+    WakeState::capture(NOW, NOW, ALARM, false);
+    TEST_ASSERT_TRUE(WakeState::isValid());
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)FastWakeAction::Sleep, (uint8_t)WakeState::onTimerWake(NOW + 60, 3));
+
+    WakeState::capture(NOW + 60, NOW + 60, ALARM + 60, false);
+    TEST_ASSERT_TRUE(WakeState::isValid());
+    TEST_ASSERT_EQUAL_UINT32(3, WakeState::data().wakeCount);
+    TEST_ASSERT_EQUAL_UINT32(3, WakeState::data().fastWakeCount);
+    TEST_ASSERT_EQUAL_UINT64(ALARM + 60, WakeState::data().alertTimestamp);
+
+    WakeState::invalidate();
+    TEST_ASSERT_FALSE(WakeState::isValid());
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)FastWakeAction::FullBoot, (uint8_t)WakeState::onTimerWake(NOW + 120));
+}
+
+static void test_capture_after_invalid_block_restarts_counters() {
+    WakeState::capture(NOW, NOW, ALARM, false);
+    WakeState::onTimerWake(NOW + 60, 5);
+    WakeState::invalidate();
+    WakeState::capture(NOW + 60, NOW + 60, ALARM, false);
+    TEST_ASSERT_EQUAL_UINT32(0, WakeState::data().wakeCount);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sealed_block_validates);
+    RUN_TEST(test_zeroed_block_is_invalid);
+    RUN_TEST(test_corruption_is_detected);
+    RUN_TEST(test_wake_before_alarm_sleeps_and_advances);
+    RUN_TEST(test_due_alarm_forces_full_boot_and_keeps_block);
+    RUN_TEST(test_led_flag_or_invalid_block_forces_full_boot);
+    RUN_TEST(test_checkpoint_every_n_wakes);
+    RUN_TEST(test_stub_wakes_count_towards_checkpoint);
+    RUN_TEST(test_capture_keeps_counters_and_invalidate_clears);
+    RUN_TEST(test_capture_after_invalid_block_restarts_counters);
+    return UNITY_END();
+}
@@ -0,0 +1,115 @@
+/**
+ * @file test_main.cpp
+ * @brief wakeStubDecide() and the host emulation of the deep-sleep wake stub
+ *        on the virtual RTC timer.
+ */
+
+#include <unity.h>
+#include "WakeStub.h"
+#include "TimeAccounting.h"
+
+#define SECOND_MICROS 1000000ULL
+#define SLEEP_MS 60000UL  // One sleep period
+
+static WakeStubState makeState(uint64_t deadlineTicks, uint64_t sleepTicks) {
+    WakeStubState state = {};
+    state.armed = WAKESTUB_ARMED;
+    state.deadlineTicks = deadlineTicks;
+    state.sleepTicks = sleepTicks;
+    state.maxSkippedWakes = WAKESTUB_MAX_SKIPPED_WAKES;
+    return state;
+}
+
+// Wakes the stub every sleep period until it boots the app, returns the absorbed wakes
+static uint32_t runUntilBoot(bool buttonPressed) {
+    uint64_t now = TimeAccounting::rtcMicros();
+    for (uint32_t wake = 0; wake < 10000; wake++) {
+        now += SLEEP_MS * 1000ULL;
+        TimeAccounting::setHostRtcMicros(now);
+        if (!WakeStub::runOnHost(buttonPressed)) break;
+    }
+    return WakeStub::takeSkippedWakes();
+}
+
+void setUp() {
+    TimeAccounting::setHostRtcMicros(1000 * SECOND_MICROS);
+    WakeStub::takeSkippedWakes();  // Disarm
+}
+
+void tearDown() {}
+
+static void test_sleeps_while_a_full_period_fits() {
+    WakeStubState state = makeState(1000, 100);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)WakeStubDecision::SleepAgain, (uint8_t)wakeStubDecide(state, 0, false));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)WakeStubDecision::SleepAgain, (uint8_t)wakeStubDecide(state, 900, false));
+}
+
+static void test_boots_when_the_next_period_overshoots() {
+    WakeStubState state = makeState(1000, 100);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)WakeStubDecision::BootApp, (uint8_t)wakeStubDecide(state, 901, false));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)WakeStubDecision::BootApp, (uint8_t)wakeStubDecide(state, 5000, false));
+}
+
+static void test_boots_when_not_armed_or_button_pressed() {
+    WakeStubState state = makeState(1000, 100);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)WakeStubDecision::BootApp, (uint8_t)wakeStubDecide(state, 0, true));
+    state.armed = 0;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)WakeStubDecision::BootApp, (uint8_t)wakeStubDecide(state, 0, false));
+}
+
+static void test_boots_after_max_skipped_wakes() {
+    WakeStubState state = makeState(1000000, 100);
+    state.tickCount = WAKESTUB_MAX_SKIPPED_WAKES - 1;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)WakeStubDecision::SleepAgain, (uint8_t)wakeStubDecide(state, 0, false));
+    state.tickCount = WAKESTUB_MAX_SKIPPED_WAKES;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)WakeStubDecision::BootApp, (uint8_t)wakeStubDecide(state, 0, false));
+}
+
+static void test_arm_converts_to_rtc_ticks() {
+    WakeStub::arm(3600, SLEEP_MS);
+    const WakeStubState& state = WakeStub::state();
+    TEST_ASSERT_EQUAL_UINT32(WAKESTUB_ARMED, state.armed);
+    TEST_ASSERT_EQUAL_UINT64(1000 * SECOND_MICROS + 3600 * SECOND_MICROS, state.deadlineTicks);
+    TEST_ASSERT_EQUAL_UINT64(SLEEP_MS * 1000ULL, state.sleepTicks);
+    TEST_ASSERT_EQUAL_UINT32(0, state.tickCount);
+}
+
+static void test_app_boots_on_the_wake_that_reaches_the_alarm() {
+    // 60 periods to the alarm: the stub absorbs 59, the app boots on the wake that reaches it
+    WakeStub::arm(3600, SLEEP_MS);
+    TEST_ASSERT_EQUAL_UINT32(59, runUntilBoot(false));
+    TEST_ASSERT_EQUAL_UINT64(1000 * SECOND_MICROS + 3600 * SECOND_MICROS, TimeAccounting::rtcMicros());
+}
+
+static void test_long_sleep_boots_for_the_checkpoint() {
+    WakeStub::arm(10 * 3600, SLEEP_MS);
+    TEST_ASSERT_EQUAL_UINT32(WAKESTUB_MAX_SKIPPED_WAKES, runUntilBoot(false));
+}
+
+static void test_button_boots_on_the_first_wake() {
+    WakeStub::arm(3600, SLEEP_MS);
+    TEST_ASSERT_EQUAL_UINT32(0, runUntilBoot(true));
+}
+
+static void test_take_skipped_wakes_disarms() {
+    WakeStub::arm(3600, SLEEP_MS);
+    TimeAccounting::setHostRtcMicros(TimeAccounting::rtcMicros() + SLEEP_MS * 1000ULL);
+    TEST_ASSERT_TRUE(WakeStub::runOnHost(false));
+    TEST_ASSERT_EQUAL_UINT32(1, WakeStub::takeSkippedWakes());
+    TEST_ASSERT_EQUAL_UINT32(0, WakeStub::takeSkippedWakes());
+    TEST_ASSERT_FALSE(WakeStub::runOnHost(false));  // Disarmed: the app boots
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sleeps_while_a_full_period_fits);
+    RUN_TEST(test_boots_when_the_next_period_overshoots);
+    RUN_TEST(test_boots_when_not_armed_or_button_pressed);
+    RUN_TEST(test_boots_after_max_skipped_wakes);
+    RUN_TEST(test_arm_converts_to_rtc_ticks);
+    RUN_TEST(test_app_boots_on_the_wake_that_reaches_the_alarm);
+    RUN_TEST(test_long_sleep_boots_for_the_checkpoint);
+    RUN_TEST(test_button_boots_on_the_first_wake);
+    RUN_TEST(test_take_skipped_wakes_disarms);
+    return UNITY_END();
+}
@@ -0,0 +1,130 @@
+"""
+Builds the web portal into the firmware image.
+
+Each page in data/ is minified, its icons (`src="icons/..."`) are inlined as
+data URIs, and the result is gzipped and written to src/WebAssets.h as a
+const byte array with a strong ETag (content hash). WiFiManager serves the
+arrays straight from flash with `Content-Encoding: gzip` and answers
+revalidations with 304, so a page is a single request and SPIFFS is not
+needed at run time.
+
+Runs as a PlatformIO pre-script (`extra_scripts = pre:tools/embed_web.py`)
+or by hand: `python3 tools/embed_web.py`. The header is only rewritten when
+its content changes, so unchanged pages do not trigger a rebuild.
+"""
+
+import base64
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+PAGES = [
+    # (file in data/, C identifier, content type)
+    ("welcome.html", "WEB_WELCOME", "text/html"),
+    ("BoardSetting.html", "WEB_BOARD_SETTING", "text/html"),
+    ("wifiCredentialsPage.html", "WEB_WIFI_CREDENTIALS", "text/html"),
+    ("thankyou_page.html", "WEB_THANK_YOU", "text/html"),
+]
+
+ICON_TYPES = {".png": "image/png", ".svg": "image/svg+xml", ".ico": "image/x-icon"}
+
+
+def inline_icons(html, data_dir, page):
+    """Replaces src="icons/..." references with data URIs."""
+    def replace(match):
+        name = match.group(2)
+        path = os.path.join(data_dir, name)
+        ext = os.path.splitext(name)[1].lower()
+        if not os.path.isfile(path) or ext not in ICON_TYPES:
+            sys.exit("embed_web: %s references missing icon %s" % (page, name))
+        with open(path, "rb") as f:
+            encoded = base64.b64encode(f.read()).decode("ascii")
+        return '%s="data:%s;base64,%s"' % (match.group(1), ICON_TYPES[ext], encoded)
+
+    return re.sub(r'(src)="/?(icons/[^"]+)"', replace, html)
+
+
+def minify(html):
+    """Conservative minifier: drops comments, indentation and blank lines.
+
+    Line breaks are kept so JavaScript statements without semicolons keep
+    their meaning; gzip makes them nearly free.
+    """
+    html = re.sub(r"<!--.*?-->", "", html, flags=re.S)
+    html = re.sub(r"/\*.*?\*/", "", html, flags=re.S)  # CSS (and JS block) comments
+    lines = []
+    for line in html.splitlines():
+        line = line.strip()
+        if line.startswith("//"):
+            continue  # Whole-line JS comment
+        line = re.sub(r"([;{])\s+//.*$", r"\1", line)  # Trailing JS comment after a statement
+        if line:
+            lines.append(line)
+    return "\n".join(lines) + "\n"
+
+
+def c_array(data):
+    rows = []
+    for i in range(0, len(data), 16):
+        rows.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(rows)
+
+
+def build(project_dir):
+    data_dir = os.path.join(project_dir, "data")
+    out_path = os.path.join(project_dir, "src", "WebAssets.h")
+
+    out = [
+        "// Generated by tools/embed_web.py from data/ - do not edit.",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "// One gzipped page in flash",
+        "struct WebAsset {",
+        "    const char* type;     ///< Content type",
+        "    const uint8_t* data;  ///< Gzipped body",
+        "    size_t length;        ///< Gzipped length in bytes",
+        "    const char* etag;     ///< Strong ETag (quoted)",
+        "};",
+        "",
+    ]
+    report = []
+    for name, ident, content_type in PAGES:
+        with open(os.path.join(data_dir, name), encoding="utf-8") as f:
+            source = f.read()
+        body = minify(inline_icons(source, data_dir, name)).encode("utf-8")
+        packed = gzip.compress(body, compresslevel=9, mtime=0)  # mtime 0: reproducible output
+        digest = hashlib.sha256(packed).hexdigest()[:16]
+        out += [
+            "// %s: %d bytes, %d minified, %d gzipped" % (name, len(source.encode("utf-8")), len(body), len(packed)),
+            "static const uint8_t %s_DATA[] = {" % ident,  # const: stays in flash (rodata)
+            c_array(packed),
+            "};",
+            'static const WebAsset %s = {"%s", %s_DATA, sizeof(%s_DATA), "\\"%s\\""};'
+            % (ident, content_type, ident, ident, digest),
+            "",
+        ]
+        report.append("%s %d -> %d" % (name, len(source), len(packed)))
+    out += ["#endif // WEB_ASSETS_H", ""]
+    text = "\n".join(out)
+
+    old = None
+    if os.path.isfile(out_path):
+        with open(out_path, encoding="utf-8") as f:
+            old = f.read()
+    if old != text:
+        with open(out_path, "w", encoding="utf-8") as f:
+            f.write(text)
+        print("embed_web: " + ", ".join(report))
+
+
+try:
+    Import("env")  # noqa: F821 (PlatformIO/SCons)
+    build(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        build(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))